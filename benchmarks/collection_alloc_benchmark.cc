@@ -0,0 +1,145 @@
+// 统计一个采集周期（采集 → 组装报告 → 列式编码 → 序列化）的堆分配次数。
+//
+//   ./build/benchmarks/collection_alloc_benchmark
+//
+// allocs_per_cycle 计数器为每个周期调用 operator new 的平均次数：
+// - BM_PooledReportCycle：ReportPool 槽位复用（当前实现）
+// - BM_FreshReportCycle：每周期新建样本 vector 并深拷贝进新的 MetricsReport（旧实现）
+// /proc 采集只产生少量样本，这里另外按 mmap 采集器的形状补齐 64 个 per-core 样本。
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "src/client/system_metrics_collector.h"
+#include "src/common/codec/columnar_codec.h"
+#include "src/common/codec/report_pool.h"
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept {
+  std::free(ptr);
+}
+
+namespace {
+
+using system_insight::client::CollectorConfig;
+using system_insight::client::SystemMetricsCollector;
+using system_insight::common::codec::ColumnarEncoder;
+using system_insight::common::codec::ReportPool;
+using systeminsight::proto::MetricSample;
+using systeminsight::proto::MetricsReport;
+
+constexpr int kCores = 64;
+
+const std::vector<std::string>& CoreNames() {
+  static const std::vector<std::string> names = [] {
+    std::vector<std::string> result;
+    for (int i = 0; i < kCores; ++i) {
+      result.push_back("cpu" + std::to_string(i));
+    }
+    return result;
+  }();
+  return names;
+}
+
+void AddPerCoreSamples(int cycle, MetricsReport* report) {
+  static const std::string kName = "system.cpu.core.usage_percent";
+  for (int i = 0; i < kCores; ++i) {
+    auto* sample = report->add_samples();
+    sample->set_name(kName);
+    sample->set_value(15.0 + ((cycle + i) % 7));
+    sample->set_timestamp_ms(1700000000000 + cycle);
+    auto* label = sample->add_labels();
+    label->set_key("core");
+    label->set_value(CoreNames()[i]);
+  }
+}
+
+void BM_PooledReportCycle(benchmark::State& state) {
+  SystemMetricsCollector collector{CollectorConfig()};
+  ReportPool pool;
+  ColumnarEncoder encoder(systeminsight::proto::REPORT_ENCODING_COLUMNAR_XOR);
+  MetricsReport wire;
+  std::string serialized;
+  int cycle = 0;
+
+  auto run_cycle = [&] {
+    auto slot = pool.Acquire();
+    auto* report = slot->report();
+    collector.Collect(report);
+    AddPerCoreSamples(cycle++, report);
+    report->set_host_id("bench-host");
+    report->set_collector_version("system_insight_client");
+    wire.set_host_id(report->host_id());
+    encoder.Encode(*report, wire.mutable_columnar());
+    wire.SerializeToString(&serialized);
+  };
+  // 预热：让槽位、字符串容量和编码器状态达到稳态
+  for (int i = 0; i < 8; ++i) run_cycle();
+
+  uint64_t before = g_allocations.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    run_cycle();
+  }
+  state.counters["allocs_per_cycle"] = benchmark::Counter(
+      static_cast<double>(g_allocations.load(std::memory_order_relaxed) - before),
+      benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_PooledReportCycle);
+
+void BM_FreshReportCycle(benchmark::State& state) {
+  SystemMetricsCollector collector{CollectorConfig()};
+  ColumnarEncoder encoder(systeminsight::proto::REPORT_ENCODING_COLUMNAR_XOR);
+  MetricsReport wire;
+  std::string serialized;
+  int cycle = 0;
+
+  auto run_cycle = [&] {
+    MetricsReport collected;
+    collector.Collect(&collected);
+    AddPerCoreSamples(cycle++, &collected);
+    std::vector<MetricSample> samples(collected.samples().begin(), collected.samples().end());
+    auto report = std::make_unique<MetricsReport>();
+    report->set_host_id("bench-host");
+    report->set_collector_version("system_insight_client");
+    for (const auto& sample : samples) {
+      *report->add_samples() = sample;
+    }
+    wire.set_host_id(report->host_id());
+    encoder.Encode(*report, wire.mutable_columnar());
+    wire.SerializeToString(&serialized);
+  };
+  for (int i = 0; i < 8; ++i) run_cycle();
+
+  uint64_t before = g_allocations.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    run_cycle();
+  }
+  state.counters["allocs_per_cycle"] = benchmark::Counter(
+      static_cast<double>(g_allocations.load(std::memory_order_relaxed) - before),
+      benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_FreshReportCycle);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,172 @@
+// 异步 gRPC 服务端在 10k 个模拟客户端下的上报吞吐与延迟。
+//
+//   ./build/benchmarks/ingest_server_benchmark
+//   SYSTEM_INSIGHT_INGEST_BENCH_AGENTS=1000 ./build/benchmarks/ingest_server_benchmark
+//
+// 进程内启动完整的接收链路（AsyncMetricsServer → MetricsServiceImpl → 仓库 + 时序库），
+// 经本机回环连接上报。每次迭代所有客户端各发送一份 50 个样本的报告（SendMetrics），
+// 全部同时在途，模拟采集周期对齐时的突发。客户端分布在 8 个连接上。
+// 参数为（完成队列数, 入库应用线程数），应用线程数为 0 时在处理线程上直接写入；
+// reports_per_second 为持续吞吐，p50_ms / p99_ms 为单份报告的往返延迟。
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "grpcpp/grpcpp.h"
+#include "src/common/logging/logging.h"
+#include "src/server/async_metrics_server.h"
+
+namespace {
+
+using system_insight::server::AsyncMetricsServer;
+using system_insight::server::AsyncServerOptions;
+using system_insight::server::IngestOptions;
+using system_insight::server::MetricsRepository;
+using system_insight::server::MetricsServiceImpl;
+using system_insight::server::TimeSeriesDb;
+using system_insight::server::TsdbOptions;
+using systeminsight::proto::MetricsReport;
+using systeminsight::proto::ReportAck;
+using systeminsight::proto::SystemInsightService;
+
+constexpr int kSamplesPerReport = 50;
+constexpr int kChannels = 8;
+constexpr int64_t kStartMs = 1'700'000'000'000;
+constexpr int64_t kIntervalMs = 10'000;
+
+size_t AgentCount() {
+  const char* env = std::getenv("SYSTEM_INSIGHT_INGEST_BENCH_AGENTS");
+  return env != nullptr ? std::strtoull(env, nullptr, 10) : 10'000;
+}
+
+struct PendingReport {
+  grpc::ClientContext context;
+  ReportAck ack;
+  grpc::Status status;
+  std::unique_ptr<grpc::ClientAsyncResponseReader<ReportAck>> reader;
+  std::chrono::steady_clock::time_point sent;
+};
+
+double Percentile(std::vector<double>* values, double q) {
+  if (values->empty()) return 0;
+  const size_t index = static_cast<size_t>(q * static_cast<double>(values->size() - 1));
+  std::nth_element(values->begin(), values->begin() + static_cast<std::ptrdiff_t>(index),
+                   values->end());
+  return (*values)[index];
+}
+
+void BM_IngestServer(benchmark::State& state) {
+  system_insight::common::logging::SetLogLevel("warn");
+
+  auto repository = std::make_shared<MetricsRepository>();
+  TsdbOptions tsdb_options;
+  tsdb_options.memory_budget_bytes = size_t{4} << 30;
+  auto tsdb = std::make_shared<TimeSeriesDb>(tsdb_options, repository->shared_series_store());
+  IngestOptions ingest;
+  ingest.applier_threads = static_cast<size_t>(state.range(1));
+  // 一次突发的全部报告都能入队
+  ingest.queue_capacity = AgentCount();
+  MetricsServiceImpl service(repository, 8, tsdb, nullptr, ingest);
+  AsyncServerOptions options;
+  options.completion_queues = static_cast<size_t>(state.range(0));
+  AsyncMetricsServer async_server(&service, options);
+
+  grpc::ServerBuilder builder;
+  int port = 0;
+  builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+  async_server.Register(&builder);
+  auto server = builder.BuildAndStart();
+  if (!server) {
+    state.SkipWithError("failed to start gRPC server");
+    return;
+  }
+  async_server.Start();
+
+  // 通道参数不同才会建立各自的连接
+  std::vector<std::unique_ptr<SystemInsightService::Stub>> stubs;
+  for (int c = 0; c < kChannels; ++c) {
+    grpc::ChannelArguments args;
+    args.SetInt("system_insight.bench_channel", c);
+    stubs.push_back(SystemInsightService::NewStub(grpc::CreateCustomChannel(
+        "127.0.0.1:" + std::to_string(port), grpc::InsecureChannelCredentials(), args)));
+  }
+
+  const size_t agents = AgentCount();
+  std::vector<MetricsReport> reports(agents);
+  for (size_t a = 0; a < agents; ++a) {
+    reports[a].set_host_id("agent-" + std::to_string(a));
+    for (int k = 0; k < kSamplesPerReport; ++k) {
+      auto* sample = reports[a].add_samples();
+      sample->set_name("metric_" + std::to_string(k % 10));
+      auto* label = sample->add_labels();
+      label->set_key("device");
+      label->set_value("dev" + std::to_string(k / 10));
+    }
+  }
+
+  grpc::CompletionQueue cq;
+  std::vector<double> latencies_ms;
+  uint64_t failed = 0;
+  int64_t timestamp_ms = kStartMs;
+  for (auto _ : state) {
+    timestamp_ms += kIntervalMs;
+    std::vector<std::unique_ptr<PendingReport>> pending(agents);
+    for (size_t a = 0; a < agents; ++a) {
+      auto& report = reports[a];
+      for (int k = 0; k < kSamplesPerReport; ++k) {
+        auto* sample = report.mutable_samples(k);
+        sample->set_value(static_cast<double>((timestamp_ms / 1000) % 100 + k));
+        sample->set_timestamp_ms(timestamp_ms);
+      }
+      auto call = std::make_unique<PendingReport>();
+      call->sent = std::chrono::steady_clock::now();
+      call->reader = stubs[a % kChannels]->AsyncSendMetrics(&call->context, report, &cq);
+      call->reader->Finish(&call->ack, &call->status, call.get());
+      pending[a] = std::move(call);
+    }
+    for (size_t done = 0; done < agents; ++done) {
+      void* tag = nullptr;
+      bool ok = false;
+      if (!cq.Next(&tag, &ok)) break;
+      auto* call = static_cast<PendingReport*>(tag);
+      latencies_ms.push_back(std::chrono::duration<double, std::milli>(
+                                 std::chrono::steady_clock::now() - call->sent)
+                                 .count());
+      if (!ok || !call->status.ok() || !call->ack.ok()) ++failed;
+    }
+  }
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * agents));
+  state.counters["reports_per_second"] = benchmark::Counter(
+      static_cast<double>(state.iterations() * agents), benchmark::Counter::kIsRate);
+  state.counters["p50_ms"] = Percentile(&latencies_ms, 0.50);
+  state.counters["p99_ms"] = Percentile(&latencies_ms, 0.99);
+  state.counters["failed"] = static_cast<double>(failed);
+
+  server->Shutdown();
+  service.StopIngest();
+  async_server.Stop();
+  cq.Shutdown();
+  void* tag = nullptr;
+  bool ok = false;
+  while (cq.Next(&tag, &ok)) {
+  }
+}
+
+}  // namespace
+
+BENCHMARK(BM_IngestServer)
+    ->Args({1, 0})
+    ->Args({1, 2})
+    ->Args({4, 0})
+    ->Args({4, 2})
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,157 @@
+// 抓取（Snapshot）与写入（UpdateReport）并发时的仓库吞吐。
+//
+//   ./build/benchmarks/metrics_repository_benchmark
+//
+// 仓库预置 5000 个主机、每个主机 50 个序列。
+// - BM_UpdateReport/<scrape>：N 个写线程写入 delta 报告；scrape=1 时另有一个线程持续抓取
+// - BM_Snapshot：单次抓取（取得全部主机快照的引用）的耗时
+// - BM_SnapshotUnderWrites/<writers>：另有 N 个写线程持续写入时单次抓取的耗时
+// - BM_BytesPerSeries：按 protobuf 副本保存与按序列表 + 列保存时每个序列占用的堆内存
+// 对比 scrape=0 与 scrape=1 即可看出抓取是否拖慢写入；对比 writers=0 与 writers>0 即可看出
+// 发布快照用的 shared_ptr 原子操作（libstdc++ 内部共享的互斥量）是否拖慢抓取。
+
+#include <benchmark/benchmark.h>
+#include <malloc.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/server/metrics_repository.h"
+
+namespace {
+
+using system_insight::server::MetricsRepository;
+using systeminsight::proto::MetricsReport;
+
+constexpr int kHosts = 5000;
+constexpr int kSeriesPerHost = 50;
+
+MetricsReport MakeReport(int host, int64_t timestamp_ms, bool delta, int series) {
+  MetricsReport report;
+  report.set_host_id("host-" + std::to_string(host));
+  report.set_delta(delta);
+  for (int i = 0; i < series; ++i) {
+    auto* sample = report.add_samples();
+    sample->set_name("system.metric_" + std::to_string(i));
+    sample->set_value(i);
+    sample->set_timestamp_ms(timestamp_ms);
+    if (i % 2 == 1) {
+      auto* label = sample->add_labels();
+      label->set_key("device");
+      label->set_value("device_" + std::to_string(i % 8));
+    }
+  }
+  return report;
+}
+
+MetricsRepository& Repository() {
+  static MetricsRepository* repository = [] {
+    auto* created = new MetricsRepository();
+    for (int host = 0; host < kHosts; ++host) {
+      created->UpdateReport(MakeReport(host, 1, false, kSeriesPerHost));
+    }
+    return created;
+  }();
+  return *repository;
+}
+
+std::atomic<bool> g_scraping{false};
+std::atomic<int64_t> g_timestamp{2};
+
+void BM_UpdateReport(benchmark::State& state) {
+  MetricsRepository& repository = Repository();
+  std::thread scraper;
+  int64_t scrapes = 0;
+  if (state.thread_index() == 0 && state.range(0) != 0) {
+    g_scraping.store(true);
+    scraper = std::thread([&repository, &scrapes] {
+      while (g_scraping.load(std::memory_order_relaxed)) {
+        benchmark::DoNotOptimize(repository.Snapshot());
+        ++scrapes;
+      }
+    });
+  }
+
+  // 每份 delta 报告只含 5 个变化的序列
+  int host = state.thread_index();
+  for (auto _ : state) {
+    MetricsReport report = MakeReport(host, g_timestamp.fetch_add(1), true, 5);
+    benchmark::DoNotOptimize(repository.UpdateReport(report));
+    host = (host + state.threads()) % kHosts;
+  }
+  state.SetItemsProcessed(state.iterations());
+
+  if (scraper.joinable()) {
+    g_scraping.store(false);
+    scraper.join();
+    state.counters["scrapes"] = static_cast<double>(scrapes);
+  }
+}
+BENCHMARK(BM_UpdateReport)->Arg(0)->Arg(1)->Threads(1)->Threads(4)->Threads(8)->UseRealTime();
+
+void BM_Snapshot(benchmark::State& state) {
+  MetricsRepository& repository = Repository();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(repository.Snapshot());
+  }
+  state.SetItemsProcessed(state.iterations() * kHosts);
+}
+BENCHMARK(BM_Snapshot);
+
+void BM_SnapshotUnderWrites(benchmark::State& state) {
+  MetricsRepository& repository = Repository();
+  std::atomic<bool> writing{true};
+  std::atomic<int64_t> writes{0};
+  std::vector<std::thread> writers;
+  for (int w = 0; w < state.range(0); ++w) {
+    writers.emplace_back([&repository, &writing, &writes, w, count = state.range(0)] {
+      for (int host = w; writing.load(std::memory_order_relaxed);
+           host = (host + static_cast<int>(count)) % kHosts) {
+        repository.UpdateReport(MakeReport(host, g_timestamp.fetch_add(1), true, 5));
+        writes.fetch_add(1, std::memory_order_relaxed);
+      }
+    });
+  }
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(repository.Snapshot());
+  }
+  state.SetItemsProcessed(state.iterations() * kHosts);
+
+  writing.store(false);
+  for (auto& writer : writers) writer.join();
+  state.counters["writes"] = static_cast<double>(writes.load());
+}
+BENCHMARK(BM_SnapshotUnderWrites)->Arg(0)->Arg(4)->Arg(8)->UseRealTime();
+
+size_t HeapInUse() {
+  return mallinfo2().uordblks;
+}
+
+void BM_BytesPerSeries(benchmark::State& state) {
+  constexpr int kMeasuredHosts = 1000;
+  constexpr double kSeries = static_cast<double>(kMeasuredHosts) * kSeriesPerHost;
+  for (auto _ : state) {
+    std::vector<MetricsReport> reports;
+    reports.reserve(kMeasuredHosts);
+    size_t before = HeapInUse();
+    for (int host = 0; host < kMeasuredHosts; ++host) {
+      reports.push_back(MakeReport(host, 1, false, kSeriesPerHost));
+    }
+    state.counters["proto_bytes_per_series"] = (HeapInUse() - before) / kSeries;
+
+    before = HeapInUse();
+    auto repository = std::make_unique<MetricsRepository>();
+    for (const auto& report : reports) {
+      repository->UpdateReport(report);
+    }
+    state.counters["store_bytes_per_series"] = (HeapInUse() - before) / kSeries;
+  }
+}
+BENCHMARK(BM_BytesPerSeries)->Iterations(1);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,102 @@
+// QueryRange 在 1M 序列 × 1 小时数据上的耗时。
+//
+//   ./build/benchmarks/query_range_benchmark
+//   SYSTEM_INSIGHT_QUERY_BENCH_SERIES=100000 ./build/benchmarks/query_range_benchmark
+//
+// 每台主机 100 个序列（10 个指标名 × 10 个 device 标签），每 60 s 一个点，共 1 小时。
+// 每次查询按一个指标名选出 1/10 的序列，以 5 分钟为步长分别做 avg / max / rate / p99。
+// 序列数可用 SYSTEM_INSIGHT_QUERY_BENCH_SERIES 调小，1M 序列约占 600 MB 内存。
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+#include "src/server/query_engine.h"
+
+namespace {
+
+using system_insight::server::QueryEngine;
+using system_insight::server::QueryEngineOptions;
+using system_insight::server::SeriesStore;
+using system_insight::server::TimeSeriesDb;
+using system_insight::server::TsdbOptions;
+using systeminsight::proto::MetricsReport;
+
+constexpr int kSeriesPerHost = 100;
+constexpr int64_t kIntervalMs = 60'000;
+constexpr int64_t kRangeMs = 3600'000;
+constexpr int64_t kStartMs = 1'700'000'000'000;
+
+size_t SeriesCount() {
+  const char* env = std::getenv("SYSTEM_INSIGHT_QUERY_BENCH_SERIES");
+  return env != nullptr ? std::strtoull(env, nullptr, 10) : 1'000'000;
+}
+
+QueryEngine& Engine() {
+  static QueryEngine* engine = [] {
+    TsdbOptions options;
+    options.retention_ms = 2 * kRangeMs;
+    options.memory_budget_bytes = size_t{8} << 30;
+    auto db = std::make_shared<TimeSeriesDb>(options, std::make_shared<SeriesStore>());
+
+    const size_t hosts = std::max<size_t>(SeriesCount() / kSeriesPerHost, 1);
+    MetricsReport report;
+    for (int k = 0; k < kSeriesPerHost; ++k) {
+      auto* sample = report.add_samples();
+      sample->set_name("metric_" + std::to_string(k % 10));
+      auto* label = sample->add_labels();
+      label->set_key("device");
+      label->set_value("dev" + std::to_string(k / 10));
+    }
+    for (int64_t t = kStartMs; t <= kStartMs + kRangeMs; t += kIntervalMs) {
+      for (size_t host = 0; host < hosts; ++host) {
+        report.set_host_id("host-" + std::to_string(host));
+        for (int k = 0; k < kSeriesPerHost; ++k) {
+          auto* sample = report.mutable_samples(k);
+          // 计数器式增长叠加少量抖动
+          sample->set_value(static_cast<double>((t - kStartMs) / 1000 * (k + 1) + host % 7));
+          sample->set_timestamp_ms(t);
+        }
+        db->Append(report);
+      }
+    }
+    return new QueryEngine(db, QueryEngineOptions{});
+  }();
+  return *engine;
+}
+
+void BM_QueryRange(benchmark::State& state) {
+  QueryEngine& engine = Engine();
+  systeminsight::proto::QueryRangeRequest request;
+  request.set_metric_name("metric_3");
+  request.set_start_ms(kStartMs);
+  request.set_end_ms(kStartMs + kRangeMs);
+  request.set_step_ms(5 * 60'000);
+  request.set_aggregation(static_cast<systeminsight::proto::QueryAggregation>(state.range(0)));
+  request.set_quantile(0.99);
+
+  uint64_t points = 0;
+  size_t series = 0;
+  for (auto _ : state) {
+    systeminsight::proto::QueryRangeResponse response;
+    std::string error;
+    engine.QueryRange(request, &response, &error);
+    points += response.points_scanned();
+    series = response.series_size();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(points));
+  state.counters["series"] = static_cast<double>(series);
+}
+BENCHMARK(BM_QueryRange)
+    ->Arg(systeminsight::proto::QUERY_AGGREGATION_AVG)
+    ->Arg(systeminsight::proto::QUERY_AGGREGATION_MAX)
+    ->Arg(systeminsight::proto::QUERY_AGGREGATION_RATE)
+    ->Arg(systeminsight::proto::QUERY_AGGREGATION_QUANTILE)
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+}  // namespace
+
+BENCHMARK_MAIN();
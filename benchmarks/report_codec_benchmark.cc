@@ -0,0 +1,148 @@
+// 对比行式与列式报告的编解码耗时和线上字节数。
+//
+//   ./build/benchmarks/report_codec_benchmark
+//
+// 每个用例的 bytes_per_report 计数器为序列化后的报告大小。
+
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "src/common/codec/columnar_codec.h"
+
+namespace {
+
+using system_insight::common::codec::ColumnarDecoder;
+using system_insight::common::codec::ColumnarEncoder;
+using systeminsight::proto::MetricsReport;
+
+constexpr int kCores = 64;
+
+// 模拟一次采集：整体 CPU + per-core CPU + 软中断 + 内存 + 网络，数值缓慢变化
+MetricsReport MakeReport(int cycle) {
+  MetricsReport report;
+  report.set_host_id("bench-host");
+  report.set_collector_version("system_insight_client");
+  const int64_t timestamp_ms = 1700000000000 + cycle * 5000;
+  auto add = [&](const std::string& name, double value, const char* core) {
+    auto* sample = report.add_samples();
+    sample->set_name(name);
+    sample->set_value(value);
+    sample->set_timestamp_ms(timestamp_ms);
+    if (core != nullptr) {
+      auto* label = sample->add_labels();
+      label->set_key("core");
+      label->set_value(core);
+    }
+  };
+
+  add("system.cpu.usage_percent", 20.0 + std::sin(cycle * 0.1) * 5.0, nullptr);
+  for (int i = 0; i < kCores; ++i) {
+    std::string core = "cpu" + std::to_string(i);
+    add("system.cpu.core.usage_percent", (i % 4 == 0) ? 0.0 : 15.0 + ((cycle + i) % 7), core.c_str());
+  }
+  const char* softirqs[] = {"hi", "timer", "net_tx", "net_rx", "tasklet", "sched", "rcu"};
+  for (const char* name : softirqs) {
+    add(std::string("system.softirq.") + name + "_per_sec", 1000.0 + (cycle % 3), nullptr);
+  }
+  add("system.mem.usage_percent", 42.5, nullptr);
+  add("system.mem.available_bytes", 8.0 * 1024 * 1024 * 1024, nullptr);
+  add("system.net.rx_bytes_per_sec", 125000.0 + cycle % 11, nullptr);
+  add("system.net.tx_bytes_per_sec", 64000.0 + cycle % 13, nullptr);
+  return report;
+}
+
+std::vector<MetricsReport> MakeReports() {
+  std::vector<MetricsReport> reports;
+  for (int cycle = 0; cycle < 64; ++cycle) {
+    reports.push_back(MakeReport(cycle));
+  }
+  return reports;
+}
+
+void BM_EncodeRow(benchmark::State& state) {
+  auto reports = MakeReports();
+  size_t bytes = 0;
+  size_t index = 0;
+  std::string wire;
+  for (auto _ : state) {
+    MetricsReport report = reports[index++ % reports.size()];
+    report.SerializeToString(&wire);
+    bytes += wire.size();
+  }
+  state.counters["bytes_per_report"] =
+      benchmark::Counter(static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_EncodeRow);
+
+void BM_EncodeColumnar(benchmark::State& state) {
+  auto encoding = static_cast<systeminsight::proto::ReportEncoding>(state.range(0));
+  auto reports = MakeReports();
+  ColumnarEncoder encoder(encoding);
+  size_t bytes = 0;
+  size_t index = 0;
+  std::string wire;
+  for (auto _ : state) {
+    MetricsReport report = reports[index++ % reports.size()];
+    encoder.Encode(&report);
+    report.SerializeToString(&wire);
+    bytes += wire.size();
+  }
+  state.counters["bytes_per_report"] =
+      benchmark::Counter(static_cast<double>(bytes), benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_EncodeColumnar)
+    ->Arg(systeminsight::proto::REPORT_ENCODING_COLUMNAR)
+    ->Arg(systeminsight::proto::REPORT_ENCODING_COLUMNAR_XOR);
+
+void BM_DecodeRow(benchmark::State& state) {
+  auto reports = MakeReports();
+  std::vector<std::string> wires;
+  for (const auto& report : reports) {
+    wires.push_back(report.SerializeAsString());
+  }
+  size_t index = 0;
+  for (auto _ : state) {
+    MetricsReport report;
+    report.ParseFromString(wires[index++ % wires.size()]);
+    benchmark::DoNotOptimize(report);
+  }
+}
+BENCHMARK(BM_DecodeRow);
+
+void BM_DecodeColumnar(benchmark::State& state) {
+  auto encoding = static_cast<systeminsight::proto::ReportEncoding>(state.range(0));
+  auto reports = MakeReports();
+  // 预先编码一条完整的报告链，解码时按顺序循环（回绕时重置解码器）
+  ColumnarEncoder encoder(encoding);
+  std::vector<std::string> wires;
+  for (auto report : reports) {
+    encoder.Encode(&report);
+    wires.push_back(report.SerializeAsString());
+  }
+  ColumnarDecoder decoder;
+  size_t index = 0;
+  for (auto _ : state) {
+    if (index % wires.size() == 0) {
+      state.PauseTiming();
+      decoder.Reset();
+      state.ResumeTiming();
+    }
+    MetricsReport report;
+    report.ParseFromString(wires[index++ % wires.size()]);
+    if (decoder.Decode(&report) != ColumnarDecoder::Status::kOk) {
+      state.SkipWithError("decode failed");
+      break;
+    }
+    benchmark::DoNotOptimize(report);
+  }
+}
+BENCHMARK(BM_DecodeColumnar)
+    ->Arg(systeminsight::proto::REPORT_ENCODING_COLUMNAR)
+    ->Arg(systeminsight::proto::REPORT_ENCODING_COLUMNAR_XOR);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,160 @@
+// 服务端接收一份报告（反序列化 → 解码 → 写入仓库与时序库）的堆分配次数与 CPU 开销。
+//
+//   ./build/benchmarks/server_ingest_alloc_benchmark
+//
+// 每次迭代接收一台主机的一份 50 个样本的报告，1000 台主机轮流上报，时间戳逐轮递增：
+// - BM_PooledRequest：请求反序列化进池化的 Arena 报告，连同槽位移交给入库流水线（当前实现）
+// - BM_FreshRequest：请求反序列化进新的堆上 MetricsReport，再复制一份写入存储（旧实现）
+// allocs_per_sample 为每个样本调用 operator new 的平均次数，cpu_per_sample 为每个样本的
+// CPU 时间（秒）。两者都包含在复用的缓冲区上重新序列化请求的开销（稳态下不分配）。
+
+#include <benchmark/benchmark.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "src/common/logging/logging.h"
+#include "src/server/metrics_service_impl.h"
+
+namespace {
+
+std::atomic<uint64_t> g_allocations{0};
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+  g_allocations.fetch_add(1, std::memory_order_relaxed);
+  if (void* ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+  throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+  std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept {
+  std::free(ptr);
+}
+
+namespace {
+
+using system_insight::server::MetricsRepository;
+using system_insight::server::MetricsServiceImpl;
+using system_insight::server::TimeSeriesDb;
+using system_insight::server::TsdbOptions;
+using systeminsight::proto::MetricsReport;
+
+constexpr int kSamplesPerReport = 50;
+constexpr size_t kHosts = 1000;
+constexpr int64_t kStartMs = 1'700'000'000'000;
+constexpr int64_t kIntervalMs = 10'000;
+
+/**
+ * @brief 轮流生成各主机的请求字节，报告对象与输出缓冲区都复用
+ */
+class RequestSource {
+ public:
+  RequestSource() : reports_(kHosts) {
+    for (size_t h = 0; h < kHosts; ++h) {
+      reports_[h].set_host_id("host-" + std::to_string(h));
+      for (int k = 0; k < kSamplesPerReport; ++k) {
+        auto* sample = reports_[h].add_samples();
+        sample->set_name("metric_" + std::to_string(k % 10));
+        auto* label = sample->add_labels();
+        label->set_key("device");
+        label->set_value("dev" + std::to_string(k / 10));
+      }
+    }
+  }
+
+  const std::string& Next() {
+    if (next_ == kHosts) {
+      next_ = 0;
+      timestamp_ms_ += kIntervalMs;
+    }
+    auto& report = reports_[next_++];
+    for (int k = 0; k < kSamplesPerReport; ++k) {
+      auto* sample = report.mutable_samples(k);
+      sample->set_value(static_cast<double>((timestamp_ms_ / 1000) % 100 + k));
+      sample->set_timestamp_ms(timestamp_ms_);
+    }
+    report.SerializeToString(&wire_);
+    return wire_;
+  }
+
+ private:
+  std::vector<MetricsReport> reports_;
+  std::string wire_;
+  size_t next_ = 0;
+  int64_t timestamp_ms_ = kStartMs;
+};
+
+std::shared_ptr<TimeSeriesDb> MakeTsdb(const std::shared_ptr<MetricsRepository>& repository) {
+  TsdbOptions options;
+  options.memory_budget_bytes = size_t{4} << 30;
+  return std::make_shared<TimeSeriesDb>(options, repository->shared_series_store());
+}
+
+void SetCounters(benchmark::State& state, uint64_t allocations) {
+  const double samples = static_cast<double>(state.iterations() * kSamplesPerReport);
+  state.SetItemsProcessed(static_cast<int64_t>(samples));
+  state.counters["allocs_per_sample"] = static_cast<double>(allocations) / samples;
+  state.counters["cpu_per_sample"] =
+      benchmark::Counter(samples, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+void BM_PooledRequest(benchmark::State& state) {
+  system_insight::common::logging::SetLogLevel("warn");
+  auto repository = std::make_shared<MetricsRepository>();
+  MetricsServiceImpl service(repository, 8, MakeTsdb(repository));
+  RequestSource source;
+  systeminsight::proto::ReportAck ack;
+
+  auto receive = [&] {
+    auto report = service.AcquireReport();
+    report->report()->ParseFromString(source.Next());
+    ack.Clear();
+    service.HandleReport(std::move(report), &ack, nullptr);
+  };
+  // 预热：每台主机的序列、槽位与字符串容量达到稳态
+  for (size_t i = 0; i < 2 * kHosts; ++i) receive();
+
+  const uint64_t before = g_allocations.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    receive();
+  }
+  SetCounters(state, g_allocations.load(std::memory_order_relaxed) - before);
+}
+BENCHMARK(BM_PooledRequest);
+
+void BM_FreshRequest(benchmark::State& state) {
+  system_insight::common::logging::SetLogLevel("warn");
+  auto repository = std::make_shared<MetricsRepository>();
+  auto tsdb = MakeTsdb(repository);
+  RequestSource source;
+
+  auto receive = [&] {
+    auto request = std::make_unique<MetricsReport>();
+    request->ParseFromString(source.Next());
+    // 请求消息只读，解码与入队前先复制
+    MetricsReport report = *request;
+    repository->UpdateReport(report);
+    tsdb->Append(report);
+  };
+  for (size_t i = 0; i < 2 * kHosts; ++i) receive();
+
+  const uint64_t before = g_allocations.load(std::memory_order_relaxed);
+  for (auto _ : state) {
+    receive();
+  }
+  SetCounters(state, g_allocations.load(std::memory_order_relaxed) - before);
+}
+BENCHMARK(BM_FreshRequest);
+
+}  // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,53 @@
+#include "src/client/adaptive_interval.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace system_insight {
+namespace client {
+
+AdaptiveInterval::AdaptiveInterval(const AdaptiveIntervalOptions& options,
+                                   std::chrono::milliseconds initial)
+    : options_(options) {
+  options_.min_interval = std::max(options_.min_interval, std::chrono::milliseconds(1));
+  options_.max_interval = std::max(options_.max_interval, options_.min_interval);
+  current_ = std::clamp(initial, options_.min_interval, options_.max_interval);
+}
+
+bool AdaptiveInterval::RateChanged(double previous, double current, double floor, double ratio) {
+  return std::fabs(current - previous) > ratio * std::max(previous, floor);
+}
+
+bool AdaptiveInterval::Active(const ActivitySignals& signals) const {
+  if (signals.has_cpu && previous_.has_cpu &&
+      std::fabs(signals.cpu_usage_percent - previous_.cpu_usage_percent) >
+          options_.cpu_change_percent) {
+    return true;
+  }
+  if (signals.has_softirq && previous_.has_softirq &&
+      RateChanged(previous_.softirq_per_sec, signals.softirq_per_sec,
+                  options_.softirq_floor_per_sec, options_.rate_change_ratio)) {
+    return true;
+  }
+  if (signals.has_net && previous_.has_net &&
+      RateChanged(previous_.net_bytes_per_sec, signals.net_bytes_per_sec,
+                  options_.net_floor_bytes_per_sec, options_.rate_change_ratio)) {
+    return true;
+  }
+  return false;
+}
+
+std::chrono::milliseconds AdaptiveInterval::Update(const ActivitySignals& signals) {
+  if (has_previous_) {
+    const double factor = Active(signals) ? options_.tighten_factor : options_.backoff_factor;
+    auto next = std::chrono::milliseconds(
+        static_cast<int64_t>(std::llround(static_cast<double>(current_.count()) * factor)));
+    current_ = std::clamp(next, options_.min_interval, options_.max_interval);
+  }
+  previous_ = signals;
+  has_previous_ = true;
+  return current_;
+}
+
+}  // namespace client
+}  // namespace system_insight
@@ -0,0 +1,62 @@
+#ifndef SYSTEM_INSIGHT_CLIENT_ADAPTIVE_INTERVAL_H_
+#define SYSTEM_INSIGHT_CLIENT_ADAPTIVE_INTERVAL_H_
+
+#include <chrono>
+
+#include "src/client/metrics/activity_signals.h"
+
+namespace system_insight {
+namespace client {
+
+/**
+ * @brief 自适应采集周期配置
+ */
+struct AdaptiveIntervalOptions {
+  std::chrono::milliseconds min_interval{1000};
+  std::chrono::milliseconds max_interval{30000};
+
+  // CPU 使用率相邻两次变化超过该百分点数视为活跃
+  double cpu_change_percent = 10.0;
+  // 软中断 / 网络速率相对变化超过该比例视为活跃
+  double rate_change_ratio = 0.5;
+  // 计算相对变化时的速率下限，避免低速率下的抖动被放大
+  double softirq_floor_per_sec = 1000.0;
+  double net_floor_bytes_per_sec = 64.0 * 1024.0;
+
+  double backoff_factor = 1.25;  // 平稳时每周期放大的倍数
+  double tighten_factor = 0.5;   // 活跃时每周期缩小的倍数
+};
+
+/**
+ * @brief 按系统活跃度调整采集周期
+ *
+ * 比较相邻两个周期的活跃度信号：任一信号变化超过阈值时按 tighten_factor
+ * 快速缩短周期，否则按 backoff_factor 逐步放大，始终限制在 [min, max] 内。
+ * 空闲或负载稳定的主机因此逐渐退到长周期，负载突变时很快回到短周期。
+ */
+class AdaptiveInterval {
+ public:
+  AdaptiveInterval(const AdaptiveIntervalOptions& options, std::chrono::milliseconds initial);
+
+  /**
+   * @brief 根据本周期的信号更新周期
+   * @return 下一次采集前应等待的周期
+   */
+  std::chrono::milliseconds Update(const ActivitySignals& signals);
+
+  std::chrono::milliseconds current() const { return current_; }
+
+ private:
+  bool Active(const ActivitySignals& signals) const;
+  static bool RateChanged(double previous, double current, double floor, double ratio);
+
+  AdaptiveIntervalOptions options_;
+  std::chrono::milliseconds current_;
+  ActivitySignals previous_;
+  bool has_previous_ = false;
+};
+
+}  // namespace client
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_CLIENT_ADAPTIVE_INTERVAL_H_
@@ -0,0 +1,194 @@
+#include "src/client/agent_telemetry.h"
+
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace system_insight {
+namespace client {
+
+namespace {
+
+const std::string kCollectorWallUsTotal = "system_insight.agent.collector_wall_us_total";
+const std::string kCollectorCpuUsTotal = "system_insight.agent.collector_cpu_us_total";
+const std::string kCollectorSamplesTotal = "system_insight.agent.collector_samples_total";
+const std::string kReportBytesBucket = "system_insight.agent.report_bytes_bucket";
+const std::string kReportBytesSum = "system_insight.agent.report_bytes_sum";
+const std::string kReportBytesCount = "system_insight.agent.report_bytes_count";
+const std::string kSendLatencyUsBucket = "system_insight.agent.send_latency_us_bucket";
+const std::string kSendLatencyUsSum = "system_insight.agent.send_latency_us_sum";
+const std::string kSendLatencyUsCount = "system_insight.agent.send_latency_us_count";
+const std::string kSendFailuresTotal = "system_insight.agent.send_failures_total";
+const std::string kRssBytes = "system_insight.agent.rss_bytes";
+
+const std::string kCollectorLabel = "collector";
+const std::string kLeLabel = "le";
+const std::string kInfLabel = "+Inf";
+const std::array<std::string, AgentTelemetry::kCollectorCount> kCollectorNames = {
+    "cpu", "mem", "net", "fs", "cpufreq"};
+
+std::chrono::nanoseconds ThreadCpuTime() {
+  timespec ts{};
+  if (::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return std::chrono::nanoseconds(0);
+  }
+  return std::chrono::seconds(ts.tv_sec) + std::chrono::nanoseconds(ts.tv_nsec);
+}
+
+systeminsight::proto::MetricSample* AddSample(const std::string& name, double value,
+                                              int64_t timestamp_ms,
+                                              systeminsight::proto::MetricsReport* report) {
+  auto* sample = report->add_samples();
+  sample->set_name(name);
+  sample->set_value(value);
+  sample->set_timestamp_ms(timestamp_ms);
+  return sample;
+}
+
+void AddLabel(const std::string& key, const std::string& value,
+              systeminsight::proto::MetricSample* sample) {
+  auto* label = sample->add_labels();
+  label->set_key(key);
+  label->set_value(value);
+}
+
+}  // namespace
+
+AgentTelemetry::AgentTelemetry() {
+  histogram_exports_[0] = {&kReportBytesBucket,
+                           &kReportBytesSum,
+                           &kReportBytesCount,
+                           &report_bytes_,
+                           {256, 1024, 4096, 16384, 65536, 262144, 1048576},
+                           {}};
+  histogram_exports_[1] = {&kSendLatencyUsBucket,
+                           &kSendLatencyUsSum,
+                           &kSendLatencyUsCount,
+                           &send_latency_us_,
+                           {250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000,
+                            1000000, 5000000},
+                           {}};
+  for (auto& histogram : histogram_exports_) {
+    for (uint64_t bound : histogram.upper_bounds) {
+      histogram.le_labels.push_back(std::to_string(bound));
+    }
+    histogram.le_labels.push_back(kInfLabel);
+  }
+  long page_size = ::sysconf(_SC_PAGESIZE);
+  if (page_size > 0) {
+    page_size_ = static_cast<uint64_t>(page_size);
+  }
+}
+
+void AgentTelemetry::RecordCollector(Collector collector, std::chrono::nanoseconds wall,
+                                     std::chrono::nanoseconds cpu, uint64_t samples) {
+  auto& cost = collectors_[collector];
+  cost.wall_ns.Add(static_cast<uint64_t>(std::max<int64_t>(wall.count(), 0)));
+  cost.cpu_ns.Add(static_cast<uint64_t>(std::max<int64_t>(cpu.count(), 0)));
+  cost.samples.Add(samples);
+}
+
+void AgentTelemetry::RecordPayloadBytes(size_t bytes) {
+  report_bytes_.Observe(bytes);
+}
+
+void AgentTelemetry::RecordSend(bool ok, std::chrono::steady_clock::duration latency) {
+  if (!ok) {
+    send_failures_.Add(1);
+    return;
+  }
+  auto latency_us = std::chrono::duration_cast<std::chrono::microseconds>(latency).count();
+  send_latency_us_.Observe(static_cast<uint64_t>(std::max<int64_t>(latency_us, 0)));
+}
+
+void AgentTelemetry::AppendHistogram(const HistogramExport& histogram, int64_t timestamp_ms,
+                                     systeminsight::proto::MetricsReport* report) {
+  histogram.histogram->Read(&snapshot_);
+  const auto append_bucket = [&](size_t bound, uint64_t cumulative) {
+    auto* sample = AddSample(*histogram.bucket_name, static_cast<double>(cumulative),
+                             timestamp_ms, report);
+    AddLabel(kLeLabel, histogram.le_labels[bound], sample);
+  };
+  size_t bound = 0;
+  uint64_t cumulative = 0;
+  for (size_t i = 0; i < snapshot_.counts.size(); ++i) {
+    if (snapshot_.counts[i] == 0) continue;
+    // 桶内的最大取值；最高的桶超出 uint64 范围，用 double 比较
+    const double top = static_cast<double>(sdk::Histogram::BucketLowerBound(i)) +
+                       sdk::Histogram::BucketWidth(i) - 1;
+    for (; bound < histogram.upper_bounds.size() &&
+           top > static_cast<double>(histogram.upper_bounds[bound]);
+         ++bound) {
+      append_bucket(bound, cumulative);
+    }
+    cumulative += snapshot_.counts[i];
+  }
+  for (; bound < histogram.upper_bounds.size(); ++bound) {
+    append_bucket(bound, cumulative);
+  }
+  append_bucket(histogram.upper_bounds.size(), snapshot_.count);
+  AddSample(*histogram.sum_name, static_cast<double>(snapshot_.sum), timestamp_ms, report);
+  AddSample(*histogram.count_name, static_cast<double>(snapshot_.count), timestamp_ms, report);
+}
+
+bool AgentTelemetry::ReadRssBytes(uint64_t* rss_bytes) {
+  // /proc/self/statm: size resident shared text lib data dt（单位为页）
+  std::string_view content;
+  if (!statm_reader_.Read(&content)) return false;
+  uint64_t size_pages = 0;
+  uint64_t resident_pages = 0;
+  if (!ParseUint64(&content, &size_pages) || !ParseUint64(&content, &resident_pages)) {
+    return false;
+  }
+  *rss_bytes = resident_pages * page_size_;
+  return true;
+}
+
+void AgentTelemetry::AppendSamples(int64_t timestamp_ms,
+                                   systeminsight::proto::MetricsReport* report) {
+  for (int i = 0; i < kCollectorCount; ++i) {
+    const auto& cost = collectors_[i];
+    AddLabel(kCollectorLabel, kCollectorNames[i],
+             AddSample(kCollectorWallUsTotal, static_cast<double>(cost.wall_ns.Value()) / 1000.0,
+                       timestamp_ms, report));
+    AddLabel(kCollectorLabel, kCollectorNames[i],
+             AddSample(kCollectorCpuUsTotal, static_cast<double>(cost.cpu_ns.Value()) / 1000.0,
+                       timestamp_ms, report));
+    AddLabel(kCollectorLabel, kCollectorNames[i],
+             AddSample(kCollectorSamplesTotal, static_cast<double>(cost.samples.Value()),
+                       timestamp_ms, report));
+  }
+  for (const auto& histogram : histogram_exports_) {
+    AppendHistogram(histogram, timestamp_ms, report);
+  }
+  AddSample(kSendFailuresTotal, static_cast<double>(send_failures_.Value()), timestamp_ms,
+            report);
+  uint64_t rss_bytes = 0;
+  if (ReadRssBytes(&rss_bytes)) {
+    AddSample(kRssBytes, static_cast<double>(rss_bytes), timestamp_ms, report);
+  }
+}
+
+ScopedCollectorTimer::ScopedCollectorTimer(AgentTelemetry* telemetry,
+                                           AgentTelemetry::Collector collector,
+                                           const systeminsight::proto::MetricsReport* report)
+    : telemetry_(telemetry), collector_(collector), report_(report) {
+  if (!telemetry_) return;
+  samples_before_ = report_->samples_size();
+  wall_start_ = std::chrono::steady_clock::now();
+  cpu_start_ = ThreadCpuTime();
+}
+
+ScopedCollectorTimer::~ScopedCollectorTimer() {
+  if (!telemetry_) return;
+  auto wall = std::chrono::steady_clock::now() - wall_start_;
+  auto cpu = ThreadCpuTime() - cpu_start_;
+  int produced = std::max(report_->samples_size() - samples_before_, 0);
+  telemetry_->RecordCollector(collector_,
+                              std::chrono::duration_cast<std::chrono::nanoseconds>(wall), cpu,
+                              static_cast<uint64_t>(produced));
+}
+
+}  // namespace client
+}  // namespace system_insight
@@ -0,0 +1,112 @@
+#ifndef SYSTEM_INSIGHT_CLIENT_AGENT_TELEMETRY_H_
+#define SYSTEM_INSIGHT_CLIENT_AGENT_TELEMETRY_H_
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "src/client/metrics/proc_file_reader.h"
+#include "src/sdk/metrics.h"
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace client {
+
+/**
+ * @brief 客户端自身开销的遥测
+ *
+ * 采集线程与发送线程在热路径上只对 SDK 的分片计数器与直方图（sdk::Counter /
+ * sdk::Histogram）做原子加，不加锁；上报时由 AppendSamples() 汇总各分片，以 system_insight.agent.* 样本追加到报告：
+ * - collector_wall_us_total / collector_cpu_us_total / collector_samples_total：
+ *   按 collector 标签区分的墙钟时间、线程 CPU 时间（CLOCK_THREAD_CPUTIME_ID）与产出样本数
+ * - report_bytes_*：序列化后线上报告大小的直方图
+ * - send_latency_us_*：上报 RPC 延迟的直方图（含流模式的 ack 往返）
+ * - send_failures_total、rss_bytes
+ *
+ * 直方图按 Prometheus 约定输出 <name>_bucket{le=...}（累计）、<name>_sum 与 <name>_count。
+ * 对数线性桶整体不超过某个 le 上界时才计入该上界，跨越上界的桶计入下一个上界，
+ * 误差不超过一个桶宽（12.5%）。
+ * Record* 可以从任意线程调用；AppendSamples() 只能由一个线程调用。
+ */
+class AgentTelemetry {
+ public:
+  enum Collector {
+    kCollectorCpu,
+    kCollectorMem,
+    kCollectorNet,
+    kCollectorFs,
+    kCollectorCpuFreq,
+    kCollectorCount
+  };
+
+  AgentTelemetry();
+
+  void RecordCollector(Collector collector, std::chrono::nanoseconds wall,
+                       std::chrono::nanoseconds cpu, uint64_t samples);
+  void RecordPayloadBytes(size_t bytes);
+  void RecordSend(bool ok, std::chrono::steady_clock::duration latency);
+
+  void AppendSamples(int64_t timestamp_ms, systeminsight::proto::MetricsReport* report);
+
+ private:
+  struct CollectorCost {
+    sdk::Counter wall_ns;
+    sdk::Counter cpu_ns;
+    sdk::Counter samples;
+  };
+
+  struct HistogramExport {
+    const std::string* bucket_name;
+    const std::string* sum_name;
+    const std::string* count_name;
+    const sdk::Histogram* histogram;
+    std::vector<uint64_t> upper_bounds;  // 导出的 le 上界，递增
+    std::vector<std::string> le_labels;  // 预先格式化的上界，最后一项为 +Inf
+  };
+
+  void AppendHistogram(const HistogramExport& histogram, int64_t timestamp_ms,
+                       systeminsight::proto::MetricsReport* report);
+  bool ReadRssBytes(uint64_t* rss_bytes);
+
+  std::array<CollectorCost, kCollectorCount> collectors_;
+  sdk::Histogram report_bytes_;
+  sdk::Histogram send_latency_us_;
+  sdk::Counter send_failures_;
+
+  // 以下只由 AppendSamples() 使用
+  std::array<HistogramExport, 2> histogram_exports_;
+  sdk::Histogram::Snapshot snapshot_;
+  ProcFileReader statm_reader_{"/proc/self/statm", 256};
+  uint64_t page_size_ = 4096;
+};
+
+/**
+ * @brief 统计一次采集调用的墙钟时间、线程 CPU 时间和新增样本数
+ *
+ * telemetry 为空时不做任何事。
+ */
+class ScopedCollectorTimer {
+ public:
+  ScopedCollectorTimer(AgentTelemetry* telemetry, AgentTelemetry::Collector collector,
+                       const systeminsight::proto::MetricsReport* report);
+  ~ScopedCollectorTimer();
+
+  ScopedCollectorTimer(const ScopedCollectorTimer&) = delete;
+  ScopedCollectorTimer& operator=(const ScopedCollectorTimer&) = delete;
+
+ private:
+  AgentTelemetry* telemetry_;
+  AgentTelemetry::Collector collector_;
+  const systeminsight::proto::MetricsReport* report_;
+  int samples_before_ = 0;
+  std::chrono::steady_clock::time_point wall_start_;
+  std::chrono::nanoseconds cpu_start_{0};
+};
+
+}  // namespace client
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_CLIENT_AGENT_TELEMETRY_H_
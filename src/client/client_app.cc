@@ -1,8 +1,12 @@
 #include "src/client/client_app.h"
 
+#include <algorithm>
 #include <chrono>
+#include <memory>
+#include <string>
 #include <thread>
 
+#include "src/common/codec/columnar_codec.h"
 #include "src/common/logging/logging.h"
 
 namespace system_insight {
@@ -14,32 +18,246 @@ void ClientApp::RequestStop() {
   should_exit_.store(true);
 }
 
+namespace {
+
+// 与采集器一致，指标名使用 std::string 常量以复用报告中已有的字符串容量
+const std::string kSendQueueDepth = "system_insight.agent.send_queue_depth";
+const std::string kSendInFlight = "system_insight.agent.send_in_flight";
+const std::string kReportsDroppedTotal = "system_insight.agent.reports_dropped_total";
+const std::string kReportsCoalescedTotal = "system_insight.agent.reports_coalesced_total";
+const std::string kSpoolReports = "system_insight.agent.spool_reports";
+const std::string kSpoolBytes = "system_insight.agent.spool_bytes";
+const std::string kCollectionIntervalMs = "system_insight.agent.collection_interval_ms";
+
+// 等待下一次采集时每隔这么久检查一次退出标记，长采集周期下也能及时退出
+constexpr std::chrono::milliseconds kStopCheckInterval(100);
+
+void AppendAgentSample(const std::string& name, double value, int64_t timestamp_ms,
+                       systeminsight::proto::MetricsReport* report) {
+  auto* sample = report->add_samples();
+  sample->set_name(name);
+  sample->set_value(value);
+  sample->set_timestamp_ms(timestamp_ms);
+}
+
+// 发送线程状态、当前生效的采集周期与自身开销遥测随下一份报告一起上报
+void AppendAgentStats(const ReportSenderStats& stats, std::chrono::milliseconds interval,
+                      AgentTelemetry* telemetry, systeminsight::proto::MetricsReport* report) {
+  int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::system_clock::now().time_since_epoch())
+                       .count();
+  AppendAgentSample(kSendQueueDepth, stats.queue_depth, now_ms, report);
+  AppendAgentSample(kSendInFlight, stats.in_flight, now_ms, report);
+  AppendAgentSample(kReportsDroppedTotal,
+                    static_cast<double>(stats.dropped_total + stats.spool_dropped_total), now_ms,
+                    report);
+  // 合并的报告数据并未丢失，单独计数
+  AppendAgentSample(kReportsCoalescedTotal, static_cast<double>(stats.coalesced_total), now_ms,
+                    report);
+  AppendAgentSample(kSpoolReports, static_cast<double>(stats.spool_reports), now_ms, report);
+  AppendAgentSample(kSpoolBytes, static_cast<double>(stats.spool_bytes), now_ms, report);
+  AppendAgentSample(kCollectionIntervalMs, static_cast<double>(interval.count()), now_ms, report);
+  telemetry->AppendSamples(now_ms, report);
+}
+
+}  // namespace
+
+void ClientApp::SleepUntil(std::chrono::steady_clock::time_point deadline) const {
+  while (!should_exit_.load()) {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= deadline) return;
+    std::this_thread::sleep_until(std::min(deadline, now + kStopCheckInterval));
+  }
+}
+
 int ClientApp::Run() {
+  // 采集线程与发送线程共享，需比二者活得更久
+  AgentTelemetry telemetry;
   auto channel = grpc::CreateChannel(config_.target, grpc::InsecureChannelCredentials());
-  MetricsClient client(channel);
+  MetricsClientOptions client_options;
+  if (!common::codec::ParseReportEncoding(config_.report_encoding,
+                                          &client_options.preferred_encoding)) {
+    LOGW("Unknown report_encoding '{}', falling back to row", config_.report_encoding);
+  }
+  client_options.use_streaming = config_.use_streaming;
+  client_options.stream.reconnect_backoff_min_ms = config_.stream_reconnect_backoff_min_ms;
+  client_options.stream.reconnect_backoff_max_ms = config_.stream_reconnect_backoff_max_ms;
+  client_options.stream.credit_wait_ms = config_.stream_credit_wait_ms;
+  client_options.max_in_flight = config_.max_in_flight;
+  client_options.send_timeout_ms = config_.send_timeout_ms;
+  client_options.telemetry = &telemetry;
+
+  ReportSenderOptions sender_options;
+  sender_options.queue_capacity = static_cast<size_t>(std::max(config_.send_queue_capacity, 1));
+  sender_options.max_in_flight = config_.max_in_flight;
+  if (!ParseOverflowPolicy(config_.send_queue_overflow_policy, &sender_options.overflow_policy)) {
+    LOGW("Unknown send_queue_overflow_policy '{}', falling back to drop_oldest",
+         config_.send_queue_overflow_policy);
+  }
+  sender_options.spool_directory = config_.spool_directory;
+  sender_options.spool_max_bytes = static_cast<uint64_t>(std::max(config_.spool_max_mb, 1)) << 20;
+  sender_options.replay_max_per_second = config_.replay_max_reports_per_second;
+  sender_options.telemetry = &telemetry;
+  // 队列、在途与正在采集的报告都来自同一个池，稳态下槽位循环复用
+  common::codec::ReportPool pool(sender_options.queue_capacity +
+                                 static_cast<size_t>(config_.max_in_flight) + 2);
+  ReportSender sender(std::make_unique<MetricsClient>(channel, client_options), &pool,
+                      sender_options);
+  sender.Start();
   
   // 构建采集器配置
   CollectorConfig collector_config;
   collector_config.use_mmap = config_.use_mmap;
   collector_config.mmap_cpu_device_path = config_.mmap_cpu_device_path;
   collector_config.mmap_softirq_device_path = config_.mmap_softirq_device_path;
+  collector_config.filesystem_enabled = config_.filesystem_enabled;
+  collector_config.filesystem.include_fstypes = config_.filesystem_include_fstypes;
+  if (!config_.filesystem_exclude_fstypes.empty()) {
+    collector_config.filesystem.exclude_fstypes = config_.filesystem_exclude_fstypes;
+  }
+  if (!config_.filesystem_exclude_mount_points.empty()) {
+    collector_config.filesystem.exclude_mount_points = config_.filesystem_exclude_mount_points;
+  }
+  collector_config.filesystem.network_spread_cycles = config_.filesystem_network_spread_cycles;
+  collector_config.extended_memory_enabled = config_.extended_memory_enabled;
+  if (!config_.memory_meminfo_keys.empty()) {
+    collector_config.memory.meminfo_keys = config_.memory_meminfo_keys;
+  }
+  if (!config_.memory_vmstat_keys.empty()) {
+    collector_config.memory.vmstat_keys = config_.memory_vmstat_keys;
+  }
+  collector_config.cpufreq_enabled = config_.cpufreq_enabled;
   
-  SystemMetricsCollector collector(collector_config);
+  SystemMetricsCollector collector(collector_config, &telemetry);
   
-  LOGI("Client loop started: target={}, interval_ms={}, use_mmap={}", 
-       config_.target, config_.collection_interval_ms, config_.use_mmap);
+  // sample_interval_ms 小于上报周期时启用窗口聚合：高频采样，每个上报周期发送一次汇总
+  const bool aggregate = config_.sample_interval_ms > 0 &&
+                         config_.sample_interval_ms < config_.collection_interval_ms;
+  const std::chrono::milliseconds report_interval(config_.collection_interval_ms);
+  std::chrono::milliseconds sample_interval(
+      aggregate ? config_.sample_interval_ms : config_.collection_interval_ms);
+  WindowAggregator aggregator;
+  systeminsight::proto::MetricsReport window_samples;  // 单次采样的暂存，循环复用
+
+  std::unique_ptr<DeadbandFilter> deadband;
+  uint64_t reports_lost = 0;
+  if (config_.deadband_enabled) {
+    DeadbandOptions deadband_options;
+    deadband_options.absolute = config_.deadband_absolute;
+    deadband_options.relative = config_.deadband_relative;
+    deadband_options.max_silence =
+        std::chrono::milliseconds(std::max(config_.deadband_max_silence_ms, 0));
+    deadband = std::make_unique<DeadbandFilter>(deadband_options);
+    LOGI("Deadband filtering enabled: absolute={}, relative={}, max_silence_ms={}",
+         deadband_options.absolute, deadband_options.relative,
+         deadband_options.max_silence.count());
+  }
+
+  // 自适应采集周期只调整逐次上报的采集节拍；窗口聚合模式下采样与上报周期保持固定
+  std::unique_ptr<AdaptiveInterval> adaptive;
+  if (config_.adaptive_interval_enabled && aggregate) {
+    LOGW("adaptive_interval_enabled is ignored while sample_interval_ms aggregation is active");
+  } else if (config_.adaptive_interval_enabled) {
+    AdaptiveIntervalOptions adaptive_options;
+    adaptive_options.min_interval =
+        std::chrono::milliseconds(config_.min_collection_interval_ms);
+    adaptive_options.max_interval =
+        std::chrono::milliseconds(config_.max_collection_interval_ms);
+    adaptive = std::make_unique<AdaptiveInterval>(adaptive_options, sample_interval);
+    sample_interval = adaptive->current();
+    LOGI("Adaptive collection interval enabled: min_ms={}, max_ms={}",
+         config_.min_collection_interval_ms, config_.max_collection_interval_ms);
+  }
+
+  std::unique_ptr<ShmIngestor> shm_ingestor;
+  if (config_.shm_ingestion_enabled) {
+    ShmIngestorOptions shm_options;
+    shm_options.directory = config_.shm_directory;
+    shm_ingestor = std::make_unique<ShmIngestor>(shm_options);
+    LOGI("Shared memory metrics ingestion enabled: directory={}", shm_options.directory);
+  }
+
+  std::unique_ptr<TextfileCollector> textfile;
+  if (!config_.textfile_directory.empty()) {
+    TextfileCollectorOptions textfile_options;
+    textfile_options.directory = config_.textfile_directory;
+    textfile = std::make_unique<TextfileCollector>(textfile_options);
+  }
 
+  LOGI("Client loop started: target={}, interval_ms={}, sample_interval_ms={}, use_mmap={}, "
+       "streaming={}",
+       config_.target, config_.collection_interval_ms, sample_interval.count(), config_.use_mmap,
+       config_.use_streaming);
+
+  auto next_sample = std::chrono::steady_clock::now();
+  auto window_end = next_sample + report_interval;
   while (!should_exit_.load()) {
-    auto samples = collector.Collect();
-    if (!samples.empty()) {
-      if (!client.SendReport(config_.host_id, "system_insight_client", samples)) {
-        LOGW("Failed to send metrics batch");
+    common::codec::PooledReport slot;
+    if (aggregate) {
+      collector.Collect(&window_samples);
+      aggregator.Add(window_samples);
+      window_samples.Clear();
+      auto now = std::chrono::steady_clock::now();
+      if (now >= window_end) {
+        slot = pool.Acquire();
+        aggregator.Flush(slot->report());
+        window_end += report_interval;
+        if (window_end <= now) {
+          window_end = now + report_interval;
+        }
+      }
+    } else {
+      slot = pool.Acquire();
+      collector.Collect(slot->report());
+      if (adaptive) {
+        sample_interval = adaptive->Update(collector.activity());
+      }
+    }
+
+    if (slot && slot->report()->samples_size() > 0) {
+      auto* report = slot->report();
+      report->set_host_id(config_.host_id);
+      report->set_collector_version("system_insight_client");
+      if (shm_ingestor || textfile) {
+        int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::system_clock::now().time_since_epoch())
+                             .count();
+        if (shm_ingestor) {
+          shm_ingestor->Drain(now_ms, report);
+        }
+        if (textfile) {
+          textfile->Append(now_ms, report);
+        }
+      }
+      const ReportSenderStats stats = sender.GetStats();
+      if (deadband) {
+        // 有报告被丢弃、发送失败或因服务端要求完整报告被拒时，其中的变化可能没有到达
+        // 服务端，改发一份完整报告重新同步
+        const uint64_t lost =
+            stats.dropped_total + stats.failed_total + stats.full_report_requests_total;
+        if (lost != reports_lost) {
+          reports_lost = lost;
+          deadband->RequestFull();
+        }
+        deadband->Filter(report, std::chrono::steady_clock::now());
       }
+      // 客户端自身状态不过滤，即使所有样本都未变化也照常发送，服务端据此确认主机在线
+      AppendAgentStats(stats, aggregate ? report_interval : sample_interval, &telemetry,
+                       report);
+      sender.Enqueue(std::move(slot));
+    }
+
+    // 按固定节拍采样；落后（例如进程被挂起）时不追赶
+    next_sample += sample_interval;
+    auto now = std::chrono::steady_clock::now();
+    if (next_sample < now) {
+      next_sample = now;
     }
-    std::this_thread::sleep_for(std::chrono::milliseconds(config_.collection_interval_ms));
+    SleepUntil(next_sample);
   }
 
   LOGI("Client loop exiting");
+  sender.Stop();
   return 0;
 }
 
@@ -2,12 +2,19 @@
 #define SYSTEM_INSIGHT_CLIENT_CLIENT_APP_H_
 
 #include <atomic>
+#include <chrono>
 #include <memory>
 #include <string>
 
 #include "grpcpp/grpcpp.h"
+#include "src/client/adaptive_interval.h"
+#include "src/client/deadband_filter.h"
 #include "src/client/metrics_client.h"
+#include "src/client/report_sender.h"
+#include "src/client/shm_ingestor.h"
 #include "src/client/system_metrics_collector.h"
+#include "src/client/textfile_collector.h"
+#include "src/client/window_aggregator.h"
 #include "src/common/config/config_loader.h"
 
 namespace system_insight {
@@ -21,6 +28,9 @@ class ClientApp {
   void RequestStop();
 
  private:
+  // 分段睡眠，期间收到退出请求时立即返回
+  void SleepUntil(std::chrono::steady_clock::time_point deadline) const;
+
   common::config::ClientConfig config_;
   std::atomic<bool> should_exit_{false};
 };
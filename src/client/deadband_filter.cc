@@ -0,0 +1,85 @@
+#include "src/client/deadband_filter.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "src/common/codec/columnar_codec.h"
+
+namespace system_insight {
+namespace client {
+
+DeadbandFilter::DeadbandFilter(const DeadbandOptions& options) : options_(options) {
+  options_.absolute = std::max(options_.absolute, 0.0);
+  options_.relative = std::max(options_.relative, 0.0);
+}
+
+DeadbandFilter::SeriesState* DeadbandFilter::FindOrCreate(
+    const systeminsight::proto::MetricSample& sample, size_t position, bool* created) {
+  common::codec::BuildSeriesKey(sample.name(), sample.labels(), &key_);
+  *created = false;
+
+  if (position < order_.size() && series_[order_[position]].key == key_) {
+    return &series_[order_[position]];
+  }
+
+  size_t slot = 0;
+  auto it = index_.find(key_);
+  if (it != index_.end()) {
+    slot = it->second;
+  } else {
+    slot = series_.size();
+    series_.push_back(SeriesState{key_, sample.value()});
+    index_.emplace(key_, slot);
+    *created = true;
+  }
+
+  if (position >= order_.size()) {
+    order_.resize(position + 1);
+  }
+  order_[position] = slot;
+  return &series_[slot];
+}
+
+bool DeadbandFilter::Changed(double last_sent, double value) const {
+  if (std::isnan(last_sent) || std::isnan(value)) {
+    return std::isnan(last_sent) != std::isnan(value);
+  }
+  const double threshold = std::max(options_.absolute, options_.relative * std::fabs(last_sent));
+  return std::fabs(value - last_sent) > threshold;
+}
+
+void DeadbandFilter::Filter(systeminsight::proto::MetricsReport* report,
+                            std::chrono::steady_clock::time_point now) {
+  const bool full = !has_full_ || now - last_full_ >= options_.max_silence;
+  if (full) {
+    has_full_ = true;
+    last_full_ = now;
+  }
+
+  auto* samples = report->mutable_samples();
+  const int count = samples->size();
+  int kept = 0;
+  for (int i = 0; i < count; ++i) {
+    const auto& sample = samples->Get(i);
+    bool created = false;
+    SeriesState* series = FindOrCreate(sample, static_cast<size_t>(i), &created);
+    if (!full && !created && !Changed(series->last_sent, sample.value())) {
+      continue;
+    }
+    series->last_sent = sample.value();
+    if (kept != i) {
+      samples->SwapElements(kept, i);
+    }
+    ++kept;
+  }
+
+  // RemoveLast 保留已清空的元素供下次复用，不释放内存
+  suppressed_total_ += static_cast<uint64_t>(count - kept);
+  while (samples->size() > kept) {
+    samples->RemoveLast();
+  }
+  report->set_delta(!full);
+}
+
+}  // namespace client
+}  // namespace system_insight
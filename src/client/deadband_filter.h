@@ -0,0 +1,82 @@
+#ifndef SYSTEM_INSIGHT_CLIENT_DEADBAND_FILTER_H_
+#define SYSTEM_INSIGHT_CLIENT_DEADBAND_FILTER_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace client {
+
+/**
+ * @brief 死区过滤配置
+ */
+struct DeadbandOptions {
+  double absolute = 0.0;  // 与上次发送值之差不超过该值时不发送
+  double relative = 0.0;  // 相对上次发送值的比例阈值，例如 0.01 表示 1%
+  // 至少每隔这么久发送一份完整报告；服务端据此清理消失的序列、重启后恢复完整状态
+  std::chrono::milliseconds max_silence{60000};
+};
+
+/**
+ * @brief 客户端死区（只上报变化）过滤
+ *
+ * 对每个序列记录上一次发送的值，变化量不超过 max(absolute, relative * |上次值|)
+ * 的样本从报告中移除，过滤后的报告标记为 delta，由服务端合并进已有状态。
+ * 两个阈值都为 0 时只过滤完全不变的值。
+ *
+ * 首份报告以及距上一份完整报告超过 max_silence 时发送完整报告（delta = false）。
+ * 上次发送值在报告组装时记录；报告随后被丢弃或发送失败时，服务端缺少其中的变化，
+ * 调用方须 RequestFull()，让下一份报告重新同步全部序列。
+ * 非线程安全。
+ */
+class DeadbandFilter {
+ public:
+  explicit DeadbandFilter(const DeadbandOptions& options);
+
+  /**
+   * @brief 原地过滤 report->samples
+   * @param now 单调时钟，用于判断是否需要完整报告
+   */
+  void Filter(systeminsight::proto::MetricsReport* report,
+              std::chrono::steady_clock::time_point now);
+
+  /**
+   * @brief 下一份报告发送完整报告
+   */
+  void RequestFull() { has_full_ = false; }
+
+  // 累计被过滤掉的样本数
+  uint64_t suppressed_total() const { return suppressed_total_; }
+
+ private:
+  struct SeriesState {
+    std::string key;
+    double last_sent = 0.0;
+  };
+
+  SeriesState* FindOrCreate(const systeminsight::proto::MetricSample& sample, size_t position,
+                            bool* created);
+  bool Changed(double last_sent, double value) const;
+
+  DeadbandOptions options_;
+  bool has_full_ = false;
+  std::chrono::steady_clock::time_point last_full_;
+
+  std::vector<SeriesState> series_;
+  std::unordered_map<std::string, size_t> index_;
+  // 上一份报告中每个位置对应的序列；样本顺序通常不变，可以跳过哈希查找
+  std::vector<size_t> order_;
+  std::string key_;
+  uint64_t suppressed_total_ = 0;
+};
+
+}  // namespace client
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_CLIENT_DEADBAND_FILTER_H_
@@ -0,0 +1,27 @@
+#ifndef SYSTEM_INSIGHT_CLIENT_METRICS_ACTIVITY_SIGNALS_H_
+#define SYSTEM_INSIGHT_CLIENT_METRICS_ACTIVITY_SIGNALS_H_
+
+namespace system_insight {
+namespace client {
+
+/**
+ * @brief 采集器在一个周期内算出的系统活跃度信号
+ *
+ * 由采集器在计算增量时顺带填写，供自适应采集周期使用；
+ * 对应的 has_* 为 false 表示本周期没有该信号（尚无基线或当前模式不支持）。
+ */
+struct ActivitySignals {
+  bool has_cpu = false;
+  double cpu_usage_percent = 0.0;
+
+  bool has_softirq = false;
+  double softirq_per_sec = 0.0;  // 所有软中断类型之和，仅 mmap 模式提供
+
+  bool has_net = false;
+  double net_bytes_per_sec = 0.0;  // 收发字节速率之和
+};
+
+}  // namespace client
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_CLIENT_METRICS_ACTIVITY_SIGNALS_H_
@@ -2,13 +2,29 @@
 
 #include <algorithm>
 #include <cmath>
-#include <numeric>
+#include <cstring>
+#include <string>
 
 #include "src/common/logging/logging.h"
 
 namespace system_insight {
 namespace client {
 
+namespace {
+
+// 指标名使用 std::string 常量：protobuf 以 const char* 赋值时会先构造临时 string
+const std::string kCpuUsagePercent = "system.cpu.usage_percent";
+const std::string kCpuCoreUsagePercent = "system.cpu.core.usage_percent";
+const std::string kSoftirqHiPerSec = "system.softirq.hi_per_sec";
+const std::string kSoftirqTimerPerSec = "system.softirq.timer_per_sec";
+const std::string kSoftirqNetTxPerSec = "system.softirq.net_tx_per_sec";
+const std::string kSoftirqNetRxPerSec = "system.softirq.net_rx_per_sec";
+const std::string kSoftirqTaskletPerSec = "system.softirq.tasklet_per_sec";
+const std::string kSoftirqSchedPerSec = "system.softirq.sched_per_sec";
+const std::string kSoftirqRcuPerSec = "system.softirq.rcu_per_sec";
+
+}  // namespace
+
 // Forward declaration
 int64_t GetCurrentTimestampMs();
 
@@ -19,9 +35,7 @@ CpuMmapCollector::CpuMmapCollector(const std::string& device_path,
       softirq_device_path_(softirq_device_path),
       previous_sample_time_(std::chrono::steady_clock::now()) {}
 
-std::vector<systeminsight::proto::MetricSample> CpuMmapCollector::Collect() {
-  std::vector<systeminsight::proto::MetricSample> samples;
-
+void CpuMmapCollector::Collect(systeminsight::proto::MetricsReport* report) {
   if (!cpu_reader_.IsValid()) {
     LOGW("CPU mmap reader not available: %s", cpu_reader_.GetLastError().c_str());
   }
@@ -30,22 +44,36 @@ std::vector<systeminsight::proto::MetricSample> CpuMmapCollector::Collect() {
     LOGW("Softirq mmap reader not available: %s", softirq_reader_.GetLastError().c_str());
   }
 
+  activity_ = ActivitySignals();
+
   // 采集各类指标
-  CollectCpuUsage(samples);
-  CollectPerCpuCore(samples);
-  CollectSoftirq(samples);
+  CollectCpuUsage(report);
+  CollectPerCpuCore(report);
+  CollectSoftirq(report);
+
+  // 保存当前数据作为下一次的历史
+  if (cpu_reader_.IsValid()) {
+    auto* data = static_cast<CpuStatData*>(cpu_reader_.GetData());
+    prev_cpu_count_ = std::min(cpu_reader_.GetValidCount(), MAX_CPUS);
+    std::copy(data, data + prev_cpu_count_, prev_cpu_stats_.begin());
+  }
 
   previous_sample_time_ = std::chrono::steady_clock::now();
   has_baseline_ = true;
+}
 
-  return samples;
+const CpuStatData* CpuMmapCollector::FindPrevCpuStat(int index, const CpuStatData& stat) const {
+  if (index >= prev_cpu_count_) return nullptr;
+  const auto& prev = prev_cpu_stats_[index];
+  if (std::strncmp(prev.cpu_name, stat.cpu_name, sizeof(stat.cpu_name)) != 0) return nullptr;
+  return &prev;
 }
 
-void CpuMmapCollector::CollectCpuUsage(std::vector<systeminsight::proto::MetricSample>& samples) {
+void CpuMmapCollector::CollectCpuUsage(systeminsight::proto::MetricsReport* report) {
   if (!cpu_reader_.IsValid()) return;
 
   auto* data = static_cast<CpuStatData*>(cpu_reader_.GetData());
-  int count = cpu_reader_.GetValidCount();
+  int count = std::min(cpu_reader_.GetValidCount(), MAX_CPUS);
 
   uint64_t total_idle = 0;
   uint64_t total_iowait = 0;
@@ -68,13 +96,11 @@ void CpuMmapCollector::CollectCpuUsage(std::vector<systeminsight::proto::MetricS
                  stat.iowait + stat.irq + stat.softirq + stat.steal;
 
     // 累加历史数据
-    auto it = prev_cpu_stats_.find(stat.cpu_name);
-    if (it != prev_cpu_stats_.end()) {
-      prev_total_idle += it->second.idle;
-      prev_total_iowait += it->second.iowait;
-      prev_total_all += it->second.user + it->second.nice + it->second.system +
-                       it->second.idle + it->second.iowait + it->second.irq +
-                       it->second.softirq + it->second.steal;
+    if (const auto* prev = FindPrevCpuStat(i, stat)) {
+      prev_total_idle += prev->idle;
+      prev_total_iowait += prev->iowait;
+      prev_total_all += prev->user + prev->nice + prev->system + prev->idle + prev->iowait +
+                        prev->irq + prev->softirq + prev->steal;
     }
   }
 
@@ -83,26 +109,22 @@ void CpuMmapCollector::CollectCpuUsage(std::vector<systeminsight::proto::MetricS
     double usage = CalculateCpuUsage(total_idle, total_iowait, total_all,
                                      prev_total_idle, prev_total_iowait, prev_total_all);
     
-    auto& sample = samples.emplace_back();
-    sample.set_name("system.cpu.usage_percent");
-    sample.set_value(usage);
-    sample.set_timestamp_ms(GetCurrentTimestampMs());
-  }
+    auto* sample = report->add_samples();
+    sample->set_name(kCpuUsagePercent);
+    sample->set_value(usage);
+    sample->set_timestamp_ms(GetCurrentTimestampMs());
 
-  // 保存当前数据作为下一次的历史
-  prev_cpu_stats_.clear();
-  for (int i = 0; i < count; ++i) {
-    if (data[i].cpu_name[0] != '\0') {
-      prev_cpu_stats_[data[i].cpu_name] = data[i];
-    }
+    activity_.has_cpu = true;
+    activity_.cpu_usage_percent = usage;
   }
 }
 
-void CpuMmapCollector::CollectPerCpuCore(std::vector<systeminsight::proto::MetricSample>& samples) {
-  if (!cpu_reader_.IsValid()) return;
+void CpuMmapCollector::CollectPerCpuCore(systeminsight::proto::MetricsReport* report) {
+  if (!cpu_reader_.IsValid() || !has_baseline_) return;
 
   auto* data = static_cast<CpuStatData*>(cpu_reader_.GetData());
-  int count = cpu_reader_.GetValidCount();
+  int count = std::min(cpu_reader_.GetValidCount(), MAX_CPUS);
+  int64_t timestamp_ms = GetCurrentTimestampMs();
 
   for (int i = 0; i < count; ++i) {
     const auto& stat = data[i];
@@ -111,42 +133,40 @@ void CpuMmapCollector::CollectPerCpuCore(std::vector<systeminsight::proto::Metri
     // 跳过聚合行 "cpu"
     if (stat.cpu_name[3] == '\0') continue;
 
-    auto it = prev_cpu_stats_.find(stat.cpu_name);
-    if (it == prev_cpu_stats_.end() || !has_baseline_) continue;
-
-    const auto& prev = it->second;
+    const auto* prev = FindPrevCpuStat(i, stat);
+    if (prev == nullptr) continue;
 
     uint64_t total = stat.user + stat.nice + stat.system + stat.idle +
                      stat.iowait + stat.irq + stat.softirq + stat.steal;
-    uint64_t prev_total = prev.user + prev.nice + prev.system + prev.idle +
-                          prev.iowait + prev.irq + prev.softirq + prev.steal;
+    uint64_t prev_total = prev->user + prev->nice + prev->system + prev->idle +
+                          prev->iowait + prev->irq + prev->softirq + prev->steal;
     uint64_t busy = stat.user + stat.nice + stat.system + stat.irq + stat.softirq + stat.steal;
-    uint64_t prev_busy = prev.user + prev.nice + prev.system + prev.irq + prev.softirq + prev.steal;
+    uint64_t prev_busy =
+        prev->user + prev->nice + prev->system + prev->irq + prev->softirq + prev->steal;
 
     if (total > prev_total && total > 0) {
       double usage = static_cast<double>(busy - prev_busy) / (total - prev_total) * 100.0;
 
-      auto& sample = samples.emplace_back();
-      sample.set_name("system.cpu.core.usage_percent");
-      sample.set_value(usage);
-      sample.set_timestamp_ms(GetCurrentTimestampMs());
+      auto* sample = report->add_samples();
+      sample->set_name(kCpuCoreUsagePercent);
+      sample->set_value(usage);
+      sample->set_timestamp_ms(timestamp_ms);
       
-      auto* label = sample.add_labels();
+      auto* label = sample->add_labels();
       label->set_key("core");
       label->set_value(stat.cpu_name);
     }
   }
 }
 
-void CpuMmapCollector::CollectSoftirq(std::vector<systeminsight::proto::MetricSample>& samples) {
+void CpuMmapCollector::CollectSoftirq(systeminsight::proto::MetricsReport* report) {
   if (!softirq_reader_.IsValid()) return;
 
   auto* data = static_cast<SoftirqStatData*>(softirq_reader_.GetData());
   int count = softirq_reader_.GetValidCount();
 
   // 软中断总计
-  uint64_t total_hi = 0, total_timer = 0, total_net_tx = 0, total_net_rx = 0;
-  uint64_t total_tasklet = 0, total_sched = 0, total_rcu = 0;
+  SoftirqTotals totals;
 
   for (int i = 0; i < count; ++i) {
     const auto& stat = data[i];
@@ -155,55 +175,52 @@ void CpuMmapCollector::CollectSoftirq(std::vector<systeminsight::proto::MetricSa
     // 跳过聚合行
     if (stat.cpu_name[3] == '\0') continue;
 
-    total_hi += stat.hi;
-    total_timer += stat.timer;
-    total_net_tx += stat.net_tx;
-    total_net_rx += stat.net_rx;
-    total_tasklet += stat.tasklet;
-    total_sched += stat.sched;
-    total_rcu += stat.rcu;
+    totals.hi += stat.hi;
+    totals.timer += stat.timer;
+    totals.net_tx += stat.net_tx;
+    totals.net_rx += stat.net_rx;
+    totals.tasklet += stat.tasklet;
+    totals.sched += stat.sched;
+    totals.rcu += stat.rcu;
   }
 
-  // 计算增量（需要保存历史数据）
-  static uint64_t prev_hi = 0, prev_timer = 0, prev_net_tx = 0, prev_net_rx = 0;
-  static uint64_t prev_tasklet = 0, prev_sched = 0, prev_rcu = 0;
-  static bool has_softirq_baseline = false;
-
-  if (has_softirq_baseline) {
+  if (has_softirq_baseline_) {
     auto now = std::chrono::steady_clock::now();
     double elapsed = std::chrono::duration<double>(now - previous_sample_time_).count();
     if (elapsed > 0) {
+      int64_t timestamp_ms = GetCurrentTimestampMs();
       // 添加软中断率指标
       auto add_rate = [&](const std::string& name, uint64_t current, uint64_t prev) {
         if (current > prev) {
-          auto& sample = samples.emplace_back();
-          sample.set_name(name);
-          sample.set_value(static_cast<double>(current - prev) / elapsed);
-          sample.set_timestamp_ms(GetCurrentTimestampMs());
+          auto* sample = report->add_samples();
+          sample->set_name(name);
+          sample->set_value(static_cast<double>(current - prev) / elapsed);
+          sample->set_timestamp_ms(timestamp_ms);
         }
       };
 
-      add_rate("system.softirq.hi_per_sec", total_hi, prev_hi);
-      add_rate("system.softirq.timer_per_sec", total_timer, prev_timer);
-      add_rate("system.softirq.net_tx_per_sec", total_net_tx, prev_net_tx);
-      add_rate("system.softirq.net_rx_per_sec", total_net_rx, prev_net_rx);
-      add_rate("system.softirq.tasklet_per_sec", total_tasklet, prev_tasklet);
-      add_rate("system.softirq.sched_per_sec", total_sched, prev_sched);
-      add_rate("system.softirq.rcu_per_sec", total_rcu, prev_rcu);
+      add_rate(kSoftirqHiPerSec, totals.hi, prev_softirq_.hi);
+      add_rate(kSoftirqTimerPerSec, totals.timer, prev_softirq_.timer);
+      add_rate(kSoftirqNetTxPerSec, totals.net_tx, prev_softirq_.net_tx);
+      add_rate(kSoftirqNetRxPerSec, totals.net_rx, prev_softirq_.net_rx);
+      add_rate(kSoftirqTaskletPerSec, totals.tasklet, prev_softirq_.tasklet);
+      add_rate(kSoftirqSchedPerSec, totals.sched, prev_softirq_.sched);
+      add_rate(kSoftirqRcuPerSec, totals.rcu, prev_softirq_.rcu);
+
+      uint64_t total = totals.hi + totals.timer + totals.net_tx + totals.net_rx +
+                       totals.tasklet + totals.sched + totals.rcu;
+      uint64_t prev_total = prev_softirq_.hi + prev_softirq_.timer + prev_softirq_.net_tx +
+                            prev_softirq_.net_rx + prev_softirq_.tasklet + prev_softirq_.sched +
+                            prev_softirq_.rcu;
+      activity_.has_softirq = true;
+      activity_.softirq_per_sec =
+          total > prev_total ? static_cast<double>(total - prev_total) / elapsed : 0.0;
     }
   }
 
   // 更新历史
-  if (has_baseline_) {
-    prev_hi = total_hi;
-    prev_timer = total_timer;
-    prev_net_tx = total_net_tx;
-    prev_net_rx = total_net_rx;
-    prev_tasklet = total_tasklet;
-    prev_sched = total_sched;
-    prev_rcu = total_rcu;
-    has_softirq_baseline = true;
-  }
+  prev_softirq_ = totals;
+  has_softirq_baseline_ = true;
 }
 
 double CpuMmapCollector::CalculateCpuUsage(uint64_t idle, uint64_t iowait,
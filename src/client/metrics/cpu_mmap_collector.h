@@ -1,12 +1,13 @@
 #ifndef SYSTEM_INSIGHT_CLIENT_CPU_MMAP_COLLECTOR_H_
 #define SYSTEM_INSIGHT_CLIENT_CPU_MMAP_COLLECTOR_H_
 
+#include <array>
 #include <chrono>
 #include <cstdint>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
+#include "src/client/metrics/activity_signals.h"
 #include "src/client/metrics/mmap_reader.h"
 #include "system_insight.pb.h"
 
@@ -36,10 +37,14 @@ class CpuMmapCollector {
                             const std::string& softirq_device_path = "");
 
   /**
-   * @brief 采集所有 CPU 指标
-   * @return 采集到的指标样本向量
+   * @brief 采集所有 CPU 指标，样本直接追加到 report->samples
    */
-  std::vector<systeminsight::proto::MetricSample> Collect();
+  void Collect(systeminsight::proto::MetricsReport* report);
+
+  /**
+   * @brief 最近一次 Collect() 得到的 CPU 与软中断活跃度
+   */
+  const ActivitySignals& activity() const { return activity_; }
 
   /**
    * @brief 检查采集器是否可用（内核模块是否已加载）
@@ -61,17 +66,17 @@ class CpuMmapCollector {
   /**
    * @brief 采集 CPU 使用率指标
    */
-  void CollectCpuUsage(std::vector<systeminsight::proto::MetricSample>& samples);
+  void CollectCpuUsage(systeminsight::proto::MetricsReport* report);
 
   /**
    * @brief 采集 per-CPU 核心指标
    */
-  void CollectPerCpuCore(std::vector<systeminsight::proto::MetricSample>& samples);
+  void CollectPerCpuCore(systeminsight::proto::MetricsReport* report);
 
   /**
    * @brief 采集软中断指标
    */
-  void CollectSoftirq(std::vector<systeminsight::proto::MetricSample>& samples);
+  void CollectSoftirq(systeminsight::proto::MetricsReport* report);
 
   /**
    * @brief 计算 CPU 使用率百分比
@@ -84,12 +89,32 @@ class CpuMmapCollector {
   MmapReader softirq_reader_;
   std::string softirq_device_path_;
   
-  // 历史数据缓存（用于计算增量）
-  std::unordered_map<std::string, CpuStatData> prev_cpu_stats_;
-  std::unordered_map<std::string, SoftirqStatData> prev_softirq_stats_;
-  
+  /**
+   * @brief 查找上一周期同一 CPU 的数据（共享内存中的条目按下标对应，名称不一致视为没有历史）
+   */
+  const CpuStatData* FindPrevCpuStat(int index, const CpuStatData& stat) const;
+
+  // 软中断各类型的全 CPU 汇总
+  struct SoftirqTotals {
+    uint64_t hi = 0;
+    uint64_t timer = 0;
+    uint64_t net_tx = 0;
+    uint64_t net_rx = 0;
+    uint64_t tasklet = 0;
+    uint64_t sched = 0;
+    uint64_t rcu = 0;
+  };
+
+  // 历史数据缓存（用于计算增量），定长数组按下标存放，每个周期整体覆盖
+  std::array<CpuStatData, MAX_CPUS> prev_cpu_stats_{};
+  int prev_cpu_count_ = 0;
+  SoftirqTotals prev_softirq_;
+  bool has_softirq_baseline_ = false;
+
   std::chrono::steady_clock::time_point previous_sample_time_;
   bool has_baseline_ = false;
+
+  ActivitySignals activity_;
 };
 
 }  // namespace client
@@ -0,0 +1,163 @@
+#include "src/client/metrics/cpufreq_collector.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <utility>
+
+#include "src/common/logging/logging.h"
+
+namespace system_insight {
+namespace client {
+
+namespace {
+
+const std::string kCoreFrequencyHz = "system.cpu.core.frequency_hz";
+const std::string kCoreThrottleTotal = "system.cpu.core.throttle_total";
+const std::string kPackageThrottleTotal = "system.cpu.package.throttle_total";
+const std::string kThermalTemperatureCelsius = "system.thermal.zone.temperature_celsius";
+
+const std::string kCoreLabel = "core";
+const std::string kPackageLabel = "package";
+const std::string kZoneLabel = "zone";
+const std::string kTypeLabel = "type";
+
+// 形如 <prefix><数字> 的目录名，返回数字部分；不匹配时返回 -1
+int NumberedEntry(const std::string& name, const std::string& prefix) {
+  if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0) return -1;
+  int number = 0;
+  for (size_t i = prefix.size(); i < name.size(); ++i) {
+    if (name[i] < '0' || name[i] > '9') return -1;
+    number = number * 10 + (name[i] - '0');
+  }
+  return number;
+}
+
+std::vector<std::pair<int, std::filesystem::path>> ListNumbered(
+    const std::filesystem::path& directory, const std::string& prefix) {
+  std::vector<std::pair<int, std::filesystem::path>> entries;
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(directory, ec)) {
+    int number = NumberedEntry(entry.path().filename().string(), prefix);
+    if (number >= 0) {
+      entries.emplace_back(number, entry.path());
+    }
+  }
+  std::sort(entries.begin(), entries.end());
+  return entries;
+}
+
+// 发现阶段读取只需读一次的属性（温区类型、封装号）
+std::string ReadFirstLine(const std::filesystem::path& path) {
+  std::ifstream file(path);
+  std::string line;
+  std::getline(file, line);
+  return line;
+}
+
+bool ParseInt64(const char* begin, const char* end, int64_t* value) {
+  bool negative = false;
+  if (begin < end && *begin == '-') {
+    negative = true;
+    ++begin;
+  }
+  if (begin == end || *begin < '0' || *begin > '9') return false;
+  int64_t result = 0;
+  while (begin < end && *begin >= '0' && *begin <= '9') {
+    result = result * 10 + (*begin - '0');
+    ++begin;
+  }
+  *value = negative ? -result : result;
+  return true;
+}
+
+int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+CpuFreqCollector::CpuFreqCollector(const CpuFreqCollectorOptions& options) : options_(options) {
+  Discover();
+}
+
+CpuFreqCollector::~CpuFreqCollector() {
+  for (auto& attribute : attributes_) {
+    ::close(attribute.fd);
+  }
+}
+
+void CpuFreqCollector::AddAttribute(const std::string& path, const std::string* name,
+                                    double scale, std::vector<Label> labels) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return;
+  Attribute attribute;
+  attribute.fd = fd;
+  attribute.name = name;
+  attribute.scale = scale;
+  attribute.labels = std::move(labels);
+  attributes_.push_back(std::move(attribute));
+}
+
+void CpuFreqCollector::Discover() {
+  const std::filesystem::path root(options_.sysfs_root);
+  std::set<std::string> packages;
+  int cores = 0;
+  for (const auto& [number, cpu_dir] : ListNumbered(root / "devices/system/cpu", "cpu")) {
+    const std::string core = "cpu" + std::to_string(number);
+    const size_t before = attributes_.size();
+    AddAttribute((cpu_dir / "cpufreq/scaling_cur_freq").string(), &kCoreFrequencyHz, 1000.0,
+                 {{&kCoreLabel, core}});
+    AddAttribute((cpu_dir / "thermal_throttle/core_throttle_count").string(),
+                 &kCoreThrottleTotal, 1.0, {{&kCoreLabel, core}});
+    // 同一封装内各核的 package_throttle_count 相同，只取第一个核
+    std::string package = ReadFirstLine(cpu_dir / "topology/physical_package_id");
+    if (!package.empty() && packages.insert(package).second) {
+      AddAttribute((cpu_dir / "thermal_throttle/package_throttle_count").string(),
+                   &kPackageThrottleTotal, 1.0, {{&kPackageLabel, package}});
+    }
+    cores += attributes_.size() > before ? 1 : 0;
+  }
+
+  int zones = 0;
+  for (const auto& [number, zone_dir] : ListNumbered(root / "class/thermal", "thermal_zone")) {
+    const size_t before = attributes_.size();
+    // temp 的单位是千分之一摄氏度
+    AddAttribute((zone_dir / "temp").string(), &kThermalTemperatureCelsius, 0.001,
+                 {{&kZoneLabel, std::to_string(number)},
+                  {&kTypeLabel, ReadFirstLine(zone_dir / "type")}});
+    zones += attributes_.size() > before ? 1 : 0;
+  }
+  LOGI("CPU frequency collector: {} cores, {} thermal zones, {} sysfs attributes", cores, zones,
+       attributes_.size());
+}
+
+void CpuFreqCollector::Collect(systeminsight::proto::MetricsReport* report) {
+  const int64_t timestamp_ms = NowMs();
+  char buffer[32];
+  for (const auto& attribute : attributes_) {
+    ssize_t n = ::pread(attribute.fd, buffer, sizeof(buffer), 0);
+    int64_t raw = 0;
+    if (n <= 0 || !ParseInt64(buffer, buffer + n, &raw)) continue;
+
+    auto* sample = report->add_samples();
+    sample->set_name(*attribute.name);
+    sample->set_value(static_cast<double>(raw) * attribute.scale);
+    sample->set_timestamp_ms(timestamp_ms);
+    for (const auto& label : attribute.labels) {
+      auto* proto_label = sample->add_labels();
+      proto_label->set_key(*label.key);
+      proto_label->set_value(label.value);
+    }
+  }
+}
+
+}  // namespace client
+}  // namespace system_insight
@@ -0,0 +1,74 @@
+#ifndef SYSTEM_INSIGHT_CLIENT_METRICS_CPUFREQ_COLLECTOR_H_
+#define SYSTEM_INSIGHT_CLIENT_METRICS_CPUFREQ_COLLECTOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace client {
+
+/**
+ * @brief CPU 频率与温度采集配置
+ */
+struct CpuFreqCollectorOptions {
+  // sysfs 挂载点，测试时可指向临时目录
+  std::string sysfs_root = "/sys";
+};
+
+/**
+ * @brief 采集每核当前频率、降频次数与各温区温度
+ *
+ * - system.cpu.core.frequency_hz{core}：cpufreq/scaling_cur_freq
+ * - system.cpu.core.throttle_total{core}：thermal_throttle/core_throttle_count
+ * - system.cpu.package.throttle_total{package}：thermal_throttle/package_throttle_count，
+ *   每个 physical_package_id 只取一次
+ * - system.thermal.zone.temperature_celsius{zone, type}：/sys/class/thermal/thermal_zone*\/temp
+ *
+ * core 标签与 CpuMmapCollector 的每核使用率一致（cpu0、cpu1 ...），便于按核关联频率与使用率。
+ *
+ * 属性文件在构造时发现并打开，之后常驻；每个周期对每个 fd 从偏移 0 pread 到同一块栈上缓冲区，
+ * 没有 open/close、目录遍历和堆分配，256 核机器上的开销也只随属性数线性增长。
+ * 读取失败（例如核被下线）的属性在该周期跳过。非线程安全。
+ */
+class CpuFreqCollector {
+ public:
+  explicit CpuFreqCollector(const CpuFreqCollectorOptions& options);
+  ~CpuFreqCollector();
+
+  CpuFreqCollector(const CpuFreqCollector&) = delete;
+  CpuFreqCollector& operator=(const CpuFreqCollector&) = delete;
+
+  void Collect(systeminsight::proto::MetricsReport* report);
+
+  // 打开的属性文件数
+  size_t attribute_count() const { return attributes_.size(); }
+
+ private:
+  struct Label {
+    const std::string* key;
+    std::string value;
+  };
+
+  struct Attribute {
+    int fd = -1;
+    const std::string* name;
+    double scale = 1.0;  // 原始值乘以该系数得到上报值
+    std::vector<Label> labels;
+  };
+
+  void Discover();
+  void AddAttribute(const std::string& path, const std::string* name, double scale,
+                    std::vector<Label> labels);
+
+  CpuFreqCollectorOptions options_;
+  std::vector<Attribute> attributes_;
+};
+
+}  // namespace client
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_CLIENT_METRICS_CPUFREQ_COLLECTOR_H_
@@ -0,0 +1,207 @@
+#include "src/client/metrics/filesystem_collector.h"
+
+#include <poll.h>
+#include <sys/statvfs.h>
+
+#include <algorithm>
+#include <chrono>
+#include <unordered_map>
+
+#include "src/common/logging/logging.h"
+
+namespace system_insight {
+namespace client {
+
+namespace {
+
+const std::string kFsSizeBytes = "system.fs.size_bytes";
+const std::string kFsUsedBytes = "system.fs.used_bytes";
+const std::string kFsAvailBytes = "system.fs.avail_bytes";
+const std::string kFsInodesTotal = "system.fs.inodes_total";
+const std::string kFsInodesFree = "system.fs.inodes_free";
+
+const std::string kDeviceLabel = "device";
+const std::string kFstypeLabel = "fstype";
+const std::string kMountpointLabel = "mountpoint";
+
+bool Contains(const std::vector<std::string>& values, std::string_view value) {
+  return std::find(values.begin(), values.end(), value) != values.end();
+}
+
+// 取出下一个以空格分隔的字段
+bool NextField(std::string_view* cursor, std::string_view* field) {
+  size_t start = cursor->find_first_not_of(' ');
+  if (start == std::string_view::npos) return false;
+  cursor->remove_prefix(start);
+  size_t end = cursor->find(' ');
+  *field = cursor->substr(0, end);
+  cursor->remove_prefix(end == std::string_view::npos ? cursor->size() : end);
+  return true;
+}
+
+int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+FilesystemCollector::FilesystemCollector(const FilesystemCollectorOptions& options)
+    : options_(options), mountinfo_reader_(options.mountinfo_path, 64 * 1024) {
+  options_.network_spread_cycles = std::max(options_.network_spread_cycles, 1);
+}
+
+std::string FilesystemCollector::Unescape(std::string_view field) {
+  std::string result;
+  result.reserve(field.size());
+  for (size_t i = 0; i < field.size(); ++i) {
+    if (field[i] == '\\' && i + 3 < field.size() && field[i + 1] >= '0' && field[i + 1] <= '3' &&
+        field[i + 2] >= '0' && field[i + 2] <= '7' && field[i + 3] >= '0' && field[i + 3] <= '7') {
+      result.push_back(static_cast<char>((field[i + 1] - '0') * 64 + (field[i + 2] - '0') * 8 +
+                                         (field[i + 3] - '0')));
+      i += 3;
+    } else {
+      result.push_back(field[i]);
+    }
+  }
+  return result;
+}
+
+bool FilesystemCollector::MountTableChanged() {
+  // 首次解析之前 fd 尚未打开；mountinfo 在挂载表变化后的下一次 poll 返回 POLLPRI
+  const int fd = mountinfo_reader_.fd();
+  if (!parsed_ || fd < 0) return true;
+  pollfd pfd{fd, POLLPRI, 0};
+  if (::poll(&pfd, 1, 0) <= 0) return false;
+  return (pfd.revents & (POLLPRI | POLLERR)) != 0;
+}
+
+bool FilesystemCollector::Selected(std::string_view fstype, std::string_view mount_point) const {
+  if (!options_.include_fstypes.empty() && !Contains(options_.include_fstypes, fstype)) {
+    return false;
+  }
+  if (Contains(options_.exclude_fstypes, fstype)) return false;
+  for (const auto& prefix : options_.exclude_mount_points) {
+    if (mount_point.compare(0, prefix.size(), prefix) == 0 &&
+        (mount_point.size() == prefix.size() || mount_point[prefix.size()] == '/')) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void FilesystemCollector::ParseMountinfo(std::string_view content) {
+  ++mountinfo_parses_;
+  // 挂载表变化后保留已有挂载点的统计值，分摊中的网络文件系统不会因此空缺一轮
+  std::unordered_map<std::string, Mount> previous;
+  for (auto& mount : mounts_) {
+    std::string key = mount.mount_point;
+    previous.emplace(std::move(key), std::move(mount));
+  }
+  mounts_.clear();
+
+  std::unordered_map<std::string, size_t> by_mount_point;
+  int network_count = 0;
+  std::string_view line;
+  while (NextLine(&content, &line)) {
+    // id parent major:minor root mount_point options [optional...] - fstype source super_options
+    std::string_view field;
+    std::string_view mount_point_field;
+    bool ok = true;
+    for (int i = 0; i < 5 && ok; ++i) {
+      ok = NextField(&line, &field);
+    }
+    if (!ok) continue;
+    mount_point_field = field;
+    while (NextField(&line, &field) && field != "-") {
+    }
+    std::string_view fstype;
+    std::string_view source;
+    if (!NextField(&line, &fstype) || !NextField(&line, &source)) continue;
+
+    std::string mount_point = Unescape(mount_point_field);
+    if (!Selected(fstype, mount_point)) continue;
+
+    // 同一挂载点被覆盖挂载时以最后（最上层）一条为准
+    Mount mount;
+    if (auto old = previous.find(mount_point);
+        old != previous.end() && old->second.fstype == fstype) {
+      mount = std::move(old->second);
+    }
+    mount.device = Unescape(source);
+    mount.fstype.assign(fstype.data(), fstype.size());
+    mount.network = Contains(options_.network_fstypes, fstype);
+    mount.mount_point = mount_point;
+    if (auto it = by_mount_point.find(mount_point); it != by_mount_point.end()) {
+      mounts_[it->second] = std::move(mount);
+    } else {
+      by_mount_point.emplace(mount_point, mounts_.size());
+      mounts_.push_back(std::move(mount));
+    }
+  }
+  for (auto& mount : mounts_) {
+    if (mount.network) {
+      mount.spread_slot = network_count++ % options_.network_spread_cycles;
+    }
+  }
+  LOGI("Mount table parsed: {} filesystems selected ({} network)", mounts_.size(),
+       network_count);
+}
+
+bool FilesystemCollector::Stat(Mount* mount) {
+  struct statvfs st {};
+  if (::statvfs(mount->mount_point.c_str(), &st) != 0 || st.f_blocks == 0) {
+    mount->has_stats = false;
+    return false;
+  }
+  const double fragment = static_cast<double>(st.f_frsize != 0 ? st.f_frsize : st.f_bsize);
+  mount->size_bytes = static_cast<double>(st.f_blocks) * fragment;
+  mount->used_bytes = static_cast<double>(st.f_blocks - st.f_bfree) * fragment;
+  mount->avail_bytes = static_cast<double>(st.f_bavail) * fragment;
+  mount->inodes_total = static_cast<double>(st.f_files);
+  mount->inodes_free = static_cast<double>(st.f_ffree);
+  mount->has_stats = true;
+  return true;
+}
+
+void FilesystemCollector::Collect(systeminsight::proto::MetricsReport* report) {
+  if (MountTableChanged()) {
+    std::string_view content;
+    if (!mountinfo_reader_.Read(&content)) return;
+    ParseMountinfo(content);
+    parsed_ = true;
+  }
+
+  const int current_slot = static_cast<int>(cycle_++ % options_.network_spread_cycles);
+  const int64_t timestamp_ms = NowMs();
+  for (auto& mount : mounts_) {
+    const bool due = !mount.network || mount.spread_slot == current_slot;
+    if (due && !Stat(&mount)) continue;
+    if (!mount.has_stats) continue;
+
+    auto add = [&](const std::string& name, double value) {
+      auto* sample = report->add_samples();
+      sample->set_name(name);
+      sample->set_value(value);
+      sample->set_timestamp_ms(timestamp_ms);
+      auto* label = sample->add_labels();
+      label->set_key(kDeviceLabel);
+      label->set_value(mount.device);
+      label = sample->add_labels();
+      label->set_key(kFstypeLabel);
+      label->set_value(mount.fstype);
+      label = sample->add_labels();
+      label->set_key(kMountpointLabel);
+      label->set_value(mount.mount_point);
+    };
+    add(kFsSizeBytes, mount.size_bytes);
+    add(kFsUsedBytes, mount.used_bytes);
+    add(kFsAvailBytes, mount.avail_bytes);
+    add(kFsInodesTotal, mount.inodes_total);
+    add(kFsInodesFree, mount.inodes_free);
+  }
+}
+
+}  // namespace client
+}  // namespace system_insight
@@ -0,0 +1,97 @@
+#ifndef SYSTEM_INSIGHT_CLIENT_METRICS_FILESYSTEM_COLLECTOR_H_
+#define SYSTEM_INSIGHT_CLIENT_METRICS_FILESYSTEM_COLLECTOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "src/client/metrics/proc_file_reader.h"
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace client {
+
+/**
+ * @brief 文件系统容量采集配置
+ *
+ * 过滤规则与 node_exporter 的默认值一致：排除伪文件系统、overlay 与容器运行时目录。
+ */
+struct FilesystemCollectorOptions {
+  std::string mountinfo_path = "/proc/self/mountinfo";
+  // 非空时只采集这些文件系统类型
+  std::vector<std::string> include_fstypes;
+  std::vector<std::string> exclude_fstypes = {
+      "autofs", "binfmt_misc", "bpf", "cgroup", "cgroup2", "configfs", "debugfs", "devpts",
+      "devtmpfs", "fusectl", "hugetlbfs", "iso9660", "mqueue", "nsfs", "overlay", "proc",
+      "procfs", "pstore", "rpc_pipefs", "securityfs", "selinuxfs", "squashfs", "sysfs",
+      "tracefs"};
+  // 挂载点等于这些路径或位于其下时不采集
+  std::vector<std::string> exclude_mount_points = {
+      "/dev", "/proc", "/sys", "/run/credentials", "/var/lib/docker",
+      "/var/lib/containers/storage"};
+  // 网络文件系统的 statvfs 可能很慢，轮流分摊到 network_spread_cycles 个周期
+  std::vector<std::string> network_fstypes = {
+      "nfs", "nfs4", "cifs", "smb3", "smbfs", "ceph", "glusterfs", "fuse.sshfs", "9p", "lustre",
+      "afs"};
+  int network_spread_cycles = 4;
+};
+
+/**
+ * @brief 按挂载点采集容量与 inode（system.fs.*）
+ *
+ * mountinfo 的文件描述符常驻，每个周期以零超时 poll 检查 POLLPRI：内核在挂载表变化时
+ * 置位，只有这时才重新解析 mountinfo 并套用过滤规则；挂载表不变时每个周期只对选中的
+ * 挂载点调用 statvfs。网络文件系统按序号分摊到多个周期，未轮到的周期沿用上次的值。
+ *
+ * 样本带 device、fstype、mountpoint 标签。非线程安全。
+ */
+class FilesystemCollector {
+ public:
+  explicit FilesystemCollector(const FilesystemCollectorOptions& options);
+
+  void Collect(systeminsight::proto::MetricsReport* report);
+
+  // 选中的挂载点数量与累计解析 mountinfo 的次数
+  size_t mount_count() const { return mounts_.size(); }
+  uint64_t mountinfo_parses() const { return mountinfo_parses_; }
+
+  /**
+   * @brief 还原 mountinfo 中的八进制转义（\040 等）
+   */
+  static std::string Unescape(std::string_view field);
+
+ private:
+  struct Mount {
+    std::string device;
+    std::string mount_point;
+    std::string fstype;
+    bool network = false;
+    int spread_slot = 0;
+
+    bool has_stats = false;
+    double size_bytes = 0.0;
+    double used_bytes = 0.0;
+    double avail_bytes = 0.0;
+    double inodes_total = 0.0;
+    double inodes_free = 0.0;
+  };
+
+  bool MountTableChanged();
+  void ParseMountinfo(std::string_view content);
+  bool Selected(std::string_view fstype, std::string_view mount_point) const;
+  bool Stat(Mount* mount);
+
+  FilesystemCollectorOptions options_;
+  ProcFileReader mountinfo_reader_;
+  bool parsed_ = false;
+  uint64_t mountinfo_parses_ = 0;
+  uint64_t cycle_ = 0;
+  std::vector<Mount> mounts_;
+};
+
+}  // namespace client
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_CLIENT_METRICS_FILESYSTEM_COLLECTOR_H_
@@ -0,0 +1,73 @@
+#include "src/client/metrics/key_table.h"
+
+#include <algorithm>
+
+#include "src/client/metrics/proc_file_reader.h"
+
+namespace system_insight {
+namespace client {
+
+namespace {
+
+bool IsSpace(char ch) {
+  return ch == ' ' || ch == '\t';
+}
+
+}  // namespace
+
+KeyTable::KeyTable(std::vector<std::string> keys) {
+  for (auto& key : keys) {
+    if (std::find(keys_.begin(), keys_.end(), key) == keys_.end()) {
+      keys_.push_back(std::move(key));
+    }
+  }
+
+  size_t slot_count = 8;
+  while (slot_count < keys_.size() * 2) {
+    slot_count <<= 1;
+  }
+  // 键集合只有几十个，通常几次尝试就能找到无冲突的种子；找不到时加倍槽数
+  while (true) {
+    slots_.assign(slot_count, -1);
+    mask_ = static_cast<uint32_t>(slot_count - 1);
+    for (seed_ = 1; seed_ <= 1024; ++seed_) {
+      std::fill(slots_.begin(), slots_.end(), -1);
+      bool collision = false;
+      for (size_t i = 0; i < keys_.size() && !collision; ++i) {
+        int32_t& slot = slots_[Hash(keys_[i], seed_) & mask_];
+        collision = slot >= 0;
+        slot = static_cast<int32_t>(i);
+      }
+      if (!collision) return;
+    }
+    slot_count <<= 1;
+  }
+}
+
+void ScanKeyValues(std::string_view content, const KeyTable& table, int skip_fields,
+                   uint64_t* values, uint8_t* seen) {
+  std::string_view line;
+  while (NextLine(&content, &line)) {
+    size_t pos = 0;
+    for (int field = 0; field < skip_fields; ++field) {
+      while (pos < line.size() && IsSpace(line[pos])) ++pos;
+      while (pos < line.size() && !IsSpace(line[pos])) ++pos;
+    }
+    while (pos < line.size() && IsSpace(line[pos])) ++pos;
+    const size_t key_start = pos;
+    while (pos < line.size() && line[pos] != ':' && !IsSpace(line[pos])) ++pos;
+
+    const int index = table.Find(line.substr(key_start, pos - key_start));
+    if (index < 0) continue;
+    if (pos < line.size() && line[pos] == ':') ++pos;
+    std::string_view rest = line.substr(pos);
+    uint64_t value = 0;
+    if (ParseUint64(&rest, &value)) {
+      values[index] = value;
+      seen[index] = 1;
+    }
+  }
+}
+
+}  // namespace client
+}  // namespace system_insight
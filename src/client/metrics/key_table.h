@@ -0,0 +1,66 @@
+#ifndef SYSTEM_INSIGHT_CLIENT_METRICS_KEY_TABLE_H_
+#define SYSTEM_INSIGHT_CLIENT_METRICS_KEY_TABLE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace system_insight {
+namespace client {
+
+/**
+ * @brief 固定键集合的完美哈希表，用于在一次遍历中从 /proc 键值文件里挑出关心的行
+ *
+ * 构造时为键集合搜索一个种子，使所有键落在互不冲突的槽位（槽数为 2 的幂，至少为键数的两倍）；
+ * 查找是一次哈希、一次取模和一次字符串比较，不在集合中的键在比较时被拒绝。
+ */
+class KeyTable {
+ public:
+  explicit KeyTable(std::vector<std::string> keys);
+
+  /**
+   * @return 键在构造时列表中的下标（重复键去重后），不存在时返回 -1
+   */
+  int Find(std::string_view key) const {
+    const int32_t index = slots_[Hash(key, seed_) & mask_];
+    return index >= 0 && keys_[index] == key ? index : -1;
+  }
+
+  size_t size() const { return keys_.size(); }
+  const std::string& key(size_t index) const { return keys_[index]; }
+
+ private:
+  static uint32_t Hash(std::string_view key, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    for (char ch : key) {
+      hash = (hash ^ static_cast<uint8_t>(ch)) * 16777619u;
+    }
+    hash ^= hash >> 15;
+    hash *= 0x2c1b3c6du;
+    hash ^= hash >> 12;
+    return hash;
+  }
+
+  std::vector<std::string> keys_;
+  std::vector<int32_t> slots_;
+  uint32_t seed_ = 0;
+  uint32_t mask_ = 0;
+};
+
+/**
+ * @brief 一次遍历 /proc 风格的键值内容，把表中键的数值写入 values
+ *
+ * 每行先跳过 skip_fields 个以空白分隔的字段（节点 meminfo 的 "Node 0" 前缀为 2），
+ * 键以 ':' 或空白结束，随后是十进制数值。
+ * @param values 长度不小于 table.size()
+ * @param seen 长度不小于 table.size()，本次出现的键置 1（调用方负责清零）
+ */
+void ScanKeyValues(std::string_view content, const KeyTable& table, int skip_fields,
+                   uint64_t* values, uint8_t* seen);
+
+}  // namespace client
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_CLIENT_METRICS_KEY_TABLE_H_
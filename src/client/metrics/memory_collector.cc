@@ -0,0 +1,203 @@
+#include "src/client/metrics/memory_collector.h"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+#include "src/common/logging/logging.h"
+
+namespace system_insight {
+namespace client {
+
+namespace {
+
+const std::string kNodeLabel = "node";
+const std::string kMemUsagePercent = "system.mem.usage_percent";
+const std::string kMemAvailableBytes = "system.mem.available_bytes";
+const std::string kMemTotalKey = "MemTotal";
+const std::string kMemAvailableKey = "MemAvailable";
+
+int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+systeminsight::proto::MetricSample* AddSample(const std::string& name, double value,
+                                              int64_t timestamp_ms,
+                                              systeminsight::proto::MetricsReport* report) {
+  auto* sample = report->add_samples();
+  sample->set_name(name);
+  sample->set_value(value);
+  sample->set_timestamp_ms(timestamp_ms);
+  return sample;
+}
+
+}  // namespace
+
+MemoryCollector::Source::Source(std::string path, std::vector<std::string> keys,
+                                int skip_fields)
+    : reader(std::move(path), 8 * 1024),
+      table(std::move(keys)),
+      skip_fields(skip_fields),
+      values(table.size(), 0),
+      seen(table.size(), 0),
+      names(table.size()),
+      scales(table.size(), 1.0) {}
+
+std::string MemoryCollector::SnakeCase(const std::string& key) {
+  std::string result;
+  for (size_t i = 0; i < key.size(); ++i) {
+    const char ch = key[i];
+    if (std::isupper(static_cast<unsigned char>(ch))) {
+      // 小写或数字之后、或连续大写后接小写（HugePages 中的 P）时断词
+      const bool after_lower = i > 0 && (std::islower(static_cast<unsigned char>(key[i - 1])) ||
+                                         std::isdigit(static_cast<unsigned char>(key[i - 1])));
+      const bool acronym_end = i > 0 && std::isupper(static_cast<unsigned char>(key[i - 1])) &&
+                               i + 1 < key.size() &&
+                               std::islower(static_cast<unsigned char>(key[i + 1]));
+      if ((after_lower || acronym_end) && !result.empty() && result.back() != '_') {
+        result.push_back('_');
+      }
+      result.push_back(static_cast<char>(std::tolower(static_cast<unsigned char>(ch))));
+    } else if (std::isalnum(static_cast<unsigned char>(ch))) {
+      result.push_back(ch);
+    } else if (!result.empty() && result.back() != '_') {
+      result.push_back('_');
+    }
+  }
+  while (!result.empty() && result.back() == '_') {
+    result.pop_back();
+  }
+  return result;
+}
+
+void MemoryCollector::MeminfoNames(const std::string& prefix, Source* source) {
+  for (size_t i = 0; i < source->table.size(); ++i) {
+    const std::string& key = source->table.key(i);
+    // HugePages_* 是页数，其余 meminfo 值的单位都是 kB
+    if (key.rfind("HugePages_", 0) == 0) {
+      source->names[i] = prefix + SnakeCase(key);
+    } else {
+      source->names[i] = prefix + SnakeCase(key) + "_bytes";
+      source->scales[i] = 1024.0;
+    }
+  }
+}
+
+MemoryCollector::MemoryCollector(const MemoryCollectorOptions& options) {
+  std::vector<std::string> meminfo_keys = options.meminfo_keys;
+  const auto configured = [&options](const std::string& key) {
+    return std::find(options.meminfo_keys.begin(), options.meminfo_keys.end(), key) !=
+           options.meminfo_keys.end();
+  };
+  for (const auto& key : {kMemTotalKey, kMemAvailableKey}) {
+    if (!configured(key)) meminfo_keys.push_back(key);
+  }
+  meminfo_ = std::make_unique<Source>(options.proc_root + "/meminfo", std::move(meminfo_keys), 0);
+  MeminfoNames("system.mem.", meminfo_.get());
+  meminfo_reported_.assign(meminfo_->table.size(), 0);
+  for (size_t i = 0; i < meminfo_->table.size(); ++i) {
+    const std::string& key = meminfo_->table.key(i);
+    if (key == kMemTotalKey) mem_total_index_ = i;
+    if (key == kMemAvailableKey) mem_available_index_ = i;
+    // MemAvailable 已作为 system.mem.available_bytes 上报
+    meminfo_reported_[i] = key != kMemAvailableKey && configured(key);
+  }
+
+  vmstat_ = std::make_unique<Source>(options.proc_root + "/vmstat", options.vmstat_keys, 0);
+  for (size_t i = 0; i < vmstat_->table.size(); ++i) {
+    vmstat_->names[i] = "system.vmstat." + vmstat_->table.key(i) + "_per_sec";
+  }
+  prev_vmstat_.assign(vmstat_->table.size(), 0);
+  prev_seen_.assign(vmstat_->table.size(), 0);
+
+  std::vector<std::pair<int, std::string>> node_dirs;
+  std::error_code ec;
+  const std::filesystem::path node_root =
+      std::filesystem::path(options.sysfs_root) / "devices/system/node";
+  for (const auto& entry : std::filesystem::directory_iterator(node_root, ec)) {
+    const std::string name = entry.path().filename().string();
+    if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+        std::all_of(name.begin() + 4, name.end(),
+                    [](char ch) { return std::isdigit(static_cast<unsigned char>(ch)); })) {
+      node_dirs.emplace_back(std::stoi(name.substr(4)), entry.path().string());
+    }
+  }
+  std::sort(node_dirs.begin(), node_dirs.end());
+  for (const auto& [id, path] : node_dirs) {
+    Node node;
+    // 每行形如 "Node 0 MemTotal:  16318412 kB"
+    node.source = std::make_unique<Source>(path + "/meminfo", options.node_keys, 2);
+    MeminfoNames("system.mem.node.", node.source.get());
+    node.id = std::to_string(id);
+    nodes_.push_back(std::move(node));
+  }
+  LOGI("Extended memory collector: {} meminfo keys, {} vmstat keys, {} NUMA nodes",
+       meminfo_->table.size(), vmstat_->table.size(), nodes_.size());
+}
+
+bool MemoryCollector::Read(Source* source) {
+  std::string_view content;
+  if (!source->reader.Read(&content)) return false;
+  std::fill(source->seen.begin(), source->seen.end(), 0);
+  ScanKeyValues(content, source->table, source->skip_fields, source->values.data(),
+                source->seen.data());
+  return true;
+}
+
+void MemoryCollector::Collect(systeminsight::proto::MetricsReport* report,
+                              std::chrono::steady_clock::time_point now) {
+  const int64_t timestamp_ms = NowMs();
+
+  if (Read(meminfo_.get())) {
+    const uint64_t total = meminfo_->values[mem_total_index_];
+    const uint64_t available = meminfo_->values[mem_available_index_];
+    if (meminfo_->seen[mem_total_index_] && meminfo_->seen[mem_available_index_] && total > 0 &&
+        available > 0) {
+      AddSample(kMemUsagePercent,
+                static_cast<double>(total - std::min(available, total)) / total * 100.0,
+                timestamp_ms, report);
+      AddSample(kMemAvailableBytes, static_cast<double>(available) * 1024.0, timestamp_ms,
+                report);
+    }
+    for (size_t i = 0; i < meminfo_->table.size(); ++i) {
+      if (!meminfo_->seen[i] || !meminfo_reported_[i]) continue;
+      AddSample(meminfo_->names[i], static_cast<double>(meminfo_->values[i]) * meminfo_->scales[i],
+                timestamp_ms, report);
+    }
+  }
+
+  if (Read(vmstat_.get())) {
+    const double elapsed_sec = std::chrono::duration<double>(now - prev_time_).count();
+    for (size_t i = 0; i < vmstat_->table.size(); ++i) {
+      if (!vmstat_->seen[i]) continue;
+      const uint64_t value = vmstat_->values[i];
+      if (has_baseline_ && prev_seen_[i] && elapsed_sec > 0 && value >= prev_vmstat_[i]) {
+        AddSample(vmstat_->names[i], static_cast<double>(value - prev_vmstat_[i]) / elapsed_sec,
+                  timestamp_ms, report);
+      }
+      prev_vmstat_[i] = value;
+    }
+    prev_seen_ = vmstat_->seen;
+    prev_time_ = now;
+    has_baseline_ = true;
+  }
+
+  for (auto& node : nodes_) {
+    Source* source = node.source.get();
+    if (!Read(source)) continue;
+    for (size_t i = 0; i < source->table.size(); ++i) {
+      if (!source->seen[i]) continue;
+      auto* sample = AddSample(source->names[i],
+                               static_cast<double>(source->values[i]) * source->scales[i],
+                               timestamp_ms, report);
+      auto* label = sample->add_labels();
+      label->set_key(kNodeLabel);
+      label->set_value(node.id);
+    }
+  }
+}
+
+}  // namespace client
+}  // namespace system_insight
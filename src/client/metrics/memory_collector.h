@@ -0,0 +1,108 @@
+#ifndef SYSTEM_INSIGHT_CLIENT_METRICS_MEMORY_COLLECTOR_H_
+#define SYSTEM_INSIGHT_CLIENT_METRICS_MEMORY_COLLECTOR_H_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/client/metrics/key_table.h"
+#include "src/client/metrics/proc_file_reader.h"
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace client {
+
+/**
+ * @brief 扩展内存指标配置；键列表即 /proc 文件中的原始键名
+ */
+struct MemoryCollectorOptions {
+  std::string proc_root = "/proc";
+  std::string sysfs_root = "/sys";
+  // /proc/meminfo 中按 gauge 上报的键；MemAvailable 只以 system.mem.available_bytes 上报
+  std::vector<std::string> meminfo_keys = {
+      "Buffers",   "Cached",        "SwapCached",     "SwapTotal",      "SwapFree",
+      "Dirty",     "Writeback",     "Shmem",          "Slab",           "SReclaimable",
+      "AnonPages", "AnonHugePages", "HugePages_Total", "HugePages_Free", "HugePages_Rsvd",
+      "Hugepagesize"};
+  // /proc/vmstat 中按每秒速率上报的累计计数器
+  std::vector<std::string> vmstat_keys = {
+      "pgfault",        "pgmajfault",    "pswpin",          "pswpout",
+      "pgscan_kswapd",  "pgscan_direct", "pgsteal_kswapd",  "pgsteal_direct",
+      "thp_fault_alloc", "thp_collapse_alloc", "oom_kill"};
+  // /sys/devices/system/node/node*/meminfo 中按节点上报的键
+  std::vector<std::string> node_keys = {"MemTotal",  "MemFree",        "MemUsed",
+                                        "FilePages", "AnonPages",      "HugePages_Total",
+                                        "HugePages_Free"};
+};
+
+/**
+ * @brief 扩展内存采集：meminfo 细项、vmstat 速率（缺页、回收扫描、换入换出、THP）
+ *        与 NUMA 节点内存
+ *
+ * - system.mem.usage_percent / system.mem.available_bytes：启用后代替基础采集上报，
+ *   与细项出自同一次 /proc/meminfo 读取
+ * - system.mem.<key>_bytes：meminfo 的 kB 值换算为字节；HugePages_* 是页数，不带 _bytes
+ * - system.vmstat.<key>_per_sec：相邻两次采集的差值除以间隔，计数器回绕或首次采集时不上报
+ * - system.mem.node.<key>_bytes{node}：每个 NUMA 节点一份
+ *
+ * 键名转为小写下划线形式（AnonHugePages -> anon_huge_pages）。每个文件只遍历一次，
+ * 行首键名经 KeyTable 完美哈希查找；数值、上次的值与指标名都在构造时按键数预分配，
+ * 稳态下没有堆分配。非线程安全。
+ */
+class MemoryCollector {
+ public:
+  explicit MemoryCollector(const MemoryCollectorOptions& options);
+
+  void Collect(systeminsight::proto::MetricsReport* report,
+               std::chrono::steady_clock::time_point now);
+
+  size_t node_count() const { return nodes_.size(); }
+
+  /**
+   * @brief meminfo 键名转指标名片段：AnonHugePages -> anon_huge_pages，Active(anon) -> active_anon
+   */
+  static std::string SnakeCase(const std::string& key);
+
+ private:
+  struct Source {
+    Source(std::string path, std::vector<std::string> keys, int skip_fields);
+
+    ProcFileReader reader;
+    KeyTable table;
+    int skip_fields;
+    std::vector<uint64_t> values;
+    std::vector<uint8_t> seen;
+    std::vector<std::string> names;  // 与 table 下标对应的指标名
+    std::vector<double> scales;      // kB 换算为字节
+  };
+
+  struct Node {
+    std::unique_ptr<Source> source;
+    std::string id;
+  };
+
+  static void MeminfoNames(const std::string& prefix, Source* source);
+  bool Read(Source* source);
+
+  std::unique_ptr<Source> meminfo_;
+  // MemTotal / MemAvailable 总会扫描，只有配置中列出的键按 gauge 上报
+  size_t mem_total_index_ = 0;
+  size_t mem_available_index_ = 0;
+  std::vector<uint8_t> meminfo_reported_;
+  std::unique_ptr<Source> vmstat_;
+  std::vector<Node> nodes_;
+
+  // vmstat 的上次值与是否有基线
+  std::vector<uint64_t> prev_vmstat_;
+  std::vector<uint8_t> prev_seen_;
+  bool has_baseline_ = false;
+  std::chrono::steady_clock::time_point prev_time_;
+};
+
+}  // namespace client
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_CLIENT_METRICS_MEMORY_COLLECTOR_H_
@@ -0,0 +1,85 @@
+#include "src/client/metrics/proc_file_reader.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include "src/common/logging/logging.h"
+
+namespace system_insight {
+namespace client {
+
+ProcFileReader::ProcFileReader(std::string path, size_t initial_capacity)
+    : path_(std::move(path)), buffer_(initial_capacity) {}
+
+ProcFileReader::~ProcFileReader() {
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+bool ProcFileReader::Read(std::string_view* content) {
+  if (fd_ < 0) {
+    fd_ = open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+      LOGW("Failed to open {}: {}", path_, std::strerror(errno));
+      return false;
+    }
+  }
+
+  while (true) {
+    size_t used = 0;
+    while (used < buffer_.size()) {
+      ssize_t n = pread(fd_, buffer_.data() + used, buffer_.size() - used, static_cast<off_t>(used));
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0) {
+        LOGW("Failed to read {}: {}", path_, std::strerror(errno));
+        close(fd_);
+        fd_ = -1;
+        return false;
+      }
+      if (n == 0) break;
+      used += static_cast<size_t>(n);
+    }
+    if (used < buffer_.size()) {
+      *content = std::string_view(buffer_.data(), used);
+      return true;
+    }
+    // 缓冲区被填满，内容可能被截断：扩容后从头重读（只在首次或文件变大时发生）
+    buffer_.resize(buffer_.size() * 2);
+  }
+}
+
+bool NextLine(std::string_view* cursor, std::string_view* line) {
+  if (cursor->empty()) return false;
+  size_t end = cursor->find('\n');
+  if (end == std::string_view::npos) {
+    *line = *cursor;
+    cursor->remove_prefix(cursor->size());
+  } else {
+    *line = cursor->substr(0, end);
+    cursor->remove_prefix(end + 1);
+  }
+  return true;
+}
+
+bool ParseUint64(std::string_view* cursor, uint64_t* value) {
+  size_t pos = 0;
+  while (pos < cursor->size() && ((*cursor)[pos] == ' ' || (*cursor)[pos] == '\t')) {
+    ++pos;
+  }
+  if (pos == cursor->size() || (*cursor)[pos] < '0' || (*cursor)[pos] > '9') return false;
+  uint64_t result = 0;
+  while (pos < cursor->size() && (*cursor)[pos] >= '0' && (*cursor)[pos] <= '9') {
+    result = result * 10 + static_cast<uint64_t>((*cursor)[pos] - '0');
+    ++pos;
+  }
+  cursor->remove_prefix(pos);
+  *value = result;
+  return true;
+}
+
+}  // namespace client
+}  // namespace system_insight
@@ -0,0 +1,59 @@
+#ifndef SYSTEM_INSIGHT_CLIENT_PROC_FILE_READER_H_
+#define SYSTEM_INSIGHT_CLIENT_PROC_FILE_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace system_insight {
+namespace client {
+
+/**
+ * @brief /proc 文件读取器
+ *
+ * 文件描述符在首次读取时打开并一直保持，之后每个周期从偏移 0 pread
+ * 到固定缓冲区；procfs 会在 offset 0 重新生成内容。相比每次构造 ifstream
+ * 并逐行 getline，稳态下不再有 open/close 和堆分配。
+ */
+class ProcFileReader {
+ public:
+  explicit ProcFileReader(std::string path, size_t initial_capacity = 16 * 1024);
+  ~ProcFileReader();
+
+  ProcFileReader(const ProcFileReader&) = delete;
+  ProcFileReader& operator=(const ProcFileReader&) = delete;
+
+  /**
+   * @brief 读取整个文件
+   * @param content 指向内部缓冲区，下一次 Read 之前有效
+   * @return 打开或读取失败时返回 false
+   */
+  bool Read(std::string_view* content);
+
+  const std::string& path() const { return path_; }
+  // 首次 Read 之前或读取失败后为 -1
+  int fd() const { return fd_; }
+
+ private:
+  std::string path_;
+  int fd_ = -1;
+  std::vector<char> buffer_;
+};
+
+/**
+ * @brief 取出 cursor 中的下一行（不含换行符），并前移 cursor
+ * @return cursor 已为空时返回 false
+ */
+bool NextLine(std::string_view* cursor, std::string_view* line);
+
+/**
+ * @brief 跳过前导空白后解析一个十进制无符号整数，并前移 cursor
+ */
+bool ParseUint64(std::string_view* cursor, uint64_t* value);
+
+}  // namespace client
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_CLIENT_PROC_FILE_READER_H_
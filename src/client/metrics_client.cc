@@ -1,33 +1,233 @@
 #include "src/client/metrics_client.h"
 
+#include <algorithm>
+
 #include "src/common/logging/logging.h"
 namespace system_insight {
 namespace client {
 
-MetricsClient::MetricsClient(std::shared_ptr<grpc::Channel> channel)
-    : stub_(systeminsight::proto::SystemInsightService::NewStub(channel)) {}
+MetricsClient::MetricsClient(std::shared_ptr<grpc::Channel> channel,
+                             const MetricsClientOptions& options)
+    : stub_(systeminsight::proto::SystemInsightService::NewStub(channel)),
+      options_(options),
+      encoder_(systeminsight::proto::REPORT_ENCODING_ROW) {
+  if (options_.use_streaming) {
+    stream_ = std::make_unique<MetricsStream>(stub_.get(), options_.stream);
+  }
+}
+
+MetricsClient::~MetricsClient() {
+  std::vector<SendCompletion> discarded;
+  CancelAll(&discarded);
+  stream_.reset();
+  cq_.Shutdown();
+  void* tag = nullptr;
+  bool ok = false;
+  while (cq_.Next(&tag, &ok)) {
+    delete static_cast<UnaryCall*>(tag);
+  }
+}
+
+size_t MetricsClient::InFlight() const {
+  return pending_stream_.size() + pending_unary_.size() + failed_.size();
+}
+
+const systeminsight::proto::MetricsReport& MetricsClient::BuildWireReport(
+    const systeminsight::proto::MetricsReport& rows) {
+  if (encoder_.encoding() == systeminsight::proto::REPORT_ENCODING_ROW) {
+    return rows;
+  }
+  if (!stream_ && options_.max_in_flight > 1) {
+    // 多份 unary 请求并发在途时到达顺序不确定，每份报告都编码为关键帧
+    encoder_.Reset();
+  }
+  wire_report_.Clear();
+  wire_report_.set_host_id(rows.host_id());
+  wire_report_.set_collector_version(rows.collector_version());
+  wire_report_.set_sequence(rows.sequence());
+  wire_report_.set_backfill(rows.backfill());
+  wire_report_.set_delta(rows.delta());
+  encoder_.Encode(rows, wire_report_.mutable_columnar());
+  return wire_report_;
+}
+
+void MetricsClient::UpdateEncoding(const systeminsight::proto::ReportAck& ack) {
+  auto preferred = options_.preferred_encoding;
+  if (!stream_ && options_.max_in_flight > 1) {
+    // 关键帧之间没有依赖可供 XOR 使用
+    preferred = std::min(preferred, systeminsight::proto::REPORT_ENCODING_COLUMNAR);
+  }
+  auto negotiated = common::codec::NegotiateReportEncoding(preferred, ack);
+  if (negotiated != encoder_.encoding()) {
+    LOGI("report encoding negotiated: {} -> {}",
+         common::codec::ReportEncodingName(encoder_.encoding()),
+         common::codec::ReportEncodingName(negotiated));
+    encoder_ = common::codec::ColumnarEncoder(negotiated);
+  }
+}
 
-bool MetricsClient::SendReport(const std::string& host_id,
-                               const std::string& collector_version,
-                               const std::vector<systeminsight::proto::MetricSample>& samples) {
-  systeminsight::proto::MetricsReport report;
-  report.set_host_id(host_id);
-  report.set_collector_version(collector_version);
-  for (const auto& sample : samples) {
-    *report.add_samples() = sample;
+void MetricsClient::RecordPayload(const systeminsight::proto::MetricsReport& wire) {
+  if (options_.telemetry) {
+    options_.telemetry->RecordPayloadBytes(wire.ByteSizeLong());
   }
+}
+
+void MetricsClient::StartSend(common::codec::PooledReport report) {
+  report->report()->set_sequence(next_sequence_++);
+  if (stream_ && StartOnStream(&report)) {
+    return;
+  }
+  StartUnary(std::move(report));
+}
 
-  grpc::ClientContext context;
-  systeminsight::proto::ReportAck ack;
-  auto status = stub_->SendMetrics(&context, report, &ack);
-  if (!status.ok()) {
-    LOGE("SendMetrics failed: {}", status.error_message());
+bool MetricsClient::StartOnStream(common::codec::PooledReport* report) {
+  auto result = stream_->EnsureConnected();
+  if (result == MetricsStream::WriteResult::kOk) {
+    if (stream_->generation() != stream_generation_) {
+      // 新建立的流：按握手重新协商编码，并从关键帧开始
+      stream_generation_ = stream_->generation();
+      encoder_.Reset();
+      UpdateEncoding(stream_->handshake());
+    }
+    if (stream_->TakeKeyframeRequest()) {
+      encoder_.Reset();
+    }
+    const auto& wire = BuildWireReport(*(*report)->report());
+    RecordPayload(wire);
+    result = stream_->Write(wire);
+    if (result == MetricsStream::WriteResult::kOk) {
+      uint64_t sequence = (*report)->report()->sequence();
+      pending_stream_[sequence] =
+          PendingStreamReport{std::move(*report), std::chrono::steady_clock::now()};
+      return true;
+    }
+  }
+
+  if (result == MetricsStream::WriteResult::kUnimplemented) {
+    FailPendingStreamReports(&failed_);
+    stream_.reset();
+    encoder_.Reset();
     return false;
   }
-  LOGI("server ack: {}", ack.message());
-  return ack.ok();
+
+  // 报告已编码但未送达，下一份从关键帧开始
+  encoder_.Reset();
+  if (!stream_->connected()) {
+    FailPendingStreamReports(&failed_);
+  }
+  failed_.push_back(SendCompletion{std::move(*report), false, {}});
+  return true;
+}
+
+void MetricsClient::StartUnary(common::codec::PooledReport report) {
+  auto* call = new UnaryCall;
+  call->start = std::chrono::steady_clock::now();
+  call->context.set_deadline(std::chrono::system_clock::now() +
+                             std::chrono::milliseconds(options_.send_timeout_ms));
+  // 请求在发起调用时即被序列化，之后可以复用 wire_report_
+  const auto& wire = BuildWireReport(*report->report());
+  RecordPayload(wire);
+  call->reader = stub_->AsyncSendMetrics(&call->context, wire, &cq_);
+  call->reader->Finish(&call->ack, &call->status, call);
+  call->report = std::move(report);
+  pending_unary_.insert(call);
+}
+
+void MetricsClient::Poll(std::chrono::milliseconds timeout,
+                         std::vector<SendCompletion>* completions) {
+  if (!failed_.empty()) {
+    for (auto& completion : failed_) {
+      completions->push_back(std::move(completion));
+    }
+    failed_.clear();
+    timeout = std::chrono::milliseconds(0);
+  }
+  if (!pending_stream_.empty()) {
+    PollStream(timeout, completions);
+  }
+  if (!pending_unary_.empty()) {
+    PollUnary(timeout, completions);
+  }
+}
+
+void MetricsClient::PollStream(std::chrono::milliseconds timeout,
+                               std::vector<SendCompletion>* completions) {
+  if (!stream_ || !stream_->connected()) {
+    FailPendingStreamReports(completions);
+    return;
+  }
+  std::vector<MetricsStream::AckEvent> acks;
+  bool alive = stream_->WaitForAcks(timeout, &acks);
+  auto now = std::chrono::steady_clock::now();
+  for (const auto& ack : acks) {
+    auto it = pending_stream_.find(ack.sequence);
+    if (it == pending_stream_.end()) continue;
+    completions->push_back(SendCompletion{std::move(it->second.report), ack.ok,
+                                          now - it->second.start, ack.need_full_report});
+    pending_stream_.erase(it);
+  }
+  if (!alive) {
+    stream_->Disconnect();
+    encoder_.Reset();
+    FailPendingStreamReports(completions);
+  }
+}
+
+void MetricsClient::PollUnary(std::chrono::milliseconds timeout,
+                              std::vector<SendCompletion>* completions) {
+  auto deadline = std::chrono::system_clock::now() + timeout;
+  void* tag = nullptr;
+  bool ok = false;
+  while (cq_.AsyncNext(&tag, &ok, deadline) == grpc::CompletionQueue::GOT_EVENT) {
+    auto* call = static_cast<UnaryCall*>(tag);
+    pending_unary_.erase(call);
+
+    bool delivered = ok && call->status.ok();
+    if (delivered) {
+      if (call->ack.need_keyframe() || !call->ack.ok()) {
+        encoder_.Reset();
+      }
+      UpdateEncoding(call->ack);
+    } else {
+      encoder_.Reset();
+      LOGE("SendMetrics failed: {}", call->status.error_message());
+    }
+    completions->push_back(SendCompletion{std::move(call->report),
+                                          delivered && call->ack.ok(),
+                                          std::chrono::steady_clock::now() - call->start,
+                                          delivered && call->ack.need_full_report()});
+    delete call;
+    // 拿到第一个事件后只收割已就绪的事件，不再等待
+    deadline = std::chrono::system_clock::now();
+  }
+}
+
+void MetricsClient::FailPendingStreamReports(std::vector<SendCompletion>* completions) {
+  for (auto& [sequence, pending] : pending_stream_) {
+    completions->push_back(SendCompletion{std::move(pending.report), false, {}});
+  }
+  pending_stream_.clear();
+}
+
+void MetricsClient::CancelAll(std::vector<SendCompletion>* completions) {
+  for (auto& completion : failed_) {
+    completions->push_back(std::move(completion));
+  }
+  failed_.clear();
+
+  if (stream_ && !pending_stream_.empty()) {
+    stream_->Disconnect();
+    encoder_.Reset();
+  }
+  FailPendingStreamReports(completions);
+
+  for (auto* call : pending_unary_) {
+    call->context.TryCancel();
+  }
+  while (!pending_unary_.empty()) {
+    PollUnary(std::chrono::milliseconds(100), completions);
+  }
 }
 
 }  // namespace client
 }  // namespace system_insight
-
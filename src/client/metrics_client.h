@@ -1,29 +1,134 @@
 #ifndef SYSTEM_INSIGHT_CLIENT_METRICS_CLIENT_H_
 #define SYSTEM_INSIGHT_CLIENT_METRICS_CLIENT_H_
 
+#include <chrono>
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
 #include "grpcpp/grpcpp.h"
+#include "src/client/agent_telemetry.h"
+#include "src/client/metrics_stream.h"
+#include "src/common/codec/report_pool.h"
+#include "src/common/codec/columnar_codec.h"
 #include "system_insight.grpc.pb.h"
 
 namespace system_insight {
 namespace client {
 
+/**
+ * @brief 传输层配置
+ */
+struct MetricsClientOptions {
+  // 期望的上报编码；首份报告总是行式，收到服务端 ack 声明的编码能力后再切换
+  systeminsight::proto::ReportEncoding preferred_encoding =
+      systeminsight::proto::REPORT_ENCODING_ROW;
+  // 使用 StreamMetrics 长连接，服务端不支持时回退到异步 SendMetrics
+  bool use_streaming = false;
+  MetricsStreamOptions stream;
+  // 异步 SendMetrics 的最大并发数与单次超时
+  int max_in_flight = 4;
+  int send_timeout_ms = 5000;
+  // 记录线上报告大小，可为空
+  AgentTelemetry* telemetry = nullptr;
+};
+
+/**
+ * @brief 一份报告的发送结果
+ */
+struct SendCompletion {
+  common::codec::PooledReport report;  // 行式原始报告，失败时可重放
+  bool ok = false;
+  std::chrono::steady_clock::duration latency{};
+  // 服务端要求改发完整报告而拒绝了这份 delta 报告；下一份完整报告会带上全部序列，无需重发
+  bool need_full_report = false;
+};
+
+/**
+ * @brief 异步上报传输层
+ *
+ * StartSend 发起发送后立即返回，完成结果通过 Poll 取回：
+ * - 流模式：报告写入长连接，收到对应 acked_sequence 的 ack 即完成；
+ *   流断开时所有未确认的报告以失败完成
+ * - unary 模式：基于 CompletionQueue 的异步 SendMetrics，可同时有多份报告在途
+ *
+ * 非线程安全，只能由一个发送线程驱动。
+ */
 class MetricsClient {
  public:
-  explicit MetricsClient(std::shared_ptr<grpc::Channel> channel);
+  MetricsClient(std::shared_ptr<grpc::Channel> channel, const MetricsClientOptions& options);
+  ~MetricsClient();
+
+  MetricsClient(const MetricsClient&) = delete;
+  MetricsClient& operator=(const MetricsClient&) = delete;
+
+  /**
+   * @brief 发起发送；无法发起时直接生成一条失败的完成记录
+   */
+  void StartSend(common::codec::PooledReport report);
+
+  /**
+   * @brief 收集已完成的发送，最多等待 timeout
+   */
+  void Poll(std::chrono::milliseconds timeout, std::vector<SendCompletion>* completions);
+
+  size_t InFlight() const;
 
-  bool SendReport(const std::string& host_id, const std::string& collector_version,
-                  const std::vector<systeminsight::proto::MetricSample>& samples);
+  /**
+   * @brief 取消所有在途发送（以失败完成），用于退出时兜底
+   */
+  void CancelAll(std::vector<SendCompletion>* completions);
 
  private:
+  struct UnaryCall {
+    grpc::ClientContext context;
+    systeminsight::proto::ReportAck ack;
+    grpc::Status status;
+    std::unique_ptr<grpc::ClientAsyncResponseReader<systeminsight::proto::ReportAck>> reader;
+    common::codec::PooledReport report;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  struct PendingStreamReport {
+    common::codec::PooledReport report;
+    std::chrono::steady_clock::time_point start;
+  };
+
+  // 按当前协商的编码生成线上报告；行式直接返回 rows 本身，避免拷贝
+  const systeminsight::proto::MetricsReport& BuildWireReport(
+      const systeminsight::proto::MetricsReport& rows);
+  void UpdateEncoding(const systeminsight::proto::ReportAck& ack);
+  void RecordPayload(const systeminsight::proto::MetricsReport& wire);
+
+  bool StartOnStream(common::codec::PooledReport* report);
+  void StartUnary(common::codec::PooledReport report);
+  void PollStream(std::chrono::milliseconds timeout, std::vector<SendCompletion>* completions);
+  void PollUnary(std::chrono::milliseconds timeout, std::vector<SendCompletion>* completions);
+  void FailPendingStreamReports(std::vector<SendCompletion>* completions);
+
   std::unique_ptr<systeminsight::proto::SystemInsightService::Stub> stub_;
+  MetricsClientOptions options_;
+  common::codec::ColumnarEncoder encoder_;
+  systeminsight::proto::MetricsReport wire_report_;
+  uint64_t next_sequence_ = 1;
+
+  // 流模式
+  std::unique_ptr<MetricsStream> stream_;
+  uint64_t stream_generation_ = 0;
+  std::map<uint64_t, PendingStreamReport> pending_stream_;
+
+  // unary 模式
+  grpc::CompletionQueue cq_;
+  std::unordered_set<UnaryCall*> pending_unary_;
+
+  // 立即失败的发送，等待下一次 Poll 取回
+  std::vector<SendCompletion> failed_;
 };
 
 }  // namespace client
 }  // namespace system_insight
 
 #endif  // SYSTEM_INSIGHT_CLIENT_METRICS_CLIENT_H_
-
@@ -0,0 +1,183 @@
+#include "src/client/metrics_stream.h"
+
+#include <algorithm>
+
+#include "src/common/logging/logging.h"
+
+namespace system_insight {
+namespace client {
+
+MetricsStream::MetricsStream(systeminsight::proto::SystemInsightService::Stub* stub,
+                             const MetricsStreamOptions& options)
+    : stub_(stub),
+      options_(options),
+      backoff_(options.reconnect_backoff_min_ms),
+      next_attempt_(std::chrono::steady_clock::now()) {}
+
+MetricsStream::~MetricsStream() {
+  Teardown(true);
+}
+
+bool MetricsStream::TakeKeyframeRequest() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  bool requested = keyframe_requested_;
+  keyframe_requested_ = false;
+  return requested;
+}
+
+bool MetricsStream::WaitForAcks(std::chrono::milliseconds timeout, std::vector<AckEvent>* acks) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  cv_.wait_for(lock, timeout, [this] { return !acks_.empty() || broken_; });
+  acks->insert(acks->end(), acks_.begin(), acks_.end());
+  acks_.clear();
+  return !broken_;
+}
+
+void MetricsStream::Disconnect() {
+  if (!stream_) return;
+  Teardown(false);
+  ScheduleReconnect();
+}
+
+MetricsStream::WriteResult MetricsStream::EnsureConnected() {
+  if (unimplemented_) return WriteResult::kUnimplemented;
+  if (stream_) return WriteResult::kOk;
+  if (std::chrono::steady_clock::now() < next_attempt_) {
+    return WriteResult::kUnavailable;
+  }
+  if (!Connect()) {
+    return unimplemented_ ? WriteResult::kUnimplemented : WriteResult::kUnavailable;
+  }
+  return WriteResult::kOk;
+}
+
+MetricsStream::WriteResult MetricsStream::Write(const systeminsight::proto::MetricsReport& report) {
+  auto connected = EnsureConnected();
+  if (connected != WriteResult::kOk) return connected;
+
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_for(lock, std::chrono::milliseconds(options_.credit_wait_ms),
+                 [this] { return credits_ > 0 || broken_; });
+    if (broken_) {
+      lock.unlock();
+      Teardown(false);
+      ScheduleReconnect();
+      return unimplemented_ ? WriteResult::kUnimplemented : WriteResult::kUnavailable;
+    }
+    if (credits_ <= 0) {
+      // 服务端处理不过来，本周期放弃发送，但保留连接
+      LOGW("metrics stream out of credits after {} ms", options_.credit_wait_ms);
+      return WriteResult::kUnavailable;
+    }
+    --credits_;
+  }
+
+  if (!stream_->Write(report)) {
+    Teardown(false);
+    ScheduleReconnect();
+    return WriteResult::kUnavailable;
+  }
+  return WriteResult::kOk;
+}
+
+bool MetricsStream::Connect() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    credits_ = 0;
+    broken_ = false;
+    handshake_received_ = false;
+    keyframe_requested_ = false;
+    acks_.clear();
+  }
+  context_ = std::make_unique<grpc::ClientContext>();
+  stream_ = stub_->StreamMetrics(context_.get());
+  reader_thread_ = std::thread(&MetricsStream::ReaderLoop, this);
+
+  bool ok = false;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait_for(lock, std::chrono::milliseconds(options_.credit_wait_ms),
+                 [this] { return handshake_received_ || broken_; });
+    ok = handshake_received_;
+  }
+  if (!ok) {
+    Teardown(false);
+    if (!unimplemented_) {
+      ScheduleReconnect();
+    }
+    return false;
+  }
+
+  ++generation_;
+  LOGI("metrics stream connected (generation {}, credits {})", generation_, handshake_.credits());
+  return true;
+}
+
+void MetricsStream::Teardown(bool graceful) {
+  if (!stream_) return;
+  bool finished = false;
+  if (graceful) {
+    // 半关闭写端，服务端处理完剩余报告后结束流；超时仍未结束则强制取消
+    stream_->WritesDone();
+    std::unique_lock<std::mutex> lock(mutex_);
+    finished = cv_.wait_for(lock, std::chrono::milliseconds(options_.credit_wait_ms),
+                            [this] { return broken_; });
+  } else {
+    // 服务端已结束的流不再取消，否则 Finish() 拿到的是 CANCELLED 而不是服务端的状态
+    // （例如 UNIMPLEMENTED）
+    std::lock_guard<std::mutex> lock(mutex_);
+    finished = broken_;
+  }
+  if (!finished) {
+    context_->TryCancel();
+  }
+  if (reader_thread_.joinable()) {
+    reader_thread_.join();
+  }
+  grpc::Status status = stream_->Finish();
+  if (status.error_code() == grpc::StatusCode::UNIMPLEMENTED) {
+    LOGW("server does not implement StreamMetrics, falling back to SendMetrics");
+    unimplemented_ = true;
+  } else if (!status.ok() && !graceful) {
+    LOGW("metrics stream closed: {}", status.error_message());
+  }
+  stream_.reset();
+  context_.reset();
+}
+
+void MetricsStream::ScheduleReconnect() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  next_attempt_ = std::chrono::steady_clock::now() + backoff_;
+  LOGI("metrics stream reconnect in {} ms", backoff_.count());
+  backoff_ = std::min(backoff_ * 2, std::chrono::milliseconds(options_.reconnect_backoff_max_ms));
+}
+
+void MetricsStream::ReaderLoop() {
+  systeminsight::proto::ReportAck ack;
+  while (stream_->Read(&ack)) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!handshake_received_) {
+      handshake_ = ack;
+      handshake_received_ = true;
+    } else {
+      if (ack.ok()) {
+        // 报告被成功应用，连接已恢复正常，重置退避
+        backoff_ = std::chrono::milliseconds(options_.reconnect_backoff_min_ms);
+      } else {
+        LOGW("server rejected report {}: {}", ack.acked_sequence(), ack.message());
+        keyframe_requested_ = true;
+      }
+      acks_.push_back(AckEvent{ack.acked_sequence(), ack.ok(), ack.need_full_report()});
+    }
+    credits_ += ack.credits();
+    cv_.notify_all();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  broken_ = true;
+  cv_.notify_all();
+}
+
+}  // namespace client
+}  // namespace system_insight
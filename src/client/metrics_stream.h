@@ -0,0 +1,131 @@
+#ifndef SYSTEM_INSIGHT_CLIENT_METRICS_STREAM_H_
+#define SYSTEM_INSIGHT_CLIENT_METRICS_STREAM_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "grpcpp/grpcpp.h"
+#include "system_insight.grpc.pb.h"
+
+namespace system_insight {
+namespace client {
+
+/**
+ * @brief StreamMetrics 长连接配置
+ */
+struct MetricsStreamOptions {
+  int reconnect_backoff_min_ms = 500;   // 首次重连等待
+  int reconnect_backoff_max_ms = 30000; // 指数退避上限
+  int credit_wait_ms = 5000;            // 等待握手 / 额度的最长时间
+};
+
+/**
+ * @brief 基于 StreamMetrics 双向流的长连接上报通道
+ *
+ * 每个 agent 持有一条长期存在的流，报告逐份写入，不再为每个周期新建 RPC：
+ * - 建流后服务端先发送握手 ack（编码能力 + 初始额度）
+ * - 每写一份报告消耗一个额度，服务端每应用一份报告归还额度；额度耗尽时等待
+ * - 后台线程读取 ack；流断开后按指数退避重连
+ *
+ * 非线程安全：除读线程外，所有方法只能由同一个发送线程调用。
+ */
+class MetricsStream {
+ public:
+  enum class WriteResult {
+    kOk,
+    kUnavailable,    // 流不可用（断开、退避中或额度等待超时）
+    kUnimplemented,  // 服务端不支持 StreamMetrics，应回退到 SendMetrics
+  };
+
+  MetricsStream(systeminsight::proto::SystemInsightService::Stub* stub,
+                const MetricsStreamOptions& options);
+  ~MetricsStream();
+
+  /**
+   * @brief 服务端对某份报告的确认
+   */
+  struct AckEvent {
+    uint64_t sequence = 0;
+    bool ok = false;
+    // 服务端没有该主机的完整报告，拒绝了 delta 报告
+    bool need_full_report = false;
+  };
+
+  MetricsStream(const MetricsStream&) = delete;
+  MetricsStream& operator=(const MetricsStream&) = delete;
+
+  /**
+   * @brief 确保流已建立（必要时按退避策略重连）
+   */
+  WriteResult EnsureConnected();
+
+  WriteResult Write(const systeminsight::proto::MetricsReport& report);
+
+  /**
+   * @brief 每次成功建流后递增，调用方据此得知需要重新协商编码并发送关键帧
+   */
+  uint64_t generation() const { return generation_; }
+
+  /**
+   * @brief 最近一次建流的握手 ack
+   */
+  const systeminsight::proto::ReportAck& handshake() const { return handshake_; }
+
+  /**
+   * @brief 取出并清除"服务端要求关键帧"标记
+   */
+  bool TakeKeyframeRequest();
+
+  /**
+   * @brief 等待并取出已收到的报告确认
+   * @return 流已断开时返回 false（未确认的报告应视为发送失败）
+   */
+  bool WaitForAcks(std::chrono::milliseconds timeout, std::vector<AckEvent>* acks);
+
+  /**
+   * @brief 主动断开当前流并按退避策略安排重连
+   */
+  void Disconnect();
+
+  bool connected() const { return stream_ != nullptr; }
+
+ private:
+  bool Connect();
+  void Teardown(bool graceful);
+  void ScheduleReconnect();
+  void ReaderLoop();
+
+  systeminsight::proto::SystemInsightService::Stub* stub_;
+  MetricsStreamOptions options_;
+
+  std::unique_ptr<grpc::ClientContext> context_;
+  std::unique_ptr<grpc::ClientReaderWriter<systeminsight::proto::MetricsReport,
+                                           systeminsight::proto::ReportAck>>
+      stream_;
+  std::thread reader_thread_;
+
+  // 以下状态由读线程与写线程共享
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int64_t credits_ = 0;
+  bool broken_ = false;
+  bool handshake_received_ = false;
+  bool keyframe_requested_ = false;
+  std::vector<AckEvent> acks_;
+  std::chrono::milliseconds backoff_;
+
+  systeminsight::proto::ReportAck handshake_;
+  uint64_t generation_ = 0;
+  bool unimplemented_ = false;
+  std::chrono::steady_clock::time_point next_attempt_;
+};
+
+}  // namespace client
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_CLIENT_METRICS_STREAM_H_
@@ -0,0 +1,293 @@
+#include "src/client/report_sender.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "src/common/codec/columnar_codec.h"
+#include "src/common/logging/logging.h"
+
+namespace system_insight {
+namespace client {
+
+namespace {
+
+// 队列中没有可发送的报告时，每次等待完成事件的最长时间
+constexpr std::chrono::milliseconds kPollInterval(50);
+
+// 把 older 中 newer 没有的序列补进 newer；同一序列以 newer 的值为准。
+// 任一份是完整报告时合并结果也包含全部序列，按完整报告发送
+void CoalesceInto(const systeminsight::proto::MetricsReport& older,
+                  systeminsight::proto::MetricsReport* newer) {
+  newer->set_delta(older.delta() && newer->delta());
+  std::unordered_set<std::string> keys;
+  keys.reserve(newer->samples_size());
+  std::string key;
+  for (const auto& sample : newer->samples()) {
+    common::codec::BuildSeriesKey(sample.name(), sample.labels(), &key);
+    keys.insert(key);
+  }
+  for (const auto& sample : older.samples()) {
+    common::codec::BuildSeriesKey(sample.name(), sample.labels(), &key);
+    if (keys.insert(key).second) {
+      *newer->add_samples() = sample;
+    }
+  }
+}
+
+}  // namespace
+
+bool ParseOverflowPolicy(const std::string& name, OverflowPolicy* policy) {
+  if (name == "drop_oldest") {
+    *policy = OverflowPolicy::kDropOldest;
+    return true;
+  }
+  if (name == "coalesce") {
+    *policy = OverflowPolicy::kCoalesce;
+    return true;
+  }
+  return false;
+}
+
+ReportSender::ReportSender(std::unique_ptr<MetricsClient> client, common::codec::ReportPool* pool,
+                           const ReportSenderOptions& options)
+    : client_(std::move(client)), pool_(pool), options_(options) {
+  options_.queue_capacity = std::max<size_t>(options_.queue_capacity, 1);
+  options_.max_in_flight = std::max(options_.max_in_flight, 1);
+}
+
+ReportSender::~ReportSender() {
+  Stop();
+}
+
+void ReportSender::Start() {
+  if (!options_.spool_directory.empty()) {
+    common::storage::SegmentLogOptions spool_options;
+    spool_options.directory = options_.spool_directory;
+    spool_options.max_total_bytes = options_.spool_max_bytes;
+    spool_options.segment_bytes = std::min<uint64_t>(4ULL << 20, options_.spool_max_bytes / 8);
+    spool_ = std::make_unique<common::storage::SegmentLog>(spool_options);
+    if (!spool_->Open()) {
+      LOGW("Report spool disabled: {} is not usable", options_.spool_directory);
+      spool_.reset();
+    }
+  }
+  thread_ = std::thread(&ReportSender::Run, this);
+}
+
+void ReportSender::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void ReportSender::Enqueue(common::codec::PooledReport report) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(std::move(report));
+    if (queue_.size() > options_.queue_capacity) {
+      if (options_.overflow_policy == OverflowPolicy::kCoalesce) {
+        CoalesceInto(*queue_.front()->report(), queue_[1]->report());
+        ++stats_.coalesced_total;
+      } else {
+        ++stats_.dropped_total;
+      }
+      queue_.pop_front();
+    }
+    stats_.queue_depth = queue_.size();
+  }
+  cv_.notify_one();
+}
+
+ReportSenderStats ReportSender::GetStats() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+void ReportSender::Run() {
+  std::vector<common::codec::PooledReport> batch;
+  std::vector<SendCompletion> completions;
+  bool stopping = false;
+  bool replay = false;
+  std::chrono::steady_clock::time_point flush_deadline;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!stop_ && client_->InFlight() == 0) {
+        auto ready = [this] { return stop_ || !queue_.empty(); };
+        if (ReplayPending()) {
+          cv_.wait_until(lock, next_replay_, ready);
+        } else {
+          cv_.wait(lock, ready);
+        }
+      }
+      auto now = std::chrono::steady_clock::now();
+      if (stop_ && !stopping) {
+        stopping = true;
+        flush_deadline = now + std::chrono::milliseconds(options_.flush_timeout_ms);
+      }
+      if (stopping &&
+          ((queue_.empty() && client_->InFlight() == 0) || now >= flush_deadline)) {
+        break;
+      }
+      size_t room = static_cast<size_t>(options_.max_in_flight);
+      room = room > client_->InFlight() ? room - client_->InFlight() : 0;
+      while (!queue_.empty() && batch.size() < room) {
+        batch.push_back(std::move(queue_.front()));
+        queue_.pop_front();
+      }
+      stats_.queue_depth = queue_.size();
+      // 实时数据优先，队列清空后才补发落盘报告
+      replay = !stopping && queue_.empty() && batch.size() < room;
+    }
+
+    if (replay) {
+      if (auto report = TakeReplayReport()) {
+        batch.push_back(std::move(report));
+      }
+    }
+
+    for (auto& report : batch) {
+      client_->StartSend(std::move(report));
+    }
+    batch.clear();
+
+    client_->Poll(kPollInterval, &completions);
+    Account(&completions);
+  }
+
+  client_->CancelAll(&completions);
+  Account(&completions);
+
+  // 退出时未发送的报告落盘，下次启动后补发
+  std::deque<common::codec::PooledReport> remaining;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    remaining.swap(queue_);
+  }
+  uint64_t dropped = 0;
+  for (auto& report : remaining) {
+    if (!SpoolReport(report->report())) {
+      ++dropped;
+    }
+  }
+  if (dropped > 0) {
+    LOGW("Dropping {} unsent reports on shutdown", dropped);
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  stats_.dropped_total += dropped;
+  stats_.spooled_total += remaining.size() - dropped;
+  stats_.queue_depth = 0;
+  stats_.in_flight = 0;
+}
+
+bool ReportSender::ReplayPending() const {
+  return spool_ && server_healthy_ && !replay_in_flight_ && !spool_->empty();
+}
+
+common::codec::PooledReport ReportSender::TakeReplayReport() {
+  if (!ReplayPending()) return nullptr;
+  auto now = std::chrono::steady_clock::now();
+  if (now < next_replay_) return nullptr;
+
+  while (spool_->ReadFront(&spool_buffer_)) {
+    auto report = pool_->Acquire();
+    if (report->report()->ParseFromString(spool_buffer_)) {
+      replay_in_flight_ = true;
+      replay_dropped_records_ = spool_->dropped_records();
+      next_replay_ = now + std::chrono::milliseconds(1000) /
+                               std::max(options_.replay_max_per_second, 1);
+      return report;
+    }
+    spool_->PopFront();
+    LOGW("Discarding unparsable spooled report");
+  }
+  return nullptr;
+}
+
+void ReportSender::FinishReplay(bool remove) {
+  replay_in_flight_ = false;
+  if (remove && spool_->dropped_records() == replay_dropped_records_) {
+    spool_->PopFront();
+  }
+}
+
+bool ReportSender::SpoolReport(systeminsight::proto::MetricsReport* report) {
+  if (!spool_) return false;
+  report->set_backfill(true);
+  report->clear_sequence();
+  if (!report->SerializeToString(&spool_buffer_)) return false;
+  return spool_->Append(spool_buffer_);
+}
+
+void ReportSender::Account(std::vector<SendCompletion>* completions) {
+  uint64_t spooled = 0;
+  uint64_t replayed = 0;
+  uint64_t full_report_requests = 0;
+  for (const auto& completion : *completions) {
+    // 要求完整报告的拒绝也是一次成功的往返
+    const bool answered = completion.ok || completion.need_full_report;
+    if (options_.telemetry) {
+      options_.telemetry->RecordSend(answered, completion.latency);
+    }
+    // 落盘的报告带 backfill 标记，同一时间只补发一份
+    const bool replay = replay_in_flight_ && completion.report->report()->backfill();
+    if (completion.need_full_report) {
+      // 补发这份 delta 报告无济于事，由调用方改发完整报告重新同步
+      ++full_report_requests;
+      server_healthy_ = true;
+      if (replay) FinishReplay(true);
+    } else if (completion.ok) {
+      if (!server_healthy_ && spool_ && !spool_->empty()) {
+        LOGI("Server reachable again, replaying {} spooled reports", spool_->pending_records());
+      }
+      server_healthy_ = true;
+      if (replay) {
+        FinishReplay(true);
+        ++replayed;
+      }
+    } else if (replay) {
+      // 留在队首，服务端再次可达后从它开始继续补发
+      FinishReplay(false);
+      server_healthy_ = false;
+    } else {
+      if (server_healthy_ && spool_) {
+        LOGW("Failed to send metrics batch, spooling reports to {}", options_.spool_directory);
+      }
+      server_healthy_ = false;
+      if (SpoolReport(completion.report->report())) {
+        ++spooled;
+      } else {
+        LOGW("Failed to send metrics batch");
+      }
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto& completion : *completions) {
+    if (completion.need_full_report) continue;
+    if (completion.ok) {
+      ++stats_.sent_total;
+    } else {
+      ++stats_.failed_total;
+    }
+  }
+  completions->clear();
+  stats_.in_flight = client_->InFlight();
+  stats_.spooled_total += spooled;
+  stats_.replayed_total += replayed;
+  stats_.full_report_requests_total += full_report_requests;
+  if (spool_) {
+    stats_.spool_reports = spool_->pending_records();
+    stats_.spool_bytes = spool_->total_bytes();
+    stats_.spool_dropped_total = spool_->dropped_records();
+  }
+}
+
+}  // namespace client
+}  // namespace system_insight
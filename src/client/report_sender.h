@@ -0,0 +1,149 @@
+#ifndef SYSTEM_INSIGHT_CLIENT_REPORT_SENDER_H_
+#define SYSTEM_INSIGHT_CLIENT_REPORT_SENDER_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "src/client/metrics_client.h"
+#include "src/common/codec/report_pool.h"
+#include "src/common/storage/segment_log.h"
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace client {
+
+/**
+ * @brief 发送队列满时的处理策略
+ */
+enum class OverflowPolicy {
+  kDropOldest,  // 丢弃最旧的报告
+  kCoalesce,    // 把最旧的报告合并进下一份，每个序列保留最新值
+};
+
+bool ParseOverflowPolicy(const std::string& name, OverflowPolicy* policy);
+
+/**
+ * @brief 发送线程配置
+ */
+struct ReportSenderOptions {
+  size_t queue_capacity = 64;
+  OverflowPolicy overflow_policy = OverflowPolicy::kDropOldest;
+  int max_in_flight = 4;
+  // Stop() 时冲刷剩余报告的最长时间
+  int flush_timeout_ms = 2000;
+
+  // 发送失败的报告落盘目录，为空时不落盘（失败即丢弃）
+  std::string spool_directory;
+  uint64_t spool_max_bytes = 64ULL << 20;
+  // 服务端恢复后每秒最多补发的落盘报告数
+  int replay_max_per_second = 10;
+
+  // 记录发送延迟与失败数，可为空
+  AgentTelemetry* telemetry = nullptr;
+};
+
+/**
+ * @brief 发送线程状态快照
+ */
+struct ReportSenderStats {
+  size_t queue_depth = 0;
+  size_t in_flight = 0;
+  uint64_t sent_total = 0;
+  uint64_t failed_total = 0;
+  uint64_t dropped_total = 0;
+  uint64_t coalesced_total = 0;
+  uint64_t spooled_total = 0;   // 写入落盘队列的报告数
+  uint64_t replayed_total = 0;  // 补发成功的报告数
+  uint64_t spool_reports = 0;   // 落盘队列中待补发的报告数
+  uint64_t spool_bytes = 0;
+  uint64_t spool_dropped_total = 0;  // 超出落盘上限被丢弃的报告数
+  // 服务端要求完整报告而拒绝的 delta 报告数；这些报告不落盘，调用方据此改发完整报告
+  uint64_t full_report_requests_total = 0;
+};
+
+/**
+ * @brief 与采集解耦的上报发送线程
+ *
+ * 采集循环只负责 Enqueue 报告，网络发送由独立线程驱动 MetricsClient 完成：
+ * 服务端变慢或不可达时，采集周期不受影响，积压体现为有界队列的深度，
+ * 超出容量时按 OverflowPolicy 丢弃或合并最旧的报告。
+ *
+ * 配置 spool_directory 后，发送失败的报告写入本地分段日志；
+ * 有报告发送成功（服务端已恢复）且实时队列为空时，按限速从最旧的开始逐份补发，
+ * 补发报告带 backfill 标记；补发确认成功后才从落盘队列移除，失败时留在队首并暂停补发，
+ * 因此补发始终保持从旧到新。退出时未发送的报告同样落盘，下次启动后补发。
+ * 服务端因缺少完整报告拒绝的 delta 报告不落盘，只计入 full_report_requests_total。
+ */
+class ReportSender {
+ public:
+  /**
+   * @param pool 补发落盘报告时从中取槽位，需比 ReportSender 活得更久
+   */
+  ReportSender(std::unique_ptr<MetricsClient> client, common::codec::ReportPool* pool,
+               const ReportSenderOptions& options);
+  ~ReportSender();
+
+  ReportSender(const ReportSender&) = delete;
+  ReportSender& operator=(const ReportSender&) = delete;
+
+  /**
+   * @brief 打开落盘队列并启动发送线程
+   */
+  void Start();
+
+  /**
+   * @brief 停止发送线程，在 flush_timeout_ms 内尽量发完剩余报告
+   */
+  void Stop();
+
+  /**
+   * @brief 报告入队，不阻塞
+   */
+  void Enqueue(common::codec::PooledReport report);
+
+  ReportSenderStats GetStats();
+
+ private:
+  void Run();
+  void Account(std::vector<SendCompletion>* completions);
+  bool SpoolReport(systeminsight::proto::MetricsReport* report);
+  // 读取队首待补发的报告，受限速控制；确认前不从落盘队列移除
+  common::codec::PooledReport TakeReplayReport();
+  // 补发的报告完成；remove 为 true 时把它从落盘队列移除
+  void FinishReplay(bool remove);
+  bool ReplayPending() const;
+
+  std::unique_ptr<MetricsClient> client_;
+  common::codec::ReportPool* pool_;
+  ReportSenderOptions options_;
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<common::codec::PooledReport> queue_;
+  bool stop_ = false;
+  ReportSenderStats stats_;
+
+  // 以下状态只由发送线程访问
+  std::unique_ptr<common::storage::SegmentLog> spool_;
+  std::string spool_buffer_;
+  bool server_healthy_ = false;
+  std::chrono::steady_clock::time_point next_replay_;
+  // 队首的报告正在补发
+  bool replay_in_flight_ = false;
+  // 开始补发时落盘队列超限丢弃的记录数；其间有丢弃说明队首已被删除
+  uint64_t replay_dropped_records_ = 0;
+
+  std::thread thread_;
+};
+
+}  // namespace client
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_CLIENT_REPORT_SENDER_H_
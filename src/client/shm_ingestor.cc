@@ -0,0 +1,185 @@
+#include "src/client/shm_ingestor.h"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+#include "src/common/logging/logging.h"
+
+namespace system_insight {
+namespace client {
+
+namespace {
+
+const std::string kAppLabel = "app";
+const std::string kShmDroppedTotal = "system_insight.agent.shm_dropped_total";
+
+bool IsPowerOfTwo(uint32_t value) {
+  return value != 0 && (value & (value - 1)) == 0;
+}
+
+}  // namespace
+
+ShmIngestor::ShmIngestor(const ShmIngestorOptions& options) : options_(options) {}
+
+ShmIngestor::~ShmIngestor() {
+  for (auto& [path, producer] : producers_) {
+    Detach(producer.get(), false);
+  }
+}
+
+void ShmIngestor::Scan() {
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(options_.directory, ec)) {
+    const std::string file = entry.path().filename().string();
+    if (file.compare(0, sizeof(sdk::shm::kFilePrefix) - 1, sdk::shm::kFilePrefix) != 0) {
+      continue;
+    }
+    const std::string path = entry.path().string();
+    if (producers_.count(path) != 0) continue;
+    if (auto producer = Attach(path)) {
+      LOGI("Attached shared memory metrics channel {} (app={}, pid={})", path, producer->app,
+           producer->header->pid);
+      producers_.emplace(path, std::move(producer));
+    }
+  }
+}
+
+std::unique_ptr<ShmIngestor::Producer> ShmIngestor::Attach(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+  if (fd < 0) return nullptr;
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(sdk::shm::ShmHeader)) {
+    ::close(fd);
+    return nullptr;
+  }
+  const size_t size = static_cast<size_t>(st.st_size);
+  void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (addr == MAP_FAILED) return nullptr;
+
+  auto producer = std::make_unique<Producer>();
+  producer->path = path;
+  producer->addr = addr;
+  producer->size = size;
+  producer->header = static_cast<sdk::shm::ShmHeader*>(addr);
+
+  // 生产者最后写 magic；尚未初始化完成的段下一次扫描再试
+  const auto* header = producer->header;
+  if (header->magic.load(std::memory_order_acquire) != sdk::shm::kMagic ||
+      header->version != sdk::shm::kVersion || !IsPowerOfTwo(header->capacity) ||
+      sdk::shm::SegmentSize(header->capacity, header->max_metrics) > size) {
+    ::munmap(addr, size);
+    return nullptr;
+  }
+  producer->records = sdk::shm::Records(producer->header);
+  producer->app.assign(header->app, strnlen(header->app, sizeof(header->app)));
+  return producer;
+}
+
+void ShmIngestor::Detach(Producer* producer, bool remove_file) {
+  if (producer->addr != nullptr) {
+    ::munmap(producer->addr, producer->size);
+    producer->addr = nullptr;
+  }
+  if (remove_file) {
+    ::unlink(producer->path.c_str());
+  }
+}
+
+bool ShmIngestor::ProducerGone(const Producer& producer) {
+  if (producer.header->closed.load(std::memory_order_acquire) != 0) return true;
+  return ::kill(producer.header->pid, 0) != 0 && errno == ESRCH;
+}
+
+void ShmIngestor::SyncMetrics(Producer* producer) {
+  const uint32_t count = std::min(producer->header->metric_count.load(std::memory_order_acquire),
+                                  producer->header->max_metrics);
+  const auto* slots = sdk::shm::Slots(producer->header);
+  while (producer->metrics.size() < count) {
+    const auto& slot = slots[producer->metrics.size()];
+    if (slot.ready.load(std::memory_order_acquire) == 0) break;
+    Metric metric;
+    metric.name.assign(slot.name, strnlen(slot.name, sizeof(slot.name)));
+    metric.type = slot.type;
+    producer->metrics.push_back(std::move(metric));
+  }
+}
+
+void ShmIngestor::DrainRing(Producer* producer) {
+  auto* header = producer->header;
+  const uint64_t capacity = header->capacity;
+  const uint64_t mask = capacity - 1;
+  uint64_t pos = header->dequeue_pos.load(std::memory_order_relaxed);
+  for (size_t n = 0; n < options_.max_records_per_drain; ++n) {
+    auto& record = producer->records[pos & mask];
+    if (record.sequence.load(std::memory_order_acquire) != pos + 1) break;
+    const uint32_t id = record.metric_id;
+    const double value = record.value;
+    record.sequence.store(pos + capacity, std::memory_order_release);
+    ++pos;
+
+    if (id >= producer->metrics.size()) {
+      SyncMetrics(producer);
+      if (id >= producer->metrics.size()) continue;
+    }
+    Metric& metric = producer->metrics[id];
+    if (metric.type == sdk::shm::kCounter) {
+      metric.value += value;
+    } else {
+      metric.value = value;
+    }
+    metric.has_value = true;
+  }
+  header->dequeue_pos.store(pos, std::memory_order_relaxed);
+}
+
+void ShmIngestor::Emit(const Producer& producer, int64_t timestamp_ms,
+                       systeminsight::proto::MetricsReport* report) {
+  auto add = [&](const std::string& name, double value) {
+    auto* sample = report->add_samples();
+    sample->set_name(name);
+    sample->set_value(value);
+    sample->set_timestamp_ms(timestamp_ms);
+    auto* label = sample->add_labels();
+    label->set_key(kAppLabel);
+    label->set_value(producer.app);
+  };
+  for (const auto& metric : producer.metrics) {
+    if (metric.has_value) {
+      add(metric.name, metric.value);
+    }
+  }
+  add(kShmDroppedTotal,
+      static_cast<double>(producer.header->dropped.load(std::memory_order_relaxed)));
+}
+
+void ShmIngestor::Drain(int64_t timestamp_ms, systeminsight::proto::MetricsReport* report) {
+  Scan();
+  for (auto it = producers_.begin(); it != producers_.end();) {
+    Producer* producer = it->second.get();
+    // 先判断再读取：判断之后写入的记录也会在这次读取中取走
+    const bool gone = ProducerGone(*producer);
+    SyncMetrics(producer);
+    DrainRing(producer);
+    Emit(*producer, timestamp_ms, report);
+    if (gone) {
+      LOGI("Shared memory metrics producer {} (pid {}) exited, removing {}", producer->app,
+           producer->header->pid, producer->path);
+      Detach(producer, true);
+      it = producers_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+}  // namespace client
+}  // namespace system_insight
@@ -0,0 +1,83 @@
+#ifndef SYSTEM_INSIGHT_CLIENT_SHM_INGESTOR_H_
+#define SYSTEM_INSIGHT_CLIENT_SHM_INGESTOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/sdk/shm_metrics.h"
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace client {
+
+/**
+ * @brief 共享内存指标通道配置
+ */
+struct ShmIngestorOptions {
+  std::string directory = "/dev/shm";
+  // 单次 Drain 中每个环最多读取的记录数，防止高频生产者拖慢采集周期
+  size_t max_records_per_drain = 1 << 16;
+};
+
+/**
+ * @brief 读取同机业务进程通过共享内存发布的指标（agent 侧）
+ *
+ * 每次 Drain() 扫描目录发现新的 system_insight.<app>.<pid> 段并映射，
+ * 读空各段的记录环：计数器累加为总数，gauge 取最后一次的值。
+ * 所有见过的指标以 app 标签追加到报告，另附每个应用的丢弃数
+ * system_insight.agent.shm_dropped_total。
+ *
+ * 生产者正常退出或进程已不存在时，读完剩余记录后解除映射并删除段文件。
+ * 非线程安全，由采集线程调用。
+ */
+class ShmIngestor {
+ public:
+  explicit ShmIngestor(const ShmIngestorOptions& options);
+  ~ShmIngestor();
+
+  ShmIngestor(const ShmIngestor&) = delete;
+  ShmIngestor& operator=(const ShmIngestor&) = delete;
+
+  void Drain(int64_t timestamp_ms, systeminsight::proto::MetricsReport* report);
+
+  size_t producer_count() const { return producers_.size(); }
+
+ private:
+  struct Metric {
+    std::string name;
+    uint32_t type = 0;
+    bool has_value = false;
+    double value = 0.0;
+  };
+
+  struct Producer {
+    std::string path;
+    void* addr = nullptr;
+    size_t size = 0;
+    sdk::shm::ShmHeader* header = nullptr;
+    sdk::shm::ShmRecord* records = nullptr;
+    std::string app;
+    std::vector<Metric> metrics;
+  };
+
+  void Scan();
+  std::unique_ptr<Producer> Attach(const std::string& path);
+  void Detach(Producer* producer, bool remove_file);
+  void SyncMetrics(Producer* producer);
+  void DrainRing(Producer* producer);
+  void Emit(const Producer& producer, int64_t timestamp_ms,
+            systeminsight::proto::MetricsReport* report);
+  static bool ProducerGone(const Producer& producer);
+
+  ShmIngestorOptions options_;
+  std::map<std::string, std::unique_ptr<Producer>> producers_;  // 按段文件路径
+};
+
+}  // namespace client
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_CLIENT_SHM_INGESTOR_H_
@@ -1,11 +1,10 @@
 #include "src/client/system_metrics_collector.h"
 
+#include <algorithm>
 #include <chrono>
 #include <cstdint>
-#include <fstream>
-#include <numeric>
-#include <sstream>
-#include <thread>
+#include <string>
+#include <string_view>
 
 #include "src/client/metrics/cpu_mmap_collector.h"
 #include "src/common/logging/logging.h"
@@ -13,11 +12,24 @@
 namespace system_insight {
 namespace client {
 
+namespace {
+
+// 指标名使用 std::string 常量：protobuf 以 const char* 赋值时会先构造临时 string
+const std::string kCpuUsagePercent = "system.cpu.usage_percent";
+const std::string kMemUsagePercent = "system.mem.usage_percent";
+const std::string kMemAvailableBytes = "system.mem.available_bytes";
+const std::string kNetRxBytesPerSec = "system.net.rx_bytes_per_sec";
+const std::string kNetTxBytesPerSec = "system.net.tx_bytes_per_sec";
+
+}  // namespace
+
 // Forward declaration
 int64_t GetCurrentTimestampMs();
 
-SystemMetricsCollector::SystemMetricsCollector(const CollectorConfig& config)
+SystemMetricsCollector::SystemMetricsCollector(const CollectorConfig& config,
+                                               AgentTelemetry* telemetry)
     : config_(config),
+      telemetry_(telemetry),
       previous_sample_time_(std::chrono::steady_clock::now()),
       use_mmap_(false) {
   // 尝试初始化 mmap 采集器
@@ -33,33 +45,60 @@ SystemMetricsCollector::SystemMetricsCollector(const CollectorConfig& config)
       LOGI("Falling back to /proc/* based collection");
     }
   }
+  if (config.filesystem_enabled) {
+    filesystem_collector_ = std::make_unique<FilesystemCollector>(config.filesystem);
+  }
+  if (config.extended_memory_enabled) {
+    memory_collector_ = std::make_unique<MemoryCollector>(config.memory);
+  }
+  if (config.cpufreq_enabled) {
+    cpufreq_collector_ = std::make_unique<CpuFreqCollector>(config.cpufreq);
+  }
 }
 
-std::vector<systeminsight::proto::MetricSample> SystemMetricsCollector::Collect() {
-  std::vector<systeminsight::proto::MetricSample> samples;
-
-  if (use_mmap_ && mmap_collector_) {
-    // 使用 mmap 采集器
-    auto mmap_samples = mmap_collector_->Collect();
-    samples.insert(samples.end(), mmap_samples.begin(), mmap_samples.end());
-  } else {
-    // 使用传统的 /proc/* 采集方式
-    CollectCpuUsage(samples);
+void SystemMetricsCollector::Collect(systeminsight::proto::MetricsReport* report) {
+  activity_ = ActivitySignals();
+  {
+    ScopedCollectorTimer timer(telemetry_, AgentTelemetry::kCollectorCpu, report);
+    if (use_mmap_ && mmap_collector_) {
+      // 使用 mmap 采集器
+      mmap_collector_->Collect(report);
+      activity_ = mmap_collector_->activity();
+    } else {
+      // 使用传统的 /proc/* 采集方式
+      CollectCpuUsage(report);
+    }
   }
 
   // 内存和网络采集（保持 /proc/* 方式，更稳定）
-  CollectMemInfo(samples);
-  CollectNetDev(samples);
+  {
+    ScopedCollectorTimer timer(telemetry_, AgentTelemetry::kCollectorMem, report);
+    // 扩展内存采集在同一次 /proc/meminfo 读取中给出使用率与可用内存
+    if (memory_collector_) {
+      memory_collector_->Collect(report, std::chrono::steady_clock::now());
+    } else {
+      CollectMemInfo(report);
+    }
+  }
+  {
+    ScopedCollectorTimer timer(telemetry_, AgentTelemetry::kCollectorNet, report);
+    CollectNetDev(report);
+  }
+  if (filesystem_collector_) {
+    ScopedCollectorTimer timer(telemetry_, AgentTelemetry::kCollectorFs, report);
+    filesystem_collector_->Collect(report);
+  }
+  if (cpufreq_collector_) {
+    ScopedCollectorTimer timer(telemetry_, AgentTelemetry::kCollectorCpuFreq, report);
+    cpufreq_collector_->Collect(report);
+  }
 
   previous_sample_time_ = std::chrono::steady_clock::now();
   has_cpu_baseline_ = true;
   has_net_baseline_ = true;
-
-  return samples;
 }
 
-void SystemMetricsCollector::CollectCpuUsage(
-    std::vector<systeminsight::proto::MetricSample>& samples) {
+void SystemMetricsCollector::CollectCpuUsage(systeminsight::proto::MetricsReport* report) {
   uint64_t idle = 0;
   uint64_t total = 0;
   if (!ReadCpuTimes(&idle, &total)) return;
@@ -69,10 +108,13 @@ void SystemMetricsCollector::CollectCpuUsage(
     const double idle_delta = static_cast<double>(idle - prev_cpu_idle_);
     if (total_delta > 0) {
       double usage = (total_delta - idle_delta) / total_delta * 100.0;
-      auto& sample = samples.emplace_back();
-      sample.set_name("system.cpu.usage_percent");
-      sample.set_value(usage);
-      sample.set_timestamp_ms(GetCurrentTimestampMs());
+      auto* sample = report->add_samples();
+      sample->set_name(kCpuUsagePercent);
+      sample->set_value(usage);
+      sample->set_timestamp_ms(GetCurrentTimestampMs());
+
+      activity_.has_cpu = true;
+      activity_.cpu_usage_percent = usage;
     }
   }
 
@@ -80,8 +122,7 @@ void SystemMetricsCollector::CollectCpuUsage(
   prev_cpu_total_ = total;
 }
 
-void SystemMetricsCollector::CollectMemInfo(
-    std::vector<systeminsight::proto::MetricSample>& samples) {
+void SystemMetricsCollector::CollectMemInfo(systeminsight::proto::MetricsReport* report) {
   uint64_t mem_total = 0;
   uint64_t mem_available = 0;
   if (!ReadMemInfo(&mem_total, &mem_available) || mem_total == 0) return;
@@ -89,19 +130,18 @@ void SystemMetricsCollector::CollectMemInfo(
   double used_ratio = static_cast<double>(mem_total - mem_available) / mem_total * 100.0;
   int64_t timestamp_ms = GetCurrentTimestampMs();
 
-  auto& mem_usage = samples.emplace_back();
-  mem_usage.set_name("system.mem.usage_percent");
-  mem_usage.set_value(used_ratio);
-  mem_usage.set_timestamp_ms(timestamp_ms);
+  auto* mem_usage = report->add_samples();
+  mem_usage->set_name(kMemUsagePercent);
+  mem_usage->set_value(used_ratio);
+  mem_usage->set_timestamp_ms(timestamp_ms);
 
-  auto& mem_available_sample = samples.emplace_back();
-  mem_available_sample.set_name("system.mem.available_bytes");
-  mem_available_sample.set_value(static_cast<double>(mem_available) * 1024.0);
-  mem_available_sample.set_timestamp_ms(timestamp_ms);
+  auto* mem_available_sample = report->add_samples();
+  mem_available_sample->set_name(kMemAvailableBytes);
+  mem_available_sample->set_value(static_cast<double>(mem_available) * 1024.0);
+  mem_available_sample->set_timestamp_ms(timestamp_ms);
 }
 
-void SystemMetricsCollector::CollectNetDev(
-    std::vector<systeminsight::proto::MetricSample>& samples) {
+void SystemMetricsCollector::CollectNetDev(systeminsight::proto::MetricsReport* report) {
   uint64_t rx_bytes = 0;
   uint64_t tx_bytes = 0;
   if (!ReadNetDev(&rx_bytes, &tx_bytes)) return;
@@ -115,101 +155,91 @@ void SystemMetricsCollector::CollectNetDev(
 
     int64_t timestamp_ms = GetCurrentTimestampMs();
 
-    auto& rx_sample = samples.emplace_back();
-    rx_sample.set_name("system.net.rx_bytes_per_sec");
-    rx_sample.set_value(rx_rate);
-    rx_sample.set_timestamp_ms(timestamp_ms);
+    auto* rx_sample = report->add_samples();
+    rx_sample->set_name(kNetRxBytesPerSec);
+    rx_sample->set_value(rx_rate);
+    rx_sample->set_timestamp_ms(timestamp_ms);
+
+    auto* tx_sample = report->add_samples();
+    tx_sample->set_name(kNetTxBytesPerSec);
+    tx_sample->set_value(tx_rate);
+    tx_sample->set_timestamp_ms(timestamp_ms);
 
-    auto& tx_sample = samples.emplace_back();
-    tx_sample.set_name("system.net.tx_bytes_per_sec");
-    tx_sample.set_value(tx_rate);
-    tx_sample.set_timestamp_ms(timestamp_ms);
+    activity_.has_net = true;
+    activity_.net_bytes_per_sec = rx_rate + tx_rate;
   }
 
   prev_rx_bytes_ = rx_bytes;
   prev_tx_bytes_ = tx_bytes;
 }
 
-bool SystemMetricsCollector::ReadCpuTimes(uint64_t* idle, uint64_t* total) const {
-  std::ifstream file("/proc/stat");
-  if (!file.is_open()) {
-    LOGW("Failed to open /proc/stat");
-    return false;
-  }
-
-  std::string line;
-  if (!std::getline(file, line)) return false;
+bool SystemMetricsCollector::ReadCpuTimes(uint64_t* idle, uint64_t* total) {
+  std::string_view content;
+  if (!stat_reader_.Read(&content)) return false;
 
-  std::istringstream ss(line);
-  std::string cpu_label;
-  ss >> cpu_label;
+  std::string_view line;
+  if (!NextLine(&content, &line)) return false;
 
-  if (cpu_label.rfind("cpu", 0) != 0) return false;
+  // 首行为聚合行 "cpu  user nice system idle iowait irq softirq steal ..."
+  if (line.rfind("cpu ", 0) != 0) return false;
+  line.remove_prefix(3);
 
-  uint64_t user = 0, nice = 0, system = 0, idle_time = 0, iowait = 0;
-  uint64_t irq = 0, softirq = 0, steal = 0;
-  ss >> user >> nice >> system >> idle_time >> iowait >> irq >> softirq >> steal;
+  uint64_t fields[8] = {};
+  for (auto& field : fields) {
+    if (!ParseUint64(&line, &field)) break;
+  }
+  const uint64_t idle_time = fields[3];
+  const uint64_t iowait = fields[4];
 
   *idle = idle_time + iowait;
-  *total = user + nice + system + idle_time + iowait + irq + softirq + steal;
+  *total = 0;
+  for (uint64_t field : fields) {
+    *total += field;
+  }
 
   return true;
 }
 
-bool SystemMetricsCollector::ReadMemInfo(uint64_t* total, uint64_t* available) const {
-  std::ifstream file("/proc/meminfo");
-  if (!file.is_open()) {
-    LOGW("Failed to open /proc/meminfo");
-    return false;
-  }
+bool SystemMetricsCollector::ReadMemInfo(uint64_t* total, uint64_t* available) {
+  std::string_view content;
+  if (!meminfo_reader_.Read(&content)) return false;
 
-  std::string line;
-  while (std::getline(file, line)) {
-    if (line.rfind("MemTotal", 0) == 0) {
-      std::istringstream ss(line);
-      std::string key, unit;
-      ss >> key >> *total >> unit;
-    }
-    if (line.rfind("MemAvailable", 0) == 0) {
-      std::istringstream ss(line);
-      std::string key, unit;
-      ss >> key >> *available >> unit;
-    }
-  }
+  uint64_t values[2] = {};
+  uint8_t seen[2] = {};
+  ScanKeyValues(content, meminfo_keys_, 0, values, seen);
+  *total = values[0];
+  *available = values[1];
 
   return *total > 0 && *available > 0;
 }
 
-bool SystemMetricsCollector::ReadNetDev(uint64_t* rx_bytes, uint64_t* tx_bytes) const {
-  std::ifstream file("/proc/net/dev");
-  if (!file.is_open()) {
-    LOGW("Failed to open /proc/net/dev");
-    return false;
-  }
+bool SystemMetricsCollector::ReadNetDev(uint64_t* rx_bytes, uint64_t* tx_bytes) {
+  std::string_view content;
+  if (!netdev_reader_.Read(&content)) return false;
 
-  std::string line;
+  std::string_view line;
   // Skip headers
-  std::getline(file, line);
-  std::getline(file, line);
+  NextLine(&content, &line);
+  NextLine(&content, &line);
 
-  while (std::getline(file, line)) {
+  while (NextLine(&content, &line)) {
     auto colon_pos = line.find(':');
-    if (colon_pos == std::string::npos) continue;
+    if (colon_pos == std::string_view::npos) continue;
 
-    std::string iface = line.substr(0, colon_pos);
-    iface.erase(0, iface.find_first_not_of(' '));
+    std::string_view iface = line.substr(0, colon_pos);
+    iface.remove_prefix(std::min(iface.find_first_not_of(' '), iface.size()));
     if (iface == "lo") continue;
 
-    std::istringstream ss(line.substr(colon_pos + 1));
+    // 接收 8 列之后是发送字节数
+    std::string_view fields = line.substr(colon_pos + 1);
     uint64_t iface_rx = 0;
     uint64_t iface_tx = 0;
-    ss >> iface_rx;
-
     uint64_t discard = 0;
+    if (!ParseUint64(&fields, &iface_rx)) continue;
     for (int i = 0; i < 7; ++i) {
-      ss >> discard;
+      ParseUint64(&fields, &discard);
     }
-    ss >> iface_tx;
+    ParseUint64(&fields, &iface_tx);
 
     *rx_bytes += iface_rx;
     *tx_bytes += iface_tx;
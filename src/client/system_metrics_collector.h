@@ -8,7 +8,14 @@
 #include <vector>
 
 #include "system_insight.pb.h"
+#include "src/client/agent_telemetry.h"
+#include "src/client/metrics/activity_signals.h"
 #include "src/client/metrics/cpu_mmap_collector.h"
+#include "src/client/metrics/cpufreq_collector.h"
+#include "src/client/metrics/filesystem_collector.h"
+#include "src/client/metrics/key_table.h"
+#include "src/client/metrics/memory_collector.h"
+#include "src/client/metrics/proc_file_reader.h"
 
 namespace system_insight {
 namespace client {
@@ -21,6 +28,18 @@ struct CollectorConfig {
   bool use_mmap = false;                              // 是否使用 mmap 采集
   std::string mmap_cpu_device_path = "/dev/system_insight_cpu_stat";   // CPU 统计设备路径
   std::string mmap_softirq_device_path = "/dev/system_insight_softirq"; // 软中断设备路径
+
+  // 按挂载点的容量与 inode 采集
+  bool filesystem_enabled = false;
+  FilesystemCollectorOptions filesystem;
+
+  // meminfo 细项、vmstat 速率与 NUMA 节点内存
+  bool extended_memory_enabled = false;
+  MemoryCollectorOptions memory;
+
+  // 每核频率、降频次数与温区温度
+  bool cpufreq_enabled = false;
+  CpuFreqCollectorOptions cpufreq;
 };
 
 /**
@@ -37,14 +56,16 @@ class SystemMetricsCollector {
   /**
    * @brief 构造函数
    * @param config 采集器配置
+   * @param telemetry 记录各采集项的耗时与产出，可为空
    */
-  explicit SystemMetricsCollector(const CollectorConfig& config = CollectorConfig());
+  explicit SystemMetricsCollector(const CollectorConfig& config = CollectorConfig(),
+                                  AgentTelemetry* telemetry = nullptr);
 
   /**
    * @brief 采集所有系统指标
-   * @return 采集到的指标样本向量
+   * @param report 样本直接追加到 report->samples（通常是池化、Arena 上的报告）
    */
-  std::vector<systeminsight::proto::MetricSample> Collect();
+  void Collect(systeminsight::proto::MetricsReport* report);
 
   /**
    * @brief 检查当前使用的采集模式
@@ -52,6 +73,11 @@ class SystemMetricsCollector {
    */
   bool IsUsingMmap() const { return use_mmap_; }
 
+  /**
+   * @brief 最近一次 Collect() 顺带算出的活跃度信号，供自适应采集周期使用
+   */
+  const ActivitySignals& activity() const { return activity_; }
+
   /**
    * @brief 检查采集器是否可用
    */
@@ -60,19 +86,30 @@ class SystemMetricsCollector {
   }
 
  private:
-  void CollectCpuUsage(std::vector<systeminsight::proto::MetricSample>& samples);
-  void CollectMemInfo(std::vector<systeminsight::proto::MetricSample>& samples);
-  void CollectNetDev(std::vector<systeminsight::proto::MetricSample>& samples);
+  void CollectCpuUsage(systeminsight::proto::MetricsReport* report);
+  void CollectMemInfo(systeminsight::proto::MetricsReport* report);
+  void CollectNetDev(systeminsight::proto::MetricsReport* report);
 
-  bool ReadCpuTimes(uint64_t* idle, uint64_t* total) const;
-  bool ReadMemInfo(uint64_t* total, uint64_t* available) const;
-  bool ReadNetDev(uint64_t* rx_bytes, uint64_t* tx_bytes) const;
+  bool ReadCpuTimes(uint64_t* idle, uint64_t* total);
+  bool ReadMemInfo(uint64_t* total, uint64_t* available);
+  bool ReadNetDev(uint64_t* rx_bytes, uint64_t* tx_bytes);
 
   // 配置
   CollectorConfig config_;
+  AgentTelemetry* telemetry_;
 
   // mmap 采集器（可选）
   std::unique_ptr<CpuMmapCollector> mmap_collector_;
+  std::unique_ptr<FilesystemCollector> filesystem_collector_;
+  std::unique_ptr<CpuFreqCollector> cpufreq_collector_;
+  std::unique_ptr<MemoryCollector> memory_collector_;
+
+  // 常驻的 /proc 文件读取器
+  ProcFileReader stat_reader_{"/proc/stat"};
+  ProcFileReader meminfo_reader_{"/proc/meminfo"};
+  ProcFileReader netdev_reader_{"/proc/net/dev"};
+  // ReadMemInfo 关心的键，下标与 ReadMemInfo 中的顺序一致
+  KeyTable meminfo_keys_{{"MemTotal", "MemAvailable"}};
 
   // 历史数据
   std::chrono::steady_clock::time_point previous_sample_time_;
@@ -85,6 +122,8 @@ class SystemMetricsCollector {
   bool use_mmap_ = false;
   bool has_cpu_baseline_ = false;
   bool has_net_baseline_ = false;
+
+  ActivitySignals activity_;
 };
 
 }  // namespace client
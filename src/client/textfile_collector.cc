@@ -0,0 +1,384 @@
+#include "src/client/textfile_collector.h"
+
+#include <fcntl.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+
+#include "src/common/logging/logging.h"
+
+namespace system_insight {
+namespace client {
+
+namespace {
+
+const std::string kTextfileMtimeSeconds = "system_insight.agent.textfile_mtime_seconds";
+const std::string kTextfileParseErrorsTotal = "system_insight.agent.textfile_parse_errors_total";
+const std::string kFileLabel = "file";
+constexpr std::string_view kTextfileSuffix = ".prom";
+
+constexpr size_t kReadChunkBytes = 64 * 1024;
+constexpr uint32_t kWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE |
+                                IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR;
+
+bool IsBlank(char ch) {
+  return ch == ' ' || ch == '\t' || ch == '\r';
+}
+
+bool IsNameStart(char ch) {
+  return (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') || ch == '_' || ch == ':';
+}
+
+bool IsNameChar(char ch) {
+  return IsNameStart(ch) || (ch >= '0' && ch <= '9');
+}
+
+void SkipBlanks(std::string_view line, size_t* i) {
+  while (*i < line.size() && IsBlank(line[*i])) ++*i;
+}
+
+// 取出下一个以空白结束的记号
+std::string_view NextToken(std::string_view line, size_t* i) {
+  const size_t start = *i;
+  while (*i < line.size() && !IsBlank(line[*i])) ++*i;
+  return line.substr(start, *i - start);
+}
+
+bool ParseValue(std::string_view token, double* value) {
+  char buffer[64];
+  if (token.empty() || token.size() >= sizeof(buffer)) return false;
+  std::copy(token.begin(), token.end(), buffer);
+  buffer[token.size()] = '\0';
+  char* end = nullptr;
+  *value = std::strtod(buffer, &end);
+  return end == buffer + token.size();
+}
+
+bool IsInteger(std::string_view token) {
+  if (!token.empty() && token.front() == '-') token.remove_prefix(1);
+  return !token.empty() &&
+         std::all_of(token.begin(), token.end(), [](char ch) { return ch >= '0' && ch <= '9'; });
+}
+
+}  // namespace
+
+TextfileCollector::TextfileCollector(const TextfileCollectorOptions& options)
+    : options_(options), buffer_(kReadChunkBytes) {}
+
+TextfileCollector::~TextfileCollector() {
+  if (inotify_fd_ >= 0) {
+    ::close(inotify_fd_);
+  }
+}
+
+bool TextfileCollector::IsTextfile(std::string_view name) {
+  return name.size() > kTextfileSuffix.size() && name.front() != '.' &&
+         name.compare(name.size() - kTextfileSuffix.size(), kTextfileSuffix.size(),
+                      kTextfileSuffix) == 0;
+}
+
+bool TextfileCollector::ParseLine(std::string_view line,
+                                  systeminsight::proto::MetricSample* sample, bool* error) {
+  *error = false;
+  size_t i = 0;
+  SkipBlanks(line, &i);
+  if (i == line.size() || line[i] == '#') return false;
+
+  sample->Clear();
+  const size_t name_start = i;
+  if (!IsNameStart(line[i])) {
+    *error = true;
+    return false;
+  }
+  while (i < line.size() && IsNameChar(line[i])) ++i;
+  sample->mutable_name()->assign(line.data() + name_start, i - name_start);
+
+  if (i < line.size() && line[i] == '{') {
+    ++i;
+    while (true) {
+      SkipBlanks(line, &i);
+      if (i < line.size() && line[i] == '}') {
+        ++i;
+        break;
+      }
+      // 标签名不允许 ':'，也不能以数字开头
+      const size_t key_start = i;
+      if (i >= line.size() || !IsNameStart(line[i]) || line[i] == ':') {
+        *error = true;
+        return false;
+      }
+      while (i < line.size() && IsNameChar(line[i]) && line[i] != ':') ++i;
+      auto* label = sample->add_labels();
+      label->mutable_key()->assign(line.data() + key_start, i - key_start);
+      SkipBlanks(line, &i);
+      if (i >= line.size() || line[i] != '=') {
+        *error = true;
+        return false;
+      }
+      ++i;
+      SkipBlanks(line, &i);
+      if (i >= line.size() || line[i] != '"') {
+        *error = true;
+        return false;
+      }
+      ++i;
+      std::string* value = label->mutable_value();
+      bool closed = false;
+      while (i < line.size()) {
+        char ch = line[i++];
+        if (ch == '"') {
+          closed = true;
+          break;
+        }
+        if (ch == '\\' && i < line.size()) {
+          ch = line[i++];
+          if (ch == 'n') ch = '\n';
+        }
+        value->push_back(ch);
+      }
+      if (!closed) {
+        *error = true;
+        return false;
+      }
+      SkipBlanks(line, &i);
+      if (i < line.size() && line[i] == ',') {
+        ++i;
+      } else if (i >= line.size() || line[i] != '}') {
+        *error = true;
+        return false;
+      }
+    }
+  }
+
+  SkipBlanks(line, &i);
+  double value = 0.0;
+  if (!ParseValue(NextToken(line, &i), &value)) {
+    *error = true;
+    return false;
+  }
+  sample->set_value(value);
+
+  // 可选的毫秒时间戳：校验格式但不使用，样本统一使用采集周期的时间戳
+  SkipBlanks(line, &i);
+  if (i < line.size()) {
+    if (!IsInteger(NextToken(line, &i))) {
+      *error = true;
+      return false;
+    }
+    SkipBlanks(line, &i);
+    if (i < line.size()) {
+      *error = true;
+      return false;
+    }
+  }
+  return true;
+}
+
+void TextfileCollector::EnsureWatch() {
+  if (inotify_fd_ == -1) {
+    inotify_fd_ = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+      LOGW("inotify unavailable ({}), textfile collector falls back to polling mtime",
+           std::strerror(errno));
+      inotify_fd_ = -2;
+    }
+  }
+  if (inotify_fd_ < 0 || watch_ >= 0) return;
+  watch_ = ::inotify_add_watch(inotify_fd_, options_.directory.c_str(), kWatchMask);
+  if (watch_ >= 0) {
+    LOGI("Watching textfile directory {}", options_.directory);
+  }
+  // 建立监听前已存在或改动过的文件由整体重扫补上
+  rescan_ = true;
+}
+
+void TextfileCollector::ReadEvents() {
+  alignas(inotify_event) char events[4096];
+  while (true) {
+    ssize_t n = ::read(inotify_fd_, events, sizeof(events));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    for (char* p = events; p < events + n;) {
+      const auto* event = reinterpret_cast<const inotify_event*>(p);
+      p += sizeof(inotify_event) + event->len;
+      if (event->mask & IN_Q_OVERFLOW) {
+        rescan_ = true;
+      } else if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+        // 目录本身被删除或移走：下个周期重新监听并整体重扫
+        if (watch_ >= 0 && !(event->mask & IN_IGNORED)) {
+          ::inotify_rm_watch(inotify_fd_, watch_);
+        }
+        watch_ = -1;
+        rescan_ = true;
+      } else if (event->len > 0 && IsTextfile(event->name)) {
+        changed_.emplace(event->name);
+      }
+    }
+  }
+}
+
+void TextfileCollector::Rescan() {
+  std::set<std::string> present;
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(options_.directory, ec)) {
+    std::string name = entry.path().filename().string();
+    if (IsTextfile(name)) {
+      present.insert(std::move(name));
+    }
+  }
+  for (auto it = files_.begin(); it != files_.end();) {
+    it = present.count(it->first) != 0 ? std::next(it) : files_.erase(it);
+  }
+  for (const auto& name : present) {
+    Reload(name, false);
+  }
+}
+
+void TextfileCollector::Reload(const std::string& name, bool force) {
+  const std::string path = options_.directory + "/" + name;
+  struct stat st {};
+  if (::stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+    files_.erase(name);
+    return;
+  }
+  const int64_t mtime_ns =
+      static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+  FileEntry& entry = files_[name];
+  if (!force && entry.mtime_ns == mtime_ns && entry.size == static_cast<int64_t>(st.st_size)) {
+    return;
+  }
+  if (!ParseFile(path, &entry)) {
+    files_.erase(name);
+    return;
+  }
+  entry.mtime_ns = mtime_ns;
+  entry.size = static_cast<int64_t>(st.st_size);
+  entry.mtime_seconds = static_cast<double>(mtime_ns) / 1e9;
+}
+
+bool TextfileCollector::ParseFile(const std::string& path, FileEntry* entry) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return false;
+  ++files_parsed_total_;
+  entry->samples.clear();
+
+  uint64_t errors = 0;
+  systeminsight::proto::MetricSample sample;
+  auto process = [&](std::string_view line) {
+    bool error = false;
+    if (!ParseLine(line, &sample, &error)) {
+      errors += error ? 1 : 0;
+      return;
+    }
+    if (entry->samples.size() >= options_.max_samples_per_file) {
+      ++errors;
+      return;
+    }
+    entry->samples.push_back(std::move(sample));
+  };
+
+  size_t total = 0;
+  bool skipping = false;  // 当前行超长，丢弃到下一个换行
+  bool truncated = false;
+  line_.clear();
+  while (true) {
+    ssize_t n = ::read(fd, buffer_.data(), buffer_.size());
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) break;
+    const size_t take = std::min(static_cast<size_t>(n), options_.max_file_bytes - total);
+    total += take;
+    std::string_view chunk(buffer_.data(), take);
+    while (!chunk.empty()) {
+      const size_t newline = chunk.find('\n');
+      std::string_view piece = chunk.substr(0, newline);
+      if (!skipping && line_.size() + piece.size() > options_.max_line_bytes) {
+        skipping = true;
+        line_.clear();
+        ++errors;
+      }
+      if (newline == std::string_view::npos) {
+        if (!skipping) line_.append(piece);
+        break;
+      }
+      chunk.remove_prefix(newline + 1);
+      if (!skipping) {
+        // 整行都在缓冲区内时直接解析，不拷贝
+        if (line_.empty()) {
+          process(piece);
+        } else {
+          line_.append(piece);
+          process(line_);
+          line_.clear();
+        }
+      }
+      skipping = false;
+    }
+    if (take < static_cast<size_t>(n)) {
+      truncated = true;
+      break;
+    }
+  }
+  ::close(fd);
+
+  if (truncated) {
+    ++errors;
+  } else if (!skipping && !line_.empty()) {
+    process(line_);
+  }
+  line_.clear();
+  if (errors > 0) {
+    parse_errors_total_ += errors;
+    LOGW("Textfile {}: {} malformed or dropped lines{}", path, errors,
+         truncated ? " (truncated at max_file_bytes)" : "");
+  }
+  return true;
+}
+
+void TextfileCollector::Append(int64_t timestamp_ms,
+                               systeminsight::proto::MetricsReport* report) {
+  EnsureWatch();
+  if (watch_ >= 0) {
+    ReadEvents();
+  } else {
+    // 没有 inotify（或目录尚不存在）时每个周期比较 mtime 与大小
+    rescan_ = true;
+  }
+  if (rescan_) {
+    rescan_ = false;
+    changed_.clear();
+    Rescan();
+  } else {
+    for (const auto& name : changed_) {
+      Reload(name, true);
+    }
+    changed_.clear();
+  }
+
+  for (const auto& [name, entry] : files_) {
+    for (const auto& cached : entry.samples) {
+      auto* sample = report->add_samples();
+      sample->CopyFrom(cached);
+      sample->set_timestamp_ms(timestamp_ms);
+    }
+    auto* mtime = report->add_samples();
+    mtime->set_name(kTextfileMtimeSeconds);
+    mtime->set_value(entry.mtime_seconds);
+    mtime->set_timestamp_ms(timestamp_ms);
+    auto* label = mtime->add_labels();
+    label->set_key(kFileLabel);
+    label->set_value(name);
+  }
+  auto* errors = report->add_samples();
+  errors->set_name(kTextfileParseErrorsTotal);
+  errors->set_value(static_cast<double>(parse_errors_total_));
+  errors->set_timestamp_ms(timestamp_ms);
+}
+
+}  // namespace client
+}  // namespace system_insight
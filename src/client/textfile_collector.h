@@ -0,0 +1,96 @@
+#ifndef SYSTEM_INSIGHT_CLIENT_TEXTFILE_COLLECTOR_H_
+#define SYSTEM_INSIGHT_CLIENT_TEXTFILE_COLLECTOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace client {
+
+/**
+ * @brief 文本文件采集配置
+ */
+struct TextfileCollectorOptions {
+  std::string directory;
+  // 单个文件最多读取的字节数与样本数，超出部分丢弃并计为解析错误
+  size_t max_file_bytes = 1 << 20;
+  size_t max_samples_per_file = 10000;
+  // 单行上限；更长的行整行跳过
+  size_t max_line_bytes = 4096;
+};
+
+/**
+ * @brief 读取批处理任务写入目录的 *.prom 文件（Prometheus 文本格式，与 node_exporter
+ *        textfile collector 相同的约定）
+ *
+ * 用 inotify 监听目录，只重新解析发生过 IN_CLOSE_WRITE / IN_MOVED_TO / IN_DELETE /
+ * IN_MOVED_FROM 的文件，解析结果缓存为样本；每个周期把缓存样本以当前时间戳追加到报告。
+ * 未变化的文件每个周期只有一次拷贝，不再读盘。事件队列溢出或目录被删除重建时整体重扫；
+ * inotify 不可用时退化为每个周期比较 mtime 与大小。
+ *
+ * 解析按固定大小的缓冲区流式读取，行长、文件大小与样本数都有上限。注释行（# HELP /
+ * # TYPE）被忽略，样本行自带的时间戳不使用。每个文件另附
+ * system_insight.agent.textfile_mtime_seconds{file=...}，解析错误累计为
+ * system_insight.agent.textfile_parse_errors_total。非线程安全，由采集线程调用。
+ */
+class TextfileCollector {
+ public:
+  explicit TextfileCollector(const TextfileCollectorOptions& options);
+  ~TextfileCollector();
+
+  TextfileCollector(const TextfileCollector&) = delete;
+  TextfileCollector& operator=(const TextfileCollector&) = delete;
+
+  void Append(int64_t timestamp_ms, systeminsight::proto::MetricsReport* report);
+
+  size_t file_count() const { return files_.size(); }
+  // 累计解析过的文件次数，用于确认未变化的文件没有被重复解析
+  uint64_t files_parsed_total() const { return files_parsed_total_; }
+  uint64_t parse_errors_total() const { return parse_errors_total_; }
+
+  /**
+   * @brief 解析一行样本，例如 `job_last_success{job="backup"} 1.7e9`
+   * @return 注释、空行或格式错误时返回 false；格式错误时 *error 置 true
+   */
+  static bool ParseLine(std::string_view line, systeminsight::proto::MetricSample* sample,
+                        bool* error);
+
+ private:
+  struct FileEntry {
+    std::vector<systeminsight::proto::MetricSample> samples;
+    int64_t mtime_ns = -1;
+    int64_t size = -1;
+    double mtime_seconds = 0.0;
+  };
+
+  void EnsureWatch();
+  void ReadEvents();
+  void Rescan();
+  // force 为 false 时 mtime 与大小都未变化的文件不重新解析
+  void Reload(const std::string& name, bool force);
+  bool ParseFile(const std::string& path, FileEntry* entry);
+  static bool IsTextfile(std::string_view name);
+
+  TextfileCollectorOptions options_;
+  int inotify_fd_ = -1;
+  int watch_ = -1;
+  bool rescan_ = true;
+  std::map<std::string, FileEntry> files_;  // 按文件名
+  std::set<std::string> changed_;
+  std::vector<char> buffer_;  // 流式读取缓冲区
+  std::string line_;          // 跨缓冲区边界的行
+  uint64_t files_parsed_total_ = 0;
+  uint64_t parse_errors_total_ = 0;
+};
+
+}  // namespace client
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_CLIENT_TEXTFILE_COLLECTOR_H_
@@ -0,0 +1,220 @@
+#include "src/client/window_aggregator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "src/common/codec/columnar_codec.h"
+
+namespace system_insight {
+namespace client {
+
+namespace {
+
+constexpr double kGamma = 1.05;
+constexpr double kMinPositive = 1e-9;
+const double kInvLogGamma = 1.0 / std::log(kGamma);
+
+const char* const kSummarySuffixes[] = {".min", ".max", ".mean", ".p50", ".p90", ".p99"};
+constexpr double kSummaryQuantiles[] = {0.0, 0.0, 0.0, 0.50, 0.90, 0.99};
+
+int LogBucket(double value) {
+  return static_cast<int>(std::floor(std::log(value) * kInvLogGamma));
+}
+
+// 桶 [gamma^i, gamma^(i+1)) 的代表值，使两端的相对误差相等
+double BucketValue(int index) {
+  return std::pow(kGamma, index) * 2.0 * kGamma / (kGamma + 1.0);
+}
+
+}  // namespace
+
+void QuantileSketch::Add(double value) {
+  ++count_;
+  if (value > kMinPositive) {
+    positive_.Add(LogBucket(value));
+  } else if (value < -kMinPositive) {
+    negative_.Add(LogBucket(-value));
+  } else {
+    // 包括 NaN
+    ++zero_count_;
+  }
+}
+
+double QuantileSketch::Quantile(double q) const {
+  if (count_ == 0) return 0.0;
+  const double rank = std::clamp(q, 0.0, 1.0) * (count_ - 1);
+  uint64_t seen = 0;
+  // 从绝对值最大的负值开始
+  for (int i = kBuckets - 1; i >= 0; --i) {
+    seen += negative_.counts[i];
+    if (rank < seen) {
+      return -BucketValue(negative_.base + i);
+    }
+  }
+  seen += zero_count_;
+  if (rank < seen) return 0.0;
+  for (int i = 0; i < kBuckets; ++i) {
+    seen += positive_.counts[i];
+    if (rank < seen) {
+      return BucketValue(positive_.base + i);
+    }
+  }
+  // 计数饱和时落到最大的非空桶
+  const int highest = positive_.HighestOccupied();
+  if (highest >= 0) return BucketValue(positive_.base + highest);
+  if (zero_count_ > 0) return 0.0;
+  for (int i = 0; i < kBuckets; ++i) {
+    if (negative_.counts[i] != 0) return -BucketValue(negative_.base + i);
+  }
+  return 0.0;
+}
+
+void QuantileSketch::Reset() {
+  positive_.Reset();
+  negative_.Reset();
+  zero_count_ = 0;
+  count_ = 0;
+}
+
+void QuantileSketch::LogBuckets::Add(int index) {
+  if (!has_base) {
+    base = index - kBuckets / 2;
+    has_base = true;
+  } else if (index >= base + kBuckets) {
+    // 向上平移窗口，越出底部的桶合并到最低桶
+    Rebase(index - kBuckets + 1);
+  } else if (index < base) {
+    int highest = HighestOccupied();
+    if (highest < 0 || base + highest - index < kBuckets) {
+      Rebase(index);
+    } else {
+      index = base;  // 跨度放不下，合并到最低桶
+    }
+  }
+
+  auto& bucket = counts[index - base];
+  if (bucket < std::numeric_limits<uint16_t>::max()) {
+    ++bucket;
+  }
+}
+
+void QuantileSketch::LogBuckets::Rebase(int new_base) {
+  std::array<uint16_t, kBuckets> rebased{};
+  for (int i = 0; i < kBuckets; ++i) {
+    if (counts[i] == 0) continue;
+    int target = std::clamp(base + i - new_base, 0, kBuckets - 1);
+    uint32_t merged = static_cast<uint32_t>(rebased[target]) + counts[i];
+    rebased[target] =
+        static_cast<uint16_t>(std::min<uint32_t>(merged, std::numeric_limits<uint16_t>::max()));
+  }
+  counts = rebased;
+  base = new_base;
+}
+
+int QuantileSketch::LogBuckets::HighestOccupied() const {
+  for (int i = kBuckets - 1; i >= 0; --i) {
+    if (counts[i] != 0) return i;
+  }
+  return -1;
+}
+
+void QuantileSketch::LogBuckets::Reset() {
+  counts.fill(0);
+  has_base = false;
+}
+
+WindowAggregator::SeriesWindow* WindowAggregator::FindOrCreate(
+    const systeminsight::proto::MetricSample& sample, size_t position) {
+  common::codec::BuildSeriesKey(sample.name(), sample.labels(), &key_);
+
+  if (position < order_.size() && series_[order_[position]]->key == key_) {
+    return series_[order_[position]].get();
+  }
+
+  size_t slot = 0;
+  auto it = index_.find(key_);
+  if (it != index_.end()) {
+    slot = it->second;
+  } else {
+    auto series = std::make_unique<SeriesWindow>();
+    series->key = key_;
+    series->prototype.set_name(sample.name());
+    *series->prototype.mutable_labels() = sample.labels();
+    for (int i = 0; i < kSummaryCount; ++i) {
+      series->summary_names[i] = sample.name() + kSummarySuffixes[i];
+    }
+    slot = series_.size();
+    series_.push_back(std::move(series));
+    index_.emplace(key_, slot);
+  }
+
+  if (position >= order_.size()) {
+    order_.resize(position + 1);
+  }
+  order_[position] = slot;
+  return series_[slot].get();
+}
+
+void WindowAggregator::Add(const systeminsight::proto::MetricsReport& samples) {
+  for (int i = 0; i < samples.samples_size(); ++i) {
+    const auto& sample = samples.samples(i);
+    SeriesWindow* series = FindOrCreate(sample, static_cast<size_t>(i));
+    const double value = sample.value();
+    if (series->count == 0) {
+      series->min = value;
+      series->max = value;
+      series->sum = 0.0;
+    } else {
+      series->min = std::min(series->min, value);
+      series->max = std::max(series->max, value);
+    }
+    series->sum += value;
+    series->last = value;
+    series->last_timestamp_ms = sample.timestamp_ms();
+    series->sketch.Add(value);
+    ++series->count;
+  }
+}
+
+void WindowAggregator::Flush(systeminsight::proto::MetricsReport* report) {
+  for (auto& series : series_) {
+    if (series->count == 0) continue;
+
+    auto emit = [&](const std::string& name, double value) {
+      auto* sample = report->add_samples();
+      sample->set_name(name);
+      sample->set_value(value);
+      sample->set_timestamp_ms(series->last_timestamp_ms);
+      *sample->mutable_labels() = series->prototype.labels();
+    };
+
+    emit(series->prototype.name(), series->last);
+    for (int i = 0; i < kSummaryCount; ++i) {
+      double value = 0.0;
+      switch (i) {
+        case kMin:
+          value = series->min;
+          break;
+        case kMax:
+          value = series->max;
+          break;
+        case kMean:
+          value = series->sum / series->count;
+          break;
+        default:
+          // 草图是近似值，限制在窗口实际的取值范围内
+          value = std::clamp(series->sketch.Quantile(kSummaryQuantiles[i]), series->min,
+                             series->max);
+          break;
+      }
+      emit(series->summary_names[i], value);
+    }
+
+    series->count = 0;
+    series->sketch.Reset();
+  }
+}
+
+}  // namespace client
+}  // namespace system_insight
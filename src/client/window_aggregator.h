@@ -0,0 +1,114 @@
+#ifndef SYSTEM_INSIGHT_CLIENT_WINDOW_AGGREGATOR_H_
+#define SYSTEM_INSIGHT_CLIENT_WINDOW_AGGREGATOR_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace client {
+
+/**
+ * @brief 定长对数分桶的分位数草图
+ *
+ * 桶边界为 gamma^i（gamma = 1.05，相对误差约 2.5%），128 个 16 位计数器，
+ * 只覆盖当前窗口数据所在的一段指数区间；数据跨度超出时把最低的桶合并到一起，
+ * 保证高分位数的精度。负值按绝对值记入一组镜像的桶，绝对值不足 kMinPositive 的值
+ * （包括 0）单独计数。
+ */
+class QuantileSketch {
+ public:
+  static constexpr int kBuckets = 128;
+
+  void Add(double value);
+
+  /**
+   * @brief 估计分位数
+   * @param q 取值范围 [0, 1]；没有数据时返回 0
+   */
+  double Quantile(double q) const;
+
+  void Reset();
+  uint32_t count() const { return count_; }
+
+ private:
+  // 一侧（正值，或负值的绝对值）的对数桶窗口
+  struct LogBuckets {
+    std::array<uint16_t, kBuckets> counts{};
+    int base = 0;  // counts[0] 对应的对数桶编号
+    bool has_base = false;
+
+    void Add(int index);
+    void Rebase(int new_base);
+    int HighestOccupied() const;
+    void Reset();
+  };
+
+  LogBuckets positive_;
+  LogBuckets negative_;
+  uint32_t zero_count_ = 0;
+  uint32_t count_ = 0;
+};
+
+/**
+ * @brief 客户端窗口聚合
+ *
+ * 以高频率（sample_interval_ms）采样、低频率（collection_interval_ms）上报：
+ * 每次采样通过 Add() 累积到各序列的窗口汇总中，窗口结束时 Flush() 为每个序列输出
+ * - 原指标名：窗口内最后一个值
+ * - <name>.min / .max / .mean
+ * - <name>.p50 / .p90 / .p99：由 QuantileSketch 估计
+ *
+ * 每个序列在首次出现时分配一个槽位（包括汇总指标名），之后原地更新、
+ * 每个窗口结束时清零复用；稳态下 Add 与 Flush 都不再分配内存。
+ */
+class WindowAggregator {
+ public:
+  /**
+   * @brief 把一次采样的全部样本累积到当前窗口
+   */
+  void Add(const systeminsight::proto::MetricsReport& samples);
+
+  /**
+   * @brief 把当前窗口的汇总追加到 report->samples，并开始新窗口
+   */
+  void Flush(systeminsight::proto::MetricsReport* report);
+
+  size_t series_count() const { return series_.size(); }
+
+ private:
+  enum Summary { kMin, kMax, kMean, kP50, kP90, kP99, kSummaryCount };
+
+  struct SeriesWindow {
+    std::string key;
+    systeminsight::proto::MetricSample prototype;  // 名称与标签
+    std::array<std::string, kSummaryCount> summary_names;
+
+    uint32_t count = 0;
+    double min = 0.0;
+    double max = 0.0;
+    double sum = 0.0;
+    double last = 0.0;
+    int64_t last_timestamp_ms = 0;
+    QuantileSketch sketch;
+  };
+
+  SeriesWindow* FindOrCreate(const systeminsight::proto::MetricSample& sample, size_t position);
+
+  std::vector<std::unique_ptr<SeriesWindow>> series_;
+  std::unordered_map<std::string, size_t> index_;
+  // 上一次采样中每个位置对应的序列；样本顺序通常不变，可以跳过哈希查找
+  std::vector<size_t> order_;
+  std::string key_;
+};
+
+}  // namespace client
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_CLIENT_WINDOW_AGGREGATOR_H_
@@ -0,0 +1,70 @@
+#include "src/common/codec/bit_stream.h"
+
+namespace system_insight {
+namespace common {
+namespace codec {
+
+BitWriter::BitWriter(std::string* out) : out_(out) {}
+
+void BitWriter::WriteBit(bool bit) {
+  if (free_bits_ == 0) {
+    out_->push_back('\0');
+    free_bits_ = 8;
+  }
+  --free_bits_;
+  if (bit) {
+    out_->back() = static_cast<char>(static_cast<uint8_t>(out_->back()) | (1u << free_bits_));
+  }
+}
+
+void BitWriter::WriteBits(uint64_t value, int num_bits) {
+  while (num_bits > 0) {
+    if (free_bits_ == 0) {
+      out_->push_back('\0');
+      free_bits_ = 8;
+    }
+    // 一次写满当前字节的剩余空间
+    int chunk = num_bits < free_bits_ ? num_bits : free_bits_;
+    num_bits -= chunk;
+    uint8_t bits = static_cast<uint8_t>((value >> num_bits) & ((1u << chunk) - 1));
+    free_bits_ -= chunk;
+    out_->back() = static_cast<char>(static_cast<uint8_t>(out_->back()) | (bits << free_bits_));
+  }
+}
+
+size_t BitWriter::BitSize() const {
+  return out_->size() * 8 - free_bits_;
+}
+
+BitReader::BitReader(const void* data, size_t size)
+    : data_(static_cast<const uint8_t*>(data)), total_bits_(size * 8) {}
+
+bool BitReader::ReadBit(bool* bit) {
+  if (position_ >= total_bits_) return false;
+  *bit = (data_[position_ >> 3] >> (7 - (position_ & 7))) & 1;
+  ++position_;
+  return true;
+}
+
+bool BitReader::ReadBits(int num_bits, uint64_t* value) {
+  if (num_bits < 0 || num_bits > 64 || RemainingBits() < static_cast<size_t>(num_bits)) {
+    return false;
+  }
+  uint64_t result = 0;
+  while (num_bits > 0) {
+    int offset = static_cast<int>(position_ & 7);
+    int available = 8 - offset;
+    int chunk = num_bits < available ? num_bits : available;
+    uint8_t byte = data_[position_ >> 3];
+    uint8_t bits = static_cast<uint8_t>((byte >> (available - chunk)) & ((1u << chunk) - 1));
+    result = (result << chunk) | bits;
+    position_ += chunk;
+    num_bits -= chunk;
+  }
+  *value = result;
+  return true;
+}
+
+}  // namespace codec
+}  // namespace common
+}  // namespace system_insight
@@ -0,0 +1,61 @@
+#ifndef SYSTEM_INSIGHT_COMMON_CODEC_BIT_STREAM_H_
+#define SYSTEM_INSIGHT_COMMON_CODEC_BIT_STREAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace system_insight {
+namespace common {
+namespace codec {
+
+/**
+ * @brief 按位追加写入器（高位在前）
+ *
+ * 直接写入调用方提供的 std::string，便于与 protobuf bytes 字段配合，
+ * 避免额外的缓冲区拷贝。
+ */
+class BitWriter {
+ public:
+  explicit BitWriter(std::string* out);
+
+  void WriteBit(bool bit);
+
+  /**
+   * @brief 写入 value 的低 num_bits 位
+   * @param num_bits 取值范围 [0, 64]
+   */
+  void WriteBits(uint64_t value, int num_bits);
+
+  size_t BitSize() const;
+
+ private:
+  std::string* out_;
+  int free_bits_ = 0;  // 最后一个字节中尚未使用的位数
+};
+
+/**
+ * @brief 按位读取器，与 BitWriter 对应
+ *
+ * 读取越界时返回 false，不会访问缓冲区之外的内存。
+ */
+class BitReader {
+ public:
+  BitReader(const void* data, size_t size);
+
+  bool ReadBit(bool* bit);
+  bool ReadBits(int num_bits, uint64_t* value);
+
+  size_t RemainingBits() const { return total_bits_ - position_; }
+
+ private:
+  const uint8_t* data_;
+  size_t total_bits_;
+  size_t position_ = 0;
+};
+
+}  // namespace codec
+}  // namespace common
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_COMMON_CODEC_BIT_STREAM_H_
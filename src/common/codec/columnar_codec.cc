@@ -0,0 +1,283 @@
+#include "src/common/codec/columnar_codec.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
+
+#include "src/common/codec/bit_stream.h"
+#include "src/common/codec/gorilla.h"
+
+namespace system_insight {
+namespace common {
+namespace codec {
+
+using systeminsight::proto::ColumnarSamples;
+using systeminsight::proto::MetricsReport;
+using systeminsight::proto::ReportAck;
+using systeminsight::proto::ReportEncoding;
+
+namespace {
+
+// 布局变化时，按序列 key 查找上一份报告中的值作为 XOR 参考
+class PreviousValueLookup {
+ public:
+  PreviousValueLookup(const std::vector<std::string>& keys, const std::vector<double>& values) {
+    index_.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); ++i) {
+      index_.emplace(keys[i], values[i]);
+    }
+  }
+
+  double Find(const std::string& key) const {
+    auto it = index_.find(key);
+    return it == index_.end() ? 0.0 : it->second;
+  }
+
+ private:
+  std::unordered_map<std::string, double> index_;
+};
+
+}  // namespace
+
+bool ParseReportEncoding(const std::string& name, ReportEncoding* encoding) {
+  if (name == "row") {
+    *encoding = systeminsight::proto::REPORT_ENCODING_ROW;
+  } else if (name == "columnar") {
+    *encoding = systeminsight::proto::REPORT_ENCODING_COLUMNAR;
+  } else if (name == "columnar_xor") {
+    *encoding = systeminsight::proto::REPORT_ENCODING_COLUMNAR_XOR;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char* ReportEncodingName(ReportEncoding encoding) {
+  switch (encoding) {
+    case systeminsight::proto::REPORT_ENCODING_COLUMNAR:
+      return "columnar";
+    case systeminsight::proto::REPORT_ENCODING_COLUMNAR_XOR:
+      return "columnar_xor";
+    default:
+      return "row";
+  }
+}
+
+ReportEncoding NegotiateReportEncoding(ReportEncoding preferred, const ReportAck& ack) {
+  ReportEncoding best = systeminsight::proto::REPORT_ENCODING_ROW;
+  for (int raw : ack.supported_encodings()) {
+    auto candidate = static_cast<ReportEncoding>(raw);
+    if (candidate <= preferred && candidate > best) {
+      best = candidate;
+    }
+  }
+  return best;
+}
+
+void BuildSeriesKey(const std::string& name,
+                    const google::protobuf::RepeatedPtrField<systeminsight::proto::MetricLabel>& labels,
+                    std::string* out) {
+  out->assign(name);
+  for (const auto& label : labels) {
+    out->push_back('\0');
+    out->append(label.key());
+    out->push_back('=');
+    out->append(label.value());
+  }
+}
+
+ColumnarEncoder::ColumnarEncoder(ReportEncoding encoding) : encoding_(encoding) {}
+
+void ColumnarEncoder::Reset() {
+  has_base_ = false;
+  prev_keys_.clear();
+  prev_values_.clear();
+}
+
+void ColumnarEncoder::Encode(MetricsReport* report) {
+  Encode(*report, report->mutable_columnar());
+  report->clear_samples();
+}
+
+void ColumnarEncoder::Encode(const MetricsReport& source, ColumnarSamples* columnar) {
+  const int count = source.samples_size();
+  current_keys_.resize(count);
+  current_values_.resize(count);
+
+  int64_t base_timestamp_ms = 0;
+  for (int i = 0; i < count; ++i) {
+    const auto& sample = source.samples(i);
+    BuildSeriesKey(sample.name(), sample.labels(), &current_keys_[i]);
+    current_values_[i] = sample.value();
+    if (i == 0 || sample.timestamp_ms() < base_timestamp_ms) {
+      base_timestamp_ms = sample.timestamp_ms();
+    }
+  }
+
+  const bool same_layout = has_base_ && current_keys_ == prev_keys_;
+  columnar->Clear();
+  columnar->set_encoding(encoding_);
+  columnar->set_base_timestamp_ms(base_timestamp_ms);
+
+  bool need_offsets = false;
+  for (const auto& sample : source.samples()) {
+    if (sample.timestamp_ms() != base_timestamp_ms) {
+      need_offsets = true;
+      break;
+    }
+  }
+  if (need_offsets) {
+    columnar->mutable_timestamp_offsets_ms()->Reserve(count);
+    for (const auto& sample : source.samples()) {
+      columnar->add_timestamp_offsets_ms(sample.timestamp_ms() - base_timestamp_ms);
+    }
+  }
+
+  uint64_t base_sequence = 0;
+  if (same_layout) {
+    columnar->set_reuse_layout(true);
+    base_sequence = sequence_;
+  } else {
+    columnar->mutable_series()->Reserve(count);
+    for (const auto& sample : source.samples()) {
+      auto* series = columnar->add_series();
+      series->set_name(sample.name());
+      *series->mutable_labels() = sample.labels();
+    }
+  }
+
+  if (encoding_ == systeminsight::proto::REPORT_ENCODING_COLUMNAR_XOR) {
+    XorEncoder xor_encoder;
+    BitWriter writer(columnar->mutable_xor_values());
+    if (same_layout) {
+      for (int i = 0; i < count; ++i) {
+        xor_encoder.Encode(current_values_[i], prev_values_[i], &writer);
+      }
+    } else if (has_base_) {
+      // 布局变化但仍有历史值：按序列 key 对齐参考值
+      PreviousValueLookup lookup(prev_keys_, prev_values_);
+      for (int i = 0; i < count; ++i) {
+        xor_encoder.Encode(current_values_[i], lookup.Find(current_keys_[i]), &writer);
+      }
+      base_sequence = sequence_;
+    } else {
+      for (int i = 0; i < count; ++i) {
+        xor_encoder.Encode(current_values_[i], 0.0, &writer);
+      }
+    }
+  } else {
+    columnar->mutable_values()->Reserve(count);
+    for (double value : current_values_) {
+      columnar->add_values(value);
+    }
+  }
+
+  columnar->set_sequence(++sequence_);
+  columnar->set_base_sequence(base_sequence);
+
+  prev_keys_.swap(current_keys_);
+  prev_values_.swap(current_values_);
+  has_base_ = true;
+}
+
+void ColumnarDecoder::Reset() {
+  has_base_ = false;
+  prev_series_.clear();
+  prev_keys_.clear();
+  prev_values_.clear();
+}
+
+ColumnarDecoder::Status ColumnarDecoder::Decode(MetricsReport* report) {
+  if (!report->has_columnar()) return Status::kOk;
+  ColumnarSamples* columnar = report->mutable_columnar();
+
+  const uint64_t base_sequence = columnar->base_sequence();
+  if (base_sequence != 0 && (!has_base_ || base_sequence != sequence_)) {
+    return Status::kMissingBase;
+  }
+  if (columnar->reuse_layout() && base_sequence == 0) {
+    return Status::kMalformed;
+  }
+
+  const bool reuse_layout = columnar->reuse_layout();
+  const size_t count = reuse_layout ? prev_series_.size()
+                                    : static_cast<size_t>(columnar->series_size());
+  const size_t offsets = static_cast<size_t>(columnar->timestamp_offsets_ms_size());
+  if (offsets != 0 && offsets != count) {
+    return Status::kMalformed;
+  }
+
+  std::vector<std::string> keys;
+  if (reuse_layout) {
+    keys = prev_keys_;
+  } else {
+    keys.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+      const auto& series = columnar->series(static_cast<int>(i));
+      BuildSeriesKey(series.name(), series.labels(), &keys[i]);
+    }
+  }
+
+  std::vector<double> values(count);
+  switch (columnar->encoding()) {
+    case systeminsight::proto::REPORT_ENCODING_COLUMNAR:
+      if (static_cast<size_t>(columnar->values_size()) != count) {
+        return Status::kMalformed;
+      }
+      std::copy(columnar->values().begin(), columnar->values().end(), values.begin());
+      break;
+    case systeminsight::proto::REPORT_ENCODING_COLUMNAR_XOR: {
+      BitReader reader(columnar->xor_values().data(), columnar->xor_values().size());
+      XorDecoder xor_decoder;
+      if (reuse_layout) {
+        for (size_t i = 0; i < count; ++i) {
+          if (!xor_decoder.Decode(&reader, prev_values_[i], &values[i])) return Status::kMalformed;
+        }
+      } else if (base_sequence != 0) {
+        PreviousValueLookup lookup(prev_keys_, prev_values_);
+        for (size_t i = 0; i < count; ++i) {
+          if (!xor_decoder.Decode(&reader, lookup.Find(keys[i]), &values[i])) {
+            return Status::kMalformed;
+          }
+        }
+      } else {
+        for (size_t i = 0; i < count; ++i) {
+          if (!xor_decoder.Decode(&reader, 0.0, &values[i])) return Status::kMalformed;
+        }
+      }
+      break;
+    }
+    default:
+      return Status::kMalformed;
+  }
+
+  if (!reuse_layout) {
+    prev_series_.clear();
+    prev_series_.reserve(count);
+    for (auto& series : *columnar->mutable_series()) {
+      prev_series_.push_back(std::move(series));
+    }
+  }
+
+  auto* samples = report->mutable_samples();
+  samples->Reserve(static_cast<int>(count));
+  for (size_t i = 0; i < count; ++i) {
+    auto* sample = samples->Add();
+    sample->set_name(prev_series_[i].name());
+    *sample->mutable_labels() = prev_series_[i].labels();
+    sample->set_value(values[i]);
+    int64_t offset = offsets == 0 ? 0 : columnar->timestamp_offsets_ms(static_cast<int>(i));
+    sample->set_timestamp_ms(columnar->base_timestamp_ms() + offset);
+  }
+
+  sequence_ = columnar->sequence();
+  prev_keys_ = std::move(keys);
+  prev_values_ = std::move(values);
+  has_base_ = true;
+  report->clear_columnar();
+  return Status::kOk;
+}
+
+}  // namespace codec
+}  // namespace common
+}  // namespace system_insight
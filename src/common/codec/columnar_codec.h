@@ -0,0 +1,105 @@
+#ifndef SYSTEM_INSIGHT_COMMON_CODEC_COLUMNAR_CODEC_H_
+#define SYSTEM_INSIGHT_COMMON_CODEC_COLUMNAR_CODEC_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace common {
+namespace codec {
+
+/**
+ * @brief 解析配置中的编码名称（"row" / "columnar" / "columnar_xor"）
+ * @return 名称无法识别时返回 false
+ */
+bool ParseReportEncoding(const std::string& name, systeminsight::proto::ReportEncoding* encoding);
+
+const char* ReportEncodingName(systeminsight::proto::ReportEncoding encoding);
+
+/**
+ * @brief 根据服务端声明的编码能力，选出不超过 preferred 的最佳编码
+ *
+ * 旧服务端的 ack 不携带 supported_encodings，此时回退到行式编码。
+ */
+systeminsight::proto::ReportEncoding NegotiateReportEncoding(
+    systeminsight::proto::ReportEncoding preferred, const systeminsight::proto::ReportAck& ack);
+
+/**
+ * @brief 把序列标识（名称 + 标签）写成唯一的 key，结果写入 out（复用其容量）
+ */
+void BuildSeriesKey(const std::string& name,
+                    const google::protobuf::RepeatedPtrField<systeminsight::proto::MetricLabel>& labels,
+                    std::string* out);
+
+/**
+ * @brief 列式报告编码器（客户端，每个连接一个实例）
+ *
+ * 把 MetricsReport.samples 原地转换为 MetricsReport.columnar：
+ * - 整份报告一个基准时间戳，样本只携带偏移（全部相同则省略）
+ * - 序列布局与上一份报告相同时不再重复发送名称和标签
+ * - XOR 模式下每个值与同一序列上一次发送的值做 Gorilla XOR
+ *
+ * 依赖上一份报告的编码（reuse_layout / XOR）通过 base_sequence 声明依赖，
+ * 发送失败或服务端要求关键帧时调用 Reset()，下一份报告即为关键帧。
+ */
+class ColumnarEncoder {
+ public:
+  explicit ColumnarEncoder(systeminsight::proto::ReportEncoding encoding);
+
+  /**
+   * @brief 原地编码：填充 report->columnar 并清空 report->samples
+   */
+  void Encode(systeminsight::proto::MetricsReport* report);
+
+  /**
+   * @brief 把 source.samples 编码进 columnar，source 保持不变（发送失败时仍可重放）
+   */
+  void Encode(const systeminsight::proto::MetricsReport& source,
+              systeminsight::proto::ColumnarSamples* columnar);
+
+  void Reset();
+
+  systeminsight::proto::ReportEncoding encoding() const { return encoding_; }
+
+ private:
+  systeminsight::proto::ReportEncoding encoding_;
+  uint64_t sequence_ = 0;
+  bool has_base_ = false;
+  std::vector<std::string> prev_keys_;
+  std::vector<double> prev_values_;
+  std::vector<std::string> current_keys_;
+  std::vector<double> current_values_;
+};
+
+/**
+ * @brief 列式报告解码器（服务端，每个主机一个实例）
+ *
+ * 把 MetricsReport.columnar 原地还原为 MetricsReport.samples。
+ */
+class ColumnarDecoder {
+ public:
+  enum class Status {
+    kOk,
+    kMissingBase,  // 缺少 base_sequence 对应的状态，需要关键帧
+    kMalformed,
+  };
+
+  Status Decode(systeminsight::proto::MetricsReport* report);
+  void Reset();
+
+ private:
+  uint64_t sequence_ = 0;
+  bool has_base_ = false;
+  std::vector<systeminsight::proto::SeriesDescriptor> prev_series_;
+  std::vector<std::string> prev_keys_;
+  std::vector<double> prev_values_;
+};
+
+}  // namespace codec
+}  // namespace common
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_COMMON_CODEC_COLUMNAR_CODEC_H_
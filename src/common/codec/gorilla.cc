@@ -0,0 +1,96 @@
+#include "src/common/codec/gorilla.h"
+
+#include <cstring>
+
+namespace system_insight {
+namespace common {
+namespace codec {
+
+namespace {
+// 前导零个数用 5 位存储，超过 31 的部分当作有效位写出
+constexpr int kMaxLeadingZeros = 31;
+}  // namespace
+
+uint64_t DoubleToBits(double value) {
+  uint64_t bits = 0;
+  std::memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+double BitsToDouble(uint64_t bits) {
+  double value = 0;
+  std::memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+void XorEncoder::Reset() {
+  prev_leading_ = -1;
+  prev_trailing_ = 0;
+}
+
+void XorEncoder::Encode(double value, double reference, BitWriter* writer) {
+  uint64_t xor_bits = DoubleToBits(value) ^ DoubleToBits(reference);
+  if (xor_bits == 0) {
+    writer->WriteBit(false);
+    return;
+  }
+  writer->WriteBit(true);
+
+  int leading = __builtin_clzll(xor_bits);
+  int trailing = __builtin_ctzll(xor_bits);
+  if (leading > kMaxLeadingZeros) leading = kMaxLeadingZeros;
+
+  if (prev_leading_ >= 0 && leading >= prev_leading_ && trailing >= prev_trailing_) {
+    writer->WriteBit(false);
+    int significant = 64 - prev_leading_ - prev_trailing_;
+    writer->WriteBits(xor_bits >> prev_trailing_, significant);
+    return;
+  }
+
+  int significant = 64 - leading - trailing;
+  writer->WriteBit(true);
+  writer->WriteBits(static_cast<uint64_t>(leading), 5);
+  // 有效位长度取值 [1, 64]，64 用 0 表示
+  writer->WriteBits(static_cast<uint64_t>(significant & 63), 6);
+  writer->WriteBits(xor_bits >> trailing, significant);
+  prev_leading_ = leading;
+  prev_trailing_ = trailing;
+}
+
+void XorDecoder::Reset() {
+  prev_leading_ = -1;
+  prev_trailing_ = 0;
+}
+
+bool XorDecoder::Decode(BitReader* reader, double reference, double* value) {
+  bool changed = false;
+  if (!reader->ReadBit(&changed)) return false;
+  if (!changed) {
+    *value = reference;
+    return true;
+  }
+
+  bool new_window = false;
+  if (!reader->ReadBit(&new_window)) return false;
+  if (new_window) {
+    uint64_t leading = 0;
+    uint64_t significant = 0;
+    if (!reader->ReadBits(5, &leading) || !reader->ReadBits(6, &significant)) return false;
+    if (significant == 0) significant = 64;
+    if (leading + significant > 64) return false;
+    prev_leading_ = static_cast<int>(leading);
+    prev_trailing_ = static_cast<int>(64 - leading - significant);
+  } else if (prev_leading_ < 0) {
+    return false;
+  }
+
+  int significant = 64 - prev_leading_ - prev_trailing_;
+  uint64_t bits = 0;
+  if (!reader->ReadBits(significant, &bits)) return false;
+  *value = BitsToDouble(DoubleToBits(reference) ^ (bits << prev_trailing_));
+  return true;
+}
+
+}  // namespace codec
+}  // namespace common
+}  // namespace system_insight
@@ -0,0 +1,49 @@
+#ifndef SYSTEM_INSIGHT_COMMON_CODEC_GORILLA_H_
+#define SYSTEM_INSIGHT_COMMON_CODEC_GORILLA_H_
+
+#include <cstdint>
+
+#include "src/common/codec/bit_stream.h"
+
+namespace system_insight {
+namespace common {
+namespace codec {
+
+/**
+ * @brief Gorilla 风格的 XOR 浮点值编码器
+ *
+ * 每个值与调用方给出的参考值做 XOR：
+ * - 相同：写 1 位 '0'
+ * - 有效位落在上一个窗口内：写 '10' + 窗口内的有效位
+ * - 否则：写 '11' + 5 位前导零个数 + 6 位有效位长度 + 有效位
+ *
+ * 参考值由调用方决定（同一序列的上一个值），窗口状态在编码器内延续。
+ */
+class XorEncoder {
+ public:
+  void Reset();
+  void Encode(double value, double reference, BitWriter* writer);
+
+ private:
+  int prev_leading_ = -1;
+  int prev_trailing_ = 0;
+};
+
+class XorDecoder {
+ public:
+  void Reset();
+  bool Decode(BitReader* reader, double reference, double* value);
+
+ private:
+  int prev_leading_ = -1;
+  int prev_trailing_ = 0;
+};
+
+uint64_t DoubleToBits(double value);
+double BitsToDouble(uint64_t bits);
+
+}  // namespace codec
+}  // namespace common
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_COMMON_CODEC_GORILLA_H_
@@ -0,0 +1,70 @@
+#include "src/common/codec/report_pool.h"
+
+namespace system_insight {
+namespace common {
+namespace codec {
+
+namespace {
+
+google::protobuf::ArenaOptions SlotArenaOptions() {
+  google::protobuf::ArenaOptions options;
+  options.start_block_size = 8 * 1024;
+  options.max_block_size = 64 * 1024;
+  return options;
+}
+
+}  // namespace
+
+ReportSlot::ReportSlot() {
+  ResetArena();
+}
+
+void ReportSlot::ResetArena() {
+  report_ = nullptr;
+  arena_ = std::make_unique<google::protobuf::Arena>(SlotArenaOptions());
+  report_ = google::protobuf::Arena::CreateMessage<systeminsight::proto::MetricsReport>(arena_.get());
+}
+
+void ReportSlotReleaser::operator()(ReportSlot* slot) const {
+  pool->Release(slot);
+}
+
+ReportPool::ReportPool(size_t max_free_slots, size_t max_retained_bytes)
+    : max_free_slots_(max_free_slots), max_retained_bytes_(max_retained_bytes) {
+  free_.reserve(max_free_slots_);
+}
+
+PooledReport ReportPool::Acquire() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!free_.empty()) {
+      ReportSlot* slot = free_.back().release();
+      free_.pop_back();
+      return PooledReport(slot, ReportSlotReleaser{this});
+    }
+  }
+  return PooledReport(new ReportSlot(), ReportSlotReleaser{this});
+}
+
+size_t ReportPool::free_slots() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return free_.size();
+}
+
+void ReportPool::Release(ReportSlot* slot) {
+  std::unique_ptr<ReportSlot> owned(slot);
+  if (slot->arena_->SpaceAllocated() > max_retained_bytes_) {
+    slot->ResetArena();
+  } else {
+    slot->report_->Clear();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (free_.size() < max_free_slots_) {
+    free_.push_back(std::move(owned));
+  }
+}
+
+}  // namespace codec
+}  // namespace common
+}  // namespace system_insight
@@ -0,0 +1,89 @@
+#ifndef SYSTEM_INSIGHT_COMMON_CODEC_REPORT_POOL_H_
+#define SYSTEM_INSIGHT_COMMON_CODEC_REPORT_POOL_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "google/protobuf/arena.h"
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace common {
+namespace codec {
+
+class ReportPool;
+
+/**
+ * @brief 池化的上报报告，报告及其样本都分配在槽位自己的 Arena 上
+ */
+class ReportSlot {
+ public:
+  systeminsight::proto::MetricsReport* report() const { return report_; }
+  // 槽位 Arena 已向系统申请的字节数
+  uint64_t arena_bytes() const { return arena_->SpaceAllocated(); }
+
+ private:
+  friend class ReportPool;
+
+  ReportSlot();
+  void ResetArena();
+
+  std::unique_ptr<google::protobuf::Arena> arena_;
+  systeminsight::proto::MetricsReport* report_ = nullptr;
+};
+
+/**
+ * @brief 释放 PooledReport 时把槽位归还给所属的池
+ */
+struct ReportSlotReleaser {
+  ReportPool* pool = nullptr;
+  void operator()(ReportSlot* slot) const;
+};
+
+using PooledReport = std::unique_ptr<ReportSlot, ReportSlotReleaser>;
+
+/**
+ * @brief 上报报告池
+ *
+ * 客户端：采集周期从池中取出一个槽位，采集器直接把样本写入槽位中的报告；
+ * 报告在发送线程上完成（或落盘）后归还。
+ * 服务端：每个 RPC 调用把请求直接反序列化进槽位中的报告，报告连同槽位移交给入库
+ * 流水线，提交后归还。
+ *
+ * 归还时只 Clear() 报告：
+ * protobuf 会保留已清空的样本、标签对象以及字符串容量，下一次
+ * add_samples()/set_name() 或反序列化直接复用，稳态下几乎没有堆分配。
+ * Arena 占用超过 max_retained_bytes（例如合并过的大报告）时整体重置。
+ *
+ * Acquire 与归还可以在不同线程；池必须比所有取出的报告活得更久。
+ */
+class ReportPool {
+ public:
+  explicit ReportPool(size_t max_free_slots = 16, size_t max_retained_bytes = 1 << 20);
+
+  ReportPool(const ReportPool&) = delete;
+  ReportPool& operator=(const ReportPool&) = delete;
+
+  PooledReport Acquire();
+
+  size_t free_slots() const;
+
+ private:
+  friend struct ReportSlotReleaser;
+  void Release(ReportSlot* slot);
+
+  const size_t max_free_slots_;
+  const size_t max_retained_bytes_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<ReportSlot>> free_;
+};
+
+}  // namespace codec
+}  // namespace common
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_COMMON_CODEC_REPORT_POOL_H_
@@ -64,6 +64,35 @@ int ToIntOrDefault(const json& object, const char* key, int fallback) {
   return fallback;
 }
 
+double ToDoubleOrDefault(const json& object, const char* key, double fallback) {
+  if (auto it = object.find(key); it != object.end()) {
+    if (it->is_number()) {
+      return it->get<double>();
+    }
+    if (it->is_string()) {
+      try {
+        return std::stod(it->get<std::string>());
+      } catch (const std::exception&) {
+        return fallback;
+      }
+    }
+  }
+  return fallback;
+}
+
+std::vector<std::string> ToStringListOrDefault(const json& object, const char* key,
+                                               std::vector<std::string> fallback) {
+  auto it = object.find(key);
+  if (it == object.end() || !it->is_array()) return fallback;
+  std::vector<std::string> values;
+  for (const auto& item : *it) {
+    if (item.is_string()) {
+      values.push_back(item.get<std::string>());
+    }
+  }
+  return values;
+}
+
 }  // namespace
 
 ClientConfig LoadClientConfig(const std::string& path) {
@@ -78,6 +107,16 @@ ClientConfig LoadClientConfig(const std::string& path) {
     }
     config.collection_interval_ms =
         ToIntOrDefault(client_section, "collection_interval_ms", config.collection_interval_ms);
+    config.sample_interval_ms =
+        ToIntOrDefault(client_section, "sample_interval_ms", config.sample_interval_ms);
+    if (auto adaptive = client_section.find("adaptive_interval_enabled");
+        adaptive != client_section.end() && adaptive->is_boolean()) {
+      config.adaptive_interval_enabled = adaptive->get<bool>();
+    }
+    config.min_collection_interval_ms = ToIntOrDefault(
+        client_section, "min_collection_interval_ms", config.min_collection_interval_ms);
+    config.max_collection_interval_ms = ToIntOrDefault(
+        client_section, "max_collection_interval_ms", config.max_collection_interval_ms);
     if (auto log_level = client_section.find("log_level"); log_level != client_section.end() && log_level->is_string()) {
       config.log_level = log_level->get<std::string>();
     } else {
@@ -103,6 +142,90 @@ ClientConfig LoadClientConfig(const std::string& path) {
         mmap_softirq_path != client_section.end() && mmap_softirq_path->is_string()) {
       config.mmap_softirq_device_path = mmap_softirq_path->get<std::string>();
     }
+
+    if (auto encoding = client_section.find("report_encoding");
+        encoding != client_section.end() && encoding->is_string()) {
+      config.report_encoding = encoding->get<std::string>();
+    }
+
+    if (auto use_streaming = client_section.find("use_streaming");
+        use_streaming != client_section.end() && use_streaming->is_boolean()) {
+      config.use_streaming = use_streaming->get<bool>();
+    }
+    config.stream_reconnect_backoff_min_ms = ToIntOrDefault(
+        client_section, "stream_reconnect_backoff_min_ms", config.stream_reconnect_backoff_min_ms);
+    config.stream_reconnect_backoff_max_ms = ToIntOrDefault(
+        client_section, "stream_reconnect_backoff_max_ms", config.stream_reconnect_backoff_max_ms);
+    config.stream_credit_wait_ms =
+        ToIntOrDefault(client_section, "stream_credit_wait_ms", config.stream_credit_wait_ms);
+
+    config.send_queue_capacity =
+        ToIntOrDefault(client_section, "send_queue_capacity", config.send_queue_capacity);
+    if (auto policy = client_section.find("send_queue_overflow_policy");
+        policy != client_section.end() && policy->is_string()) {
+      config.send_queue_overflow_policy = policy->get<std::string>();
+    }
+    config.max_in_flight = ToIntOrDefault(client_section, "max_in_flight", config.max_in_flight);
+    config.send_timeout_ms =
+        ToIntOrDefault(client_section, "send_timeout_ms", config.send_timeout_ms);
+
+    if (auto spool = client_section.find("spool_directory");
+        spool != client_section.end() && spool->is_string()) {
+      config.spool_directory = spool->get<std::string>();
+    }
+    config.spool_max_mb = ToIntOrDefault(client_section, "spool_max_mb", config.spool_max_mb);
+    config.replay_max_reports_per_second = ToIntOrDefault(
+        client_section, "replay_max_reports_per_second", config.replay_max_reports_per_second);
+
+    if (auto deadband = client_section.find("deadband_enabled");
+        deadband != client_section.end() && deadband->is_boolean()) {
+      config.deadband_enabled = deadband->get<bool>();
+    }
+    config.deadband_absolute =
+        ToDoubleOrDefault(client_section, "deadband_absolute", config.deadband_absolute);
+    config.deadband_relative =
+        ToDoubleOrDefault(client_section, "deadband_relative", config.deadband_relative);
+    config.deadband_max_silence_ms =
+        ToIntOrDefault(client_section, "deadband_max_silence_ms", config.deadband_max_silence_ms);
+
+    if (auto shm = client_section.find("shm_ingestion_enabled");
+        shm != client_section.end() && shm->is_boolean()) {
+      config.shm_ingestion_enabled = shm->get<bool>();
+    }
+    if (auto shm_directory = client_section.find("shm_directory");
+        shm_directory != client_section.end() && shm_directory->is_string()) {
+      config.shm_directory = shm_directory->get<std::string>();
+    }
+    if (auto filesystem = client_section.find("filesystem_enabled");
+        filesystem != client_section.end() && filesystem->is_boolean()) {
+      config.filesystem_enabled = filesystem->get<bool>();
+    }
+    config.filesystem_include_fstypes = ToStringListOrDefault(
+        client_section, "filesystem_include_fstypes", config.filesystem_include_fstypes);
+    config.filesystem_exclude_fstypes = ToStringListOrDefault(
+        client_section, "filesystem_exclude_fstypes", config.filesystem_exclude_fstypes);
+    config.filesystem_exclude_mount_points = ToStringListOrDefault(
+        client_section, "filesystem_exclude_mount_points", config.filesystem_exclude_mount_points);
+    config.filesystem_network_spread_cycles = ToIntOrDefault(
+        client_section, "filesystem_network_spread_cycles", config.filesystem_network_spread_cycles);
+
+    if (auto memory = client_section.find("extended_memory_enabled");
+        memory != client_section.end() && memory->is_boolean()) {
+      config.extended_memory_enabled = memory->get<bool>();
+    }
+    config.memory_meminfo_keys = ToStringListOrDefault(client_section, "memory_meminfo_keys",
+                                                       config.memory_meminfo_keys);
+    config.memory_vmstat_keys =
+        ToStringListOrDefault(client_section, "memory_vmstat_keys", config.memory_vmstat_keys);
+    if (auto cpufreq = client_section.find("cpufreq_enabled");
+        cpufreq != client_section.end() && cpufreq->is_boolean()) {
+      config.cpufreq_enabled = cpufreq->get<bool>();
+    }
+
+    if (auto textfile = client_section.find("textfile_directory");
+        textfile != client_section.end() && textfile->is_string()) {
+      config.textfile_directory = textfile->get<std::string>();
+    }
   } else {
     LOGW("client section not found or not an object in config, using defaults");
   }
@@ -128,6 +251,44 @@ ServerConfig LoadServerConfig(const std::string& path) {
     } else {
       LOGW("server.log_level not found or not a string, using default");
     }
+    config.stream_initial_credits =
+        ToIntOrDefault(server_section, "stream_initial_credits", config.stream_initial_credits);
+    if (auto tsdb = server_section.find("tsdb_enabled");
+        tsdb != server_section.end() && tsdb->is_boolean()) {
+      config.tsdb_enabled = tsdb->get<bool>();
+    }
+    config.tsdb_retention_seconds =
+        ToIntOrDefault(server_section, "tsdb_retention_seconds", config.tsdb_retention_seconds);
+    config.tsdb_memory_budget_mb =
+        ToIntOrDefault(server_section, "tsdb_memory_budget_mb", config.tsdb_memory_budget_mb);
+    if (auto data_directory = server_section.find("tsdb_data_directory");
+        data_directory != server_section.end() && data_directory->is_string()) {
+      config.tsdb_data_directory = data_directory->get<std::string>();
+    }
+    config.tsdb_compaction_interval_seconds =
+        ToIntOrDefault(server_section, "tsdb_compaction_interval_seconds",
+                       config.tsdb_compaction_interval_seconds);
+    config.tsdb_rollup_1m_retention_hours =
+        ToIntOrDefault(server_section, "tsdb_rollup_1m_retention_hours",
+                       config.tsdb_rollup_1m_retention_hours);
+    config.tsdb_rollup_1h_retention_days =
+        ToIntOrDefault(server_section, "tsdb_rollup_1h_retention_days",
+                       config.tsdb_rollup_1h_retention_days);
+    config.query_threads = ToIntOrDefault(server_section, "query_threads", config.query_threads);
+    config.grpc_completion_queues =
+        ToIntOrDefault(server_section, "grpc_completion_queues", config.grpc_completion_queues);
+    if (auto pin = server_section.find("grpc_pin_pollers");
+        pin != server_section.end() && pin->is_boolean()) {
+      config.grpc_pin_pollers = pin->get<bool>();
+    }
+    config.ingest_applier_threads =
+        ToIntOrDefault(server_section, "ingest_applier_threads", config.ingest_applier_threads);
+    config.ingest_queue_capacity =
+        ToIntOrDefault(server_section, "ingest_queue_capacity", config.ingest_queue_capacity);
+    if (auto durable = server_section.find("ingest_durable_ack");
+        durable != server_section.end() && durable->is_boolean()) {
+      config.ingest_durable_ack = durable->get<bool>();
+    }
   } else {
     LOGW("server section not found or not an object in config, using defaults");
   }
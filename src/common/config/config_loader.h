@@ -2,6 +2,7 @@
 #define SYSTEM_INSIGHT_COMMON_CONFIG_CONFIG_LOADER_H_
 
 #include <string>
+#include <vector>
 
 namespace system_insight {
 namespace common {
@@ -10,6 +11,12 @@ namespace config {
 struct ClientConfig {
   std::string target = "127.0.0.1:50052";
   int collection_interval_ms = 5000;
+  // 自适应采集周期：以 collection_interval_ms 为初值，按系统活跃度在 [min, max] 内调整
+  bool adaptive_interval_enabled = false;
+  int min_collection_interval_ms = 1000;
+  int max_collection_interval_ms = 30000;
+  // 采样周期；小于 collection_interval_ms 时在客户端按上报周期做窗口聚合，0 表示不聚合
+  int sample_interval_ms = 0;
   std::string log_level = "info";
   std::string host_id;
   
@@ -17,12 +24,86 @@ struct ClientConfig {
   bool use_mmap = false;
   std::string mmap_cpu_device_path = "/dev/system_insight_cpu_stat";
   std::string mmap_softirq_device_path = "/dev/system_insight_softirq";
+
+  // 按挂载点的容量与 inode；过滤列表为空时使用采集器的默认规则（与 node_exporter 一致）
+  bool filesystem_enabled = false;
+  std::vector<std::string> filesystem_include_fstypes;
+  std::vector<std::string> filesystem_exclude_fstypes;
+  std::vector<std::string> filesystem_exclude_mount_points;
+  // 网络文件系统的 statvfs 分摊到多少个采集周期
+  int filesystem_network_spread_cycles = 4;
+
+  // meminfo 细项、vmstat 速率与 NUMA 节点内存；键列表为空时使用采集器的默认键
+  bool extended_memory_enabled = false;
+  std::vector<std::string> memory_meminfo_keys;
+  std::vector<std::string> memory_vmstat_keys;
+
+  // 每核频率（scaling_cur_freq）、降频次数（thermal_throttle）与温区温度
+  bool cpufreq_enabled = false;
+
+  // 上报编码："row" / "columnar" / "columnar_xor"，与服务端协商后生效
+  std::string report_encoding = "columnar_xor";
+
+  // 长连接上报（StreamMetrics），服务端不支持时自动回退到 SendMetrics
+  bool use_streaming = true;
+  int stream_reconnect_backoff_min_ms = 500;
+  int stream_reconnect_backoff_max_ms = 30000;
+  // 额度耗尽或等待建流握手的最长时间
+  int stream_credit_wait_ms = 5000;
+
+  // 发送线程：有界队列容量与溢出策略（"drop_oldest" / "coalesce"）
+  int send_queue_capacity = 64;
+  std::string send_queue_overflow_policy = "drop_oldest";
+  // 同时在途的报告数与单次发送超时
+  int max_in_flight = 4;
+  int send_timeout_ms = 5000;
+
+  // 发送失败的报告落盘目录（为空则不落盘）、容量上限与恢复后的补发速率
+  std::string spool_directory = "/var/lib/system_insight/spool";
+  int spool_max_mb = 64;
+  int replay_max_reports_per_second = 10;
+
+  // 死区过滤：只上报变化超过阈值的样本，至少每 deadband_max_silence_ms 发送一份完整报告
+  bool deadband_enabled = false;
+  double deadband_absolute = 0.0;
+  double deadband_relative = 0.0;
+  int deadband_max_silence_ms = 60000;
+
+  // 同机业务进程通过共享内存发布的指标（src/sdk/shm_metrics.h），随每份报告上报
+  bool shm_ingestion_enabled = false;
+  std::string shm_directory = "/dev/shm";
+
+  // 批处理任务写入的 *.prom 文本文件目录（node_exporter textfile 约定），为空则不采集
+  std::string textfile_directory;
 };
 
 struct ServerConfig {
   std::string listen_address = "0.0.0.0:50052";
   std::string log_level = "info";
   int prometheus_http_port = 9102;
+  // StreamMetrics 建流时授予客户端的初始发送额度
+  int stream_initial_credits = 8;
+  // 内嵌时序库：保留最近 tsdb_retention_seconds 的样本，压缩块总量不超过 tsdb_memory_budget_mb
+  bool tsdb_enabled = true;
+  int tsdb_retention_seconds = 3600;
+  int tsdb_memory_budget_mb = 256;
+  // 时序库数据目录（为空则只保存在内存中）：预写日志与定期压缩出的块文件，重启后恢复
+  std::string tsdb_data_directory = "/var/lib/system_insight/tsdb";
+  int tsdb_compaction_interval_seconds = 300;
+  // 汇总层级（1 分钟、1 小时粒度的 min / max / sum / count）各自的保留期，0 表示不维护该层
+  int tsdb_rollup_1m_retention_hours = 7 * 24;
+  int tsdb_rollup_1h_retention_days = 90;
+  // QueryRange 并行计算的线程数，0 表示硬件线程数
+  int query_threads = 0;
+  // gRPC 完成队列数（每个队列一个轮询线程），0 表示硬件线程数；轮询线程是否按队列绑核
+  int grpc_completion_queues = 0;
+  bool grpc_pin_pollers = true;
+  // 入库流水线：RPC 处理线程只入队，ingest_applier_threads 个线程成批写入（0 表示在处理线程上直接写入）；
+  // 每个应用线程的队列容量为 ingest_queue_capacity 份报告，队列满时拒绝；
+  // ingest_durable_ack 为 true 时写入预写日志并落盘（每批一次 fdatasync）、写入内存后才确认
+  int ingest_applier_threads = 2;
+  int ingest_queue_capacity = 4096;
+  bool ingest_durable_ack = false;
 };
 
 ClientConfig LoadClientConfig(const std::string& path);
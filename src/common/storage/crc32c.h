@@ -0,0 +1,21 @@
+#ifndef SYSTEM_INSIGHT_COMMON_STORAGE_CRC32C_H_
+#define SYSTEM_INSIGHT_COMMON_STORAGE_CRC32C_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace system_insight {
+namespace common {
+namespace storage {
+
+/**
+ * @brief CRC32C（Castagnoli），用于校验落盘记录
+ * @param crc 上一段数据的结果，首段传 0
+ */
+uint32_t Crc32c(const void* data, size_t size, uint32_t crc = 0);
+
+}  // namespace storage
+}  // namespace common
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_COMMON_STORAGE_CRC32C_H_
@@ -0,0 +1,360 @@
+#include "src/common/storage/segment_log.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+#include "src/common/logging/logging.h"
+#include "src/common/storage/crc32c.h"
+
+namespace system_insight {
+namespace common {
+namespace storage {
+
+namespace {
+
+constexpr size_t kHeaderSize = 8;
+// 长度字段的合理上限，超过视为损坏
+constexpr uint32_t kMaxRecordSize = 64U << 20;
+constexpr char kSegmentSuffix[] = ".seg";
+
+void EncodeFixed32(uint32_t value, char* out) {
+  for (int i = 0; i < 4; ++i) {
+    out[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+}
+
+uint32_t DecodeFixed32(const char* in) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) {
+    value |= static_cast<uint32_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+  }
+  return value;
+}
+
+bool PreadFully(int fd, void* buffer, size_t size, uint64_t offset) {
+  auto* out = static_cast<char*>(buffer);
+  while (size > 0) {
+    ssize_t n = ::pread(fd, out, size, static_cast<off_t>(offset));
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    out += n;
+    size -= static_cast<size_t>(n);
+    offset += static_cast<uint64_t>(n);
+  }
+  return true;
+}
+
+// 读取 offset 处的一条记录；校验失败返回 false
+bool ReadRecord(int fd, uint64_t offset, uint64_t file_size, std::string* payload,
+                uint64_t* record_size) {
+  if (offset + kHeaderSize > file_size) return false;
+  char header[kHeaderSize];
+  if (!PreadFully(fd, header, kHeaderSize, offset)) return false;
+  uint32_t length = DecodeFixed32(header);
+  uint32_t crc = DecodeFixed32(header + 4);
+  if (length > kMaxRecordSize || offset + kHeaderSize + length > file_size) return false;
+  payload->resize(length);
+  if (length > 0 && !PreadFully(fd, payload->data(), length, offset + kHeaderSize)) return false;
+  if (Crc32c(payload->data(), length) != crc) return false;
+  *record_size = kHeaderSize + length;
+  return true;
+}
+
+}  // namespace
+
+SegmentLog::SegmentLog(const SegmentLogOptions& options) : options_(options) {
+  options_.max_total_bytes = std::max<uint64_t>(options_.max_total_bytes, 2 * kHeaderSize);
+  // 至少保留两个段的余量，才能在不动活跃段的前提下删除旧数据
+  options_.segment_bytes =
+      std::clamp<uint64_t>(options_.segment_bytes, kHeaderSize, options_.max_total_bytes / 2);
+}
+
+SegmentLog::~SegmentLog() {
+  CloseReadSegment();
+  if (write_fd_ >= 0) {
+    ::close(write_fd_);
+  }
+}
+
+std::string SegmentLog::SegmentPath(uint64_t id) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%020" PRIu64 "%s", id, kSegmentSuffix);
+  return options_.directory + "/" + name;
+}
+
+bool SegmentLog::Open() {
+  std::error_code ec;
+  std::filesystem::create_directories(options_.directory, ec);
+  if (ec) {
+    LOGE("Failed to create segment log directory {}: {}", options_.directory, ec.message());
+    return false;
+  }
+
+  std::vector<uint64_t> ids;
+  for (const auto& entry : std::filesystem::directory_iterator(options_.directory, ec)) {
+    const auto& path = entry.path();
+    if (path.extension() != kSegmentSuffix) continue;
+    char* end = nullptr;
+    std::string stem = path.stem().string();
+    uint64_t id = std::strtoull(stem.c_str(), &end, 10);
+    if (end != stem.c_str() + stem.size() || id == 0) continue;
+    ids.push_back(id);
+  }
+  if (ec) {
+    LOGE("Failed to list segment log directory {}: {}", options_.directory, ec.message());
+    return false;
+  }
+  std::sort(ids.begin(), ids.end());
+
+  for (uint64_t id : ids) {
+    Segment segment;
+    segment.id = id;
+    if (!RecoverSegment(&segment)) continue;
+    if (segment.records == 0) {
+      ::unlink(SegmentPath(id).c_str());
+      continue;
+    }
+    segments_.push_back(segment);
+    total_bytes_ += segment.size;
+    pending_records_ += segment.records;
+  }
+  if (!ids.empty()) {
+    next_segment_id_ = ids.back() + 1;
+  }
+  if (pending_records_ > 0) {
+    LOGI("Recovered {} records ({} bytes) from {}", pending_records_, total_bytes_,
+         options_.directory);
+  }
+  EnforceLimit();
+  return true;
+}
+
+bool SegmentLog::RecoverSegment(Segment* segment) {
+  std::string path = SegmentPath(segment->id);
+  int fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+  if (fd < 0) {
+    LOGW("Failed to open segment {}: {}", path, std::strerror(errno));
+    return false;
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+  uint64_t file_size = static_cast<uint64_t>(st.st_size);
+  uint64_t offset = 0;
+  uint64_t record_size = 0;
+  std::string payload;
+  while (ReadRecord(fd, offset, file_size, &payload, &record_size)) {
+    offset += record_size;
+    ++segment->records;
+  }
+  if (offset < file_size) {
+    LOGW("Truncating segment {} from {} to {} bytes", path, file_size, offset);
+    if (::ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+      LOGW("Failed to truncate segment {}: {}", path, std::strerror(errno));
+    }
+  }
+  ::close(fd);
+  segment->size = offset;
+  return true;
+}
+
+bool SegmentLog::OpenWriteSegment() {
+  if (write_fd_ >= 0) {
+    Sync();
+    ::close(write_fd_);
+    write_fd_ = -1;
+  }
+  uint64_t id = next_segment_id_++;
+  std::string path = SegmentPath(id);
+  write_fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+  if (write_fd_ < 0) {
+    LOGE("Failed to create segment {}: {}", path, std::strerror(errno));
+    return false;
+  }
+  Segment segment;
+  segment.id = id;
+  segments_.push_back(segment);
+  return true;
+}
+
+bool SegmentLog::Append(const void* data, size_t size) {
+  if (size > kMaxRecordSize) {
+    LOGW("Record of {} bytes exceeds segment log limit", size);
+    return false;
+  }
+  uint64_t record_size = kHeaderSize + size;
+  // 重启后恢复的段只读不写，新记录总是写入新段
+  if (write_fd_ < 0 ||
+      (segments_.back().size > 0 && segments_.back().size + record_size > options_.segment_bytes)) {
+    if (!OpenWriteSegment()) return false;
+  }
+
+  char header[kHeaderSize];
+  EncodeFixed32(static_cast<uint32_t>(size), header);
+  EncodeFixed32(Crc32c(data, size), header + 4);
+  iovec iov[2];
+  iov[0].iov_base = header;
+  iov[0].iov_len = kHeaderSize;
+  iov[1].iov_base = const_cast<void*>(data);
+  iov[1].iov_len = size;
+
+  Segment& segment = segments_.back();
+  ssize_t written = -1;
+  do {
+    written = ::writev(write_fd_, iov, 2);
+  } while (written < 0 && errno == EINTR);
+  if (written != static_cast<ssize_t>(record_size)) {
+    LOGE("Failed to append to segment {}: {}", SegmentPath(segment.id),
+         written < 0 ? std::strerror(errno) : "short write");
+    // 丢掉写了一半的记录，保持段内记录完整
+    if (written > 0 && ::ftruncate(write_fd_, static_cast<off_t>(segment.size)) != 0) {
+      LOGW("Failed to roll back segment {}", SegmentPath(segment.id));
+    }
+    return false;
+  }
+  if (options_.sync) {
+    ::fdatasync(write_fd_);
+  } else {
+    unsynced_ = true;
+  }
+
+  segment.size += record_size;
+  ++segment.records;
+  total_bytes_ += record_size;
+  ++pending_records_;
+  EnforceLimit();
+  return true;
+}
+
+bool SegmentLog::Sync() {
+  if (!unsynced_ || write_fd_ < 0) return true;
+  unsynced_ = false;
+  ++sync_count_;
+  if (::fdatasync(write_fd_) != 0) {
+    LOGW("Failed to sync segment {}: {}", SegmentPath(segments_.back().id), std::strerror(errno));
+    return false;
+  }
+  return true;
+}
+
+bool SegmentLog::ReadFront(std::string* payload) {
+  while (!segments_.empty()) {
+    Segment& front = segments_.front();
+    if (read_records_ < front.records) {
+      if (read_fd_ < 0) {
+        read_fd_ = ::open(SegmentPath(front.id).c_str(), O_RDONLY | O_CLOEXEC);
+      }
+      if (read_fd_ >= 0 &&
+          ReadRecord(read_fd_, read_offset_, front.size, payload, &front_record_size_)) {
+        return true;
+      }
+      LOGW("Discarding unreadable segment {} at offset {}", SegmentPath(front.id), read_offset_);
+    }
+    RemoveFrontSegment();
+  }
+  return false;
+}
+
+void SegmentLog::PopFront() {
+  if (segments_.empty() || front_record_size_ == 0) return;
+  read_offset_ += front_record_size_;
+  front_record_size_ = 0;
+  ++read_records_;
+  --pending_records_;
+  if (read_records_ >= segments_.front().records) {
+    RemoveFrontSegment();
+  }
+}
+
+bool SegmentLog::Scan(const std::function<bool(const std::string&)>& visitor) const {
+  std::string payload;
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    const Segment& segment = segments_[i];
+    uint64_t offset = i == 0 ? read_offset_ : 0;
+    uint64_t records = i == 0 ? read_records_ : 0;
+    if (records >= segment.records) continue;
+    int fd = ::open(SegmentPath(segment.id).c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      LOGW("Failed to open segment {}: {}", SegmentPath(segment.id), std::strerror(errno));
+      return false;
+    }
+    uint64_t record_size = 0;
+    for (; records < segment.records; ++records) {
+      if (!ReadRecord(fd, offset, segment.size, &payload, &record_size)) {
+        LOGW("Unreadable record in segment {} at offset {}", SegmentPath(segment.id), offset);
+        ::close(fd);
+        return false;
+      }
+      offset += record_size;
+      if (!visitor(payload)) {
+        ::close(fd);
+        return true;
+      }
+    }
+    ::close(fd);
+  }
+  return true;
+}
+
+uint64_t SegmentLog::DropFront(uint64_t records) {
+  uint64_t dropped = 0;
+  while (!segments_.empty()) {
+    const uint64_t unread = segments_.front().records - std::min(read_records_,
+                                                                 segments_.front().records);
+    if (unread > records - dropped) break;
+    // 按已消费处理，不计入 dropped_records()
+    read_records_ = segments_.front().records;
+    pending_records_ -= unread;
+    dropped += unread;
+    RemoveFrontSegment();
+  }
+  return dropped;
+}
+
+void SegmentLog::CloseReadSegment() {
+  if (read_fd_ >= 0) {
+    ::close(read_fd_);
+    read_fd_ = -1;
+  }
+  read_offset_ = 0;
+  read_records_ = 0;
+  front_record_size_ = 0;
+}
+
+void SegmentLog::RemoveFrontSegment() {
+  const Segment& front = segments_.front();
+  dropped_records_ += front.records - std::min(read_records_, front.records);
+  pending_records_ -= front.records - std::min(read_records_, front.records);
+  total_bytes_ -= front.size;
+  if (segments_.size() == 1 && write_fd_ >= 0) {
+    ::close(write_fd_);
+    write_fd_ = -1;
+  }
+  ::unlink(SegmentPath(front.id).c_str());
+  segments_.pop_front();
+  CloseReadSegment();
+}
+
+void SegmentLog::EnforceLimit() {
+  while (total_bytes_ > options_.max_total_bytes && segments_.size() > 1) {
+    LOGW("Segment log {} over {} bytes, dropping oldest segment", options_.directory,
+         options_.max_total_bytes);
+    RemoveFrontSegment();
+  }
+}
+
+}  // namespace storage
+}  // namespace common
+}  // namespace system_insight
@@ -0,0 +1,125 @@
+#ifndef SYSTEM_INSIGHT_COMMON_STORAGE_SEGMENT_LOG_H_
+#define SYSTEM_INSIGHT_COMMON_STORAGE_SEGMENT_LOG_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+
+namespace system_insight {
+namespace common {
+namespace storage {
+
+/**
+ * @brief 分段日志配置
+ */
+struct SegmentLogOptions {
+  std::string directory;
+  uint64_t segment_bytes = 4ULL << 20;     // 单个段文件的目标大小
+  uint64_t max_total_bytes = 64ULL << 20;  // 总大小上限，超出时删除最旧的段
+  bool sync = false;                       // 每次追加后 fdatasync
+};
+
+/**
+ * @brief 只追加的分段日志，按先进先出消费
+ *
+ * 目录下按递增编号存放 <id>.seg 段文件，每条记录为
+ * [4 字节长度][4 字节 CRC32C][payload]（小端），以 O_APPEND 写入。
+ * - Open() 扫描全部段，截断校验失败的尾部（进程崩溃时写了一半的记录）
+ * - 总大小超过上限时整段删除最旧的数据
+ * - ReadFront()/PopFront() 从最旧的记录开始消费，段消费完即删除
+ *
+ * 消费位置只保存在内存中：重启后未删除的段会从头重新消费，
+ * 调用方需要容忍少量重复。非线程安全。
+ */
+class SegmentLog {
+ public:
+  explicit SegmentLog(const SegmentLogOptions& options);
+  ~SegmentLog();
+
+  SegmentLog(const SegmentLog&) = delete;
+  SegmentLog& operator=(const SegmentLog&) = delete;
+
+  /**
+   * @brief 创建目录并恢复已有的段
+   * @return 目录不可用时返回 false
+   */
+  bool Open();
+
+  bool Append(const void* data, size_t size);
+  bool Append(const std::string& payload) { return Append(payload.data(), payload.size()); }
+
+  /**
+   * @brief 把 sync 为 false 时追加的记录刷到磁盘，一批追加只需一次 fdatasync
+   */
+  bool Sync();
+
+  /**
+   * @brief 读取最旧的未消费记录（不消费）
+   * @return 没有可读记录时返回 false
+   */
+  bool ReadFront(std::string* payload);
+
+  /**
+   * @brief 消费上一次 ReadFront() 返回的记录
+   */
+  void PopFront();
+
+  /**
+   * @brief 按顺序遍历全部未消费记录，不改变消费位置；visitor 返回 false 时停止
+   * @return 遇到无法读取的记录时返回 false
+   */
+  bool Scan(const std::function<bool(const std::string&)>& visitor) const;
+
+  /**
+   * @brief 丢弃最旧的至多 records 条未消费记录，只删除整段，部分覆盖的段保留
+   * @return 实际丢弃的记录数
+   */
+  uint64_t DropFront(uint64_t records);
+
+  bool empty() const { return pending_records_ == 0; }
+  uint64_t pending_records() const { return pending_records_; }
+  uint64_t total_bytes() const { return total_bytes_; }
+  // 因超出总大小上限或校验失败而丢弃的记录数
+  uint64_t dropped_records() const { return dropped_records_; }
+  // Sync() 实际执行 fdatasync 的次数
+  uint64_t sync_count() const { return sync_count_; }
+
+ private:
+  struct Segment {
+    uint64_t id = 0;
+    uint64_t size = 0;
+    uint64_t records = 0;
+  };
+
+  std::string SegmentPath(uint64_t id) const;
+  // 校验段内记录，截断第一条无效记录之后的内容
+  bool RecoverSegment(Segment* segment);
+  bool OpenWriteSegment();
+  void CloseReadSegment();
+  void RemoveFrontSegment();
+  void EnforceLimit();
+
+  SegmentLogOptions options_;
+  std::deque<Segment> segments_;
+  uint64_t next_segment_id_ = 1;
+  int write_fd_ = -1;
+  bool unsynced_ = false;  // 写入段有尚未 fdatasync 的记录
+
+  int read_fd_ = -1;
+  uint64_t read_offset_ = 0;     // 最旧段内的消费位置
+  uint64_t read_records_ = 0;    // 最旧段内已消费的记录数
+  uint64_t front_record_size_ = 0;
+
+  uint64_t total_bytes_ = 0;
+  uint64_t pending_records_ = 0;
+  uint64_t dropped_records_ = 0;
+  uint64_t sync_count_ = 0;
+};
+
+}  // namespace storage
+}  // namespace common
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_COMMON_STORAGE_SEGMENT_LOG_H_
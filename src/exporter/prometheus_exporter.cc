@@ -92,18 +92,20 @@ void PrometheusExporter::Serve() {
 
 std::string PrometheusExporter::BuildMetricsPayload() const {
   auto snapshot = repository_->Snapshot();
+  const auto& series_store = repository_->series_store();
   std::ostringstream ss;
 
-  for (const auto& report : snapshot) {
-    for (const auto& sample : report.samples()) {
-      std::string metric_name = SanitizeMetricName(sample.name());
-      ss << metric_name << "{host=\"" << EscapeLabelValue(report.host_id()) << "\"";
-      for (const auto& label : sample.labels()) {
-        ss << "," << SanitizeMetricName(label.key()) << "=\"" << EscapeLabelValue(label.value()) << "\"";
+  for (const auto& host : snapshot) {
+    const std::string host_label = EscapeLabelValue(host->host_id);
+    for (size_t i = 0; i < host->series_ids.size(); ++i) {
+      const auto& series = series_store.series(host->series_ids[i]);
+      ss << SanitizeMetricName(*series.name) << "{host=\"" << host_label << "\"";
+      for (const auto& label : series.labels) {
+        ss << "," << SanitizeMetricName(*label.key) << "=\"" << EscapeLabelValue(*label.value) << "\"";
       }
-      ss << "} " << sample.value();
-      if (sample.timestamp_ms() > 0) {
-        ss << " " << sample.timestamp_ms();
+      ss << "} " << host->values[i];
+      if (host->timestamps_ms[i] > 0) {
+        ss << " " << host->timestamps_ms[i];
       }
       ss << "\n";
     }
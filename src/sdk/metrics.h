@@ -0,0 +1,438 @@
+#ifndef SYSTEM_INSIGHT_SDK_METRICS_H_
+#define SYSTEM_INSIGHT_SDK_METRICS_H_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "src/sdk/shm_metrics.h"
+
+namespace system_insight {
+namespace sdk {
+
+// 计数单元的分片数；线程按首次记录的顺序轮流分配到各分片
+constexpr size_t kMetricShards = 32;
+
+/**
+ * @brief 当前线程所属的分片下标
+ */
+inline size_t MetricShard() {
+  static std::atomic<size_t> next_shard{0};
+  thread_local const size_t shard =
+      next_shard.fetch_add(1, std::memory_order_relaxed) % kMetricShards;
+  return shard;
+}
+
+/**
+ * @brief 单调计数器
+ *
+ * 每个分片独占一个缓存行，Add 只做一次 relaxed fetch_add，不同线程互不争用；
+ * Value() 把各分片相加。
+ */
+class Counter {
+ public:
+  void Add(uint64_t delta = 1) {
+    cells_[MetricShard()].value.fetch_add(delta, std::memory_order_relaxed);
+  }
+
+  uint64_t Value() const {
+    uint64_t total = 0;
+    for (const auto& cell : cells_) {
+      total += cell.value.load(std::memory_order_relaxed);
+    }
+    return total;
+  }
+
+ private:
+  struct alignas(64) Cell {
+    std::atomic<uint64_t> value{0};
+  };
+  std::array<Cell, kMetricShards> cells_;
+};
+
+/**
+ * @brief 瞬时值；Set 后写者胜出，不分片
+ */
+class Gauge {
+ public:
+  void Set(double value) { value_.store(value, std::memory_order_relaxed); }
+
+  void Add(double delta) {
+    double current = value_.load(std::memory_order_relaxed);
+    while (!value_.compare_exchange_weak(current, current + delta, std::memory_order_relaxed)) {
+    }
+  }
+
+  double Value() const { return value_.load(std::memory_order_relaxed); }
+
+ private:
+  std::atomic<double> value_{0.0};
+};
+
+/**
+ * @brief 对数线性桶直方图（非负整数取值，例如微秒、字节）
+ *
+ * 每个 2 的幂区间再线性分成 kSubBuckets 个桶，相对误差不超过 1/kSubBuckets（12.5%），
+ * 覆盖整个 uint64 范围，无需预先指定上下界。小于 kSubBuckets 的值各自独占一个桶。
+ *
+ * 各分片的桶数组在线程第一次记录时才分配，内存与实际记录的线程数成正比；
+ * Observe 是一次 clz 加两次 relaxed fetch_add。
+ */
+class Histogram {
+ public:
+  static constexpr int kSubBucketBits = 3;
+  static constexpr uint64_t kSubBuckets = uint64_t{1} << kSubBucketBits;
+  static constexpr size_t kBucketCount = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  static size_t BucketIndex(uint64_t value) {
+    if (value < kSubBuckets) return static_cast<size_t>(value);
+    const int exponent = 63 - __builtin_clzll(value);
+    const uint64_t sub = (value >> (exponent - kSubBucketBits)) & (kSubBuckets - 1);
+    return static_cast<size_t>((exponent - kSubBucketBits + 1) * kSubBuckets + sub);
+  }
+
+  // 桶的下界（含）与宽度；最高的桶上界超出 uint64 时用 double 表示
+  static uint64_t BucketLowerBound(size_t index) {
+    if (index < kSubBuckets) return index;
+    const int exponent = static_cast<int>(index / kSubBuckets) + kSubBucketBits - 1;
+    const uint64_t sub = index % kSubBuckets;
+    return (kSubBuckets + sub) << (exponent - kSubBucketBits);
+  }
+
+  static double BucketWidth(size_t index) {
+    if (index < kSubBuckets) return 1.0;
+    const int exponent = static_cast<int>(index / kSubBuckets) + kSubBucketBits - 1;
+    return static_cast<double>(uint64_t{1} << (exponent - kSubBucketBits));
+  }
+
+  struct Snapshot {
+    std::vector<uint64_t> counts;  // 按桶下标，长度 kBucketCount
+    uint64_t sum = 0;
+    uint64_t count = 0;
+
+    /**
+     * @brief 估算分位数，返回所在桶的中点（小值桶返回精确值）
+     * @param q [0, 1]；没有样本时返回 0
+     */
+    double Quantile(double q) const {
+      if (count == 0) return 0.0;
+      const double rank = q * static_cast<double>(count);
+      uint64_t seen = 0;
+      for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        if (counts[i] != 0 && static_cast<double>(seen) >= rank) {
+          if (i < kSubBuckets) return static_cast<double>(i);
+          return static_cast<double>(BucketLowerBound(i)) + BucketWidth(i) / 2.0;
+        }
+      }
+      return static_cast<double>(BucketLowerBound(counts.size() - 1));
+    }
+  };
+
+  Histogram() = default;
+  ~Histogram() {
+    for (auto& shard : shards_) {
+      delete shard.load(std::memory_order_relaxed);
+    }
+  }
+
+  Histogram(const Histogram&) = delete;
+  Histogram& operator=(const Histogram&) = delete;
+
+  void Observe(uint64_t value) {
+    Cells* cells = ShardCells(MetricShard());
+    cells->buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    cells->sum.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  void Read(Snapshot* snapshot) const {
+    snapshot->counts.assign(kBucketCount, 0);
+    snapshot->sum = 0;
+    snapshot->count = 0;
+    for (const auto& shard : shards_) {
+      const Cells* cells = shard.load(std::memory_order_acquire);
+      if (cells == nullptr) continue;
+      for (size_t i = 0; i < kBucketCount; ++i) {
+        const uint64_t n = cells->buckets[i].load(std::memory_order_relaxed);
+        snapshot->counts[i] += n;
+        snapshot->count += n;
+      }
+      snapshot->sum += cells->sum.load(std::memory_order_relaxed);
+    }
+  }
+
+ private:
+  struct alignas(64) Cells {
+    Cells() {
+      sum.store(0, std::memory_order_relaxed);
+      for (auto& bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+      }
+    }
+    std::atomic<uint64_t> sum;
+    std::array<std::atomic<uint64_t>, kBucketCount> buckets;
+  };
+
+  Cells* ShardCells(size_t shard) {
+    Cells* cells = shards_[shard].load(std::memory_order_acquire);
+    if (cells != nullptr) return cells;
+    // 同一分片的两个线程可能同时分配，输者释放自己的那份
+    auto* fresh = new Cells();
+    if (shards_[shard].compare_exchange_strong(cells, fresh, std::memory_order_acq_rel)) {
+      return fresh;
+    }
+    delete fresh;
+    return cells;
+  }
+
+  std::array<std::atomic<Cells*>, kMetricShards> shards_{};
+};
+
+/**
+ * @brief 按名称管理指标
+ *
+ * Get* 是冷路径（加锁），应在初始化时调用并保存返回的指针；指标与注册表同生命周期。
+ * 同一名称只能属于一种指标类型，类型冲突时返回 nullptr。
+ */
+class MetricsRegistry {
+ public:
+  // 进程级默认注册表
+  static MetricsRegistry& Default() {
+    static MetricsRegistry* registry = new MetricsRegistry();
+    return *registry;
+  }
+
+  Counter* GetCounter(const std::string& name) { return Get(name, &counters_); }
+  Gauge* GetGauge(const std::string& name) { return Get(name, &gauges_); }
+  Histogram* GetHistogram(const std::string& name) { return Get(name, &histograms_); }
+
+  /**
+   * @brief 依次访问所有指标；fn 在注册锁内调用，不应再调用 Get*
+   */
+  template <typename CounterFn, typename GaugeFn, typename HistogramFn>
+  void ForEach(CounterFn&& on_counter, GaugeFn&& on_gauge, HistogramFn&& on_histogram) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& [name, counter] : counters_) on_counter(name, *counter);
+    for (const auto& [name, gauge] : gauges_) on_gauge(name, *gauge);
+    for (const auto& [name, histogram] : histograms_) on_histogram(name, *histogram);
+  }
+
+ private:
+  template <typename Metric>
+  using Entries = std::vector<std::pair<std::string, std::unique_ptr<Metric>>>;
+
+  template <typename Metric>
+  Metric* Get(const std::string& name, Entries<Metric>* entries) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = names_.find(name);
+    if (it != names_.end()) {
+      if (it->second.first != static_cast<const void*>(entries)) return nullptr;
+      return static_cast<Metric*>(it->second.second);
+    }
+    entries->emplace_back(name, std::make_unique<Metric>());
+    Metric* metric = entries->back().second.get();
+    names_.emplace(name, std::make_pair(static_cast<const void*>(entries), metric));
+    return metric;
+  }
+
+  mutable std::mutex mutex_;
+  Entries<Counter> counters_;
+  Entries<Gauge> gauges_;
+  Entries<Histogram> histograms_;
+  // 名称 -> (所属类型的列表, 指标)
+  std::unordered_map<std::string, std::pair<const void*, void*>> names_;
+};
+
+/**
+ * @brief 后台刷新线程：定期把注册表中的聚合值经共享内存通道推给本机 agent
+ *
+ * - 计数器：发布自上次成功刷新以来的增量，agent 累加为总数
+ * - gauge：发布当前值
+ * - 直方图：<name>_count / <name>_sum 按计数器发布，<name>_p50 / _p90 / _p99
+ *   按 gauge 发布，为本次刷新周期内新增样本的分位数
+ *
+ * 共享内存环满导致计数器发布失败时不推进已发布位置，增量在下次刷新时补发。
+ * Stop() 与析构时会做最后一次刷新。
+ */
+class MetricsFlusher {
+ public:
+  struct Options {
+    std::string app;
+    std::chrono::milliseconds interval{1000};
+    ShmMetricsProducer::Options shm;
+  };
+
+  MetricsFlusher(MetricsRegistry* registry, Options options)
+      : registry_(registry), options_(std::move(options)) {}
+
+  ~MetricsFlusher() { Stop(); }
+
+  MetricsFlusher(const MetricsFlusher&) = delete;
+  MetricsFlusher& operator=(const MetricsFlusher&) = delete;
+
+  /**
+   * @return 无法创建共享内存段时返回 false
+   */
+  bool Start() {
+    std::lock_guard<std::mutex> lock(flush_mutex_);
+    if (thread_.joinable()) return true;
+    if (!producer_) {
+      producer_ = ShmMetricsProducer::Create(options_.app, options_.shm);
+      if (!producer_) return false;
+    }
+    {
+      std::lock_guard<std::mutex> state_lock(state_mutex_);
+      stopping_ = false;
+    }
+    thread_ = std::thread([this] { Run(); });
+    return true;
+  }
+
+  void Stop() {
+    {
+      std::lock_guard<std::mutex> lock(state_mutex_);
+      stopping_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+      thread_.join();
+      Flush();
+    }
+  }
+
+  /**
+   * @brief 立即刷新一次；未 Start() 时不做任何事
+   */
+  void Flush() {
+    std::lock_guard<std::mutex> lock(flush_mutex_);
+    if (!producer_) return;
+    registry_->ForEach(
+        [this](const std::string& name, const Counter& counter) { FlushCounter(name, counter); },
+        [this](const std::string& name, const Gauge& gauge) {
+          producer_->Set(Resolve(name, shm::kGauge), gauge.Value());
+        },
+        [this](const std::string& name, const Histogram& histogram) {
+          FlushHistogram(name, histogram);
+        });
+  }
+
+ private:
+  struct CounterState {
+    int32_t id = -1;
+    uint64_t published = 0;
+  };
+
+  struct HistogramState {
+    int32_t count_id = -1;
+    int32_t sum_id = -1;
+    std::array<int32_t, 3> quantile_ids{-1, -1, -1};
+    uint64_t published_count = 0;
+    uint64_t published_sum = 0;
+    Histogram::Snapshot last;  // 上次刷新时的快照
+  };
+
+  static constexpr std::array<double, 3> kQuantiles = {0.5, 0.9, 0.99};
+
+  void Run() {
+    std::unique_lock<std::mutex> lock(state_mutex_);
+    while (!cv_.wait_for(lock, options_.interval, [this] { return stopping_; })) {
+      lock.unlock();
+      Flush();
+      lock.lock();
+    }
+  }
+
+  int32_t Resolve(const std::string& name, shm::MetricType type) {
+    auto it = ids_.find(name);
+    if (it != ids_.end()) return it->second;
+    const int32_t id = producer_->Register(name, type);
+    // 指标槽已满时不缓存，之后的刷新会继续尝试
+    if (id >= 0) ids_.emplace(name, id);
+    return id;
+  }
+
+  void FlushCounter(const std::string& name, const Counter& counter) {
+    CounterState& state = counters_[&counter];
+    if (state.id < 0) state.id = Resolve(name, shm::kCounter);
+    const uint64_t value = counter.Value();
+    if (value == state.published) return;
+    if (producer_->Add(state.id, static_cast<double>(value - state.published))) {
+      state.published = value;
+    }
+  }
+
+  void FlushHistogram(const std::string& name, const Histogram& histogram) {
+    HistogramState& state = histograms_[&histogram];
+    if (state.count_id < 0) {
+      state.count_id = Resolve(name + "_count", shm::kCounter);
+      state.sum_id = Resolve(name + "_sum", shm::kCounter);
+      state.quantile_ids = {Resolve(name + "_p50", shm::kGauge),
+                            Resolve(name + "_p90", shm::kGauge),
+                            Resolve(name + "_p99", shm::kGauge)};
+    }
+    if (state.last.counts.empty()) {
+      state.last.counts.assign(Histogram::kBucketCount, 0);
+    }
+    histogram.Read(&current_);
+    if (current_.count == state.last.count && current_.count == state.published_count &&
+        current_.sum == state.published_sum) {
+      return;
+    }
+
+    // 分位数只统计上次刷新以来新增的样本
+    window_.counts.resize(Histogram::kBucketCount);
+    for (size_t i = 0; i < Histogram::kBucketCount; ++i) {
+      window_.counts[i] = current_.counts[i] - state.last.counts[i];
+    }
+    window_.count = current_.count - state.last.count;
+    window_.sum = current_.sum - state.last.sum;
+
+    // count 与 sum 分别记录已发布的位置，各自在下次补发
+    if (current_.count != state.published_count &&
+        producer_->Add(state.count_id,
+                       static_cast<double>(current_.count - state.published_count))) {
+      state.published_count = current_.count;
+    }
+    if (current_.sum != state.published_sum &&
+        producer_->Add(state.sum_id, static_cast<double>(current_.sum - state.published_sum))) {
+      state.published_sum = current_.sum;
+    }
+    if (window_.count != 0) {
+      for (size_t i = 0; i < kQuantiles.size(); ++i) {
+        producer_->Set(state.quantile_ids[i], window_.Quantile(kQuantiles[i]));
+      }
+    }
+    std::swap(state.last, current_);
+  }
+
+  MetricsRegistry* registry_;
+  Options options_;
+
+  std::mutex flush_mutex_;  // 保护以下刷新状态
+  std::unique_ptr<ShmMetricsProducer> producer_;
+  std::unordered_map<std::string, int32_t> ids_;
+  std::unordered_map<const Counter*, CounterState> counters_;
+  std::unordered_map<const Histogram*, HistogramState> histograms_;
+  Histogram::Snapshot current_;
+  Histogram::Snapshot window_;
+
+  std::mutex state_mutex_;
+  std::condition_variable cv_;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+}  // namespace sdk
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_SDK_METRICS_H_
@@ -0,0 +1,248 @@
+#ifndef SYSTEM_INSIGHT_SDK_SHM_METRICS_H_
+#define SYSTEM_INSIGHT_SDK_SHM_METRICS_H_
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace system_insight {
+namespace sdk {
+
+/**
+ * @brief 共享内存指标通道的内存布局
+ *
+ * 每个生产者进程在 /dev/shm 下创建一个段，文件名为 system_insight.<app>.<pid>：
+ *
+ *   [ShmHeader][ShmMetricSlot × max_metrics][ShmRecord × capacity]
+ *
+ * - 指标槽：生产者注册的指标名与类型，注册完成后置 ready，之后只读
+ * - 记录环：Vyukov 风格的有界 MPSC 环，生产者线程以 CAS 抢占写入位置，
+ *   agent 是唯一消费者；每个记录带序号，消费者据此判断记录是否写完
+ *
+ * 生产者写完头部与所有槽位后最后写入 magic，agent 看到 magic 才开始读取。
+ * 环满时更新被丢弃并计入 dropped，生产者永远不会阻塞。
+ * 段内只使用地址无关的无锁原子变量，生产者与 agent 之间没有任何系统调用。
+ */
+namespace shm {
+
+constexpr uint32_t kMagic = 0x53494d31;  // "SIM1"
+constexpr uint32_t kVersion = 1;
+constexpr char kFilePrefix[] = "system_insight.";
+constexpr size_t kMaxAppLength = 63;
+constexpr size_t kMaxNameLength = 127;
+
+enum MetricType : uint32_t {
+  kCounter = 1,  // 记录为增量，agent 累加为单调递增的总数
+  kGauge = 2,    // 记录为当前值，agent 取最后一次
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free,
+              "shared memory channel requires lock-free atomics");
+
+struct ShmHeader {
+  std::atomic<uint32_t> magic;
+  uint32_t version;
+  uint32_t capacity;     // 记录环容量，2 的幂
+  uint32_t max_metrics;  // 指标槽数量
+  int32_t pid;
+  char app[kMaxAppLength + 1];
+
+  alignas(64) std::atomic<uint64_t> enqueue_pos;  // 生产者抢占的下一个写入位置
+  alignas(64) std::atomic<uint64_t> dequeue_pos;  // agent 的消费位置
+  alignas(64) std::atomic<uint64_t> dropped;      // 环满被丢弃的更新数
+  std::atomic<uint32_t> metric_count;             // 已分配的指标槽数
+  std::atomic<uint32_t> closed;                   // 生产者正常退出时置 1
+};
+
+struct ShmMetricSlot {
+  std::atomic<uint32_t> ready;
+  uint32_t type;
+  char name[kMaxNameLength + 1];
+};
+
+struct ShmRecord {
+  std::atomic<uint64_t> sequence;
+  uint32_t metric_id;
+  uint32_t reserved;
+  double value;
+  uint64_t padding;
+};
+static_assert(sizeof(ShmRecord) == 32, "ShmRecord layout changed");
+
+inline size_t SegmentSize(uint32_t capacity, uint32_t max_metrics) {
+  return sizeof(ShmHeader) + sizeof(ShmMetricSlot) * max_metrics + sizeof(ShmRecord) * capacity;
+}
+
+inline ShmMetricSlot* Slots(ShmHeader* header) {
+  return reinterpret_cast<ShmMetricSlot*>(reinterpret_cast<char*>(header) + sizeof(ShmHeader));
+}
+
+inline ShmRecord* Records(ShmHeader* header) {
+  return reinterpret_cast<ShmRecord*>(reinterpret_cast<char*>(Slots(header)) +
+                                      sizeof(ShmMetricSlot) * header->max_metrics);
+}
+
+}  // namespace shm
+
+/**
+ * @brief 共享内存指标生产者（业务进程内使用，仅头文件）
+ *
+ * 用法：
+ *   auto producer = ShmMetricsProducer::Create("order_service");
+ *   auto requests = producer->Register("order.requests_total", shm::kCounter);
+ *   producer->Add(requests, 1);
+ *
+ * Register 是冷路径（进程内加锁去重）；Add/Set 只有几次原子操作，可从任意线程调用。
+ * agent 以 app 标签上报这些指标。
+ */
+class ShmMetricsProducer {
+ public:
+  struct Options {
+    std::string directory = "/dev/shm";
+    uint32_t capacity = 4096;  // 向上取整到 2 的幂
+    uint32_t max_metrics = 256;
+  };
+
+  static std::unique_ptr<ShmMetricsProducer> Create(const std::string& app) {
+    return Create(app, Options());
+  }
+
+  /**
+   * @return 无法创建共享内存段时返回 nullptr
+   */
+  static std::unique_ptr<ShmMetricsProducer> Create(const std::string& app,
+                                                    const Options& options) {
+    uint32_t capacity = 1;
+    while (capacity < options.capacity && capacity < (1U << 24)) {
+      capacity <<= 1;
+    }
+    const uint32_t max_metrics = options.max_metrics == 0 ? 1 : options.max_metrics;
+
+    std::string safe_app = app.substr(0, shm::kMaxAppLength);
+    for (char& ch : safe_app) {
+      if (ch == '.' || ch == '/') ch = '_';
+    }
+    const int32_t pid = static_cast<int32_t>(::getpid());
+    std::string path =
+        options.directory + "/" + shm::kFilePrefix + safe_app + "." + std::to_string(pid);
+
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return nullptr;
+    const size_t size = shm::SegmentSize(capacity, max_metrics);
+    void* addr = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(size)) == 0) {
+      addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+      ::unlink(path.c_str());
+      return nullptr;
+    }
+
+    // ftruncate 得到的是全零页；原子变量按零值开始，只需写入非零字段
+    auto* header = static_cast<shm::ShmHeader*>(addr);
+    header->version = shm::kVersion;
+    header->capacity = capacity;
+    header->max_metrics = max_metrics;
+    header->pid = pid;
+    std::memcpy(header->app, safe_app.data(), safe_app.size());
+    shm::ShmRecord* records = shm::Records(header);
+    for (uint32_t i = 0; i < capacity; ++i) {
+      records[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    header->magic.store(shm::kMagic, std::memory_order_release);
+    return std::unique_ptr<ShmMetricsProducer>(new ShmMetricsProducer(header, size));
+  }
+
+  ~ShmMetricsProducer() {
+    // 段文件留给 agent 在读完剩余记录后删除
+    header_->closed.store(1, std::memory_order_release);
+    ::munmap(header_, size_);
+  }
+
+  ShmMetricsProducer(const ShmMetricsProducer&) = delete;
+  ShmMetricsProducer& operator=(const ShmMetricsProducer&) = delete;
+
+  /**
+   * @brief 注册指标，同名指标返回同一个 id
+   * @return 指标槽已满或名称为空时返回 -1
+   */
+  int32_t Register(const std::string& name, shm::MetricType type) {
+    if (name.empty()) return -1;
+    std::lock_guard<std::mutex> lock(register_mutex_);
+    auto it = ids_.find(name);
+    if (it != ids_.end()) return it->second;
+    uint32_t id = header_->metric_count.load(std::memory_order_relaxed);
+    if (id >= header_->max_metrics) return -1;
+    shm::ShmMetricSlot& slot = shm::Slots(header_)[id];
+    slot.type = type;
+    const size_t length = std::min(name.size(), shm::kMaxNameLength);
+    std::memcpy(slot.name, name.data(), length);
+    slot.name[length] = '\0';
+    slot.ready.store(1, std::memory_order_release);
+    header_->metric_count.store(id + 1, std::memory_order_release);
+    ids_.emplace(name, static_cast<int32_t>(id));
+    return static_cast<int32_t>(id);
+  }
+
+  // 计数器增量
+  bool Add(int32_t id, double delta) { return Publish(id, delta); }
+  // gauge 的当前值
+  bool Set(int32_t id, double value) { return Publish(id, value); }
+
+  uint64_t dropped() const { return header_->dropped.load(std::memory_order_relaxed); }
+
+ private:
+  ShmMetricsProducer(shm::ShmHeader* header, size_t size)
+      : header_(header), records_(shm::Records(header)), mask_(header->capacity - 1), size_(size) {}
+
+  bool Publish(int32_t id, double value) {
+    if (id < 0) return false;
+    uint64_t pos = header_->enqueue_pos.load(std::memory_order_relaxed);
+    shm::ShmRecord* record = nullptr;
+    while (true) {
+      record = &records_[pos & mask_];
+      const uint64_t sequence = record->sequence.load(std::memory_order_acquire);
+      const int64_t diff = static_cast<int64_t>(sequence) - static_cast<int64_t>(pos);
+      if (diff == 0) {
+        if (header_->enqueue_pos.compare_exchange_weak(pos, pos + 1,
+                                                       std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        // 环已满：agent 还没消费到这里
+        header_->dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      } else {
+        pos = header_->enqueue_pos.load(std::memory_order_relaxed);
+      }
+    }
+    record->metric_id = static_cast<uint32_t>(id);
+    record->value = value;
+    record->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  }
+
+  shm::ShmHeader* header_;
+  shm::ShmRecord* records_;
+  uint64_t mask_;
+  size_t size_;
+  std::mutex register_mutex_;
+  std::unordered_map<std::string, int32_t> ids_;
+};
+
+}  // namespace sdk
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_SDK_SHM_METRICS_H_
@@ -0,0 +1,257 @@
+#include "src/server/async_metrics_server.h"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "src/common/logging/logging.h"
+
+namespace system_insight {
+namespace server {
+
+using systeminsight::proto::MetricsReport;
+using systeminsight::proto::QueryRangeRequest;
+using systeminsight::proto::QueryRangeResponse;
+using systeminsight::proto::ReportAck;
+
+class AsyncMetricsServer::Call {
+ public:
+  Call(AsyncMetricsServer* server, Queue* queue) : server_(server), queue_(queue) {}
+  virtual ~Call() = default;
+
+  /**
+   * @brief 上一个操作完成后推进一步；调用结束时删除自身
+   * @param ok 操作是否成功（请求到达、读到消息、写入完成）
+   */
+  virtual void Proceed(bool ok) = 0;
+
+ protected:
+  void* tag() { return this; }
+
+  // 报告提交后在应用线程上调用；此时调用没有未完成的操作，由这里发出下一个
+  void Resume() {
+    std::lock_guard<std::mutex> lock(queue_->mutex);
+    if (queue_->shutdown) {
+      delete this;
+      return;
+    }
+    Committed();
+  }
+  virtual void Committed() {}
+
+  AsyncMetricsServer* server_;
+  Queue* queue_;
+  grpc::ServerContext context_;
+};
+
+class AsyncMetricsServer::SendMetricsCall final : public Call {
+ public:
+  SendMetricsCall(AsyncMetricsServer* server, Queue* queue)
+      : Call(server, queue), request_(server->handler_->AcquireReport()), responder_(&context_) {
+    // 请求直接反序列化进池化报告，处理时连同槽位移交给入库流水线
+    server_->service_.RequestSendMetrics(&context_, request_->report(), &responder_,
+                                         queue_->cq.get(), queue_->cq.get(), tag());
+  }
+
+  void Proceed(bool ok) override {
+    if (!ok || finishing_) {
+      delete this;
+      return;
+    }
+    // 先补挂一个请求，再处理本次调用
+    new SendMetricsCall(server_, queue_);
+    finishing_ = true;
+    if (server_->handler_->HandleReport(std::move(request_), &response_, [this] { Resume(); })) {
+      Committed();
+    }
+  }
+
+ private:
+  void Committed() override { responder_.Finish(response_, grpc::Status::OK, tag()); }
+
+  common::codec::PooledReport request_;
+  ReportAck response_;
+  grpc::ServerAsyncResponseWriter<ReportAck> responder_;
+  bool finishing_ = false;
+};
+
+class AsyncMetricsServer::QueryRangeCall final : public Call {
+ public:
+  QueryRangeCall(AsyncMetricsServer* server, Queue* queue)
+      : Call(server, queue), responder_(&context_) {
+    server_->service_.RequestQueryRange(&context_, &request_, &responder_, queue_->cq.get(),
+                                        queue_->cq.get(), tag());
+  }
+
+  void Proceed(bool ok) override {
+    if (!ok || finishing_) {
+      delete this;
+      return;
+    }
+    new QueryRangeCall(server_, queue_);
+    const grpc::Status status = server_->handler_->HandleQuery(request_, &response_);
+    finishing_ = true;
+    if (status.ok()) {
+      responder_.Finish(response_, status, tag());
+    } else {
+      responder_.FinishWithError(status, tag());
+    }
+  }
+
+ private:
+  QueryRangeRequest request_;
+  QueryRangeResponse response_;
+  grpc::ServerAsyncResponseWriter<QueryRangeResponse> responder_;
+  bool finishing_ = false;
+};
+
+/**
+ * @brief 上报流：握手 → 读报告 → 回确认 → 读报告 …，读到流结束后 Finish
+ */
+class AsyncMetricsServer::StreamMetricsCall final : public Call {
+ public:
+  StreamMetricsCall(AsyncMetricsServer* server, Queue* queue)
+      : Call(server, queue), stream_(&context_) {
+    server_->service_.RequestStreamMetrics(&context_, &stream_, queue_->cq.get(),
+                                           queue_->cq.get(), tag());
+  }
+
+  void Proceed(bool ok) override {
+    switch (state_) {
+      case State::kRequested:
+        if (!ok) break;
+        new StreamMetricsCall(server_, queue_);
+        server_->handler_->FillStreamHandshake(&ack_);
+        state_ = State::kHandshake;
+        stream_.Write(ack_, tag());
+        return;
+      case State::kHandshake:
+        if (!ok) return Finish();
+        LOGI("metrics stream opened from {}", context_.peer());
+        opened_ = true;
+        return Read();
+      case State::kReading:
+        // 客户端结束发送或连接断开
+        if (!ok) return Finish();
+        state_ = State::kWriting;
+        if (server_->handler_->HandleStreamReport(std::move(report_), &ack_,
+                                                   [this] { Resume(); })) {
+          Committed();
+        }
+        return;
+      case State::kWriting:
+        if (!ok) return Finish();
+        return Read();
+      case State::kFinishing:
+        if (opened_) LOGI("metrics stream closed from {}", context_.peer());
+        break;
+    }
+    delete this;
+  }
+
+ private:
+  enum class State { kRequested, kHandshake, kReading, kWriting, kFinishing };
+
+  void Committed() override { stream_.Write(ack_, tag()); }
+
+  void Read() {
+    state_ = State::kReading;
+    // 每份报告读进一个新的池化报告，上一份已移交给入库流水线
+    if (!report_) report_ = server_->handler_->AcquireReport();
+    stream_.Read(report_->report(), tag());
+  }
+
+  void Finish() {
+    state_ = State::kFinishing;
+    stream_.Finish(grpc::Status::OK, tag());
+  }
+
+  common::codec::PooledReport report_;
+  ReportAck ack_;
+  grpc::ServerAsyncReaderWriter<ReportAck, MetricsReport> stream_;
+  State state_ = State::kRequested;
+  bool opened_ = false;
+};
+
+AsyncMetricsServer::AsyncMetricsServer(MetricsServiceImpl* handler, AsyncServerOptions options)
+    : handler_(handler), options_(options) {}
+
+AsyncMetricsServer::~AsyncMetricsServer() { Stop(); }
+
+void AsyncMetricsServer::Register(grpc::ServerBuilder* builder) {
+  builder->RegisterService(&service_);
+  size_t count = options_.completion_queues;
+  if (count == 0) {
+    count = std::max(1u, std::thread::hardware_concurrency());
+  }
+  for (size_t i = 0; i < count; ++i) {
+    auto queue = std::make_unique<Queue>();
+    queue->cq = builder->AddCompletionQueue();
+    queues_.push_back(std::move(queue));
+  }
+}
+
+void AsyncMetricsServer::Start() {
+  const size_t cpus = std::max(1u, std::thread::hardware_concurrency());
+  const size_t calls = std::max<size_t>(options_.calls_per_method, 1);
+  for (size_t i = 0; i < queues_.size(); ++i) {
+    Queue* queue = queues_[i].get();
+    for (size_t k = 0; k < calls; ++k) {
+      new SendMetricsCall(this, queue);
+      new StreamMetricsCall(this, queue);
+      new QueryRangeCall(this, queue);
+    }
+    pollers_.emplace_back([this, queue] { Poll(queue); });
+    if (options_.pin_pollers) {
+      cpu_set_t cpu_set;
+      CPU_ZERO(&cpu_set);
+      CPU_SET(i % cpus, &cpu_set);
+      const int rc = pthread_setaffinity_np(pollers_.back().native_handle(), sizeof(cpu_set),
+                                            &cpu_set);
+      if (rc != 0) {
+        LOGW("failed to pin completion queue poller {} to cpu {}: error {}", i, i % cpus, rc);
+      }
+    }
+  }
+  LOGI("async gRPC service started with {} completion queues", queues_.size());
+}
+
+void AsyncMetricsServer::Stop() {
+  for (auto& queue : queues_) {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->shutdown) continue;
+    queue->shutdown = true;
+    queue->cq->Shutdown();
+  }
+  if (pollers_.empty()) {
+    // 未启动轮询线程时由调用线程释放挂起的调用
+    for (auto& queue : queues_) {
+      Poll(queue.get());
+    }
+  }
+  for (auto& poller : pollers_) {
+    if (poller.joinable()) poller.join();
+  }
+  pollers_.clear();
+}
+
+void AsyncMetricsServer::Poll(Queue* queue) {
+  void* tag = nullptr;
+  bool ok = false;
+  while (queue->cq->Next(&tag, &ok)) {
+    auto* call = static_cast<Call*>(tag);
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    if (queue->shutdown) {
+      // 队列已关闭，不能再提交后续操作
+      delete call;
+      continue;
+    }
+    call->Proceed(ok);
+  }
+}
+
+}  // namespace server
+}  // namespace system_insight
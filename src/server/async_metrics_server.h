@@ -0,0 +1,89 @@
+#ifndef SYSTEM_INSIGHT_SERVER_ASYNC_METRICS_SERVER_H_
+#define SYSTEM_INSIGHT_SERVER_ASYNC_METRICS_SERVER_H_
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "grpcpp/grpcpp.h"
+#include "src/server/metrics_service_impl.h"
+#include "system_insight.grpc.pb.h"
+
+namespace system_insight {
+namespace server {
+
+struct AsyncServerOptions {
+  // 完成队列数，每个队列一个轮询线程；0 表示硬件线程数
+  size_t completion_queues = 0;
+  // 把第 i 个轮询线程绑定到第 i % 硬件线程数 个 CPU 上
+  bool pin_pollers = true;
+  // 每个队列上为每个方法预先挂起的请求数，决定突发连接时无需等待重新挂起的并发度
+  size_t calls_per_method = 16;
+};
+
+/**
+ * @brief 以异步 API 提供 SystemInsightService，处理逻辑委托给 MetricsServiceImpl
+ *
+ * 同步服务为每个进行中的调用占用线程池中的一个线程，上万个长连接的上报流会把线程池耗尽。
+ * 这里每个完成队列只有一个轮询线程，调用是挂在队列上的状态机：
+ * 请求到达、读完、写完时在该线程上推进一步，调用数与线程数无关。
+ *
+ * 用法：Register(&builder) → builder.BuildAndStart() → Start()；
+ * 关闭时先 Server::Shutdown()，再 Stop()。
+ */
+class AsyncMetricsServer {
+ public:
+  AsyncMetricsServer(MetricsServiceImpl* handler, AsyncServerOptions options);
+  ~AsyncMetricsServer();
+
+  AsyncMetricsServer(const AsyncMetricsServer&) = delete;
+  AsyncMetricsServer& operator=(const AsyncMetricsServer&) = delete;
+
+  /**
+   * @brief 在 builder 上注册异步服务并创建完成队列，须在 BuildAndStart 之前调用
+   */
+  void Register(grpc::ServerBuilder* builder);
+
+  /**
+   * @brief 在每个队列上挂起请求并启动轮询线程，须在 BuildAndStart 之后调用
+   */
+  void Start();
+
+  /**
+   * @brief 关闭完成队列、释放剩余调用并等待轮询线程退出
+   *
+   * 须在 Server::Shutdown 与 MetricsServiceImpl::StopIngest 之后调用，等待提交的调用此时都已恢复。
+   */
+  void Stop();
+
+  size_t queue_count() const { return queues_.size(); }
+
+ private:
+  struct Queue {
+    std::unique_ptr<grpc::ServerCompletionQueue> cq;
+    // 推进调用与关闭队列互斥，保证关闭后不再向队列提交操作
+    std::mutex mutex;
+    bool shutdown = false;
+  };
+
+  // 挂在完成队列上的调用；任一时刻至多有一个未完成的操作，以自身地址为 tag
+  class Call;
+  class SendMetricsCall;
+  class StreamMetricsCall;
+  class QueryRangeCall;
+
+  void Poll(Queue* queue);
+
+  MetricsServiceImpl* handler_;
+  const AsyncServerOptions options_;
+  systeminsight::proto::SystemInsightService::AsyncService service_;
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> pollers_;
+};
+
+}  // namespace server
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_SERVER_ASYNC_METRICS_SERVER_H_
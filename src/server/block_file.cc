@@ -0,0 +1,338 @@
+#include "src/server/block_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+
+#include "src/common/logging/logging.h"
+#include "src/common/storage/crc32c.h"
+
+namespace system_insight {
+namespace server {
+
+namespace {
+
+constexpr char kMagic[8] = {'S', 'I', 'B', 'L', 'O', 'C', 'K', '\0'};
+constexpr uint32_t kVersion = 2;
+constexpr size_t kFlushBytes = 1 << 20;
+
+struct BlockHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t series_count;
+  uint64_t chunk_count;
+  int64_t min_time_ms;
+  int64_t max_time_ms;
+  uint64_t index_offset;
+  uint64_t index_bytes;
+  uint32_t index_crc;
+  uint32_t reserved;
+};
+static_assert(sizeof(BlockHeader) == 64, "block header must stay 64 bytes");
+
+void PutVarint(uint64_t value, std::string* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<char>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<char>(value));
+}
+
+void PutString(const std::string& value, std::string* out) {
+  PutVarint(value.size(), out);
+  out->append(value);
+}
+
+uint64_t ZigZag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+// 索引区的顺序读取器，越界后 ok 置为 false，后续读取均返回 0 / 空串
+struct IndexReader {
+  const char* cursor;
+  const char* end;
+  bool ok = true;
+
+  uint64_t Varint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (cursor >= end) break;
+      const uint8_t byte = static_cast<uint8_t>(*cursor++);
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) return value;
+    }
+    ok = false;
+    return 0;
+  }
+
+  std::string String() {
+    const uint64_t size = Varint();
+    if (!ok || size > static_cast<uint64_t>(end - cursor)) {
+      ok = false;
+      return {};
+    }
+    std::string value(cursor, size);
+    cursor += size;
+    return value;
+  }
+};
+
+bool WriteFully(int fd, const char* data, size_t size) {
+  while (size > 0) {
+    ssize_t n = ::write(fd, data, size);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) return false;
+    data += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+void SyncDirectory(const std::string& path) {
+  const std::string directory = std::filesystem::path(path).parent_path().string();
+  int fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd >= 0) {
+    ::fsync(fd);
+    ::close(fd);
+  }
+}
+
+}  // namespace
+
+BlockWriter::BlockWriter(std::string path) : path_(std::move(path)), temp_path_(path_ + ".tmp") {}
+
+BlockWriter::~BlockWriter() {
+  if (fd_ >= 0) {
+    ::close(fd_);
+    ::unlink(temp_path_.c_str());
+  }
+}
+
+bool BlockWriter::Open() {
+  fd_ = ::open(temp_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd_ < 0) {
+    LOGE("Failed to create block {}: {}", temp_path_, std::strerror(errno));
+    return false;
+  }
+  // 头最后写入，先占位
+  buffer_.assign(sizeof(BlockHeader), '\0');
+  offset_ = sizeof(BlockHeader);
+  return true;
+}
+
+bool BlockWriter::Write(const void* data, size_t size) {
+  buffer_.append(static_cast<const char*>(data), size);
+  offset_ += size;
+  return buffer_.size() < kFlushBytes || Flush();
+}
+
+bool BlockWriter::Flush() {
+  if (!WriteFully(fd_, buffer_.data(), buffer_.size())) {
+    LOGE("Failed to write block {}: {}", temp_path_, std::strerror(errno));
+    return false;
+  }
+  buffer_.clear();
+  return true;
+}
+
+bool BlockWriter::AddSeries(const std::string& host_id, const SeriesStore::Series& series,
+                            const std::vector<std::shared_ptr<const SealedChunk>>& chunks,
+                            const std::vector<BlockRollup>& rollups) {
+  if (fd_ < 0 || (chunks.empty() && rollups.empty())) return fd_ >= 0;
+  PutString(host_id, &index_);
+  PutString(*series.name, &index_);
+  PutVarint(series.labels.size(), &index_);
+  for (const auto& label : series.labels) {
+    PutString(*label.key, &index_);
+    PutString(*label.value, &index_);
+  }
+  PutVarint(chunks.size(), &index_);
+  for (const auto& chunk : chunks) {
+    PutVarint((offset_ - sizeof(BlockHeader)) / sizeof(uint64_t), &index_);
+    PutVarint(chunk->word_count(), &index_);
+    PutVarint(chunk->count, &index_);
+    PutVarint(ZigZag(chunk->min_time_ms), &index_);
+    PutVarint(static_cast<uint64_t>(chunk->max_time_ms - chunk->min_time_ms), &index_);
+    if (!Write(chunk->words(), chunk->word_count() * sizeof(uint64_t))) return false;
+    min_time_ms_ = std::min(min_time_ms_, chunk->min_time_ms);
+    max_time_ms_ = std::max(max_time_ms_, chunk->max_time_ms);
+    ++chunk_count_;
+  }
+  PutVarint(rollups.size(), &index_);
+  for (const auto& rollup : rollups) {
+    PutVarint(static_cast<uint64_t>(rollup.resolution_ms), &index_);
+    PutVarint(rollup.chunks.size(), &index_);
+    for (const auto& chunk : rollup.chunks) {
+      static constexpr char kPadding[sizeof(uint64_t)] = {};
+      const size_t size = chunk->storage.size();
+      PutVarint((offset_ - sizeof(BlockHeader)) / sizeof(uint64_t), &index_);
+      PutVarint(size, &index_);
+      PutVarint(chunk->count, &index_);
+      PutVarint(ZigZag(chunk->min_time_ms), &index_);
+      PutVarint(static_cast<uint64_t>(chunk->max_time_ms - chunk->min_time_ms), &index_);
+      if (!Write(chunk->storage.data(), size) ||
+          !Write(kPadding, (sizeof(uint64_t) - size % sizeof(uint64_t)) % sizeof(uint64_t))) {
+        return false;
+      }
+      min_time_ms_ = std::min(min_time_ms_, chunk->min_time_ms);
+      max_time_ms_ = std::max(max_time_ms_, chunk->max_time_ms);
+      ++chunk_count_;
+    }
+  }
+  ++series_count_;
+  return true;
+}
+
+bool BlockWriter::Finish() {
+  if (fd_ < 0) return false;
+  BlockHeader header{};
+  std::memcpy(header.magic, kMagic, sizeof(kMagic));
+  header.version = kVersion;
+  header.series_count = static_cast<uint32_t>(series_count_);
+  header.chunk_count = chunk_count_;
+  header.min_time_ms = min_time_ms_;
+  header.max_time_ms = max_time_ms_;
+  header.index_offset = offset_;
+  header.index_bytes = index_.size();
+  header.index_crc = common::storage::Crc32c(index_.data(), index_.size());
+
+  if (!Write(index_.data(), index_.size()) || !Flush()) return false;
+  if (::pwrite(fd_, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+      ::fsync(fd_) != 0) {
+    LOGE("Failed to finish block {}: {}", temp_path_, std::strerror(errno));
+    return false;
+  }
+  ::close(fd_);
+  fd_ = -1;
+  if (::rename(temp_path_.c_str(), path_.c_str()) != 0) {
+    LOGE("Failed to publish block {}: {}", path_, std::strerror(errno));
+    ::unlink(temp_path_.c_str());
+    return false;
+  }
+  SyncDirectory(path_);
+  return true;
+}
+
+std::shared_ptr<MappedBlock> MappedBlock::Open(const std::string& path) {
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    LOGW("Failed to open block {}: {}", path, std::strerror(errno));
+    return nullptr;
+  }
+  struct stat st {};
+  if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(BlockHeader)) {
+    LOGW("Block {} is truncated", path);
+    ::close(fd);
+    return nullptr;
+  }
+  const size_t size = static_cast<size_t>(st.st_size);
+  void* data = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    LOGW("Failed to map block {}: {}", path, std::strerror(errno));
+    return nullptr;
+  }
+
+  std::shared_ptr<MappedBlock> block(new MappedBlock());
+  block->data_ = static_cast<const char*>(data);
+  block->size_ = size;
+
+  BlockHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  const bool valid_layout = std::memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 &&
+                            header.version == kVersion &&
+                            header.index_offset >= sizeof(BlockHeader) &&
+                            header.index_offset + header.index_bytes == size &&
+                            (header.index_offset - sizeof(BlockHeader)) % sizeof(uint64_t) == 0;
+  if (!valid_layout || common::storage::Crc32c(block->data_ + header.index_offset,
+                                               header.index_bytes) != header.index_crc) {
+    LOGW("Block {} failed validation", path);
+    return nullptr;
+  }
+  block->index_offset_ = header.index_offset;
+  block->index_bytes_ = header.index_bytes;
+  block->series_count_ = header.series_count;
+  block->min_time_ms_ = header.min_time_ms;
+  block->max_time_ms_ = header.max_time_ms;
+  return block;
+}
+
+MappedBlock::~MappedBlock() {
+  if (data_ != nullptr) {
+    ::munmap(const_cast<char*>(data_), size_);
+  }
+}
+
+bool MappedBlock::ForEachSeries(const std::function<void(BlockSeries&&)>& visitor) const {
+  const auto* words = reinterpret_cast<const uint64_t*>(data_ + sizeof(BlockHeader));
+  const uint64_t data_words = (index_offset_ - sizeof(BlockHeader)) / sizeof(uint64_t);
+  const std::shared_ptr<const void> mapping = shared_from_this();
+  IndexReader reader{data_ + index_offset_, data_ + index_offset_ + index_bytes_};
+
+  for (size_t i = 0; i < series_count_; ++i) {
+    BlockSeries series;
+    series.host_id = reader.String();
+    series.key.set_name(reader.String());
+    const uint64_t label_count = reader.Varint();
+    for (uint64_t j = 0; j < label_count && reader.ok; ++j) {
+      auto* label = series.key.add_labels();
+      label->set_key(reader.String());
+      label->set_value(reader.String());
+    }
+    const uint64_t chunk_count = reader.Varint();
+    for (uint64_t j = 0; j < chunk_count && reader.ok; ++j) {
+      auto chunk = std::make_shared<SealedChunk>();
+      const uint64_t word_offset = reader.Varint();
+      chunk->mapped_word_count = reader.Varint();
+      chunk->count = static_cast<uint32_t>(reader.Varint());
+      chunk->min_time_ms = UnZigZag(reader.Varint());
+      chunk->max_time_ms = chunk->min_time_ms + static_cast<int64_t>(reader.Varint());
+      if (word_offset > data_words || chunk->mapped_word_count > data_words - word_offset) {
+        reader.ok = false;
+      }
+      if (!reader.ok) break;
+      chunk->mapped_words = words + word_offset;
+      chunk->mapping = mapping;
+      series.chunks.push_back(std::move(chunk));
+    }
+    const uint64_t rollup_count = reader.Varint();
+    for (uint64_t j = 0; j < rollup_count && reader.ok; ++j) {
+      BlockRollup rollup;
+      rollup.resolution_ms = static_cast<int64_t>(reader.Varint());
+      const uint64_t rollup_chunks = reader.Varint();
+      for (uint64_t k = 0; k < rollup_chunks && reader.ok; ++k) {
+        auto chunk = std::make_shared<RollupChunk>();
+        const uint64_t word_offset = reader.Varint();
+        const uint64_t size = reader.Varint();
+        chunk->count = static_cast<uint32_t>(reader.Varint());
+        chunk->min_time_ms = UnZigZag(reader.Varint());
+        chunk->max_time_ms = chunk->min_time_ms + static_cast<int64_t>(reader.Varint());
+        if (word_offset > data_words ||
+            size > (data_words - word_offset) * sizeof(uint64_t)) {
+          reader.ok = false;
+        }
+        if (!reader.ok) break;
+        chunk->storage.assign(reinterpret_cast<const char*>(words + word_offset), size);
+        rollup.chunks.push_back(std::move(chunk));
+      }
+      series.rollups.push_back(std::move(rollup));
+    }
+    if (!reader.ok) return false;
+    visitor(std::move(series));
+  }
+  return true;
+}
+
+}  // namespace server
+}  // namespace system_insight
@@ -0,0 +1,121 @@
+#ifndef SYSTEM_INSIGHT_SERVER_BLOCK_FILE_H_
+#define SYSTEM_INSIGHT_SERVER_BLOCK_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/server/gorilla_chunk.h"
+#include "src/server/rollup.h"
+#include "src/server/series_store.h"
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace server {
+
+/**
+ * @brief 一个汇总层级的封存块
+ */
+struct BlockRollup {
+  int64_t resolution_ms = 0;
+  std::vector<std::shared_ptr<const RollupChunk>> chunks;
+};
+
+/**
+ * @brief 块文件中的一个（主机, 序列）及其封存块
+ */
+struct BlockSeries {
+  std::string host_id;
+  systeminsight::proto::MetricSample key;  // 只有 name 与 labels
+  std::vector<std::shared_ptr<const SealedChunk>> chunks;
+  std::vector<BlockRollup> rollups;
+};
+
+/**
+ * @brief 写入块文件：一次压缩（compaction）落盘的封存块与序列索引，写完后不再修改
+ *
+ * 布局（主机字节序，只供本机重启时读取）：
+ *   [64 字节头][位流区：各块的 64 位字依次排列][索引区]
+ * 头记录魔数、版本、时间范围以及索引区的位置与 CRC32C；索引区按序列依次记录
+ * 主机 id、指标名、标签、每个块的（字偏移, 字数, 样本数, 时间范围），以及每个汇总层级的
+ * 分辨率和其块的（字偏移, 字节数, 桶数, 时间范围）。汇总块补齐到 8 字节。
+ * 先写临时文件，Finish() 时 fsync 后原子改名，目录中只会出现完整的块文件。
+ */
+class BlockWriter {
+ public:
+  explicit BlockWriter(std::string path);
+  ~BlockWriter();
+
+  BlockWriter(const BlockWriter&) = delete;
+  BlockWriter& operator=(const BlockWriter&) = delete;
+
+  bool Open();
+  bool AddSeries(const std::string& host_id, const SeriesStore::Series& series,
+                 const std::vector<std::shared_ptr<const SealedChunk>>& chunks,
+                 const std::vector<BlockRollup>& rollups = {});
+  bool Finish();
+
+  size_t series_count() const { return series_count_; }
+
+ private:
+  bool Write(const void* data, size_t size);
+  bool Flush();
+
+  std::string path_;
+  std::string temp_path_;
+  int fd_ = -1;
+  std::string buffer_;
+  uint64_t offset_ = 0;  // 已写入（含缓冲）的字节数
+  std::string index_;
+  size_t series_count_ = 0;
+  uint64_t chunk_count_ = 0;
+  int64_t min_time_ms_ = INT64_MAX;
+  int64_t max_time_ms_ = INT64_MIN;
+};
+
+/**
+ * @brief 只读映射的块文件；解析出的封存块直接引用映射，映射随最后一个块释放
+ *
+ * 汇总块复制到堆上，不引用映射。
+ */
+class MappedBlock : public std::enable_shared_from_this<MappedBlock> {
+ public:
+  /**
+   * @return 文件不存在、头或索引校验失败时返回 nullptr
+   */
+  static std::shared_ptr<MappedBlock> Open(const std::string& path);
+  ~MappedBlock();
+
+  MappedBlock(const MappedBlock&) = delete;
+  MappedBlock& operator=(const MappedBlock&) = delete;
+
+  /**
+   * @brief 按写入顺序逐个解析序列
+   * @return 索引内容越界时返回 false（已回调的序列仍然有效）
+   */
+  bool ForEachSeries(const std::function<void(BlockSeries&&)>& visitor) const;
+
+  int64_t min_time_ms() const { return min_time_ms_; }
+  int64_t max_time_ms() const { return max_time_ms_; }
+  size_t series_count() const { return series_count_; }
+  size_t file_bytes() const { return size_; }
+
+ private:
+  MappedBlock() = default;
+
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  uint64_t index_offset_ = 0;
+  uint64_t index_bytes_ = 0;
+  size_t series_count_ = 0;
+  int64_t min_time_ms_ = 0;
+  int64_t max_time_ms_ = 0;
+};
+
+}  // namespace server
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_SERVER_BLOCK_FILE_H_
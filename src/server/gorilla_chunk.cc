@@ -0,0 +1,227 @@
+#include "src/server/gorilla_chunk.h"
+
+#include <algorithm>
+#include <iterator>
+
+#include "src/common/codec/gorilla.h"
+
+namespace system_insight {
+namespace server {
+
+namespace {
+
+// 单个样本编码后的最大位数：'1111' + 64 位时间戳差分，'11' + 5 + 6 + 64 位取值
+constexpr size_t kMaxSampleBits = 4 + 64 + 2 + 5 + 6 + 64;
+
+bool FitsSigned(int64_t value, int bits) {
+  const int64_t limit = int64_t{1} << (bits - 1);
+  return value >= -limit && value < limit;
+}
+
+uint64_t LowBits(uint64_t value, int bits) {
+  return bits == 64 ? value : value & ((uint64_t{1} << bits) - 1);
+}
+
+int64_t SignExtend(uint64_t value, int bits) {
+  if (bits == 64) return static_cast<int64_t>(value);
+  const uint64_t sign = uint64_t{1} << (bits - 1);
+  return static_cast<int64_t>((value ^ sign) - sign);
+}
+
+class BitReader {
+ public:
+  BitReader(const uint64_t* words, size_t word_count) : words_(words), word_count_(word_count) {}
+
+  bool ReadBits(int count, uint64_t* value) {
+    if (pos_ + count > word_count_ * 64) return false;
+    uint64_t result = 0;
+    while (count > 0) {
+      const size_t offset = pos_ & 63;
+      const int take = static_cast<int>(std::min<size_t>(64 - offset, count));
+      const uint64_t word = words_[pos_ >> 6];
+      const uint64_t bits = LowBits(word >> (64 - offset - take), take);
+      result = take == 64 ? bits : (result << take) | bits;
+      pos_ += take;
+      count -= take;
+    }
+    *value = result;
+    return true;
+  }
+
+  bool ReadBit(bool* bit) {
+    uint64_t value = 0;
+    if (!ReadBits(1, &value)) return false;
+    *bit = value != 0;
+    return true;
+  }
+
+ private:
+  const uint64_t* words_;
+  size_t word_count_;
+  size_t pos_ = 0;
+};
+
+// 时间戳 delta-of-delta 的分档：前缀 1 的个数 -> 负载位数
+constexpr int kDodBits[] = {14, 17, 20, 64};
+
+}  // namespace
+
+HeadChunk::HeadChunk() {
+  for (auto& word : words_) {
+    word.store(0, std::memory_order_relaxed);
+  }
+}
+
+void HeadChunk::WriteBits(uint64_t bits, int count) {
+  while (count > 0) {
+    const size_t offset = bit_pos_ & 63;
+    const int take = static_cast<int>(std::min<size_t>(64 - offset, count));
+    const uint64_t chunk = LowBits(bits >> (count - take), take);
+    auto& word = words_[bit_pos_ >> 6];
+    word.store(word.load(std::memory_order_relaxed) | (chunk << (64 - offset - take)),
+               std::memory_order_relaxed);
+    bit_pos_ += take;
+    count -= take;
+  }
+}
+
+bool HeadChunk::Append(int64_t timestamp_ms, double value) {
+  const uint32_t count = count_.load(std::memory_order_relaxed);
+  if (count >= kMaxSamples) return false;
+  const uint64_t value_bits = common::codec::DoubleToBits(value);
+
+  if (count == 0) {
+    min_time_ms_ = timestamp_ms;
+    WriteBits(static_cast<uint64_t>(timestamp_ms), 64);
+    WriteBits(value_bits, 64);
+  } else {
+    if (bit_pos_ + kMaxSampleBits > kWords * 64) return false;
+
+    const int64_t delta = timestamp_ms - prev_timestamp_ms_;
+    const int64_t dod = delta - prev_delta_ms_;
+    if (dod == 0) {
+      WriteBits(0, 1);
+    } else {
+      for (size_t bucket = 0; bucket < std::size(kDodBits); ++bucket) {
+        const int bits = kDodBits[bucket];
+        if (bits == 64 || FitsSigned(dod, bits)) {
+          // 前缀：bucket 个 1 加一个 0，最后一档是四个 1
+          const int prefix_bits = bucket == 3 ? 4 : static_cast<int>(bucket) + 2;
+          const uint64_t prefix = bucket == 3 ? 0xF : ((uint64_t{1} << (bucket + 2)) - 2);
+          WriteBits(prefix, prefix_bits);
+          WriteBits(LowBits(static_cast<uint64_t>(dod), bits), bits);
+          break;
+        }
+      }
+    }
+    prev_delta_ms_ = delta;
+
+    const uint64_t xor_bits = value_bits ^ prev_value_bits_;
+    if (xor_bits == 0) {
+      WriteBits(0, 1);
+    } else {
+      int leading = __builtin_clzll(xor_bits);
+      const int trailing = __builtin_ctzll(xor_bits);
+      if (leading > 31) leading = 31;
+      if (prev_leading_ >= 0 && leading >= prev_leading_ && trailing >= prev_trailing_) {
+        // 有效位落在上一个窗口内，沿用窗口
+        const int significant = 64 - prev_leading_ - prev_trailing_;
+        WriteBits(0b10, 2);
+        WriteBits(xor_bits >> prev_trailing_, significant);
+      } else {
+        const int significant = 64 - leading - trailing;
+        WriteBits(0b11, 2);
+        WriteBits(static_cast<uint64_t>(leading), 5);
+        WriteBits(static_cast<uint64_t>(significant == 64 ? 0 : significant), 6);
+        WriteBits(xor_bits >> trailing, significant);
+        prev_leading_ = leading;
+        prev_trailing_ = trailing;
+      }
+    }
+  }
+
+  prev_timestamp_ms_ = timestamp_ms;
+  prev_value_bits_ = value_bits;
+  count_.store(count + 1, std::memory_order_release);
+  return true;
+}
+
+void HeadChunk::Read(int64_t start_ms, int64_t end_ms, PointBlock* out) const {
+  const uint32_t count = count_.load(std::memory_order_acquire);
+  if (count == 0) return;
+  uint64_t words[kWords];
+  for (size_t i = 0; i < kWords; ++i) {
+    words[i] = words_[i].load(std::memory_order_relaxed);
+  }
+  DecodeChunk(words, kWords, count, start_ms, end_ms, out);
+}
+
+std::shared_ptr<const SealedChunk> HeadChunk::Seal() const {
+  auto chunk = std::make_shared<SealedChunk>();
+  chunk->count = count_.load(std::memory_order_relaxed);
+  chunk->min_time_ms = min_time_ms_;
+  chunk->max_time_ms = prev_timestamp_ms_;
+  const size_t used_words = (bit_pos_ + 63) / 64;
+  chunk->storage.resize(used_words);
+  for (size_t i = 0; i < used_words; ++i) {
+    chunk->storage[i] = words_[i].load(std::memory_order_relaxed);
+  }
+  return chunk;
+}
+
+void DecodeChunk(const uint64_t* words, size_t word_count, uint32_t count, int64_t start_ms,
+                 int64_t end_ms, PointBlock* out) {
+  BitReader reader(words, word_count);
+  uint64_t raw = 0;
+  if (count == 0 || !reader.ReadBits(64, &raw)) return;
+  int64_t timestamp_ms = static_cast<int64_t>(raw);
+  if (!reader.ReadBits(64, &raw)) return;
+  uint64_t value_bits = raw;
+  int64_t delta = 0;
+  int leading = 0;
+  int trailing = 0;
+
+  for (uint32_t i = 0;;) {
+    if (timestamp_ms > end_ms) return;
+    if (timestamp_ms >= start_ms) {
+      out->timestamps_ms.push_back(timestamp_ms);
+      out->values.push_back(common::codec::BitsToDouble(value_bits));
+    }
+    if (++i == count) return;
+
+    // 时间戳：数前缀里 1 的个数（最多 4 个）确定分档
+    size_t ones = 0;
+    bool bit = false;
+    while (ones < 4) {
+      if (!reader.ReadBit(&bit)) return;
+      if (!bit) break;
+      ++ones;
+    }
+    if (ones > 0) {
+      const int bits = kDodBits[ones - 1];
+      if (!reader.ReadBits(bits, &raw)) return;
+      delta += SignExtend(raw, bits);
+    }
+    timestamp_ms += delta;
+
+    // 取值：0 表示与上一个相同，10 沿用窗口，11 新窗口
+    if (!reader.ReadBit(&bit)) return;
+    if (bit) {
+      if (!reader.ReadBit(&bit)) return;
+      if (bit) {
+        uint64_t field = 0;
+        if (!reader.ReadBits(5, &field)) return;
+        leading = static_cast<int>(field);
+        if (!reader.ReadBits(6, &field)) return;
+        const int significant = field == 0 ? 64 : static_cast<int>(field);
+        trailing = 64 - leading - significant;
+      }
+      const int significant = 64 - leading - trailing;
+      if (!reader.ReadBits(significant, &raw)) return;
+      value_bits ^= raw << trailing;
+    }
+  }
+}
+
+}  // namespace server
+}  // namespace system_insight
@@ -0,0 +1,108 @@
+#ifndef SYSTEM_INSIGHT_SERVER_GORILLA_CHUNK_H_
+#define SYSTEM_INSIGHT_SERVER_GORILLA_CHUNK_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace system_insight {
+namespace server {
+
+/**
+ * @brief 按列存放的一段时间点，时间戳升序；查询的聚合核直接在两列上批量计算
+ */
+struct PointBlock {
+  std::vector<int64_t> timestamps_ms;
+  std::vector<double> values;
+
+  size_t size() const { return timestamps_ms.size(); }
+  void clear() {
+    timestamps_ms.clear();
+    values.clear();
+  }
+};
+
+/**
+ * @brief 已封存的 Gorilla 压缩块；不可变
+ *
+ * 位流要么在堆上按实际大小分配（storage），要么直接指向映射的块文件（mapping 持有映射）。
+ */
+struct SealedChunk {
+  int64_t min_time_ms = 0;
+  int64_t max_time_ms = 0;
+  uint32_t count = 0;
+  std::vector<uint64_t> storage;
+  const uint64_t* mapped_words = nullptr;
+  size_t mapped_word_count = 0;
+  std::shared_ptr<const void> mapping;
+
+  const uint64_t* words() const { return mapping ? mapped_words : storage.data(); }
+  size_t word_count() const { return mapping ? mapped_word_count : storage.size(); }
+  // 映射的位流由页缓存承载，不计入堆内存
+  size_t MemoryBytes() const {
+    return sizeof(SealedChunk) + storage.capacity() * sizeof(uint64_t);
+  }
+};
+
+/**
+ * @brief 可追加的头块：时间戳用 delta-of-delta、取值用 XOR 编码（Gorilla，VLDB 2015）
+ *
+ * 固定容量，写满（或样本数达到上限）后由调用方封存并换新头块。
+ * 单写者：Append 只能由一个线程调用。读者可与写者并发读取：位流存放在原子字里，
+ * 写者只改动已发布样本之后的位，再以 release 发布样本数，读者不加锁。
+ */
+class HeadChunk {
+ public:
+  static constexpr size_t kWords = 16;
+  static constexpr uint32_t kMaxSamples = 120;
+
+  HeadChunk();
+
+  /**
+   * @return 空间或样本数不足时返回 false，样本未写入
+   */
+  bool Append(int64_t timestamp_ms, double value);
+
+  uint32_t count() const { return count_.load(std::memory_order_acquire); }
+  int64_t min_time_ms() const { return min_time_ms_; }
+  // 仅写者调用
+  int64_t last_time_ms() const { return prev_timestamp_ms_; }
+
+  /**
+   * @brief 读取已发布的样本（可与 Append 并发），追加落在 [start_ms, end_ms] 内的点
+   */
+  void Read(int64_t start_ms, int64_t end_ms, PointBlock* out) const;
+
+  /**
+   * @brief 复制为按实际大小分配的封存块；仅写者调用
+   */
+  std::shared_ptr<const SealedChunk> Seal() const;
+
+ private:
+  void WriteBits(uint64_t bits, int count);
+
+  std::atomic<uint64_t> words_[kWords];
+  std::atomic<uint32_t> count_{0};
+  int64_t min_time_ms_ = 0;  // 第一个样本写入前发布，之后不变
+
+  // 编码状态，仅写者访问
+  size_t bit_pos_ = 0;
+  int64_t prev_timestamp_ms_ = 0;
+  int64_t prev_delta_ms_ = 0;
+  uint64_t prev_value_bits_ = 0;
+  int prev_leading_ = -1;
+  int prev_trailing_ = 0;
+};
+
+/**
+ * @brief 解码 count 个样本，追加落在 [start_ms, end_ms] 内的点
+ */
+void DecodeChunk(const uint64_t* words, size_t word_count, uint32_t count, int64_t start_ms,
+                 int64_t end_ms, PointBlock* out);
+
+}  // namespace server
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_SERVER_GORILLA_CHUNK_H_
@@ -0,0 +1,108 @@
+#include "src/server/ingest_pipeline.h"
+
+#include <algorithm>
+#include <string>
+#include <utility>
+
+#include "src/common/logging/logging.h"
+
+namespace system_insight {
+namespace server {
+
+IngestPipeline::IngestPipeline(IngestOptions options,
+                               std::shared_ptr<MetricsRepository> repository,
+                               std::shared_ptr<TimeSeriesDb> tsdb)
+    : options_(options), repository_(std::move(repository)), tsdb_(std::move(tsdb)) {
+  for (size_t i = 0; i < options_.applier_threads; ++i) {
+    appliers_.push_back(std::make_unique<Applier>());
+  }
+  for (auto& applier : appliers_) {
+    applier->thread = std::thread([this, raw = applier.get()] { ApplierLoop(raw); });
+  }
+}
+
+IngestPipeline::~IngestPipeline() { Stop(); }
+
+IngestPipeline::SubmitResult IngestPipeline::Submit(common::codec::PooledReport report,
+                                                    std::function<void()> on_commit) {
+  if (!appliers_.empty()) {
+    Applier& applier =
+        *appliers_[std::hash<std::string>{}(report->report()->host_id()) % appliers_.size()];
+    std::unique_lock<std::mutex> lock(applier.mutex);
+    if (!applier.stopping) {
+      if (applier.queue.size() >= std::max<size_t>(options_.queue_capacity, 1)) {
+        lock.unlock();
+        const uint64_t rejected = ++rejected_total_;
+        // 持续过载时每 1000 份报告记一条日志
+        if (rejected % 1000 == 1) {
+          LOGW("ingest queue full, rejected {} reports so far", rejected);
+        }
+        return SubmitResult::kRejected;
+      }
+      const bool was_empty = applier.queue.empty();
+      applier.queue.push_back(Entry{std::move(report), std::move(on_commit)});
+      lock.unlock();
+      if (was_empty) applier.cv.notify_one();
+      return SubmitResult::kQueued;
+    }
+  }
+  if (repository_) repository_->UpdateReport(*report->report());
+  if (tsdb_) tsdb_->Append(*report->report());
+  ++committed_total_;
+  return SubmitResult::kApplied;
+}
+
+void IngestPipeline::Stop() {
+  for (auto& applier : appliers_) {
+    {
+      std::lock_guard<std::mutex> lock(applier->mutex);
+      applier->stopping = true;
+    }
+    applier->cv.notify_one();
+  }
+  for (auto& applier : appliers_) {
+    if (applier->thread.joinable()) applier->thread.join();
+  }
+}
+
+void IngestPipeline::ApplierLoop(Applier* applier) {
+  std::vector<Entry> batch;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(applier->mutex);
+      applier->cv.wait(lock, [applier] { return applier->stopping || !applier->queue.empty(); });
+      if (applier->queue.empty()) return;  // 停止且已排空
+      // 一次取走全部报告，生产者只在交换的瞬间与应用线程竞争
+      batch.swap(applier->queue);
+    }
+    const size_t max_batch = std::max<size_t>(options_.max_batch, 1);
+    for (auto begin = batch.begin(); begin != batch.end();) {
+      auto end = begin + static_cast<std::ptrdiff_t>(
+                             std::min<size_t>(max_batch, static_cast<size_t>(batch.end() - begin)));
+      Commit(begin, end);
+      begin = end;
+    }
+    batch.clear();
+  }
+}
+
+void IngestPipeline::Commit(std::vector<Entry>::iterator begin,
+                            std::vector<Entry>::iterator end) {
+  thread_local std::vector<const systeminsight::proto::MetricsReport*> reports;
+  reports.clear();
+  for (auto it = begin; it != end; ++it) {
+    reports.push_back(it->report->report());
+  }
+  if (repository_) repository_->UpdateReports(reports);
+  if (tsdb_) tsdb_->AppendBatch(reports);
+  committed_total_ += reports.size();
+  LOGD("committed batch of {} reports", reports.size());
+  for (auto it = begin; it != end; ++it) {
+    // 先归还槽位：回调可能立即让同一调用取下一个槽位
+    it->report.reset();
+    if (it->on_commit) it->on_commit();
+  }
+}
+
+}  // namespace server
+}  // namespace system_insight
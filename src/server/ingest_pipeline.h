@@ -0,0 +1,98 @@
+#ifndef SYSTEM_INSIGHT_SERVER_INGEST_PIPELINE_H_
+#define SYSTEM_INSIGHT_SERVER_INGEST_PIPELINE_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "src/common/codec/report_pool.h"
+#include "src/server/metrics_repository.h"
+#include "src/server/time_series_db.h"
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace server {
+
+struct IngestOptions {
+  // 应用线程数；0 表示不排队，在 RPC 处理线程上直接应用
+  size_t applier_threads = 0;
+  // 每个应用线程的队列容量（报告数），队列满时拒绝报告，由客户端稍后重发
+  size_t queue_capacity = 4096;
+  // 每次提交的最大报告数
+  size_t max_batch = 256;
+  // 为 true 时报告写入预写日志与内存后才确认；否则入队即确认
+  bool durable_ack = false;
+};
+
+/**
+ * @brief 入库流水线：RPC 处理线程只把报告放入队列，应用线程成批提交
+ *
+ * 报告按主机哈希分给一个应用线程，同一主机的报告按提交顺序应用。每个应用线程一个
+ * 有界队列（多生产者、单消费者），一次取出队列中的全部报告，按 max_batch 分批
+ * 提交：仓库与时序库按分片分组，每个分片每批只加一次锁，预写日志每批只同步一次。
+ * 应用线程数整除分片数时，各应用线程写入互不相交的分片。
+ *
+ * 报告以池化槽位的形式移交，入队与提交都不复制报告；提交后槽位归还给所属的池。
+ */
+class IngestPipeline {
+ public:
+  enum class SubmitResult {
+    kApplied,   // 未配置应用线程或流水线已停止，报告已在调用线程上直接应用
+    kQueued,    // 已入队；on_commit 非空时在提交后于应用线程上调用
+    kRejected,  // 队列已满
+  };
+
+  IngestPipeline(IngestOptions options, std::shared_ptr<MetricsRepository> repository,
+                 std::shared_ptr<TimeSeriesDb> tsdb);
+  ~IngestPipeline();
+
+  IngestPipeline(const IngestPipeline&) = delete;
+  IngestPipeline& operator=(const IngestPipeline&) = delete;
+
+  SubmitResult Submit(common::codec::PooledReport report,
+                      std::function<void()> on_commit = nullptr);
+
+  /**
+   * @brief 提交队列中剩余的报告并等待应用线程退出；之后的报告在调用线程上直接应用
+   */
+  void Stop();
+
+  const IngestOptions& options() const { return options_; }
+  uint64_t committed_total() const { return committed_total_.load(); }
+  uint64_t rejected_total() const { return rejected_total_.load(); }
+
+ private:
+  struct Entry {
+    common::codec::PooledReport report;
+    std::function<void()> on_commit;
+  };
+
+  struct alignas(64) Applier {
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<Entry> queue;
+    bool stopping = false;
+    std::thread thread;
+  };
+
+  void ApplierLoop(Applier* applier);
+  void Commit(std::vector<Entry>::iterator begin, std::vector<Entry>::iterator end);
+
+  const IngestOptions options_;
+  std::shared_ptr<MetricsRepository> repository_;
+  std::shared_ptr<TimeSeriesDb> tsdb_;
+  std::vector<std::unique_ptr<Applier>> appliers_;
+  std::atomic<uint64_t> committed_total_{0};
+  std::atomic<uint64_t> rejected_total_{0};
+};
+
+}  // namespace server
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_SERVER_INGEST_PIPELINE_H_
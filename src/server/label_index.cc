@@ -0,0 +1,251 @@
+#include "src/server/label_index.h"
+
+#include <algorithm>
+#include <mutex>
+
+namespace system_insight {
+namespace server {
+
+namespace {
+
+// 哈希表节点与桶的大致开销，用于估算内存
+constexpr size_t kMapEntryOverhead = 64;
+
+void WriteVarint(uint32_t value, std::vector<uint8_t>* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t ReadVarint(const uint8_t* data, size_t* offset) {
+  uint32_t value = 0;
+  for (int shift = 0;; shift += 7) {
+    const uint8_t byte = data[(*offset)++];
+    value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) return value;
+  }
+}
+
+// 参与求交的一个集合：单个倒排列表直接引用，多个值的并集先展开为数组
+struct IdSet {
+  const PostingList* list = nullptr;
+  std::vector<uint32_t> ids;
+
+  size_t size() const { return list != nullptr ? list->size() : ids.size(); }
+};
+
+// 保留 candidates 中在 set 里（keep_present）或不在 set 里的 id
+void Filter(const IdSet& set, bool keep_present, std::vector<uint32_t>* candidates) {
+  size_t kept = 0;
+  if (set.list != nullptr) {
+    PostingList::Iterator it = set.list->begin();
+    for (uint32_t id : *candidates) {
+      it.SeekGe(id);
+      const bool present = it.Valid() && it.Value() == id;
+      if (present == keep_present) (*candidates)[kept++] = id;
+    }
+  } else {
+    const uint32_t* cursor = set.ids.data();
+    const uint32_t* end = cursor + set.ids.size();
+    for (uint32_t id : *candidates) {
+      cursor = GallopGe(cursor, end, id);
+      const bool present = cursor != end && *cursor == id;
+      if (present == keep_present) (*candidates)[kept++] = id;
+    }
+  }
+  candidates->resize(kept);
+}
+
+}  // namespace
+
+const std::string LabelIndex::kNameKey = "__name__";
+
+PostingList::Iterator::Iterator(const PostingList* list) : list_(list) {
+  if (list_->count_ > 0) EnterBlock(0);
+}
+
+void PostingList::Iterator::EnterBlock(size_t block) {
+  block_ = block;
+  index_in_block_ = 0;
+  offset_ = list_->block_offset_[block];
+  value_ = list_->block_first_[block];
+  valid_ = true;
+}
+
+void PostingList::Iterator::Next() {
+  if (!valid_) return;
+  if (index_in_block_ + 1 < list_->BlockLength(block_)) {
+    value_ += ReadVarint(list_->bytes_.data(), &offset_);
+    ++index_in_block_;
+  } else if (block_ + 1 < list_->block_first_.size()) {
+    EnterBlock(block_ + 1);
+  } else {
+    valid_ = false;
+  }
+}
+
+void PostingList::Iterator::SeekGe(uint32_t target) {
+  if (!valid_ || value_ >= target) return;
+  const auto& firsts = list_->block_first_;
+  const size_t blocks = firsts.size();
+  if (block_ + 1 < blocks && firsts[block_ + 1] <= target) {
+    // 倍增找到跨过 target 的区间，再二分出最后一个块首 <= target 的块
+    size_t low = block_ + 1;
+    size_t step = 1;
+    while (low + step < blocks && firsts[low + step] <= target) {
+      low += step;
+      step <<= 1;
+    }
+    const size_t high = std::min(low + step, blocks);
+    const size_t block =
+        static_cast<size_t>(std::upper_bound(firsts.begin() + low, firsts.begin() + high, target) -
+                            firsts.begin()) - 1;
+    EnterBlock(block);
+  }
+  while (valid_ && value_ < target) Next();
+}
+
+void PostingList::Append(uint32_t id) {
+  if (count_ > 0 && id <= last_) return;
+  if (count_ % kBlockSize == 0) {
+    block_first_.push_back(id);
+    block_offset_.push_back(static_cast<uint32_t>(bytes_.size()));
+  } else {
+    WriteVarint(id - last_, &bytes_);
+  }
+  last_ = id;
+  ++count_;
+}
+
+size_t PostingList::BlockLength(size_t block) const {
+  return block + 1 < block_first_.size() ? kBlockSize : count_ - block * kBlockSize;
+}
+
+void PostingList::AppendTo(std::vector<uint32_t>* out) const {
+  out->reserve(out->size() + count_);
+  for (Iterator it = begin(); it.Valid(); it.Next()) {
+    out->push_back(it.Value());
+  }
+}
+
+size_t PostingList::MemoryBytes() const {
+  return sizeof(PostingList) + block_first_.capacity() * sizeof(uint32_t) +
+         block_offset_.capacity() * sizeof(uint32_t) + bytes_.capacity();
+}
+
+const uint32_t* GallopGe(const uint32_t* begin, const uint32_t* end, uint32_t target) {
+  if (begin == end || *begin >= target) return begin;
+  size_t low = 0;  // begin[low] < target
+  size_t step = 1;
+  const size_t size = static_cast<size_t>(end - begin);
+  while (low + step < size && begin[low + step] < target) {
+    low += step;
+    step <<= 1;
+  }
+  return std::lower_bound(begin + low + 1, begin + std::min(low + step, size), target);
+}
+
+bool IndexMatcher::Matches(const std::string& candidate) const {
+  switch (type) {
+    case Type::kNotEqual:
+      return candidate != value;
+    case Type::kRegex:
+      return std::regex_match(candidate, regex);
+    case Type::kNotRegex:
+      return !std::regex_match(candidate, regex);
+    default:
+      return candidate == value;
+  }
+}
+
+void LabelIndex::Add(uint32_t id, const std::string& name, const std::vector<Label>& labels) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  postings_[kNameKey][name].Append(id);
+  for (const auto& label : labels) {
+    postings_[*label.key][*label.value].Append(id);
+  }
+}
+
+std::vector<uint32_t> LabelIndex::Select(const std::vector<IndexMatcher>& matchers) const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  std::vector<IdSet> includes;
+  std::vector<IdSet> excludes;
+
+  for (const auto& matcher : matchers) {
+    auto key = postings_.find(matcher.key);
+    const ValueMap* values = key != postings_.end() ? &key->second : nullptr;
+    // 不匹配空串：结果只能来自命中的值；匹配空串：剔除未命中的值
+    const bool matches_empty = matcher.Matches("");
+    IdSet set;
+    const bool exact = matcher.type == IndexMatcher::Type::kEqual ||
+                       matcher.type == IndexMatcher::Type::kNotEqual;
+    if (values == nullptr) {
+      // 该键不存在：所有序列都按空串处理
+    } else if (exact && !matcher.value.empty()) {
+      auto it = values->find(matcher.value);
+      if (it != values->end()) set.list = &it->second;
+    } else {
+      std::vector<const PostingList*> lists;
+      for (const auto& [value, list] : *values) {
+        if (matcher.Matches(value) != matches_empty) lists.push_back(&list);
+      }
+      if (lists.size() == 1) {
+        set.list = lists.front();
+      } else if (!lists.empty()) {
+        for (const auto* list : lists) list->AppendTo(&set.ids);
+        std::sort(set.ids.begin(), set.ids.end());
+        set.ids.erase(std::unique(set.ids.begin(), set.ids.end()), set.ids.end());
+      }
+    }
+
+    if (!matches_empty) {
+      if (set.size() == 0) return {};
+      includes.push_back(std::move(set));
+    } else if (set.size() > 0) {
+      excludes.push_back(std::move(set));
+    }
+  }
+  if (includes.empty()) return {};
+
+  // 从最小的集合出发，逐个与其余集合求交（galloping），最后剔除排除集合
+  std::sort(includes.begin(), includes.end(),
+            [](const IdSet& lhs, const IdSet& rhs) { return lhs.size() < rhs.size(); });
+  std::vector<uint32_t> result;
+  if (includes.front().list != nullptr) {
+    includes.front().list->AppendTo(&result);
+  } else {
+    result = std::move(includes.front().ids);
+  }
+  for (size_t i = 1; i < includes.size() && !result.empty(); ++i) {
+    Filter(includes[i], true, &result);
+  }
+  for (const auto& set : excludes) {
+    if (result.empty()) break;
+    Filter(set, false, &result);
+  }
+  return result;
+}
+
+size_t LabelIndex::MemoryBytes() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  size_t bytes = sizeof(LabelIndex);
+  for (const auto& [key, values] : postings_) {
+    bytes += kMapEntryOverhead + key.capacity();
+    for (const auto& [value, list] : values) {
+      bytes += kMapEntryOverhead + value.capacity() + list.MemoryBytes();
+    }
+  }
+  return bytes;
+}
+
+size_t LabelIndex::posting_count() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  size_t count = 0;
+  for (const auto& [key, values] : postings_) count += values.size();
+  return count;
+}
+
+}  // namespace server
+}  // namespace system_insight
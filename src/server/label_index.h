@@ -0,0 +1,123 @@
+#ifndef SYSTEM_INSIGHT_SERVER_LABEL_INDEX_H_
+#define SYSTEM_INSIGHT_SERVER_LABEL_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <regex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace system_insight {
+namespace server {
+
+/**
+ * @brief 压缩的有序序列 id 集合（只能按递增顺序追加）
+ *
+ * 每 kBlockSize 个 id 为一块：块首 id 与块在字节流中的偏移不压缩，块内其余 id 存为
+ * 与前一个 id 之差的 varint。稠密 id 每个约 1 字节。SeekGe 先在块首上倍增查找（galloping）
+ * 定位块，再在块内顺序解码，求交时跳过不可能命中的整块。
+ */
+class PostingList {
+ public:
+  static constexpr size_t kBlockSize = 128;
+
+  class Iterator {
+   public:
+    explicit Iterator(const PostingList* list);
+
+    bool Valid() const { return valid_; }
+    uint32_t Value() const { return value_; }
+    void Next();
+    /**
+     * @brief 前进到第一个 >= target 的 id（不会后退）
+     */
+    void SeekGe(uint32_t target);
+
+   private:
+    void EnterBlock(size_t block);
+
+    const PostingList* list_;
+    size_t block_ = 0;
+    size_t index_in_block_ = 0;  // 当前 id 在块内的序号
+    size_t offset_ = 0;          // 下一个 varint 的字节偏移
+    uint32_t value_ = 0;
+    bool valid_ = false;
+  };
+
+  void Append(uint32_t id);
+  size_t size() const { return count_; }
+  Iterator begin() const { return Iterator(this); }
+  void AppendTo(std::vector<uint32_t>* out) const;
+  size_t MemoryBytes() const;
+
+ private:
+  size_t BlockLength(size_t block) const;
+
+  std::vector<uint32_t> block_first_;
+  std::vector<uint32_t> block_offset_;
+  std::vector<uint8_t> bytes_;
+  uint32_t last_ = 0;
+  size_t count_ = 0;
+};
+
+/**
+ * @brief 标签匹配器；key 为 "__name__" 时匹配指标名，序列上不存在的标签按空串处理
+ */
+struct IndexMatcher {
+  enum class Type { kEqual, kNotEqual, kRegex, kNotRegex };
+
+  std::string key;
+  std::string value;
+  Type type = Type::kEqual;
+  std::regex regex;  // kRegex / kNotRegex 使用，整串匹配
+
+  bool Matches(const std::string& candidate) const;
+};
+
+/**
+ * @brief 倒排索引：（标签键, 标签值）-> 有序序列 id，指标名以 "__name__" 作为标签键
+ *
+ * 随 SeriesStore 定义新序列增量维护（序列 id 递增，只需在列表尾部追加）。
+ * 查询与追加用读写锁隔离；新序列很少出现，查询几乎不会等待。
+ */
+class LabelIndex {
+ public:
+  static const std::string kNameKey;
+
+  struct Label {
+    const std::string* key;
+    const std::string* value;
+  };
+
+  void Add(uint32_t id, const std::string& name, const std::vector<Label>& labels);
+
+  /**
+   * @brief 同时满足全部匹配器的序列 id（升序）
+   *
+   * 相等匹配直接取倒排列表，正则匹配合并该键下所有命中的值；匹配空串的条件
+   * （如 key=""、key!="x"）转为从结果中剔除。至少需要一个不匹配空串的匹配器，
+   * 否则返回空。
+   */
+  std::vector<uint32_t> Select(const std::vector<IndexMatcher>& matchers) const;
+
+  size_t MemoryBytes() const;
+  size_t posting_count() const;
+
+ private:
+  using ValueMap = std::unordered_map<std::string, PostingList>;
+
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<std::string, ValueMap> postings_;
+};
+
+/**
+ * @brief 在升序数组 [begin, end) 中从 begin 开始倍增查找第一个 >= target 的位置
+ */
+const uint32_t* GallopGe(const uint32_t* begin, const uint32_t* end, uint32_t target);
+
+}  // namespace server
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_SERVER_LABEL_INDEX_H_
@@ -1,25 +1,152 @@
 #include "src/server/metrics_repository.h"
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <utility>
 
 namespace system_insight {
 namespace server {
 
-void MetricsRepository::UpdateReport(const systeminsight::proto::MetricsReport& report) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  reports_[report.host_id()] = report;
+namespace {
+
+int64_t LatestTimestamp(const systeminsight::proto::MetricsReport& report) {
+  int64_t latest = 0;
+  for (const auto& sample : report.samples()) {
+    latest = std::max(latest, sample.timestamp_ms());
+  }
+  return latest;
+}
+
+}  // namespace
+
+MetricsRepository::MetricsRepository(size_t shard_count,
+                                     std::shared_ptr<SeriesStore> series_store)
+    : series_store_(series_store ? std::move(series_store) : std::make_shared<SeriesStore>()),
+      shards_(std::make_unique<Shard[]>(std::max<size_t>(shard_count, 1))),
+      shard_count_(std::max<size_t>(shard_count, 1)) {}
+
+MetricsRepository::Shard& MetricsRepository::ShardFor(const std::string& host_id) const {
+  return shards_[std::hash<std::string>{}(host_id) % shard_count_];
+}
+
+bool MetricsRepository::UpdateReport(const systeminsight::proto::MetricsReport& report) {
+  Shard& shard = ShardFor(report.host_id());
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  std::vector<std::shared_ptr<HostEntry>> added;
+  const bool updated = UpdateLocked(&shard, report, &added);
+  PublishHosts(&shard, added);
+  return updated;
+}
+
+size_t MetricsRepository::UpdateReports(
+    const std::vector<const systeminsight::proto::MetricsReport*>& reports) {
+  // 按分片分组，每个分片只加锁一次、新主机只发布一次目录；同一主机的报告保持原有顺序
+  std::vector<size_t> order(reports.size());
+  std::vector<size_t> shard_of(reports.size());
+  for (size_t i = 0; i < reports.size(); ++i) {
+    order[i] = i;
+    shard_of[i] = std::hash<std::string>{}(reports[i]->host_id()) % shard_count_;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&shard_of](size_t a, size_t b) { return shard_of[a] < shard_of[b]; });
+  size_t updated = 0;
+  std::vector<std::shared_ptr<HostEntry>> added;
+  for (size_t begin = 0; begin < order.size();) {
+    Shard& shard = shards_[shard_of[order[begin]]];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    added.clear();
+    size_t end = begin;
+    for (; end < order.size() && shard_of[order[end]] == shard_of[order[begin]]; ++end) {
+      updated += UpdateLocked(&shard, *reports[order[end]], &added) ? 1 : 0;
+    }
+    PublishHosts(&shard, added);
+    begin = end;
+  }
+  return updated;
+}
+
+void MetricsRepository::PublishHosts(Shard* shard,
+                                     const std::vector<std::shared_ptr<HostEntry>>& added) {
+  if (added.empty()) return;
+  auto hosts = std::make_shared<HostList>(*std::atomic_load(&shard->published));
+  hosts->insert(hosts->end(), added.begin(), added.end());
+  std::atomic_store(&shard->published, std::shared_ptr<const HostList>(std::move(hosts)));
 }
 
-std::vector<systeminsight::proto::MetricsReport> MetricsRepository::Snapshot() const {
-  std::lock_guard<std::mutex> lock(mutex_);
-  std::vector<systeminsight::proto::MetricsReport> snapshot;
-  snapshot.reserve(reports_.size());
-  for (const auto& [host, report] : reports_) {
-    snapshot.push_back(report);
+bool MetricsRepository::UpdateLocked(Shard* shard,
+                                     const systeminsight::proto::MetricsReport& report,
+                                     std::vector<std::shared_ptr<HostEntry>>* added) {
+  int64_t timestamp_ms = LatestTimestamp(report);
+  auto [it, inserted] = shard->hosts.try_emplace(report.host_id());
+  if (!inserted && timestamp_ms < it->second->latest_timestamp_ms) {
+    return false;
+  }
+  if (inserted) {
+    it->second = std::make_shared<HostEntry>();
+  }
+  HostEntry& entry = *it->second;
+
+  // 已发布的序列不可变：delta 合并在副本上进行（三列连续内存，复制代价很小），完成后整体替换
+  auto next = std::make_shared<HostSeries>();
+  if (report.delta() && !inserted) {
+    *next = *entry.published;
+    // 先推进沿用序列的时间戳，再写入变化的样本（保留它们自己的时间戳）
+    for (auto& sample_timestamp : next->timestamps_ms) {
+      sample_timestamp = std::max(sample_timestamp, timestamp_ms);
+    }
+  } else {
+    next->host_id = report.host_id();
+    next->series_ids.reserve(report.samples_size());
+    next->values.reserve(report.samples_size());
+    next->timestamps_ms.reserve(report.samples_size());
+    entry.positions.clear();
+    entry.positions.reserve(report.samples_size());
+  }
+  Apply(report, &entry, next.get());
+  entry.latest_timestamp_ms = timestamp_ms;
+  std::atomic_store(&entry.published, HostPtr(std::move(next)));
+
+  if (inserted) {
+    added->push_back(it->second);
+  }
+  return true;
+}
+
+void MetricsRepository::Apply(const systeminsight::proto::MetricsReport& report,
+                              HostEntry* entry, HostSeries* host) {
+  auto& positions = entry->positions;
+  for (const auto& sample : report.samples()) {
+    const uint32_t id = series_store_->Intern(sample);
+    if (id == SeriesStore::kInvalidSeries) continue;
+    auto position = std::lower_bound(
+        positions.begin(), positions.end(), id,
+        [](const std::pair<uint32_t, uint32_t>& lhs, uint32_t rhs) { return lhs.first < rhs; });
+    if (position != positions.end() && position->first == id) {
+      host->values[position->second] = sample.value();
+      host->timestamps_ms[position->second] = sample.timestamp_ms();
+      continue;
+    }
+    // 新序列追加到列尾；完整报告里序列 id 通常递增，插入点多在末尾
+    positions.insert(position, {id, static_cast<uint32_t>(host->series_ids.size())});
+    host->series_ids.push_back(id);
+    host->values.push_back(sample.value());
+    host->timestamps_ms.push_back(sample.timestamp_ms());
+  }
+}
+
+std::vector<MetricsRepository::HostPtr> MetricsRepository::Snapshot() const {
+  std::vector<HostPtr> snapshot;
+  for (size_t i = 0; i < shard_count_; ++i) {
+    auto hosts = std::atomic_load(&shards_[i].published);
+    for (const auto& entry : *hosts) {
+      if (auto host = std::atomic_load(&entry->published)) {
+        snapshot.push_back(std::move(host));
+      }
+    }
   }
   return snapshot;
 }
 
 }  // namespace server
 }  // namespace system_insight
-
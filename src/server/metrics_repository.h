@@ -1,28 +1,121 @@
 #ifndef SYSTEM_INSIGHT_SERVER_METRICS_REPOSITORY_H_
 #define SYSTEM_INSIGHT_SERVER_METRICS_REPOSITORY_H_
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "src/server/series_store.h"
 #include "system_insight.pb.h"
 
 namespace system_insight {
 namespace server {
 
+/**
+ * @brief 一个主机某一时刻的全部序列，按列存放；发布后不可变
+ *
+ * 第 i 个序列的定义为 SeriesStore::series(series_ids[i])。
+ */
+struct HostSeries {
+  std::string host_id;
+  std::vector<uint32_t> series_ids;
+  std::vector<double> values;
+  std::vector<int64_t> timestamps_ms;
+};
+
+/**
+ * @brief 每个主机最新一份报告的内存仓库
+ *
+ * 报告按样本时间戳排序而不是按到达顺序：补发的历史报告（backfill）
+ * 或乱序到达的报告不会覆盖已有的更新数据。
+ *
+ * 完整报告替换该主机的全部状态；delta 报告（客户端死区过滤后只含变化的样本）
+ * 按序列合并，未出现的序列沿用上一次的值，时间戳推进到这份报告的时间，
+ * 导出端因此始终看到完整、最新的序列集合。
+ *
+ * 样本入库时转换为 SeriesStore 中的序列 id，主机只保存 id、值和时间戳三列，
+ * 不再保留 protobuf 副本。
+ *
+ * 主机按 host_id 哈希分片，写者只持有所在分片的锁。每个主机的序列以不可变的
+ * shared_ptr 发布、原子替换；读者（Snapshot）不持分片锁也不复制数据，只复制指针，
+ * 拿到的快照在读者释放之前保持不变。
+ *
+ * 限制：C++17 下 shared_ptr 的 std::atomic_load / std::atomic_store 并非无锁，libstdc++
+ * 按对象地址从进程内共享的一小组互斥量中取一个（TimeSeriesDb 发布块列表也用同一组）。
+ * 临界区只有指针复制与引用计数增减，读者不会等待写者的合并，但抓取与高频写入落在同一把
+ * 互斥量上时仍会短暂互相阻塞。benchmarks/metrics_repository_benchmark.cc 中
+ * BM_UpdateReport/1 与 BM_SnapshotUnderWrites 分别测量抓取对写入、写入对抓取的影响；
+ * 若成为瓶颈，再改为原子裸指针加 epoch 回收。
+ */
 class MetricsRepository {
  public:
-  void UpdateReport(const systeminsight::proto::MetricsReport& report);
-  std::vector<systeminsight::proto::MetricsReport> Snapshot() const;
+  using HostPtr = std::shared_ptr<const HostSeries>;
+
+  /**
+   * @param series_store 与其他组件（如 TimeSeriesDb）共享的序列表；为空时自建
+   */
+  explicit MetricsRepository(size_t shard_count = 16,
+                             std::shared_ptr<SeriesStore> series_store = nullptr);
+
+  /**
+   * @return 报告成为该主机的最新数据时返回 true
+   */
+  bool UpdateReport(const systeminsight::proto::MetricsReport& report);
+
+  /**
+   * @brief 按顺序应用一批报告，每个分片只加一次锁
+   * @return 成为所在主机最新数据的报告数
+   */
+  size_t UpdateReports(const std::vector<const systeminsight::proto::MetricsReport*>& reports);
+
+  /**
+   * @brief 每个主机当前发布的序列；不阻塞写者
+   */
+  std::vector<HostPtr> Snapshot() const;
+
+  const SeriesStore& series_store() const { return *series_store_; }
+  const std::shared_ptr<SeriesStore>& shared_series_store() const { return series_store_; }
 
  private:
-  mutable std::mutex mutex_;
-  std::unordered_map<std::string, systeminsight::proto::MetricsReport> reports_;
+  struct HostEntry {
+    // 已发布的序列，读写都经 std::atomic_load / std::atomic_store（见类注释中的限制）
+    HostPtr published;
+    // 以下字段只由持有分片锁的写者访问
+    int64_t latest_timestamp_ms = 0;
+    // (序列 id, published 中的下标)，按 id 排序；比哈希表每序列少约 40 字节
+    std::vector<std::pair<uint32_t, uint32_t>> positions;
+  };
+
+  using HostList = std::vector<std::shared_ptr<HostEntry>>;
+
+  struct alignas(64) Shard {
+    std::mutex mutex;  // 串行化本分片的写者
+    std::unordered_map<std::string, std::shared_ptr<HostEntry>> hosts;
+    // 读者遍历的主机目录，只在新增主机时整体替换
+    std::shared_ptr<const HostList> published = std::make_shared<const HostList>();
+  };
+
+  Shard& ShardFor(const std::string& host_id) const;
+
+  // 调用方持有 shard->mutex；新建的主机追加到 added，由 PublishHosts 一并发布
+  bool UpdateLocked(Shard* shard, const systeminsight::proto::MetricsReport& report,
+                    std::vector<std::shared_ptr<HostEntry>>* added);
+  static void PublishHosts(Shard* shard, const std::vector<std::shared_ptr<HostEntry>>& added);
+
+  void Apply(const systeminsight::proto::MetricsReport& report, HostEntry* entry,
+             HostSeries* host);
+
+  std::shared_ptr<SeriesStore> series_store_;
+  std::unique_ptr<Shard[]> shards_;
+  size_t shard_count_;
 };
 
 }  // namespace server
 }  // namespace system_insight
 
 #endif  // SYSTEM_INSIGHT_SERVER_METRICS_REPOSITORY_H_
-
@@ -1,26 +1,169 @@
 #include "src/server/metrics_service_impl.h"
 
+#include <algorithm>
+#include <utility>
+
 #include "src/common/logging/logging.h"
 
 namespace system_insight {
 namespace server {
 
-MetricsServiceImpl::MetricsServiceImpl(std::shared_ptr<MetricsRepository> repository)
-    : repository_(std::move(repository)) {}
+namespace {
+
+// 空闲池化报告的上限：覆盖一轮突发入队的报告，更多时按需新建 Arena
+size_t ReportPoolSize(const IngestOptions& ingest) {
+  return std::min<size_t>(std::max<size_t>(ingest.queue_capacity * ingest.applier_threads, 64),
+                          1024);
+}
+
+}  // namespace
+
+MetricsServiceImpl::MetricsServiceImpl(std::shared_ptr<MetricsRepository> repository,
+                                       int stream_initial_credits,
+                                       std::shared_ptr<TimeSeriesDb> tsdb,
+                                       std::shared_ptr<QueryEngine> query_engine,
+                                       IngestOptions ingest)
+    : repository_(std::move(repository)),
+      tsdb_(std::move(tsdb)),
+      query_engine_(std::move(query_engine)),
+      stream_initial_credits_(stream_initial_credits),
+      report_pool_(ReportPoolSize(ingest)),
+      pipeline_(std::make_unique<IngestPipeline>(ingest, repository_, tsdb_)) {}
+
+void MetricsServiceImpl::StopIngest() { pipeline_->Stop(); }
+
+MetricsServiceImpl::HostDecoder* MetricsServiceImpl::GetDecoder(const std::string& host_id) {
+  std::lock_guard<std::mutex> lock(decoders_mutex_);
+  auto& decoder = decoders_[host_id];
+  if (!decoder) {
+    decoder = std::make_unique<HostDecoder>();
+  }
+  return decoder.get();
+}
+
+void MetricsServiceImpl::FillSupportedEncodings(systeminsight::proto::ReportAck* response) {
+  response->add_supported_encodings(systeminsight::proto::REPORT_ENCODING_ROW);
+  response->add_supported_encodings(systeminsight::proto::REPORT_ENCODING_COLUMNAR);
+  response->add_supported_encodings(systeminsight::proto::REPORT_ENCODING_COLUMNAR_XOR);
+}
+
+bool MetricsServiceImpl::DecodeColumnar(systeminsight::proto::MetricsReport* report,
+                                        systeminsight::proto::ReportAck* response) {
+  if (!report->has_columnar()) return true;
+  auto* host_decoder = GetDecoder(report->host_id());
+  common::codec::ColumnarDecoder::Status status;
+  {
+    std::lock_guard<std::mutex> lock(host_decoder->mutex);
+    status = host_decoder->decoder.Decode(report);
+  }
+  if (status == common::codec::ColumnarDecoder::Status::kMissingBase) {
+    LOGI("missing columnar base for host {}, requesting keyframe", report->host_id());
+    response->set_ok(false);
+    response->set_need_keyframe(true);
+    response->set_message("keyframe required");
+    return false;
+  }
+  if (status == common::codec::ColumnarDecoder::Status::kMalformed) {
+    LOGW("malformed columnar report from host {}", report->host_id());
+    response->set_ok(false);
+    response->set_need_keyframe(true);
+    response->set_message("malformed columnar report");
+    return false;
+  }
+  return true;
+}
 
-grpc::Status MetricsServiceImpl::SendMetrics(
-    grpc::ServerContext* /*context*/, 
-    const systeminsight::proto::MetricsReport* request,
-    systeminsight::proto::ReportAck* response) {
-  LOGI("received {} samples from host {}", request->samples_size(), request->host_id());
-  if (repository_) {
-    repository_->UpdateReport(*request);
+bool MetricsServiceImpl::ApplyReport(common::codec::PooledReport pooled,
+                                     systeminsight::proto::ReportAck* response,
+                                     std::function<void()> on_commit) {
+  const auto* report = pooled->report();
+  if (report->delta() && !HasFullReport(report->host_id())) {
+    // delta 报告只含变化的序列，收到该主机的完整报告之前（例如服务端刚重启）不能单独入库；
+    // 客户端随后改发完整报告（含全部序列的最新值），被拒的报告不再补发
+    LOGI("delta report from unknown host {}, requesting a full report", report->host_id());
+    response->set_ok(false);
+    response->set_need_full_report(true);
+    response->set_message("full report required");
+    return true;
   }
+  LOGI("received {} samples from host {}{}", report->samples_size(), report->host_id(),
+       report->backfill() ? " (backfill)" : "");
+  // 早于已存数据的历史报告照常确认，客户端无需重发：仓库不会用它覆盖最新值，
+  // 时序库把补发报告中早于序列最新样本的点写入补发块
   response->set_ok(true);
   response->set_message("accepted");
+  const bool wait = pipeline_->options().durable_ack;
+  std::string full_host;
+  if (!report->delta()) full_host = report->host_id();
+  switch (pipeline_->Submit(std::move(pooled), wait ? std::move(on_commit) : nullptr)) {
+    case IngestPipeline::SubmitResult::kRejected:
+      // 客户端把未确认的报告留待重发
+      response->set_ok(false);
+      response->set_message("ingest queue full");
+      return true;
+    case IngestPipeline::SubmitResult::kQueued:
+      MarkFullReport(std::move(full_host));
+      return !wait;
+    case IngestPipeline::SubmitResult::kApplied:
+      MarkFullReport(std::move(full_host));
+      break;
+  }
+  return true;
+}
+
+bool MetricsServiceImpl::HasFullReport(const std::string& host_id) const {
+  std::lock_guard<std::mutex> lock(full_hosts_mutex_);
+  return full_hosts_.count(host_id) > 0;
+}
+
+void MetricsServiceImpl::MarkFullReport(std::string host_id) {
+  if (host_id.empty()) return;
+  std::lock_guard<std::mutex> lock(full_hosts_mutex_);
+  full_hosts_.insert(std::move(host_id));
+}
+
+bool MetricsServiceImpl::HandleReport(common::codec::PooledReport report,
+                                      systeminsight::proto::ReportAck* response,
+                                      std::function<void()> on_commit) {
+  FillSupportedEncodings(response);
+  if (!DecodeColumnar(report->report(), response)) return true;
+  return ApplyReport(std::move(report), response, std::move(on_commit));
+}
+
+void MetricsServiceImpl::FillStreamHandshake(systeminsight::proto::ReportAck* handshake) const {
+  // 握手：声明编码能力并授予初始额度
+  FillSupportedEncodings(handshake);
+  handshake->set_ok(true);
+  handshake->set_message("stream opened");
+  handshake->set_credits(static_cast<uint32_t>(stream_initial_credits_));
+}
+
+bool MetricsServiceImpl::HandleStreamReport(common::codec::PooledReport report,
+                                            systeminsight::proto::ReportAck* ack,
+                                            std::function<void()> on_commit) {
+  ack->Clear();
+  ack->set_acked_sequence(report->report()->sequence());
+  // 每应用一份报告归还一个额度
+  ack->set_credits(1);
+  // 流上的报告由调用方独占，列式报告直接原地解码
+  if (!DecodeColumnar(report->report(), ack)) return true;
+  return ApplyReport(std::move(report), ack, std::move(on_commit));
+}
+
+grpc::Status MetricsServiceImpl::HandleQuery(
+    const systeminsight::proto::QueryRangeRequest& request,
+    systeminsight::proto::QueryRangeResponse* response) const {
+  if (!query_engine_) {
+    return grpc::Status(grpc::StatusCode::UNAVAILABLE, "time-series storage is disabled");
+  }
+  std::string error;
+  if (!query_engine_->QueryRange(request, response, &error)) {
+    return grpc::Status(grpc::StatusCode::INVALID_ARGUMENT, error);
+  }
+  LOGD("query {} matched {} series, scanned {} points", request.metric_name(),
+       response->series_size(), response->points_scanned());
   return grpc::Status::OK;
 }
 
 }  // namespace server
 }  // namespace system_insight
-
@@ -1,29 +1,110 @@
 #ifndef SYSTEM_INSIGHT_SERVER_METRICS_SERVICE_IMPL_H_
 #define SYSTEM_INSIGHT_SERVER_METRICS_SERVICE_IMPL_H_
 
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "grpcpp/grpcpp.h"
 #include "system_insight.grpc.pb.h"
+#include "src/common/codec/columnar_codec.h"
+#include "src/common/codec/report_pool.h"
+#include "src/server/ingest_pipeline.h"
 #include "src/server/metrics_repository.h"
+#include "src/server/query_engine.h"
+#include "src/server/time_series_db.h"
 
 namespace system_insight {
 namespace server {
 
-class MetricsServiceImpl final : public systeminsight::proto::SystemInsightService::Service {
+/**
+ * @brief SystemInsightService 的处理逻辑
+ *
+ * 不直接注册为 gRPC 服务：AsyncMetricsServer 在自己的完成队列线程上调用 Handle* 系列方法，
+ * 各连接共享同一份解码状态与存储。
+ *
+ * 处理线程只解码与校验报告，写入交给 IngestPipeline；配置应用线程时报告入队即确认，
+ * durable_ack 时在提交后经 on_commit 通知调用方再确认。
+ *
+ * 请求反序列化进 ReportPool 的池化报告（Arena 分配），解码后连同槽位移交给流水线，
+ * 从收包到写入存储不复制报告。
+ */
+class MetricsServiceImpl final {
  public:
-  explicit MetricsServiceImpl(std::shared_ptr<MetricsRepository> repository);
+  /**
+   * @param stream_initial_credits StreamMetrics 建流时授予客户端的初始发送额度
+   * @param tsdb 为空时不保存历史样本
+   * @param query_engine 为空时 QueryRange 返回 UNAVAILABLE
+   * @param ingest 默认不排队，在处理线程上直接写入
+   */
+  explicit MetricsServiceImpl(std::shared_ptr<MetricsRepository> repository,
+                              int stream_initial_credits = 8,
+                              std::shared_ptr<TimeSeriesDb> tsdb = nullptr,
+                              std::shared_ptr<QueryEngine> query_engine = nullptr,
+                              IngestOptions ingest = {});
 
-  grpc::Status SendMetrics(grpc::ServerContext* context,
-                           const systeminsight::proto::MetricsReport* request,
-                           systeminsight::proto::ReportAck* response) override;
+  /**
+   * @brief 取一个池化报告，供调用方把请求直接反序列化进去
+   */
+  common::codec::PooledReport AcquireReport() { return report_pool_.Acquire(); }
+
+  /**
+   * @brief 应用一份报告；列式报告原地还原为行式，报告随后移交给入库流水线
+   * @return true 表示 response 已可回复；false 表示报告等待提交，提交后在应用线程上
+   *         调用 on_commit，此前不能访问 response
+   */
+  bool HandleReport(common::codec::PooledReport report,
+                    systeminsight::proto::ReportAck* response, std::function<void()> on_commit);
+  // 上报流的第一条消息：编码能力与初始额度
+  void FillStreamHandshake(systeminsight::proto::ReportAck* handshake) const;
+  // 流上每应用一份报告回复的确认；返回值与 on_commit 同 HandleReport
+  bool HandleStreamReport(common::codec::PooledReport report,
+                          systeminsight::proto::ReportAck* ack, std::function<void()> on_commit);
+  grpc::Status HandleQuery(const systeminsight::proto::QueryRangeRequest& request,
+                           systeminsight::proto::QueryRangeResponse* response) const;
+
+  /**
+   * @brief 提交入库队列中剩余的报告并停止应用线程，须在 RPC 服务关闭之后调用
+   */
+  void StopIngest();
 
  private:
+  // 列式报告的解码状态按主机保存（布局与 XOR 基准依赖上一份报告）
+  struct HostDecoder {
+    std::mutex mutex;
+    common::codec::ColumnarDecoder decoder;
+  };
+
+  HostDecoder* GetDecoder(const std::string& host_id);
+  static void FillSupportedEncodings(systeminsight::proto::ReportAck* response);
+
+  // 把列式报告原地还原为行式；失败时填好 response 并返回 false
+  bool DecodeColumnar(systeminsight::proto::MetricsReport* report,
+                      systeminsight::proto::ReportAck* response);
+  // 把报告交给入库流水线；返回值与 on_commit 同 HandleReport
+  bool ApplyReport(common::codec::PooledReport report,
+                   systeminsight::proto::ReportAck* response, std::function<void()> on_commit);
+  // 是否已接受过该主机的完整报告；在此之前其 delta 报告缺少未变化的序列，须拒绝
+  bool HasFullReport(const std::string& host_id) const;
+  void MarkFullReport(std::string host_id);
+
   std::shared_ptr<MetricsRepository> repository_;
+  std::shared_ptr<TimeSeriesDb> tsdb_;
+  std::shared_ptr<QueryEngine> query_engine_;
+  int stream_initial_credits_;
+  // 须先于 pipeline_ 构造：队列中的报告析构时归还到池
+  common::codec::ReportPool report_pool_;
+  std::unique_ptr<IngestPipeline> pipeline_;
+  std::mutex decoders_mutex_;
+  std::unordered_map<std::string, std::unique_ptr<HostDecoder>> decoders_;
+  mutable std::mutex full_hosts_mutex_;
+  std::unordered_set<std::string> full_hosts_;
 };
 
 }  // namespace server
 }  // namespace system_insight
 
 #endif  // SYSTEM_INSIGHT_SERVER_METRICS_SERVICE_IMPL_H_
-
@@ -0,0 +1,310 @@
+#include "src/server/query_engine.h"
+
+#include <algorithm>
+#include <atomic>
+#include <regex>
+#include <thread>
+#include <utility>
+
+#include "src/server/query_kernels.h"
+
+namespace system_insight {
+namespace server {
+
+using systeminsight::proto::LabelMatcher;
+using systeminsight::proto::QueryAggregation;
+
+namespace {
+
+const std::string kHostLabel = "host";
+
+IndexMatcher::Type ToIndexType(LabelMatcher::Type type) {
+  switch (type) {
+    case LabelMatcher::NOT_EQUAL:
+      return IndexMatcher::Type::kNotEqual;
+    case LabelMatcher::REGEX:
+      return IndexMatcher::Type::kRegex;
+    case LabelMatcher::NOT_REGEX:
+      return IndexMatcher::Type::kNotRegex;
+    default:
+      return IndexMatcher::Type::kEqual;
+  }
+}
+
+struct CompiledMatcher {
+  const LabelMatcher* matcher;
+  std::regex regex;
+
+  bool Matches(const std::string& value) const {
+    switch (matcher->type()) {
+      case LabelMatcher::NOT_EQUAL:
+        return value != matcher->value();
+      case LabelMatcher::REGEX:
+        return std::regex_match(value, regex);
+      case LabelMatcher::NOT_REGEX:
+        return !std::regex_match(value, regex);
+      default:
+        return value == matcher->value();
+    }
+  }
+};
+
+}  // namespace
+
+struct QueryEngine::Matchers {
+  std::vector<CompiledMatcher> host;
+  // 指标名（"__name__"）与其余标签，交给倒排索引求交
+  std::vector<IndexMatcher> labels;
+};
+
+QueryEngine::QueryEngine(std::shared_ptr<TimeSeriesDb> tsdb, QueryEngineOptions options)
+    : tsdb_(std::move(tsdb)), options_(options) {
+  size_t threads = options_.threads;
+  if (threads == 0) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  // 调用线程也参与计算
+  pool_ = std::make_unique<ThreadPool>(threads - 1);
+}
+
+std::vector<uint32_t> QueryEngine::MatchSeries(const Matchers& matchers) const {
+  return tsdb_->series_store().label_index().Select(matchers.labels);
+}
+
+size_t QueryEngine::RollupTierFor(const systeminsight::proto::QueryRangeRequest& request) const {
+  const auto& tiers = tsdb_->rollup_tiers();
+  if (request.aggregation() == systeminsight::proto::QUERY_AGGREGATION_RATE ||
+      request.aggregation() == systeminsight::proto::QUERY_AGGREGATION_QUANTILE) {
+    return tiers.size();
+  }
+  for (size_t i = tiers.size(); i-- > 0;) {
+    const int64_t resolution_ms = tiers[i].resolution_ms;
+    if (request.step_ms() % resolution_ms == 0 && request.start_ms() % resolution_ms == 0) {
+      return i;
+    }
+  }
+  return tiers.size();
+}
+
+bool QueryEngine::QueryRange(const systeminsight::proto::QueryRangeRequest& request,
+                             systeminsight::proto::QueryRangeResponse* response,
+                             std::string* error) const {
+  if (request.metric_name().empty()) {
+    *error = "metric_name is required";
+    return false;
+  }
+  if (request.step_ms() <= 0 || request.end_ms() < request.start_ms()) {
+    *error = "step_ms must be positive and end_ms must not precede start_ms";
+    return false;
+  }
+  const int64_t buckets = (request.end_ms() - request.start_ms()) / request.step_ms() + 1;
+  if (buckets > options_.max_buckets) {
+    *error = "too many buckets, increase step_ms";
+    return false;
+  }
+  if (request.aggregation() == systeminsight::proto::QUERY_AGGREGATION_QUANTILE &&
+      (request.quantile() < 0 || request.quantile() > 1)) {
+    *error = "quantile must be within [0, 1]";
+    return false;
+  }
+
+  Matchers matchers;
+  IndexMatcher name_matcher;
+  name_matcher.key = LabelIndex::kNameKey;
+  name_matcher.value = request.metric_name();
+  matchers.labels.push_back(std::move(name_matcher));
+  for (const auto& matcher : request.matchers()) {
+    CompiledMatcher compiled{&matcher, {}};
+    if (matcher.type() == LabelMatcher::REGEX || matcher.type() == LabelMatcher::NOT_REGEX) {
+      try {
+        compiled.regex = std::regex(matcher.value());
+      } catch (const std::regex_error& ex) {
+        *error = "invalid regex for label " + matcher.key() + ": " + ex.what();
+        return false;
+      }
+    }
+    if (matcher.key() == kHostLabel) {
+      matchers.host.push_back(std::move(compiled));
+      continue;
+    }
+    IndexMatcher label;
+    label.key = matcher.key();
+    label.value = matcher.value();
+    label.type = ToIndexType(matcher.type());
+    label.regex = std::move(compiled.regex);
+    matchers.labels.push_back(std::move(label));
+  }
+
+  std::vector<TimeSeriesDb::SeriesRef> refs;
+  tsdb_->Select(
+      [&matchers](const std::string& host_id) {
+        return std::all_of(matchers.host.begin(), matchers.host.end(),
+                           [&host_id](const auto& matcher) { return matcher.Matches(host_id); });
+      },
+      MatchSeries(matchers), &refs);
+  std::sort(refs.begin(), refs.end(), [](const auto& lhs, const auto& rhs) {
+    return lhs.host_id != rhs.host_id ? lhs.host_id < rhs.host_id
+                                      : lhs.series_id < rhs.series_id;
+  });
+
+  const size_t tier = RollupTierFor(request);
+  const bool use_rollup = tier < tsdb_->rollup_tiers().size();
+  std::vector<systeminsight::proto::QueryRangeSeries> results(refs.size());
+  std::atomic<uint64_t> points_scanned{0};
+  pool_->ParallelFor(refs.size(), options_.series_per_task, [&](size_t begin, size_t end) {
+    uint64_t scanned = 0;
+    for (size_t i = begin; i < end; ++i) {
+      if (use_rollup) {
+        EvaluateRollup(request, refs[i], buckets, tier, &results[i], &scanned);
+      } else {
+        Evaluate(request, refs[i], buckets, &results[i], &scanned);
+      }
+    }
+    points_scanned += scanned;
+  });
+
+  for (auto& result : results) {
+    if (result.timestamps_ms_size() > 0) {
+      *response->add_series() = std::move(result);
+    }
+  }
+  response->set_points_scanned(points_scanned.load());
+  response->set_resolution_ms(use_rollup ? tsdb_->rollup_tiers()[tier].resolution_ms : 0);
+  return true;
+}
+
+void QueryEngine::Evaluate(const systeminsight::proto::QueryRangeRequest& request,
+                           const TimeSeriesDb::SeriesRef& ref, int64_t buckets,
+                           systeminsight::proto::QueryRangeSeries* out,
+                           uint64_t* points_scanned) const {
+  // 每个线程复用自己的解码与计算缓冲区
+  thread_local PointBlock block;
+  thread_local std::vector<uint32_t> bucket_of;
+  thread_local std::vector<double> scratch;
+
+  const QueryAggregation aggregation = request.aggregation();
+  const bool rate = aggregation == systeminsight::proto::QUERY_AGGREGATION_RATE;
+  const int64_t start_ms = request.start_ms();
+  const int64_t step_ms = request.step_ms();
+  const int64_t end_ms = start_ms + buckets * step_ms - 1;
+
+  // rate 需要区间开始前的一个点作为第一个桶的基准
+  block.clear();
+  TimeSeriesDb::Read(ref, rate ? start_ms - step_ms : start_ms, end_ms, &block);
+  *points_scanned += block.size();
+  const int64_t* timestamps = block.timestamps_ms.data();
+  const double* values = block.values.data();
+  const size_t first = static_cast<size_t>(
+      std::lower_bound(block.timestamps_ms.begin(), block.timestamps_ms.end(), start_ms) -
+      block.timestamps_ms.begin());
+  const size_t count = block.size() - first;
+  if (count == 0) return;
+
+  bucket_of.resize(count);
+  kernels::BucketIndices(timestamps + first, count, start_ms, step_ms, bucket_of.data());
+
+  for (size_t run_begin = 0; run_begin < count;) {
+    const uint32_t bucket = bucket_of[run_begin];
+    size_t run_end = run_begin + 1;
+    while (run_end < count && bucket_of[run_end] == bucket) ++run_end;
+    const size_t a = first + run_begin;
+    const size_t n = run_end - run_begin;
+    run_begin = run_end;
+
+    double result = 0;
+    switch (aggregation) {
+      case systeminsight::proto::QUERY_AGGREGATION_MIN:
+        result = kernels::Min(values + a, n);
+        break;
+      case systeminsight::proto::QUERY_AGGREGATION_MAX:
+        result = kernels::Max(values + a, n);
+        break;
+      case systeminsight::proto::QUERY_AGGREGATION_SUM:
+        result = kernels::Sum(values + a, n);
+        break;
+      case systeminsight::proto::QUERY_AGGREGATION_RATE: {
+        // 从前一个点（可能在上一个桶或区间之前）算到桶内最后一个点
+        const size_t base = a > 0 ? a - 1 : a;
+        const size_t span = a + n - base;
+        const int64_t elapsed_ms = timestamps[a + n - 1] - timestamps[base];
+        if (span < 2 || elapsed_ms <= 0) continue;
+        result = kernels::Increase(values + base, span) * 1000.0 / elapsed_ms;
+        break;
+      }
+      case systeminsight::proto::QUERY_AGGREGATION_QUANTILE:
+        scratch.assign(values + a, values + a + n);
+        result = kernels::Quantile(scratch.data(), n, request.quantile());
+        break;
+      default:
+        result = kernels::Sum(values + a, n) / static_cast<double>(n);
+        break;
+    }
+    out->add_timestamps_ms(start_ms + static_cast<int64_t>(bucket) * step_ms);
+    out->add_values(result);
+  }
+
+  FillLabels(ref, out);
+}
+
+void QueryEngine::EvaluateRollup(const systeminsight::proto::QueryRangeRequest& request,
+                                 const TimeSeriesDb::SeriesRef& ref, int64_t buckets, size_t tier,
+                                 systeminsight::proto::QueryRangeSeries* out,
+                                 uint64_t* points_scanned) const {
+  thread_local AggregateBlock block;
+  thread_local std::vector<uint32_t> bucket_of;
+
+  const int64_t start_ms = request.start_ms();
+  const int64_t step_ms = request.step_ms();
+  const int64_t end_ms = start_ms + buckets * step_ms - 1;
+
+  // 汇总桶按层级分辨率对齐，步长是其整数倍，每个汇总桶整体落在一个查询桶内
+  block.clear();
+  *points_scanned += TimeSeriesDb::ReadAggregates(ref, tier, start_ms, end_ms, &block);
+  const size_t count = block.size();
+  if (count == 0) return;
+
+  bucket_of.resize(count);
+  kernels::BucketIndices(block.timestamps_ms.data(), count, start_ms, step_ms, bucket_of.data());
+
+  for (size_t a = 0; a < count;) {
+    const uint32_t bucket = bucket_of[a];
+    size_t run_end = a + 1;
+    while (run_end < count && bucket_of[run_end] == bucket) ++run_end;
+    const size_t n = run_end - a;
+
+    double result = 0;
+    switch (request.aggregation()) {
+      case systeminsight::proto::QUERY_AGGREGATION_MIN:
+        result = kernels::Min(block.min.data() + a, n);
+        break;
+      case systeminsight::proto::QUERY_AGGREGATION_MAX:
+        result = kernels::Max(block.max.data() + a, n);
+        break;
+      case systeminsight::proto::QUERY_AGGREGATION_SUM:
+        result = kernels::Sum(block.sum.data() + a, n);
+        break;
+      default:
+        result = kernels::Sum(block.sum.data() + a, n) / kernels::Sum(block.count.data() + a, n);
+        break;
+    }
+    a = run_end;
+    out->add_timestamps_ms(start_ms + static_cast<int64_t>(bucket) * step_ms);
+    out->add_values(result);
+  }
+  FillLabels(ref, out);
+}
+
+void QueryEngine::FillLabels(const TimeSeriesDb::SeriesRef& ref,
+                             systeminsight::proto::QueryRangeSeries* out) const {
+  if (out->timestamps_ms_size() == 0) return;
+  out->set_host_id(ref.host_id);
+  const auto& series = tsdb_->series_store().series(ref.series_id);
+  for (const auto& label : series.labels) {
+    auto* proto_label = out->add_labels();
+    proto_label->set_key(*label.key);
+    proto_label->set_value(*label.value);
+  }
+}
+
+}  // namespace server
+}  // namespace system_insight
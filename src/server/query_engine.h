@@ -0,0 +1,72 @@
+#ifndef SYSTEM_INSIGHT_SERVER_QUERY_ENGINE_H_
+#define SYSTEM_INSIGHT_SERVER_QUERY_ENGINE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "src/server/thread_pool.h"
+#include "src/server/time_series_db.h"
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace server {
+
+struct QueryEngineOptions {
+  // 工作线程数；为 0 时使用硬件线程数
+  size_t threads = 0;
+  // 单次查询的桶数上限（(end - start) / step + 1）
+  int64_t max_buckets = 11000;
+  // 每个任务处理的序列数
+  size_t series_per_task = 64;
+};
+
+/**
+ * @brief TimeSeriesDb 上的区间查询
+ *
+ * 先按指标名与标签匹配器选出（主机, 序列），再把序列分块交给线程池：每个序列解码
+ * 落在区间内的块到按列存放的缓冲区，批量计算桶下标，桶内样本是连续的一段，
+ * 直接交给 kernels 中的聚合核。
+ *
+ * avg / min / max / sum 可由桶的 min / max / sum / count 合并得出：步长与起点都按某个汇总
+ * 层级的分辨率对齐时，改读能满足的最粗层级，扫描量与查询跨度除以分辨率成正比。
+ * rate 与 quantile 总是读原始样本。
+ */
+class QueryEngine {
+ public:
+  QueryEngine(std::shared_ptr<TimeSeriesDb> tsdb, QueryEngineOptions options);
+
+  /**
+   * @return 请求不合法时返回 false 并填写 error
+   */
+  bool QueryRange(const systeminsight::proto::QueryRangeRequest& request,
+                  systeminsight::proto::QueryRangeResponse* response, std::string* error) const;
+
+ private:
+  struct Matchers;
+
+  // 指标名与非 host 标签都匹配的序列 id（升序），经标签倒排索引求交
+  std::vector<uint32_t> MatchSeries(const Matchers& matchers) const;
+  // 可用的最粗汇总层级；不可用时返回层级数
+  size_t RollupTierFor(const systeminsight::proto::QueryRangeRequest& request) const;
+  void Evaluate(const systeminsight::proto::QueryRangeRequest& request,
+                const TimeSeriesDb::SeriesRef& ref, int64_t buckets,
+                systeminsight::proto::QueryRangeSeries* out, uint64_t* points_scanned) const;
+  void EvaluateRollup(const systeminsight::proto::QueryRangeRequest& request,
+                      const TimeSeriesDb::SeriesRef& ref, int64_t buckets, size_t tier,
+                      systeminsight::proto::QueryRangeSeries* out,
+                      uint64_t* points_scanned) const;
+  void FillLabels(const TimeSeriesDb::SeriesRef& ref,
+                  systeminsight::proto::QueryRangeSeries* out) const;
+
+  std::shared_ptr<TimeSeriesDb> tsdb_;
+  QueryEngineOptions options_;
+  std::unique_ptr<ThreadPool> pool_;
+};
+
+}  // namespace server
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_SERVER_QUERY_ENGINE_H_
@@ -0,0 +1,104 @@
+#ifndef SYSTEM_INSIGHT_SERVER_QUERY_KERNELS_H_
+#define SYSTEM_INSIGHT_SERVER_QUERY_KERNELS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace system_insight {
+namespace server {
+namespace kernels {
+
+// 查询聚合用的批量计算核，作用在解码后的连续列上。循环体没有分支和跨迭代依赖
+// （归约拆成 4 路独立累加），编译器可以直接向量化。
+
+/**
+ * @brief 每个时间戳所在的桶下标：(ts - start) / step，要求 ts >= start
+ */
+inline void BucketIndices(const int64_t* timestamps_ms, size_t count, int64_t start_ms,
+                          int64_t step_ms, uint32_t* out) {
+  for (size_t i = 0; i < count; ++i) {
+    out[i] = static_cast<uint32_t>((timestamps_ms[i] - start_ms) / step_ms);
+  }
+}
+
+inline double Sum(const double* values, size_t count) {
+  double lanes[4] = {0, 0, 0, 0};
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    lanes[0] += values[i];
+    lanes[1] += values[i + 1];
+    lanes[2] += values[i + 2];
+    lanes[3] += values[i + 3];
+  }
+  double sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+  for (; i < count; ++i) sum += values[i];
+  return sum;
+}
+
+inline double Min(const double* values, size_t count) {
+  double lanes[4] = {std::numeric_limits<double>::infinity(),
+                     std::numeric_limits<double>::infinity(),
+                     std::numeric_limits<double>::infinity(),
+                     std::numeric_limits<double>::infinity()};
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    for (size_t lane = 0; lane < 4; ++lane) {
+      lanes[lane] = values[i + lane] < lanes[lane] ? values[i + lane] : lanes[lane];
+    }
+  }
+  double result = std::min(std::min(lanes[0], lanes[1]), std::min(lanes[2], lanes[3]));
+  for (; i < count; ++i) result = std::min(result, values[i]);
+  return result;
+}
+
+inline double Max(const double* values, size_t count) {
+  double lanes[4] = {-std::numeric_limits<double>::infinity(),
+                     -std::numeric_limits<double>::infinity(),
+                     -std::numeric_limits<double>::infinity(),
+                     -std::numeric_limits<double>::infinity()};
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    for (size_t lane = 0; lane < 4; ++lane) {
+      lanes[lane] = values[i + lane] > lanes[lane] ? values[i + lane] : lanes[lane];
+    }
+  }
+  double result = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+  for (; i < count; ++i) result = std::max(result, values[i]);
+  return result;
+}
+
+/**
+ * @brief 计数器在 values[0] 到 values[count - 1] 之间的增量；变小视为重置，重置后的值计入增量
+ */
+inline double Increase(const double* values, size_t count) {
+  double increase = 0;
+  for (size_t i = 1; i < count; ++i) {
+    const double delta = values[i] - values[i - 1];
+    increase += delta >= 0 ? delta : values[i];
+  }
+  return increase;
+}
+
+/**
+ * @brief 线性插值的分位数；会重排 values
+ */
+inline double Quantile(double* values, size_t count, double q) {
+  if (count == 0) return std::numeric_limits<double>::quiet_NaN();
+  q = std::clamp(q, 0.0, 1.0);
+  const double rank = q * static_cast<double>(count - 1);
+  const size_t lower = static_cast<size_t>(std::floor(rank));
+  std::nth_element(values, values + lower, values + count);
+  const double lower_value = values[lower];
+  if (lower + 1 >= count) return lower_value;
+  const double upper_value = *std::min_element(values + lower + 1, values + count);
+  return lower_value + (upper_value - lower_value) * (rank - static_cast<double>(lower));
+}
+
+}  // namespace kernels
+}  // namespace server
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_SERVER_QUERY_KERNELS_H_
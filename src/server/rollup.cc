@@ -0,0 +1,251 @@
+#include "src/server/rollup.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "src/common/codec/bit_stream.h"
+#include "src/common/codec/gorilla.h"
+
+namespace system_insight {
+namespace server {
+
+namespace {
+
+using common::codec::BitReader;
+using common::codec::BitWriter;
+using common::codec::XorDecoder;
+using common::codec::XorEncoder;
+
+// 每个块最多容纳的桶数，另按时间跨度封存（见 RollupSeries 构造参数）
+constexpr uint32_t kMaxBucketsPerChunk = 120;
+constexpr int kColumns = 4;  // min, max, sum, count
+
+int64_t FloorTo(int64_t timestamp_ms, int64_t resolution_ms) {
+  const int64_t remainder = timestamp_ms % resolution_ms;
+  return timestamp_ms - (remainder < 0 ? remainder + resolution_ms : remainder);
+}
+
+}  // namespace
+
+/**
+ * @brief 追加编码一个块的桶；每次追加后复制一份位流作为不可变快照发布
+ */
+class RollupChunkWriter {
+ public:
+  RollupChunkWriter() : writer_(&bits_) {}
+
+  void Append(int64_t start_ms, const double (&values)[kColumns]) {
+    if (count_ == 0) {
+      min_time_ms_ = start_ms;
+      writer_.WriteBits(static_cast<uint64_t>(start_ms), 64);
+    } else {
+      const int64_t delta = start_ms - prev_time_ms_;
+      if (delta == prev_delta_) {
+        writer_.WriteBit(false);
+      } else {
+        writer_.WriteBit(true);
+        writer_.WriteBits(static_cast<uint64_t>(delta), 64);
+        prev_delta_ = delta;
+      }
+    }
+    for (int i = 0; i < kColumns; ++i) {
+      encoders_[i].Encode(values[i], prev_[i], &writer_);
+      prev_[i] = values[i];
+    }
+    prev_time_ms_ = start_ms;
+    ++count_;
+  }
+
+  std::shared_ptr<const RollupChunk> Snapshot() const {
+    auto chunk = std::make_shared<RollupChunk>();
+    chunk->min_time_ms = min_time_ms_;
+    chunk->max_time_ms = prev_time_ms_;
+    chunk->count = count_;
+    chunk->storage = bits_;
+    return chunk;
+  }
+
+  uint32_t count() const { return count_; }
+  int64_t min_time_ms() const { return min_time_ms_; }
+
+ private:
+  std::string bits_;
+  BitWriter writer_;
+  XorEncoder encoders_[kColumns];
+  double prev_[kColumns] = {};
+  int64_t min_time_ms_ = 0;
+  int64_t prev_time_ms_ = 0;
+  int64_t prev_delta_ = 0;
+  uint32_t count_ = 0;
+};
+
+void AggregateBlock::clear() {
+  timestamps_ms.clear();
+  min.clear();
+  max.clear();
+  sum.clear();
+  count.clear();
+}
+
+void AggregateBlock::Append(int64_t timestamp_ms, double min_value, double max_value,
+                            double sum_value, double count_value) {
+  timestamps_ms.push_back(timestamp_ms);
+  min.push_back(min_value);
+  max.push_back(max_value);
+  sum.push_back(sum_value);
+  count.push_back(count_value);
+}
+
+void DecodeRollupChunk(const RollupChunk& chunk, int64_t start_ms, int64_t end_ms,
+                       AggregateBlock* out) {
+  BitReader reader(chunk.storage.data(), chunk.storage.size());
+  XorDecoder decoders[kColumns];
+  double values[kColumns] = {};
+  int64_t time_ms = 0;
+  int64_t delta = 0;
+  for (uint32_t i = 0; i < chunk.count; ++i) {
+    uint64_t bits = 0;
+    if (i == 0) {
+      if (!reader.ReadBits(64, &bits)) return;
+      time_ms = static_cast<int64_t>(bits);
+    } else {
+      bool changed = false;
+      if (!reader.ReadBit(&changed)) return;
+      if (changed) {
+        if (!reader.ReadBits(64, &bits)) return;
+        delta = static_cast<int64_t>(bits);
+      }
+      time_ms += delta;
+    }
+    for (int c = 0; c < kColumns; ++c) {
+      if (!decoders[c].Decode(&reader, values[c], &values[c])) return;
+    }
+    if (time_ms >= end_ms) return;
+    if (time_ms >= start_ms) out->Append(time_ms, values[0], values[1], values[2], values[3]);
+  }
+}
+
+RollupSeries::RollupSeries(int64_t resolution_ms, int64_t chunk_span_ms)
+    : resolution_ms_(resolution_ms),
+      chunk_span_ms_(chunk_span_ms),
+      snapshot_(std::make_shared<const Snapshot>()) {}
+
+RollupSeries::~RollupSeries() = default;
+
+RollupSeries::RollupSeries(RollupSeries&&) noexcept = default;
+
+int64_t RollupSeries::Add(int64_t timestamp_ms, double min_value, double max_value,
+                          double sum_value, double count_value) {
+  const int64_t start_ms = FloorTo(timestamp_ms, resolution_ms_);
+  if (start_ms < snapshot_->closed_until_ms) return 0;
+  if (open_count_ > 0 && start_ms == open_start_ms_) {
+    open_min_ = std::min(open_min_, min_value);
+    open_max_ = std::max(open_max_, max_value);
+    open_sum_ += sum_value;
+    open_count_ += count_value;
+    return 0;
+  }
+  if (open_count_ > 0 && start_ms < open_start_ms_) return 0;
+  const int64_t delta = open_count_ > 0 ? CloseBucket(start_ms) : 0;
+  open_start_ms_ = start_ms;
+  open_min_ = min_value;
+  open_max_ = max_value;
+  open_sum_ = sum_value;
+  open_count_ = count_value;
+  return delta;
+}
+
+int64_t RollupSeries::CloseIfStale(int64_t now_ms, int64_t grace_ms) {
+  if (open_count_ == 0 || open_start_ms_ + resolution_ms_ + grace_ms > now_ms) return 0;
+  return CloseBucket(open_start_ms_ + resolution_ms_);
+}
+
+int64_t RollupSeries::CloseBucket(int64_t closed_until_ms) {
+  auto next = std::make_shared<Snapshot>(*snapshot_);
+  if (writer_ && (writer_->count() >= kMaxBucketsPerChunk ||
+                  open_start_ms_ - writer_->min_time_ms() >= chunk_span_ms_)) {
+    writer_.reset();  // 封存：最后一个快照即为完整的块
+  }
+  if (!writer_) {
+    writer_ = std::make_unique<RollupChunkWriter>();
+    next->chunks.emplace_back();
+  }
+  const double values[kColumns] = {open_min_, open_max_, open_sum_, open_count_};
+  writer_->Append(open_start_ms_, values);
+
+  int64_t delta = 0;
+  auto& last = next->chunks.back();
+  if (last) delta -= static_cast<int64_t>(last->MemoryBytes());
+  last = writer_->Snapshot();
+  delta += static_cast<int64_t>(last->MemoryBytes());
+  next->closed_until_ms = closed_until_ms;
+  std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(std::move(next)));
+  open_count_ = 0;
+  return delta;
+}
+
+int64_t RollupSeries::DropBefore(int64_t cutoff_ms) {
+  const auto& chunks = snapshot_->chunks;
+  size_t drop = 0;
+  int64_t delta = 0;
+  while (drop < chunks.size() && chunks[drop]->max_time_ms + resolution_ms_ <= cutoff_ms) {
+    delta -= static_cast<int64_t>(chunks[drop]->MemoryBytes());
+    ++drop;
+  }
+  if (drop == 0) return 0;
+  if (drop == chunks.size()) writer_.reset();
+  persisted_ = persisted_ > drop ? persisted_ - drop : 0;
+  auto next = std::make_shared<Snapshot>();
+  next->chunks.assign(chunks.begin() + static_cast<std::ptrdiff_t>(drop), chunks.end());
+  next->closed_until_ms = snapshot_->closed_until_ms;
+  std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(std::move(next)));
+  return delta;
+}
+
+int64_t RollupSeries::AppendLoaded(std::shared_ptr<const RollupChunk> chunk) {
+  if (writer_ || open_count_ > 0 || chunk->count == 0 ||
+      chunk->min_time_ms < snapshot_->closed_until_ms) {
+    return 0;
+  }
+  const int64_t delta = static_cast<int64_t>(chunk->MemoryBytes());
+  auto next = std::make_shared<Snapshot>(*snapshot_);
+  next->closed_until_ms = chunk->max_time_ms + resolution_ms_;
+  next->chunks.push_back(std::move(chunk));
+  persisted_ = next->chunks.size();
+  std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(std::move(next)));
+  return delta;
+}
+
+void RollupSeries::ReadOpen(AggregateBlock* out) const {
+  if (open_count_ > 0) out->Append(open_start_ms_, open_min_, open_max_, open_sum_, open_count_);
+}
+
+size_t RollupSeries::Read(const Snapshot& snapshot, int64_t start_ms, int64_t end_ms,
+                          AggregateBlock* out) {
+  const size_t before = out->size();
+  for (const auto& chunk : snapshot.chunks) {
+    if (chunk->max_time_ms < start_ms) continue;
+    if (chunk->min_time_ms >= end_ms) break;
+    DecodeRollupChunk(*chunk, start_ms, end_ms, out);
+  }
+  return out->size() - before;
+}
+
+std::vector<std::shared_ptr<const RollupChunk>> RollupSeries::Unpersisted() const {
+  const auto& chunks = snapshot_->chunks;
+  const size_t sealed = sealed_count();
+  if (persisted_ >= sealed) return {};
+  return {chunks.begin() + static_cast<std::ptrdiff_t>(persisted_),
+          chunks.begin() + static_cast<std::ptrdiff_t>(sealed)};
+}
+
+void RollupSeries::MarkPersisted(const std::shared_ptr<const RollupChunk>& last) {
+  const auto& chunks = snapshot_->chunks;
+  auto it = std::find(chunks.begin(), chunks.end(), last);
+  if (it != chunks.end()) {
+    persisted_ = std::max(persisted_, static_cast<size_t>(it - chunks.begin()) + 1);
+  }
+}
+
+}  // namespace server
+}  // namespace system_insight
@@ -0,0 +1,150 @@
+#ifndef SYSTEM_INSIGHT_SERVER_ROLLUP_H_
+#define SYSTEM_INSIGHT_SERVER_ROLLUP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace system_insight {
+namespace server {
+
+/**
+ * @brief 汇总层级：按 resolution_ms 对齐的桶，保留 retention_ms
+ */
+struct RollupTier {
+  int64_t resolution_ms = 0;
+  int64_t retention_ms = 0;
+};
+
+/**
+ * @brief 按列存放的一段汇总值，时间戳为桶起始（原始样本视为 count 为 1 的桶）
+ */
+struct AggregateBlock {
+  std::vector<int64_t> timestamps_ms;
+  std::vector<double> min;
+  std::vector<double> max;
+  std::vector<double> sum;
+  std::vector<double> count;
+
+  size_t size() const { return timestamps_ms.size(); }
+  void clear();
+  void Append(int64_t timestamp_ms, double min_value, double max_value, double sum_value,
+              double count_value);
+};
+
+/**
+ * @brief 一串已结束的汇总桶，不可变
+ *
+ * 桶起始时间用 delta-of-delta（间隔不变时 1 位），min / max / sum / count 四列各自做
+ * XOR 编码。汇总块很小，从块文件加载时复制到堆上。
+ */
+struct RollupChunk {
+  int64_t min_time_ms = 0;  // 第一个桶的起始时间
+  int64_t max_time_ms = 0;  // 最后一个桶的起始时间
+  uint32_t count = 0;       // 桶数
+  std::string storage;
+
+  size_t MemoryBytes() const { return sizeof(RollupChunk) + storage.capacity(); }
+};
+
+/**
+ * @brief 追加桶起始时间落在 [start_ms, end_ms) 内的桶
+ */
+void DecodeRollupChunk(const RollupChunk& chunk, int64_t start_ms, int64_t end_ms,
+                       AggregateBlock* out);
+
+class RollupChunkWriter;
+
+/**
+ * @brief 一个序列在一个汇总层级上的数据，随样本写入增量更新
+ *
+ * 未结束的桶只在写者处累加；样本落入更晚的桶时把它编码进最后一个块，并以不可变快照
+ * （块列表 + closed_until_ms）原子发布。读者只读快照，不加锁。块按桶数或时间跨度封存，
+ * 封存后才会写入块文件。
+ *
+ * 单写者：除 Load() 与 Read() 外的方法只能由持有序列锁的写者调用。
+ * 改变内存占用的方法返回堆内存的变化量（字节）。
+ */
+class RollupSeries {
+ public:
+  struct Snapshot {
+    std::vector<std::shared_ptr<const RollupChunk>> chunks;
+    // 早于该时间的桶都已写入 chunks，之后的数据只在未结束的桶里
+    int64_t closed_until_ms = INT64_MIN;
+  };
+
+  RollupSeries(int64_t resolution_ms, int64_t chunk_span_ms);
+  ~RollupSeries();
+  RollupSeries(RollupSeries&&) noexcept;
+
+  int64_t resolution_ms() const { return resolution_ms_; }
+
+  /**
+   * @brief 并入一个点或一个更细的桶；落在已结束的桶里的数据被忽略
+   *
+   * 时间戳需要非递减。
+   */
+  int64_t Add(int64_t timestamp_ms, double min_value, double max_value, double sum_value,
+              double count_value);
+
+  /**
+   * @brief 桶结束超过 grace_ms 仍没有更晚的样本时结束它（序列停止上报的情形）
+   */
+  int64_t CloseIfStale(int64_t now_ms, int64_t grace_ms);
+
+  /**
+   * @brief 丢弃最后一个桶在 cutoff_ms 之前结束的块
+   */
+  int64_t DropBefore(int64_t cutoff_ms);
+
+  /**
+   * @brief 接上从块文件加载的封存块（已落盘）；与已有数据重叠时忽略
+   */
+  int64_t AppendLoaded(std::shared_ptr<const RollupChunk> chunk);
+
+  /**
+   * @brief 追加未结束的桶（若有）
+   */
+  void ReadOpen(AggregateBlock* out) const;
+
+  std::shared_ptr<const Snapshot> Load() const { return std::atomic_load(&snapshot_); }
+
+  /**
+   * @brief 追加快照中桶起始时间落在 [start_ms, end_ms) 内的桶
+   * @return 追加的桶数
+   */
+  static size_t Read(const Snapshot& snapshot, int64_t start_ms, int64_t end_ms,
+                     AggregateBlock* out);
+
+  // 已封存但尚未写入块文件的块
+  std::vector<std::shared_ptr<const RollupChunk>> Unpersisted() const;
+  // last 及其之前的块已写入块文件
+  void MarkPersisted(const std::shared_ptr<const RollupChunk>& last);
+
+  bool empty() const { return snapshot_->chunks.empty() && open_count_ == 0; }
+
+ private:
+  int64_t CloseBucket(int64_t closed_until_ms);
+  size_t sealed_count() const { return snapshot_->chunks.size() - (writer_ ? 1 : 0); }
+
+  int64_t resolution_ms_;
+  int64_t chunk_span_ms_;
+  // 读写都经 std::atomic_load / std::atomic_store
+  std::shared_ptr<const Snapshot> snapshot_;
+  // 最后一个块仍可追加时非空
+  std::unique_ptr<RollupChunkWriter> writer_;
+  size_t persisted_ = 0;
+
+  int64_t open_start_ms_ = INT64_MIN;
+  double open_min_ = 0;
+  double open_max_ = 0;
+  double open_sum_ = 0;
+  double open_count_ = 0;
+};
+
+}  // namespace server
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_SERVER_ROLLUP_H_
@@ -0,0 +1,78 @@
+#include "src/server/series_store.h"
+
+#include <functional>
+
+#include "src/common/codec/columnar_codec.h"
+
+namespace system_insight {
+namespace server {
+
+SeriesStore::SeriesStore()
+    : index_(std::make_unique<IndexShard[]>(kIndexShards)),
+      chunks_(std::make_unique<std::atomic<Series*>[]>(kMaxChunks)) {
+  for (uint32_t i = 0; i < kMaxChunks; ++i) {
+    chunks_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+SeriesStore::~SeriesStore() {
+  for (uint32_t i = 0; i < kMaxChunks; ++i) {
+    delete[] chunks_[i].load(std::memory_order_relaxed);
+  }
+}
+
+uint32_t SeriesStore::Intern(const systeminsight::proto::MetricSample& sample) {
+  thread_local std::string key;
+  common::codec::BuildSeriesKey(sample.name(), sample.labels(), &key);
+  IndexShard& shard = index_[std::hash<std::string>{}(key) % kIndexShards];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.ids.find(key);
+  if (it != shard.ids.end()) {
+    return it->second;
+  }
+  uint32_t id = Define(sample);
+  if (id != kInvalidSeries) {
+    shard.ids.emplace(key, id);
+  }
+  return id;
+}
+
+uint32_t SeriesStore::Find(const systeminsight::proto::MetricSample& sample) const {
+  thread_local std::string key;
+  common::codec::BuildSeriesKey(sample.name(), sample.labels(), &key);
+  const IndexShard& shard = index_[std::hash<std::string>{}(key) % kIndexShards];
+  std::lock_guard<std::mutex> lock(shard.mutex);
+  auto it = shard.ids.find(key);
+  return it == shard.ids.end() ? kInvalidSeries : it->second;
+}
+
+uint32_t SeriesStore::Define(const systeminsight::proto::MetricSample& sample) {
+  std::lock_guard<std::mutex> lock(define_mutex_);
+  const size_t id = series_count_.load(std::memory_order_relaxed);
+  const size_t chunk_index = id >> kChunkBits;
+  if (chunk_index >= kMaxChunks) {
+    return kInvalidSeries;
+  }
+  Series* chunk = chunks_[chunk_index].load(std::memory_order_relaxed);
+  if (chunk == nullptr) {
+    chunk = new Series[kChunkSize];
+    chunks_[chunk_index].store(chunk, std::memory_order_release);
+  }
+
+  Series& series = chunk[id & (kChunkSize - 1)];
+  series.name = InternString(sample.name());
+  series.labels.reserve(sample.labels_size());
+  for (const auto& label : sample.labels()) {
+    series.labels.push_back({InternString(label.key()), InternString(label.value())});
+  }
+  label_index_.Add(static_cast<uint32_t>(id), *series.name, series.labels);
+  series_count_.store(id + 1, std::memory_order_release);
+  return static_cast<uint32_t>(id);
+}
+
+const std::string* SeriesStore::InternString(const std::string& value) {
+  return &*strings_.insert(value).first;
+}
+
+}  // namespace server
+}  // namespace system_insight
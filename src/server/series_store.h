@@ -0,0 +1,92 @@
+#ifndef SYSTEM_INSIGHT_SERVER_SERIES_STORE_H_
+#define SYSTEM_INSIGHT_SERVER_SERIES_STORE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "src/server/label_index.h"
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace server {
+
+/**
+ * @brief 序列定义表：把（指标名 + 标签）映射为稠密的 32 位序列 id
+ *
+ * 指标名、标签键和标签值全部驻留（intern），所有主机共享同一份字符串与序列定义，
+ * 主机侧只保存序列 id 与取值列。序列只增不删。
+ *
+ * Intern 线程安全：已有序列只持有 key 所在索引分片的锁，新序列额外持有定义锁。
+ * series() 不加锁，调用方保证 id 来自已发布的数据（发布先于读取，定义对读者可见）。
+ * 新序列定义时同步写入标签倒排索引，按标签选择序列走 label_index()。
+ */
+class SeriesStore {
+ public:
+  using Label = LabelIndex::Label;
+
+  struct Series {
+    const std::string* name;
+    std::vector<Label> labels;
+  };
+
+  static constexpr uint32_t kInvalidSeries = UINT32_MAX;
+
+  SeriesStore();
+  ~SeriesStore();
+
+  SeriesStore(const SeriesStore&) = delete;
+  SeriesStore& operator=(const SeriesStore&) = delete;
+
+  /**
+   * @return 样本所属序列的 id；序列表已满时返回 kInvalidSeries
+   */
+  uint32_t Intern(const systeminsight::proto::MetricSample& sample);
+
+  /**
+   * @return 样本所属序列的 id；序列尚未出现过时返回 kInvalidSeries
+   */
+  uint32_t Find(const systeminsight::proto::MetricSample& sample) const;
+
+  const Series& series(uint32_t id) const {
+    const Series* chunk = chunks_[id >> kChunkBits].load(std::memory_order_acquire);
+    return chunk[id & (kChunkSize - 1)];
+  }
+
+  size_t series_count() const { return series_count_.load(std::memory_order_acquire); }
+  const LabelIndex& label_index() const { return label_index_; }
+
+ private:
+  static constexpr uint32_t kChunkBits = 12;
+  static constexpr uint32_t kChunkSize = 1u << kChunkBits;
+  static constexpr uint32_t kMaxChunks = 1u << 14;
+  static constexpr size_t kIndexShards = 16;
+
+  struct alignas(64) IndexShard {
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, uint32_t> ids;  // 序列 key -> id
+  };
+
+  uint32_t Define(const systeminsight::proto::MetricSample& sample);
+  const std::string* InternString(const std::string& value);
+
+  std::unique_ptr<IndexShard[]> index_;
+
+  std::mutex define_mutex_;  // 保护 strings_ 与新序列的分配
+  // 节点式容器，元素地址在 rehash 后保持不变，序列定义直接保存指针
+  std::unordered_set<std::string> strings_;
+  std::unique_ptr<std::atomic<Series*>[]> chunks_;
+  std::atomic<size_t> series_count_{0};
+  LabelIndex label_index_;
+};
+
+}  // namespace server
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_SERVER_SERIES_STORE_H_
@@ -1,7 +1,9 @@
 #include "src/server/server_app.h"
 
+#include <algorithm>
 #include <chrono>
 #include <stdexcept>
+#include <thread>
 #include <utility>
 
 #include "grpcpp/server_builder.h"
@@ -10,12 +12,72 @@
 namespace system_insight {
 namespace server {
 
+namespace {
+
+// Run 每隔这么久检查一次退出标记
+constexpr std::chrono::milliseconds kStopCheckInterval(100);
+
+std::shared_ptr<TimeSeriesDb> MakeTimeSeriesDb(const common::config::ServerConfig& config,
+                                               MetricsRepository& repository) {
+  if (!config.tsdb_enabled) return nullptr;
+  TsdbOptions options;
+  options.retention_ms = static_cast<int64_t>(config.tsdb_retention_seconds) * 1000;
+  options.memory_budget_bytes = static_cast<size_t>(config.tsdb_memory_budget_mb) << 20;
+  options.data_directory = config.tsdb_data_directory;
+  // 持久确认时报告须在预写日志落盘后才确认：每批报告 fdatasync 一次（组提交）
+  options.wal_sync = config.ingest_durable_ack;
+  options.compaction_interval =
+      std::chrono::seconds(std::max(config.tsdb_compaction_interval_seconds, 1));
+  options.rollups.clear();
+  if (config.tsdb_rollup_1m_retention_hours > 0) {
+    options.rollups.push_back(
+        {60 * 1000, static_cast<int64_t>(config.tsdb_rollup_1m_retention_hours) * 3600 * 1000});
+  }
+  if (config.tsdb_rollup_1h_retention_days > 0) {
+    options.rollups.push_back(
+        {3600 * 1000, static_cast<int64_t>(config.tsdb_rollup_1h_retention_days) * 86400 * 1000});
+  }
+  // 与仓库共用序列表，两边的序列 id 一致
+  auto tsdb = std::make_shared<TimeSeriesDb>(options, repository.shared_series_store());
+  // 重放的报告同时恢复各主机的最新值，导出端重启后不必等客户端重新上报
+  if (!tsdb->Open([&repository](const auto& report) { repository.UpdateReport(report); })) {
+    LOGW("tsdb data directory {} is not usable, keeping samples in memory only",
+         config.tsdb_data_directory);
+  }
+  return tsdb;
+}
+
+IngestOptions MakeIngestOptions(const common::config::ServerConfig& config) {
+  IngestOptions options;
+  options.applier_threads = static_cast<size_t>(std::max(config.ingest_applier_threads, 0));
+  options.queue_capacity = static_cast<size_t>(std::max(config.ingest_queue_capacity, 1));
+  options.durable_ack = config.ingest_durable_ack;
+  return options;
+}
+
+std::shared_ptr<QueryEngine> MakeQueryEngine(const common::config::ServerConfig& config,
+                                             std::shared_ptr<TimeSeriesDb> tsdb) {
+  if (!tsdb) return nullptr;
+  QueryEngineOptions options;
+  options.threads = static_cast<size_t>(std::max(config.query_threads, 0));
+  return std::make_shared<QueryEngine>(std::move(tsdb), options);
+}
+
+}  // namespace
+
 ServerApp::ServerApp(common::config::ServerConfig config,
                      std::shared_ptr<MetricsRepository> repository): 
       config_(std::move(config)),
       repository_(repository ? std::move(repository) : std::make_shared<MetricsRepository>()),
+      tsdb_(MakeTimeSeriesDb(config_, *repository_)),
+      query_engine_(MakeQueryEngine(config_, tsdb_)),
       exporter_(std::make_unique<exporter::PrometheusExporter>(repository_, config_.prometheus_http_port)),
-      service_(repository_) {}
+      service_(repository_, config_.stream_initial_credits, tsdb_, query_engine_,
+               MakeIngestOptions(config_)),
+      async_server_(&service_,
+                    AsyncServerOptions{
+                        static_cast<size_t>(std::max(config_.grpc_completion_queues, 0)),
+                        config_.grpc_pin_pollers}) {}
 
 ServerApp::~ServerApp() { Shutdown(); }
 
@@ -26,35 +88,47 @@ void ServerApp::SetListenAddress(std::string address) {
 void ServerApp::Run() {
   grpc::ServerBuilder builder;
   builder.AddListeningPort(config_.listen_address, grpc::InsecureServerCredentials());
-  builder.RegisterService(&service_);
+  async_server_.Register(&builder);
   server_ = builder.BuildAndStart();
 
   if (!server_) {
     throw std::runtime_error("Failed to start gRPC server");
   }
+  async_server_.Start();
 
   LOGI("server listening on {}", config_.listen_address);
   exporter_->Start();
+  if (tsdb_) {
+    tsdb_->Start();
+  }
 
-  server_->Wait();
-}
-
-void ServerApp::RequestStop() {
-  // 使用立即关闭来快速响应信号
-  if (server_) {
-    server_->Shutdown(std::chrono::system_clock::now());
+  // 信号处理函数只置位标记：在信号上下文里关闭 gRPC 服务会重入它内部的锁
+  while (!should_exit_.load()) {
+    std::this_thread::sleep_for(kStopCheckInterval);
   }
+  // 使用立即关闭来快速响应信号
+  server_->Shutdown(std::chrono::system_clock::now());
 }
 
+void ServerApp::RequestStop() { should_exit_.store(true); }
+
 // 优雅关闭，在析构里执行
 void ServerApp::Shutdown() {
   if (server_) {
     server_->Shutdown();
+  }
+  // 先提交排队的报告（等待提交的调用随之恢复），再关闭完成队列
+  service_.StopIngest();
+  if (server_) {
+    async_server_.Stop();
     server_.reset();
   }
   if (exporter_) {
     exporter_->Stop();
   }
+  if (tsdb_) {
+    tsdb_->Stop();
+  }
 }
 
 }  // namespace server
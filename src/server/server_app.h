@@ -1,14 +1,18 @@
 #ifndef SYSTEM_INSIGHT_SERVER_SERVER_APP_H_
 #define SYSTEM_INSIGHT_SERVER_SERVER_APP_H_
 
+#include <atomic>
 #include <memory>
 #include <string>
 
 #include "grpcpp/grpcpp.h"
 #include "src/common/config/config_loader.h"
 #include "src/exporter/prometheus_exporter.h"
+#include "src/server/async_metrics_server.h"
 #include "src/server/metrics_repository.h"
 #include "src/server/metrics_service_impl.h"
+#include "src/server/query_engine.h"
+#include "src/server/time_series_db.h"
 
 namespace system_insight {
 namespace server {
@@ -23,17 +27,23 @@ class ServerApp {
   ServerApp& operator=(const ServerApp&) = delete;
 
   void SetListenAddress(std::string address);
-  // 阻塞运行，直到 Shutdown 被调用或捕获终止信号。
+  // 阻塞运行，直到 RequestStop 被调用。
   void Run();
+  // 只设置退出标记，可在信号处理函数中调用
   void RequestStop();
   void Shutdown();
 
  private:
   common::config::ServerConfig config_;
   std::shared_ptr<MetricsRepository> repository_;
+  std::shared_ptr<TimeSeriesDb> tsdb_;
+  std::shared_ptr<QueryEngine> query_engine_;
   std::unique_ptr<exporter::PrometheusExporter> exporter_;
-  std::unique_ptr<grpc::Server> server_;
   MetricsServiceImpl service_;
+  // 服务与完成队列须比 server_ 活得久
+  AsyncMetricsServer async_server_;
+  std::unique_ptr<grpc::Server> server_;
+  std::atomic<bool> should_exit_{false};
 };
 
 }  // namespace server
@@ -0,0 +1,89 @@
+#include "src/server/thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace system_insight {
+namespace server {
+
+ThreadPool::ThreadPool(size_t threads) {
+  workers_.reserve(threads);
+  for (size_t i = 0; i < threads; ++i) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  cv_.notify_all();
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::WorkerLoop() {
+  while (true) {
+    std::function<void()> task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this] { return stopping_ || !tasks_.empty(); });
+      if (tasks_.empty()) return;
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+    task();
+  }
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grain,
+                             const std::function<void(size_t begin, size_t end)>& fn) {
+  if (count == 0) return;
+  grain = std::max<size_t>(grain, 1);
+  const size_t blocks = (count + grain - 1) / grain;
+  if (workers_.empty() || blocks == 1) {
+    fn(0, count);
+    return;
+  }
+
+  // 状态由参与的线程共享持有：迟到的工作线程发现块已取完就直接返回，不会触碰 fn
+  struct State {
+    std::atomic<size_t> next{0};
+    size_t done = 0;
+    std::mutex mutex;
+    std::condition_variable cv;
+  };
+  auto state = std::make_shared<State>();
+  auto drain = [state, count, grain, blocks, &fn] {
+    size_t finished = 0;
+    for (size_t block = state->next++; block < blocks; block = state->next++) {
+      const size_t begin = block * grain;
+      fn(begin, std::min(count, begin + grain));
+      ++finished;
+    }
+    if (finished > 0) {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      state->done += finished;
+      if (state->done == blocks) state->cv.notify_all();
+    }
+  };
+
+  const size_t helpers = std::min(workers_.size(), blocks - 1);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < helpers; ++i) {
+      tasks_.emplace_back(drain);
+    }
+  }
+  cv_.notify_all();
+  drain();
+
+  std::unique_lock<std::mutex> lock(state->mutex);
+  state->cv.wait(lock, [&] { return state->done == blocks; });
+}
+
+}  // namespace server
+}  // namespace system_insight
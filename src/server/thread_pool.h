@@ -0,0 +1,50 @@
+#ifndef SYSTEM_INSIGHT_SERVER_THREAD_POOL_H_
+#define SYSTEM_INSIGHT_SERVER_THREAD_POOL_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace system_insight {
+namespace server {
+
+/**
+ * @brief 固定大小的工作线程池，用于把一次查询拆到多个线程上并行执行
+ */
+class ThreadPool {
+ public:
+  /**
+   * @param threads 工作线程数；为 0 时所有任务都在调用线程上执行
+   */
+  explicit ThreadPool(size_t threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  size_t size() const { return workers_.size(); }
+
+  /**
+   * @brief 把 [0, count) 按 grain 切块，由工作线程与调用线程共同执行 fn(begin, end)，全部完成后返回
+   */
+  void ParallelFor(size_t count, size_t grain,
+                   const std::function<void(size_t begin, size_t end)>& fn);
+
+ private:
+  void WorkerLoop();
+
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  std::deque<std::function<void()>> tasks_;
+  bool stopping_ = false;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace server
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_SERVER_THREAD_POOL_H_
@@ -0,0 +1,985 @@
+#include "src/server/time_series_db.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <utility>
+
+#include "src/common/logging/logging.h"
+#include "src/server/block_file.h"
+
+namespace system_insight {
+namespace server {
+
+namespace {
+
+// 每个序列除块数据以外的开销：序列对象、块列表、哈希表节点
+constexpr int64_t kSeriesOverheadBytes = 128;
+constexpr int64_t kHeadChunkBytes = sizeof(HeadChunk);
+constexpr int64_t kMaxChunkRangeMs = 2 * 3600 * 1000;
+constexpr char kBlockSuffix[] = ".block";
+// 每个汇总层级的写者状态与快照开销
+constexpr int64_t kRollupOverheadBytes = 256;
+// 桶结束后这么久仍没有更晚的样本即关闭它；容忍上报延迟与主机时钟偏差
+constexpr int64_t kRollupCloseGraceMs = 10 * 60 * 1000;
+
+std::vector<RollupTier> ValidRollupTiers(std::vector<RollupTier> tiers) {
+  std::sort(tiers.begin(), tiers.end(), [](const RollupTier& lhs, const RollupTier& rhs) {
+    return lhs.resolution_ms < rhs.resolution_ms;
+  });
+  std::vector<RollupTier> valid;
+  for (const auto& tier : tiers) {
+    // 查询时由细的层补齐粗的层，每层的桶必须恰好由上一层的整数个桶组成
+    if (tier.resolution_ms <= 0 || tier.retention_ms <= 0 ||
+        (!valid.empty() && (tier.resolution_ms == valid.back().resolution_ms ||
+                            tier.resolution_ms % valid.back().resolution_ms != 0))) {
+      LOGW("Ignoring tsdb rollup tier with resolution {} ms and retention {} ms",
+           tier.resolution_ms, tier.retention_ms);
+      continue;
+    }
+    valid.push_back(tier);
+  }
+  return valid;
+}
+
+size_t TierIndex(const std::vector<RollupTier>& tiers, int64_t resolution_ms) {
+  for (size_t i = 0; i < tiers.size(); ++i) {
+    if (tiers[i].resolution_ms == resolution_ms) return i;
+  }
+  return tiers.size();
+}
+
+// 把 out 中 begin 之后的点按时间戳排序（含补发块时各块的时间区间会交叠）
+void SortPoints(PointBlock* out, size_t begin) {
+  const size_t count = out->size() - begin;
+  std::vector<size_t> order(count);
+  for (size_t i = 0; i < count; ++i) order[i] = begin + i;
+  const auto& timestamps = out->timestamps_ms;
+  std::sort(order.begin(), order.end(),
+            [&timestamps](size_t a, size_t b) { return timestamps[a] < timestamps[b]; });
+  std::vector<int64_t> sorted_timestamps(count);
+  std::vector<double> sorted_values(count);
+  for (size_t i = 0; i < count; ++i) {
+    sorted_timestamps[i] = out->timestamps_ms[order[i]];
+    sorted_values[i] = out->values[order[i]];
+  }
+  std::copy(sorted_timestamps.begin(), sorted_timestamps.end(),
+            out->timestamps_ms.begin() + static_cast<std::ptrdiff_t>(begin));
+  std::copy(sorted_values.begin(), sorted_values.end(),
+            out->values.begin() + static_cast<std::ptrdiff_t>(begin));
+}
+
+int64_t NowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+}  // namespace
+
+TimeSeriesDb::TimeSeriesDb(TsdbOptions options, std::shared_ptr<SeriesStore> series_store)
+    : options_(std::move(options)),
+      // 头块覆盖的时间跨度不超过保留期的四分之一，过期数据能及时随封存块丢弃
+      chunk_range_ms_(std::clamp<int64_t>(options_.retention_ms / 4, 1, kMaxChunkRangeMs)),
+      rollup_tiers_(ValidRollupTiers(options_.rollups)),
+      shard_count_(std::max<size_t>(options_.shard_count, 1)),
+      series_store_(std::move(series_store)),
+      shards_(std::make_unique<Shard[]>(shard_count_)) {}
+
+TimeSeriesDb::~TimeSeriesDb() { Stop(); }
+
+void TimeSeriesDb::Start() {
+  std::lock_guard<std::mutex> lock(housekeeping_mutex_);
+  if (housekeeping_thread_.joinable()) return;
+  stopping_ = false;
+  housekeeping_thread_ = std::thread(&TimeSeriesDb::HousekeepingLoop, this);
+}
+
+void TimeSeriesDb::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(housekeeping_mutex_);
+    stopping_ = true;
+  }
+  housekeeping_cv_.notify_all();
+  if (housekeeping_thread_.joinable()) {
+    housekeeping_thread_.join();
+  }
+}
+
+void TimeSeriesDb::HousekeepingLoop() {
+  std::unique_lock<std::mutex> lock(housekeeping_mutex_);
+  while (!housekeeping_cv_.wait_for(lock, options_.housekeeping_interval,
+                                    [this] { return stopping_; })) {
+    lock.unlock();
+    const int64_t now_ms = NowMs();
+    Purge(now_ms);
+    if (wal_ && (now_ms - last_compaction_ms_.load() >= options_.compaction_interval.count() ||
+                 wal_bytes() >= options_.wal_checkpoint_bytes)) {
+      Compact();
+    }
+    lock.lock();
+  }
+}
+
+TimeSeriesDb::Shard& TimeSeriesDb::ShardFor(const std::string& host_id) const {
+  return shards_[std::hash<std::string>{}(host_id) % shard_count_];
+}
+
+size_t TimeSeriesDb::Append(const systeminsight::proto::MetricsReport& report) {
+  if (!wal_) {
+    return AppendReport(report, kNoSequence);
+  }
+  thread_local std::string payload;
+  report.SerializeToString(&payload);
+  std::shared_lock<std::shared_mutex> checkpoint_lock(checkpoint_mutex_);
+  uint64_t sequence = kNoSequence;
+  {
+    std::lock_guard<std::mutex> lock(wal_mutex_);
+    if (wal_->Append(payload)) {
+      sequence = next_sequence_++;
+      if (options_.wal_sync) wal_->Sync();
+    }
+  }
+  if (sequence == kNoSequence) {
+    LOGW("tsdb failed to log report from host {}, samples kept in memory only", report.host_id());
+  }
+  return AppendReport(report, sequence);
+}
+
+size_t TimeSeriesDb::AppendBatch(
+    const std::vector<const systeminsight::proto::MetricsReport*>& reports) {
+  std::vector<uint64_t> sequences(reports.size(), kNoSequence);
+  std::shared_lock<std::shared_mutex> checkpoint_lock(checkpoint_mutex_, std::defer_lock);
+  if (wal_) {
+    thread_local std::vector<std::string> payloads;
+    payloads.resize(std::max(payloads.size(), reports.size()));
+    for (size_t i = 0; i < reports.size(); ++i) {
+      reports[i]->SerializeToString(&payloads[i]);
+    }
+    checkpoint_lock.lock();
+    std::lock_guard<std::mutex> lock(wal_mutex_);
+    for (size_t i = 0; i < reports.size(); ++i) {
+      if (wal_->Append(payloads[i])) {
+        sequences[i] = next_sequence_++;
+      } else {
+        LOGW("tsdb failed to log report from host {}, samples kept in memory only",
+             reports[i]->host_id());
+      }
+    }
+    if (options_.wal_sync) wal_->Sync();
+  }
+
+  // 按分片分组，每个分片只加锁一次；同一主机的报告保持原有顺序
+  std::vector<size_t> order(reports.size());
+  std::vector<size_t> shard_of(reports.size());
+  for (size_t i = 0; i < reports.size(); ++i) {
+    order[i] = i;
+    shard_of[i] = std::hash<std::string>{}(reports[i]->host_id()) % shard_count_;
+  }
+  std::stable_sort(order.begin(), order.end(),
+                   [&shard_of](size_t a, size_t b) { return shard_of[a] < shard_of[b]; });
+  size_t appended = 0;
+  thread_local std::vector<AppendTarget> targets;
+  for (size_t begin = 0; begin < order.size();) {
+    Shard& shard = shards_[shard_of[order[begin]]];
+    size_t end = begin;
+    targets.clear();
+    {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      for (; end < order.size() && shard_of[order[end]] == shard_of[order[begin]]; ++end) {
+        ResolveLocked(&shard, *reports[order[end]], &targets);
+      }
+    }
+    const AppendTarget* next = targets.data();
+    for (size_t i = begin; i < end; ++i) {
+      const auto& report = *reports[order[i]];
+      appended += AppendResolved(report, next, sequences[order[i]]);
+      next += report.samples_size();
+    }
+    begin = end;
+  }
+  targets.clear();
+  return appended;
+}
+
+size_t TimeSeriesDb::AppendReport(const systeminsight::proto::MetricsReport& report,
+                                  uint64_t sequence) {
+  thread_local std::vector<AppendTarget> targets;
+  targets.clear();
+  {
+    Shard& shard = ShardFor(report.host_id());
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    ResolveLocked(&shard, report, &targets);
+  }
+  const size_t appended = AppendResolved(report, targets.data(), sequence);
+  targets.clear();
+  return appended;
+}
+
+void TimeSeriesDb::ResolveLocked(Shard* shard, const systeminsight::proto::MetricsReport& report,
+                                 std::vector<AppendTarget>* targets) {
+  Host& host = shard->hosts[report.host_id()];
+  for (const auto& sample : report.samples()) {
+    AppendTarget& target = targets->emplace_back();
+    target.id = series_store_->Intern(sample);
+    if (target.id == SeriesStore::kInvalidSeries) continue;
+    target.series = FindOrCreateSeries(&host, target.id);
+  }
+}
+
+size_t TimeSeriesDb::AppendResolved(const systeminsight::proto::MetricsReport& report,
+                                    const AppendTarget* targets, uint64_t sequence) {
+  size_t appended = 0;
+  for (int i = 0; i < report.samples_size(); ++i) {
+    std::shared_ptr<Series> series = targets[i].series;
+    if (!series) continue;
+    std::unique_lock<std::mutex> lock(series->mutex);
+    if (series->removed) {
+      // 查找之后被 Purge 移除（整个保留期内没有新样本），重新查找会建一个新序列
+      lock.unlock();
+      {
+        Shard& shard = ShardFor(report.host_id());
+        std::lock_guard<std::mutex> shard_lock(shard.mutex);
+        series = FindOrCreateSeries(&shard.hosts[report.host_id()], targets[i].id);
+      }
+      if (!series) continue;
+      lock = std::unique_lock<std::mutex>(series->mutex);
+    }
+    const auto& sample = report.samples(i);
+    if (sample.timestamp_ms() > series->last_timestamp_ms) {
+      AppendPoint(series.get(), sample.timestamp_ms(), sample.value(), sequence);
+    } else if (!report.backfill() ||
+               !AppendBackfill(series.get(), sample.timestamp_ms(), sample.value(), sequence)) {
+      ++out_of_order_total_;
+      continue;
+    }
+    ++appended;
+  }
+  return appended;
+}
+
+std::shared_ptr<TimeSeriesDb::Series> TimeSeriesDb::FindOrCreateSeries(Host* host, uint32_t id) {
+  auto it = host->series.find(id);
+  if (it != host->series.end()) return it->second;
+  if (memory_bytes() > options_.memory_budget_bytes) return nullptr;
+  auto series = std::make_shared<Series>();
+  auto chunks = std::make_shared<ChunkList>();
+  chunks->head = std::make_shared<HeadChunk>();
+  series->chunks = std::move(chunks);
+  series->rollups.reserve(rollup_tiers_.size());
+  for (size_t i = 0; i < rollup_tiers_.size(); ++i) {
+    // 未封存的汇总块重启时由更细一层重建，跨度不超过那一层保留期的一半
+    const int64_t source_retention_ms =
+        i == 0 ? options_.retention_ms : rollup_tiers_[i - 1].retention_ms;
+    series->rollups.emplace_back(
+        rollup_tiers_[i].resolution_ms,
+        std::max(source_retention_ms / 2, rollup_tiers_[i].resolution_ms));
+  }
+  it = host->series.emplace(id, std::move(series)).first;
+  memory_bytes_ += kSeriesOverheadBytes + kHeadChunkBytes +
+                   kRollupOverheadBytes * static_cast<int64_t>(rollup_tiers_.size());
+  ++series_count_;
+  return it->second;
+}
+
+void TimeSeriesDb::AppendPoint(Series* series, int64_t timestamp_ms, double value,
+                               uint64_t sequence) {
+  // 写者持有序列锁，块列表只会被自己替换，这里直接读取
+  const ChunkList& current = *series->chunks;
+  HeadChunk* head = current.head.get();
+  const bool head_full =
+      head->count() > 0 && timestamp_ms - head->min_time_ms() >= chunk_range_ms_;
+  if (!head_full && head->Append(timestamp_ms, value)) {
+    // 序号在日志锁内分配、在序列锁内应用，同一块内的样本序号不一定递增
+    series->head_sequence = std::min(series->head_sequence, sequence);
+  } else {
+    // 封存当前头块，新样本写入新头块后一起发布
+    auto next = std::make_shared<ChunkList>();
+    next->sealed.reserve(current.sealed.size() + 1);
+    next->sealed = current.sealed;
+    auto sealed = head->Seal();
+    memory_bytes_ += static_cast<int64_t>(sealed->MemoryBytes());
+    next->sealed.push_back(std::move(sealed));
+    next->head = std::make_shared<HeadChunk>();
+    next->head->Append(timestamp_ms, value);
+    next->backfill_head = current.backfill_head;
+    next->ordered = current.ordered;
+    std::atomic_store(&series->chunks, std::shared_ptr<const ChunkList>(std::move(next)));
+    series->sealed_sequences.push_back(series->head_sequence);
+    series->head_sequence = sequence;
+  }
+  series->last_timestamp_ms = timestamp_ms;
+  for (auto& rollup : series->rollups) {
+    memory_bytes_ += rollup.Add(timestamp_ms, value, value, value, 1);
+  }
+}
+
+bool TimeSeriesDb::AppendBackfill(Series* series, int64_t timestamp_ms, double value,
+                                  uint64_t sequence) {
+  if (timestamp_ms <= series->last_timestamp_ms - options_.retention_ms) return false;
+  const ChunkList& current = *series->chunks;
+  // 重放日志或客户端重发时同一个点可能再次到达
+  thread_local PointBlock existing;
+  existing.clear();
+  ReadChunks(current, timestamp_ms, timestamp_ms, &existing);
+  if (existing.size() > 0) return false;
+
+  HeadChunk* head = current.backfill_head.get();
+  // 补发点按补发顺序写入，时间戳回退或跨度超限时封存当前补发头块
+  const bool head_full = head != nullptr && head->count() > 0 &&
+                         (timestamp_ms <= head->last_time_ms() ||
+                          timestamp_ms - head->min_time_ms() >= chunk_range_ms_);
+  if (head != nullptr && !head_full && head->Append(timestamp_ms, value)) {
+    series->backfill_sequence = std::min(series->backfill_sequence, sequence);
+  } else {
+    auto next = std::make_shared<ChunkList>(current);
+    if (head == nullptr) {
+      memory_bytes_ += kHeadChunkBytes;
+    } else if (head->count() > 0) {
+      auto sealed = head->Seal();
+      memory_bytes_ += static_cast<int64_t>(sealed->MemoryBytes());
+      next->sealed.push_back(std::move(sealed));
+      next->ordered = false;
+      series->sealed_sequences.push_back(series->backfill_sequence);
+    }
+    next->backfill_head = std::make_shared<HeadChunk>();
+    next->backfill_head->Append(timestamp_ms, value);
+    std::atomic_store(&series->chunks, std::shared_ptr<const ChunkList>(std::move(next)));
+    series->backfill_sequence = sequence;
+  }
+  // 已结束的汇总桶不再改动，落在其中的补发点只出现在原始样本中
+  for (auto& rollup : series->rollups) {
+    memory_bytes_ += rollup.Add(timestamp_ms, value, value, value, 1);
+  }
+  return true;
+}
+
+bool TimeSeriesDb::Query(const std::string& host_id, uint32_t series_id, int64_t start_ms,
+                         int64_t end_ms, PointBlock* out) const {
+  SeriesRef ref;
+  {
+    const Shard& shard = ShardFor(host_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto host = shard.hosts.find(host_id);
+    if (host == shard.hosts.end()) return false;
+    auto it = host->second.series.find(series_id);
+    if (it == host->second.series.end()) return false;
+    ref.series = it->second;
+  }
+  Read(ref, start_ms, end_ms, out);
+  return true;
+}
+
+void TimeSeriesDb::Select(const std::function<bool(const std::string&)>& host_filter,
+                          const std::vector<uint32_t>& series_ids,
+                          std::vector<SeriesRef>* out) const {
+  if (series_ids.empty()) return;
+  for (size_t i = 0; i < shard_count_; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mutex);
+    for (const auto& [host_id, host] : shards_[i].hosts) {
+      if (!host_filter(host_id)) continue;
+      // 候选 id 少时逐个查表，否则遍历主机的序列做二分
+      if (series_ids.size() <= host.series.size()) {
+        for (uint32_t id : series_ids) {
+          auto it = host.series.find(id);
+          if (it != host.series.end()) {
+            out->push_back({host_id, id, it->second});
+          }
+        }
+      } else {
+        for (const auto& [id, series] : host.series) {
+          if (std::binary_search(series_ids.begin(), series_ids.end(), id)) {
+            out->push_back({host_id, id, series});
+          }
+        }
+      }
+    }
+  }
+}
+
+void TimeSeriesDb::Read(const SeriesRef& ref, int64_t start_ms, int64_t end_ms,
+                        PointBlock* out) {
+  ReadChunks(*std::atomic_load(&ref.series->chunks), start_ms, end_ms, out);
+}
+
+void TimeSeriesDb::ReadChunks(const ChunkList& chunks, int64_t start_ms, int64_t end_ms,
+                              PointBlock* out) {
+  const size_t begin = out->size();
+  for (const auto& chunk : chunks.sealed) {
+    if (chunk->max_time_ms < start_ms || chunk->min_time_ms > end_ms) continue;
+    DecodeChunk(chunk->words(), chunk->word_count(), chunk->count, start_ms, end_ms, out);
+  }
+  chunks.head->Read(start_ms, end_ms, out);
+  bool ordered = chunks.ordered;
+  if (chunks.backfill_head) {
+    const size_t before = out->size();
+    chunks.backfill_head->Read(start_ms, end_ms, out);
+    ordered = ordered && out->size() == before;
+  }
+  if (!ordered) SortPoints(out, begin);
+}
+
+size_t TimeSeriesDb::ReadAggregates(const SeriesRef& ref, size_t tier, int64_t start_ms,
+                                    int64_t end_ms, AggregateBlock* out) {
+  const auto& rollups = ref.series->rollups;
+  size_t read = 0;
+  int64_t from_ms = start_ms;
+  // 由粗到细读取已结束的桶，每层从上一层结束处接着读；快照依次取得，只会越来越新
+  for (size_t i = std::min(tier + 1, rollups.size()); i-- > 0;) {
+    auto snapshot = rollups[i].Load();
+    const int64_t until_ms = std::min(snapshot->closed_until_ms, end_ms);
+    if (until_ms > from_ms) {
+      read += RollupSeries::Read(*snapshot, from_ms, until_ms, out);
+      from_ms = until_ms;
+    }
+  }
+  thread_local PointBlock points;
+  points.clear();
+  Read(ref, from_ms, end_ms, &points);
+  for (size_t i = 0; i < points.size(); ++i) {
+    const double value = points.values[i];
+    out->Append(points.timestamps_ms[i], value, value, value, 1);
+  }
+  return read + points.size();
+}
+
+int64_t TimeSeriesDb::DropChunks(Series* series, int64_t cutoff_ms) {
+  const ChunkList& current = *series->chunks;
+  auto keep =
+      std::find_if(current.sealed.begin(), current.sealed.end(),
+                   [cutoff_ms](const auto& chunk) { return chunk->max_time_ms > cutoff_ms; });
+  if (keep == current.sealed.begin()) return 0;
+
+  int64_t freed = 0;
+  for (auto it = current.sealed.begin(); it != keep; ++it) {
+    freed += static_cast<int64_t>((*it)->MemoryBytes());
+  }
+  // 丢弃的块中未落盘的部分不再需要重放
+  const size_t dropped = static_cast<size_t>(keep - current.sealed.begin());
+  const size_t unpersisted =
+      dropped > series->persisted_chunks ? dropped - series->persisted_chunks : 0;
+  series->sealed_sequences.erase(series->sealed_sequences.begin(),
+                                 series->sealed_sequences.begin() + unpersisted);
+  series->persisted_chunks -= dropped - unpersisted;
+
+  auto next = std::make_shared<ChunkList>();
+  next->sealed.assign(keep, current.sealed.end());
+  next->head = current.head;
+  next->backfill_head = current.backfill_head;
+  // 补发块丢弃后剩下的块可能重新按时间排列
+  for (size_t i = 1; i < next->sealed.size() && next->ordered; ++i) {
+    next->ordered = next->sealed[i - 1]->max_time_ms < next->sealed[i]->min_time_ms;
+  }
+  if (!next->sealed.empty() && next->head->count() > 0) {
+    next->ordered = next->ordered && next->sealed.back()->max_time_ms < next->head->min_time_ms();
+  }
+  std::atomic_store(&series->chunks, std::shared_ptr<const ChunkList>(std::move(next)));
+  memory_bytes_ -= freed;
+  return freed;
+}
+
+void TimeSeriesDb::Purge(int64_t now_ms) {
+  const int64_t cutoff_ms = now_ms - options_.retention_ms;
+  size_t dropped_series = 0;
+  for (size_t i = 0; i < shard_count_; ++i) {
+    Shard& shard = shards_[i];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    for (auto host = shard.hosts.begin(); host != shard.hosts.end();) {
+      auto& series_map = host->second.series;
+      for (auto it = series_map.begin(); it != series_map.end();) {
+        // 持有引用：移除时序列锁仍在作用域内
+        const std::shared_ptr<Series> series = it->second;
+        std::lock_guard<std::mutex> series_lock(series->mutex);
+        DropChunks(series.get(), cutoff_ms);
+        bool rollups_empty = true;
+        for (size_t t = 0; t < series->rollups.size(); ++t) {
+          RollupSeries& rollup = series->rollups[t];
+          memory_bytes_ += rollup.CloseIfStale(now_ms, kRollupCloseGraceMs);
+          memory_bytes_ += rollup.DropBefore(now_ms - rollup_tiers_[t].retention_ms);
+          rollups_empty = rollups_empty && rollup.empty();
+        }
+        // 整个保留期内都没有新样本、汇总也都过期的序列连同头块一起移除
+        if (series->last_timestamp_ms <= cutoff_ms && rollups_empty) {
+          memory_bytes_ -= kSeriesOverheadBytes + kHeadChunkBytes +
+                           kRollupOverheadBytes * static_cast<int64_t>(series->rollups.size());
+          if (series->chunks->backfill_head) memory_bytes_ -= kHeadChunkBytes;
+          for (const auto& chunk : series->chunks->sealed) {
+            memory_bytes_ -= static_cast<int64_t>(chunk->MemoryBytes());
+          }
+          series->removed = true;
+          it = series_map.erase(it);
+          --series_count_;
+          ++dropped_series;
+        } else {
+          ++it;
+        }
+      }
+      host = series_map.empty() ? shard.hosts.erase(host) : std::next(host);
+    }
+  }
+  if (dropped_series > 0) {
+    LOGD("tsdb dropped {} stale series", dropped_series);
+  }
+  RemoveExpiredBlocks(now_ms);
+  EnforceBudget();
+}
+
+void TimeSeriesDb::EnforceBudget() {
+  const int64_t budget = static_cast<int64_t>(options_.memory_budget_bytes);
+  if (memory_bytes_.load() <= budget) return;
+
+  // 按封存块的结束时间排序，找到释放足够内存所需的最小截止时间
+  std::vector<std::pair<int64_t, int64_t>> chunks;  // (max_time_ms, bytes)
+  for (size_t i = 0; i < shard_count_; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mutex);
+    for (const auto& [host_id, host] : shards_[i].hosts) {
+      for (const auto& [id, series] : host.series) {
+        std::lock_guard<std::mutex> series_lock(series->mutex);
+        for (const auto& chunk : series->chunks->sealed) {
+          chunks.emplace_back(chunk->max_time_ms, static_cast<int64_t>(chunk->MemoryBytes()));
+        }
+      }
+    }
+  }
+  std::sort(chunks.begin(), chunks.end());
+  int64_t excess = memory_bytes_.load() - budget;
+  int64_t cutoff_ms = INT64_MIN;
+  for (const auto& [max_time_ms, bytes] : chunks) {
+    if (excess <= 0) break;
+    cutoff_ms = max_time_ms;
+    excess -= bytes;
+  }
+  if (cutoff_ms == INT64_MIN) {
+    LOGW("tsdb memory {} bytes exceeds budget {} with no sealed chunks to drop",
+         memory_bytes_.load(), budget);
+    return;
+  }
+
+  int64_t freed = 0;
+  for (size_t i = 0; i < shard_count_; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mutex);
+    for (auto& [host_id, host] : shards_[i].hosts) {
+      for (auto& [id, series] : host.series) {
+        std::lock_guard<std::mutex> series_lock(series->mutex);
+        freed += DropChunks(series.get(), cutoff_ms);
+      }
+    }
+  }
+  LOGI("tsdb over memory budget, dropped {} bytes of chunks ending at or before {}", freed,
+       cutoff_ms);
+}
+
+bool TimeSeriesDb::Open(
+    const std::function<void(const systeminsight::proto::MetricsReport&)>& on_replay) {
+  if (options_.data_directory.empty()) return true;
+  const auto started = std::chrono::steady_clock::now();
+  const std::string block_directory = options_.data_directory + "/blocks";
+  std::error_code ec;
+  std::filesystem::create_directories(block_directory, ec);
+  if (ec) {
+    LOGE("Failed to create tsdb block directory {}: {}", block_directory, ec.message());
+    return false;
+  }
+  common::storage::SegmentLogOptions wal_options;
+  wal_options.directory = options_.data_directory + "/wal";
+  wal_options.segment_bytes = options_.wal_segment_bytes;
+  wal_options.max_total_bytes = options_.wal_max_bytes;
+  // wal_sync 时由写者在一批报告之后统一 fdatasync（组提交）
+  wal_options.sync = false;
+  auto wal = std::make_unique<common::storage::SegmentLog>(wal_options);
+  if (!wal->Open()) return false;
+
+  // 块文件按编号（即写入顺序）加载，同一序列的块依次接在后面
+  std::vector<uint64_t> ids;
+  for (const auto& entry : std::filesystem::directory_iterator(block_directory, ec)) {
+    const auto& path = entry.path();
+    if (path.extension() == ".tmp") {
+      // 压缩中途退出留下的临时文件
+      std::filesystem::remove(path, ec);
+      continue;
+    }
+    if (path.extension() != kBlockSuffix) continue;
+    char* end = nullptr;
+    const std::string stem = path.stem().string();
+    const uint64_t id = std::strtoull(stem.c_str(), &end, 10);
+    if (end != stem.c_str() + stem.size() || id == 0) continue;
+    ids.push_back(id);
+  }
+  std::sort(ids.begin(), ids.end());
+  const int64_t now_ms = NowMs();
+  {
+    std::lock_guard<std::mutex> lock(compaction_mutex_);
+    for (uint64_t id : ids) {
+      LoadBlock(BlockPath(id), now_ms);
+      next_block_id_ = id + 1;
+    }
+  }
+  if (!rollup_tiers_.empty()) {
+    for (size_t i = 0; i < shard_count_; ++i) {
+      std::lock_guard<std::mutex> lock(shards_[i].mutex);
+      for (const auto& [host_id, host] : shards_[i].hosts) {
+        for (const auto& [id, series] : host.series) {
+          std::lock_guard<std::mutex> series_lock(series->mutex);
+          RebuildRollups(series);
+        }
+      }
+    }
+  }
+
+  // 与块文件重叠的日志样本在重放时按乱序丢弃，不计入乱序计数
+  const uint64_t out_of_order_before = out_of_order_total_.load();
+  uint64_t sequence = 0;
+  systeminsight::proto::MetricsReport report;
+  const bool replayed = wal->Scan([&](const std::string& payload) {
+    if (report.ParseFromString(payload)) {
+      AppendReport(report, sequence);
+      if (on_replay) on_replay(report);
+    } else {
+      LOGW("Skipping malformed tsdb wal record {}", sequence);
+    }
+    ++sequence;
+    return true;
+  });
+  if (!replayed) {
+    LOGW("tsdb wal replay stopped at record {} of {}", sequence, wal->pending_records());
+  }
+  out_of_order_total_ = out_of_order_before;
+
+  {
+    std::lock_guard<std::mutex> lock(wal_mutex_);
+    wal_first_sequence_ = 0;
+    wal_dropped_records_ = wal->dropped_records();
+    next_sequence_ = wal->pending_records();
+    wal_ = std::move(wal);
+  }
+  last_compaction_ms_ = NowMs();
+  LOGI("tsdb restored {} series from {} blocks and replayed {} wal records in {} ms",
+       series_count(), block_count(), sequence,
+       std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                             started)
+           .count());
+  return true;
+}
+
+std::string TimeSeriesDb::BlockPath(uint64_t id) const {
+  char name[32];
+  std::snprintf(name, sizeof(name), "%020" PRIu64 "%s", id, kBlockSuffix);
+  return options_.data_directory + "/blocks/" + name;
+}
+
+void TimeSeriesDb::LoadBlock(const std::string& path, int64_t now_ms) {
+  auto block = MappedBlock::Open(path);
+  if (!block) {
+    LOGW("Skipping unreadable tsdb block {}", path);
+    return;
+  }
+  const int64_t cutoff_ms = now_ms - options_.retention_ms;
+  int64_t expires_ms = INT64_MIN;
+  const bool complete = block->ForEachSeries([&](BlockSeries&& entry) {
+    int64_t entry_expires_ms = INT64_MIN;
+    for (const auto& chunk : entry.chunks) {
+      entry_expires_ms = std::max(entry_expires_ms, chunk->max_time_ms + options_.retention_ms);
+    }
+    for (const auto& rollup : entry.rollups) {
+      const size_t tier = TierIndex(rollup_tiers_, rollup.resolution_ms);
+      if (tier == rollup_tiers_.size() || rollup.chunks.empty()) continue;
+      entry_expires_ms =
+          std::max(entry_expires_ms, rollup.chunks.back()->max_time_ms + rollup.resolution_ms +
+                                         rollup_tiers_[tier].retention_ms);
+    }
+    expires_ms = std::max(expires_ms, entry_expires_ms);
+    if (entry_expires_ms <= now_ms) return;
+
+    const uint32_t id = series_store_->Intern(entry.key);
+    if (id == SeriesStore::kInvalidSeries) return;
+    Shard& shard = ShardFor(entry.host_id);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto series = FindOrCreateSeries(&shard.hosts[entry.host_id], id);
+    if (series == nullptr) return;
+    std::lock_guard<std::mutex> series_lock(series->mutex);
+    auto next = std::make_shared<ChunkList>(*series->chunks);
+    for (auto& chunk : entry.chunks) {
+      if (chunk->max_time_ms <= cutoff_ms) continue;
+      // 块按封存顺序写入，补发块早于它之前的块
+      if (chunk->min_time_ms <= series->last_timestamp_ms) next->ordered = false;
+      series->last_timestamp_ms = std::max(series->last_timestamp_ms, chunk->max_time_ms);
+      memory_bytes_ += static_cast<int64_t>(chunk->MemoryBytes());
+      next->sealed.push_back(std::move(chunk));
+    }
+    series->persisted_chunks = next->sealed.size();
+    std::atomic_store(&series->chunks, std::shared_ptr<const ChunkList>(std::move(next)));
+
+    for (auto& rollup : entry.rollups) {
+      const size_t tier = TierIndex(rollup_tiers_, rollup.resolution_ms);
+      if (tier == rollup_tiers_.size()) continue;  // 该层已从配置中移除
+      const int64_t tier_cutoff_ms = now_ms - rollup_tiers_[tier].retention_ms;
+      for (auto& chunk : rollup.chunks) {
+        if (chunk->max_time_ms + rollup.resolution_ms <= tier_cutoff_ms) continue;
+        memory_bytes_ += series->rollups[tier].AppendLoaded(std::move(chunk));
+      }
+    }
+  });
+  if (!complete) {
+    LOGW("tsdb block {} has a corrupt index, loaded the series before it", path);
+  }
+  if (expires_ms <= now_ms) {
+    ::unlink(path.c_str());
+    return;
+  }
+  blocks_.push_back({path, expires_ms});
+}
+
+void TimeSeriesDb::RebuildRollups(const std::shared_ptr<Series>& series) {
+  auto& rollups = series->rollups;
+  if (rollups.empty()) return;
+  // 第一层由块文件中的原始样本补齐，之后每层由上一层的桶（含未结束的桶）补齐
+  PointBlock points;
+  SeriesRef ref;
+  ref.series = series;
+  Read(ref, rollups[0].Load()->closed_until_ms, INT64_MAX, &points);
+  for (size_t i = 0; i < points.size(); ++i) {
+    const double value = points.values[i];
+    memory_bytes_ += rollups[0].Add(points.timestamps_ms[i], value, value, value, 1);
+  }
+  AggregateBlock source;
+  for (size_t t = 1; t < rollups.size(); ++t) {
+    source.clear();
+    RollupSeries::Read(*rollups[t - 1].Load(), rollups[t].Load()->closed_until_ms, INT64_MAX,
+                       &source);
+    rollups[t - 1].ReadOpen(&source);
+    for (size_t i = 0; i < source.size(); ++i) {
+      memory_bytes_ += rollups[t].Add(source.timestamps_ms[i], source.min[i], source.max[i],
+                                      source.sum[i], source.count[i]);
+    }
+  }
+}
+
+void TimeSeriesDb::RemoveExpiredBlocks(int64_t now_ms) {
+  std::lock_guard<std::mutex> lock(compaction_mutex_);
+  // 已映射的块在最后一个引用释放时解除映射，文件可以先删除
+  auto expired = std::partition(blocks_.begin(), blocks_.end(), [now_ms](const auto& block) {
+    return block.expires_ms > now_ms;
+  });
+  for (auto it = expired; it != blocks_.end(); ++it) {
+    ::unlink(it->path.c_str());
+  }
+  blocks_.erase(expired, blocks_.end());
+}
+
+uint64_t TimeSeriesDb::RetainedSequence(const Series& series) {
+  uint64_t retained = kNoSequence;
+  if (!series.sealed_sequences.empty()) {
+    retained = *std::min_element(series.sealed_sequences.begin(), series.sealed_sequences.end());
+  }
+  if (series.chunks->head->count() > 0) retained = std::min(retained, series.head_sequence);
+  const auto& backfill_head = series.chunks->backfill_head;
+  if (backfill_head && backfill_head->count() > 0) {
+    retained = std::min(retained, series.backfill_sequence);
+  }
+  return retained;
+}
+
+bool TimeSeriesDb::Compact() {
+  if (!wal_) return true;
+  std::lock_guard<std::mutex> compaction_lock(compaction_mutex_);
+  const auto started = std::chrono::steady_clock::now();
+  uint64_t checkpoint = 0;
+  {
+    // 独占锁等待进行中的写入：序号小于 checkpoint 的报告都已写入内存
+    std::unique_lock<std::shared_mutex> lock(checkpoint_mutex_);
+    std::lock_guard<std::mutex> wal_lock(wal_mutex_);
+    checkpoint = next_sequence_;
+  }
+
+  // 收集尚未落盘的封存块；封存块不可变，在锁外写文件
+  struct Pending {
+    std::string host_id;
+    uint32_t series_id;
+    std::vector<std::shared_ptr<const SealedChunk>> chunks;
+    std::vector<BlockRollup> rollups;
+  };
+  std::vector<Pending> pending;
+  for (size_t i = 0; i < shard_count_; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mutex);
+    for (const auto& [host_id, host] : shards_[i].hosts) {
+      for (const auto& [id, series] : host.series) {
+        std::lock_guard<std::mutex> series_lock(series->mutex);
+        Pending entry{host_id, id, {}, {}};
+        const auto& sealed = series->chunks->sealed;
+        if (sealed.size() > series->persisted_chunks) {
+          entry.chunks.assign(sealed.begin() + series->persisted_chunks, sealed.end());
+        }
+        for (const auto& rollup : series->rollups) {
+          auto chunks = rollup.Unpersisted();
+          if (!chunks.empty()) entry.rollups.push_back({rollup.resolution_ms(), std::move(chunks)});
+        }
+        if (!entry.chunks.empty() || !entry.rollups.empty()) {
+          pending.push_back(std::move(entry));
+        }
+      }
+    }
+  }
+
+  std::vector<const Pending*> raw;
+  std::vector<const Pending*> rollups;
+  for (const auto& entry : pending) {
+    if (!entry.chunks.empty()) raw.push_back(&entry);
+    if (!entry.rollups.empty()) rollups.push_back(&entry);
+  }
+
+  size_t chunk_count = 0;
+  if (!raw.empty()) {
+    const std::string path = BlockPath(next_block_id_++);
+    BlockWriter writer(path);
+    bool written = writer.Open();
+    for (const Pending* entry : raw) {
+      if (!written) break;
+      written = writer.AddSeries(entry->host_id, series_store_->series(entry->series_id),
+                                 entry->chunks);
+    }
+    if (!written || !writer.Finish()) {
+      LOGE("tsdb compaction failed, keeping wal");
+      return false;
+    }
+    auto block = MappedBlock::Open(path);
+    std::vector<std::vector<std::shared_ptr<const SealedChunk>>> mapped;
+    if (!block || !block->ForEachSeries([&mapped](BlockSeries&& entry) {
+          mapped.push_back(std::move(entry.chunks));
+        }) || mapped.size() != raw.size()) {
+      LOGE("tsdb block {} cannot be read back, keeping wal", path);
+      ::unlink(path.c_str());
+      return false;
+    }
+    blocks_.push_back({path, block->max_time_ms() + options_.retention_ms});
+
+    // 标记为已落盘，并把堆上的封存块换成映射的副本
+    for (size_t i = 0; i < raw.size(); ++i) {
+      const Pending& entry = *raw[i];
+      chunk_count += entry.chunks.size();
+      Shard& shard = ShardFor(entry.host_id);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto host = shard.hosts.find(entry.host_id);
+      if (host == shard.hosts.end()) continue;
+      auto it = host->second.series.find(entry.series_id);
+      if (it == host->second.series.end()) continue;
+      Series* series = it->second.get();
+      std::lock_guard<std::mutex> series_lock(series->mutex);
+      const auto& sealed = series->chunks->sealed;
+      // 期间只可能从头部丢弃块或在尾部追加块，按最后一个已写入块定位
+      auto last = std::find(sealed.begin(), sealed.end(), entry.chunks.back());
+      if (last == sealed.end()) continue;
+      const size_t end = static_cast<size_t>(last - sealed.begin()) + 1;
+      const size_t begin = end >= entry.chunks.size() ? end - entry.chunks.size() : 0;
+      const size_t skipped = entry.chunks.size() - (end - begin);
+      auto next = std::make_shared<ChunkList>(*series->chunks);
+      for (size_t j = begin; j < end; ++j) {
+        auto& replacement = mapped[i][skipped + j - begin];
+        memory_bytes_ += static_cast<int64_t>(replacement->MemoryBytes()) -
+                         static_cast<int64_t>(next->sealed[j]->MemoryBytes());
+        next->sealed[j] = std::move(replacement);
+      }
+      series->sealed_sequences.erase(
+          series->sealed_sequences.begin(),
+          series->sealed_sequences.begin() + (end - series->persisted_chunks));
+      series->persisted_chunks = end;
+      std::atomic_store(&series->chunks, std::shared_ptr<const ChunkList>(std::move(next)));
+    }
+  }
+
+  // 汇总块单独成文件：它们的保留期远长于原始样本，不应让原始块跟着保留
+  size_t rollup_chunk_count = 0;
+  if (!rollups.empty()) {
+    const std::string path = BlockPath(next_block_id_++);
+    BlockWriter writer(path);
+    bool written = writer.Open();
+    int64_t expires_ms = INT64_MIN;
+    for (const Pending* entry : rollups) {
+      if (!written) break;
+      written = writer.AddSeries(entry->host_id, series_store_->series(entry->series_id), {},
+                                 entry->rollups);
+      for (const auto& rollup : entry->rollups) {
+        const size_t tier = TierIndex(rollup_tiers_, rollup.resolution_ms);
+        expires_ms = std::max(expires_ms, rollup.chunks.back()->max_time_ms +
+                                              rollup.resolution_ms +
+                                              rollup_tiers_[tier].retention_ms);
+        rollup_chunk_count += rollup.chunks.size();
+      }
+    }
+    if (!written || !writer.Finish()) {
+      LOGE("tsdb rollup compaction failed, keeping wal");
+      return false;
+    }
+    blocks_.push_back({path, expires_ms});
+
+    for (const Pending* entry : rollups) {
+      Shard& shard = ShardFor(entry->host_id);
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      auto host = shard.hosts.find(entry->host_id);
+      if (host == shard.hosts.end()) continue;
+      auto it = host->second.series.find(entry->series_id);
+      if (it == host->second.series.end()) continue;
+      std::lock_guard<std::mutex> series_lock(it->second->mutex);
+      for (const auto& rollup : entry->rollups) {
+        const size_t tier = TierIndex(rollup_tiers_, rollup.resolution_ms);
+        it->second->rollups[tier].MarkPersisted(rollup.chunks.back());
+      }
+    }
+  }
+
+  // 日志只需保留到仍在内存中、尚未落盘的最早样本
+  uint64_t retained = checkpoint;
+  for (size_t i = 0; i < shard_count_; ++i) {
+    std::lock_guard<std::mutex> lock(shards_[i].mutex);
+    for (const auto& [host_id, host] : shards_[i].hosts) {
+      for (const auto& [id, series] : host.series) {
+        std::lock_guard<std::mutex> series_lock(series->mutex);
+        retained = std::min(retained, RetainedSequence(*series));
+      }
+    }
+  }
+  uint64_t dropped = 0;
+  uint64_t wal_bytes = 0;
+  {
+    std::lock_guard<std::mutex> lock(wal_mutex_);
+    // 追加时超出总大小上限删除的段不经 DropFront，先把最旧序号推进到日志实际的开头
+    wal_first_sequence_ += wal_->dropped_records() - wal_dropped_records_;
+    wal_dropped_records_ = wal_->dropped_records();
+    if (retained > wal_first_sequence_) {
+      dropped = wal_->DropFront(retained - wal_first_sequence_);
+      wal_first_sequence_ += dropped;
+    }
+    wal_bytes = wal_->total_bytes();
+  }
+  last_compaction_ms_ = NowMs();
+  if (pending.empty() && dropped == 0) return true;
+  LOGI("tsdb compacted {} chunks and {} rollup chunks of {} series in {} ms, dropped {} wal "
+       "records, wal {} bytes",
+       chunk_count, rollup_chunk_count, pending.size(),
+       std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() -
+                                                             started)
+           .count(),
+       dropped, wal_bytes);
+  return true;
+}
+
+size_t TimeSeriesDb::block_count() const {
+  std::lock_guard<std::mutex> lock(compaction_mutex_);
+  return blocks_.size();
+}
+
+uint64_t TimeSeriesDb::wal_bytes() const {
+  std::lock_guard<std::mutex> lock(wal_mutex_);
+  return wal_ ? wal_->total_bytes() : 0;
+}
+
+uint64_t TimeSeriesDb::wal_sync_count() const {
+  std::lock_guard<std::mutex> lock(wal_mutex_);
+  return wal_ ? wal_->sync_count() : 0;
+}
+
+}  // namespace server
+}  // namespace system_insight
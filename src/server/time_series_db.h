@@ -0,0 +1,284 @@
+#ifndef SYSTEM_INSIGHT_SERVER_TIME_SERIES_DB_H_
+#define SYSTEM_INSIGHT_SERVER_TIME_SERIES_DB_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "src/common/storage/segment_log.h"
+#include "src/server/gorilla_chunk.h"
+#include "src/server/rollup.h"
+#include "src/server/series_store.h"
+#include "system_insight.pb.h"
+
+namespace system_insight {
+namespace server {
+
+struct TsdbOptions {
+  // 早于 now - retention 的块被丢弃
+  int64_t retention_ms = 3600 * 1000;
+  // 超出预算时从最旧的封存块开始丢弃，且不再接受新序列
+  size_t memory_budget_bytes = size_t{256} << 20;
+  size_t shard_count = 16;
+  std::chrono::milliseconds housekeeping_interval{10000};
+
+  // 汇总层级，按分辨率升序，每层的分辨率须是上一层的整数倍；为空时不做汇总
+  std::vector<RollupTier> rollups = {{60 * 1000, 7 * 24 * 3600 * 1000LL},
+                                     {3600 * 1000, 90 * 24 * 3600 * 1000LL}};
+
+  // 数据目录，为空时只保存在内存中。否则写入的报告先追加到预写日志（<dir>/wal），
+  // 封存块定期压缩为块文件（<dir>/blocks），重启时映射块文件并只重放日志尾部
+  std::string data_directory;
+  std::chrono::milliseconds compaction_interval{300000};
+  // 日志超过该大小时提前压缩
+  uint64_t wal_checkpoint_bytes = 64ULL << 20;
+  uint64_t wal_segment_bytes = 8ULL << 20;
+  // 日志总大小上限，超出时删除最旧的段（其中尚未落盘的样本重启后丢失）
+  uint64_t wal_max_bytes = 1ULL << 30;
+  // 每条日志后 fdatasync；关闭时进程崩溃不丢数据，掉电可能丢失最近的写入
+  bool wal_sync = false;
+};
+
+/**
+ * @brief 内嵌的内存时序库：按（主机, 序列）保存最近一段时间的样本
+ *
+ * 每个序列是一串只追加的 Gorilla 压缩块：封存块不可变、按实际大小分配，
+ * 只有头块接受追加。序列 id 来自与 MetricsRepository 共享的 SeriesStore。
+ *
+ * 主机按哈希分片，分片锁只保护主机与序列表：写者在分片锁内查找（或创建）一份报告涉及的
+ * 全部序列，随后在锁外逐个序列追加，只持有该序列自己的锁，同一分片内不同序列的追加
+ * 互不阻塞；头块本身是单写者结构。清理与压缩在分片锁内再逐个取序列锁。
+ * 读者不取序列锁：查询只在查找序列时短暂持有分片锁，解码封存块和头块都在锁外进行，
+ * 可与追加并发；序列的块列表以不可变 shared_ptr 发布、原子替换。
+ *
+ * 每个序列的时间戳必须严格递增，乱序或重复的样本被丢弃并计数。补发报告（backfill）例外：
+ * 早于序列最新样本、仍在保留期内且时间戳不重复的点写入单独的补发头块，封存后接在封存块
+ * 列表末尾，与其他块一样压缩落盘；读取时与按序写入的点合并排序。汇总只并入仍未结束的桶。
+ *
+ * 配置数据目录后：每份报告先写预写日志再写入内存；Compact() 把尚未落盘的封存块写成
+ * 不可变的块文件，随后用映射的块替换堆上的副本，并删除已被块文件覆盖的日志段。
+ * 头块只存在于日志中，日志保留到最早一个未落盘样本所在的段。
+ *
+ * 每个序列在每个汇总层级上随写入增量维护 min / max / sum / count 桶（RollupSeries），
+ * 各层按自己的保留期清理。封存的汇总块写入单独的块文件，未封存的部分重启时由
+ * 更细一层（第一层由原始样本）重建。
+ */
+class TimeSeriesDb {
+ private:
+  struct Series;
+
+ public:
+  /**
+   * @brief Select 选出的一个（主机, 序列）；持有序列的引用，读取时不再查表
+   */
+  struct SeriesRef {
+    std::string host_id;
+    uint32_t series_id = SeriesStore::kInvalidSeries;
+    std::shared_ptr<Series> series;
+  };
+
+  TimeSeriesDb(TsdbOptions options, std::shared_ptr<SeriesStore> series_store);
+  ~TimeSeriesDb();
+
+  TimeSeriesDb(const TimeSeriesDb&) = delete;
+  TimeSeriesDb& operator=(const TimeSeriesDb&) = delete;
+
+  /**
+   * @brief 启动后台线程，按 housekeeping_interval 执行 Purge
+   */
+  void Start();
+  void Stop();
+
+  /**
+   * @brief 打开数据目录：映射保留期内的块文件，再重放预写日志
+   * @param on_replay 每条重放的报告回调一次，可为空
+   * @return 未配置数据目录时直接返回 true；目录不可用时返回 false，此后只保存在内存中
+   */
+  bool Open(const std::function<void(const systeminsight::proto::MetricsReport&)>& on_replay);
+
+  /**
+   * @brief 把尚未落盘的封存块写成新的块文件，并丢弃已被块文件覆盖的日志段
+   * @return 未配置数据目录时返回 true；写块文件失败时返回 false，日志保持不变
+   */
+  bool Compact();
+
+  /**
+   * @return 写入的样本数
+   */
+  size_t Append(const systeminsight::proto::MetricsReport& report);
+
+  /**
+   * @brief 批量写入：整批追加到预写日志后只同步一次，再按分片分组、每个分片加一次锁
+   * @return 写入的样本数
+   */
+  size_t AppendBatch(const std::vector<const systeminsight::proto::MetricsReport*>& reports);
+
+  /**
+   * @brief 追加 [start_ms, end_ms] 内的点（按时间升序）
+   * @return 主机上不存在该序列时返回 false
+   */
+  bool Query(const std::string& host_id, uint32_t series_id, int64_t start_ms, int64_t end_ms,
+             PointBlock* out) const;
+
+  /**
+   * @brief 选出 host_filter 接受的主机上、id 在 series_ids（升序）中的全部序列
+   *
+   * 逐个分片短暂持锁收集引用；读取（Read）在锁外进行。
+   */
+  void Select(const std::function<bool(const std::string&)>& host_filter,
+              const std::vector<uint32_t>& series_ids, std::vector<SeriesRef>* out) const;
+
+  /**
+   * @brief 追加 [start_ms, end_ms] 内的点（按时间升序），可与追加并发
+   */
+  static void Read(const SeriesRef& ref, int64_t start_ms, int64_t end_ms, PointBlock* out);
+
+  /**
+   * @brief 以第 tier 层汇总追加 [start_ms, end_ms] 内的桶（按时间升序），可与追加并发
+   *
+   * 该层尚未结束的桶由更细的层补齐，最后不足一个最细桶的部分用原始样本，因此结果覆盖到
+   * 最新的样本。start_ms 需要按该层分辨率对齐。
+   * @return 读取的桶数与原始样本数之和
+   */
+  static size_t ReadAggregates(const SeriesRef& ref, size_t tier, int64_t start_ms,
+                               int64_t end_ms, AggregateBlock* out);
+
+  /**
+   * @brief 丢弃超出保留期的块与不再更新的序列，再按内存预算丢弃最旧的块
+   */
+  void Purge(int64_t now_ms);
+
+  size_t memory_bytes() const { return static_cast<size_t>(memory_bytes_.load()); }
+  size_t series_count() const { return series_count_.load(); }
+  uint64_t out_of_order_total() const { return out_of_order_total_.load(); }
+  size_t block_count() const;
+  uint64_t wal_bytes() const;
+  // wal_sync 时每次 Append / AppendBatch 执行一次 fdatasync
+  uint64_t wal_sync_count() const;
+  const SeriesStore& series_store() const { return *series_store_; }
+  const std::vector<RollupTier>& rollup_tiers() const { return rollup_tiers_; }
+
+ private:
+  struct ChunkList {
+    // 按封存顺序排列；补发块的时间早于它之前的块，此时 ordered 为 false
+    std::vector<std::shared_ptr<const SealedChunk>> sealed;
+    std::shared_ptr<HeadChunk> head;
+    // 收到第一个补发点时创建
+    std::shared_ptr<HeadChunk> backfill_head;
+    bool ordered = true;
+  };
+
+  static constexpr uint64_t kNoSequence = UINT64_MAX;
+
+  struct Series {
+    // 读写都经 std::atomic_load / std::atomic_store
+    std::shared_ptr<const ChunkList> chunks;
+    // 串行化该序列的写者（追加、清理、压缩）；需要分片锁时先取分片锁
+    std::mutex mutex;
+    // 以下字段只由持有 mutex 的写者访问
+    // 已从序列表移除；持有旧引用的写者须重新查找
+    bool removed = false;
+    int64_t last_timestamp_ms = INT64_MIN;
+    // 封存块中已写入块文件的前缀长度
+    size_t persisted_chunks = 0;
+    // 未落盘的封存块与头块中样本的最小日志序号，重放需从这里开始
+    std::vector<uint64_t> sealed_sequences;
+    uint64_t head_sequence = kNoSequence;
+    uint64_t backfill_sequence = kNoSequence;
+    // 与 rollup_tiers_ 一一对应，创建后不再增删
+    std::vector<RollupSeries> rollups;
+  };
+
+  struct Host {
+    std::unordered_map<uint32_t, std::shared_ptr<Series>> series;
+  };
+
+  struct alignas(64) Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, Host> hosts;
+  };
+
+  struct BlockInfo {
+    std::string path;
+    // 其中所有块都超出各自保留期的时间
+    int64_t expires_ms = 0;
+  };
+
+  // 报告中一个样本要写入的序列；series 为空表示该样本不写入
+  struct AppendTarget {
+    uint32_t id = SeriesStore::kInvalidSeries;
+    std::shared_ptr<Series> series;
+  };
+
+  Shard& ShardFor(const std::string& host_id) const;
+  size_t AppendReport(const systeminsight::proto::MetricsReport& report, uint64_t sequence);
+  // 调用方持有 shard->mutex；按样本顺序把目标序列追加到 targets
+  void ResolveLocked(Shard* shard, const systeminsight::proto::MetricsReport& report,
+                     std::vector<AppendTarget>* targets);
+  // 不持分片锁；targets 与报告的样本一一对应
+  size_t AppendResolved(const systeminsight::proto::MetricsReport& report,
+                        const AppendTarget* targets, uint64_t sequence);
+  // 超出内存预算时返回 nullptr
+  std::shared_ptr<Series> FindOrCreateSeries(Host* host, uint32_t id);
+  // 调用方持有 series->mutex
+  void AppendPoint(Series* series, int64_t timestamp_ms, double value, uint64_t sequence);
+  // 写入早于最新样本的补发点；超出保留期或时间戳已存在时返回 false。调用方持有 series->mutex
+  bool AppendBackfill(Series* series, int64_t timestamp_ms, double value, uint64_t sequence);
+  // 追加块列表中 [start_ms, end_ms] 内的点，按时间升序
+  static void ReadChunks(const ChunkList& chunks, int64_t start_ms, int64_t end_ms,
+                         PointBlock* out);
+  // 序列仍需要的最早日志序号；调用方持有 series.mutex
+  static uint64_t RetainedSequence(const Series& series);
+  std::string BlockPath(uint64_t id) const;
+  void LoadBlock(const std::string& path, int64_t now_ms);
+  // 由原始样本与更细一层补齐各层未落盘的部分
+  void RebuildRollups(const std::shared_ptr<Series>& series);
+  void RemoveExpiredBlocks(int64_t now_ms);
+  // 丢弃 max_time <= cutoff_ms 的封存块；返回释放的字节数。调用方持有 series->mutex
+  int64_t DropChunks(Series* series, int64_t cutoff_ms);
+  void EnforceBudget();
+  void HousekeepingLoop();
+
+  const TsdbOptions options_;
+  const int64_t chunk_range_ms_;
+  const std::vector<RollupTier> rollup_tiers_;
+  const size_t shard_count_;
+  std::shared_ptr<SeriesStore> series_store_;
+  std::unique_ptr<Shard[]> shards_;
+
+  std::atomic<int64_t> memory_bytes_{0};
+  std::atomic<size_t> series_count_{0};
+  std::atomic<uint64_t> out_of_order_total_{0};
+
+  // 写入持共享锁；Compact() 取检查点时持独占锁，等待已分配序号的写入完成
+  std::shared_mutex checkpoint_mutex_;
+  mutable std::mutex wal_mutex_;  // 保护 wal_ 的追加与序号
+  std::unique_ptr<common::storage::SegmentLog> wal_;
+  uint64_t wal_first_sequence_ = 0;  // 日志中最旧记录的序号
+  uint64_t wal_dropped_records_ = 0;  // 已计入 wal_first_sequence_ 的超限丢弃记录数
+  uint64_t next_sequence_ = 0;
+  mutable std::mutex compaction_mutex_;  // 串行化 Compact()，保护 blocks_
+  std::vector<BlockInfo> blocks_;
+  uint64_t next_block_id_ = 1;
+  std::atomic<int64_t> last_compaction_ms_{0};
+
+  std::mutex housekeeping_mutex_;
+  std::condition_variable housekeeping_cv_;
+  bool stopping_ = false;
+  std::thread housekeeping_thread_;
+};
+
+}  // namespace server
+}  // namespace system_insight
+
+#endif  // SYSTEM_INSIGHT_SERVER_TIME_SERIES_DB_H_
@@ -0,0 +1,64 @@
+#include "../src/client/adaptive_interval.h"
+
+#include <chrono>
+
+#include <gtest/gtest.h>
+
+using system_insight::client::ActivitySignals;
+using system_insight::client::AdaptiveInterval;
+using system_insight::client::AdaptiveIntervalOptions;
+using std::chrono::milliseconds;
+
+namespace {
+
+ActivitySignals Signals(double cpu, double net_bytes_per_sec) {
+  ActivitySignals signals;
+  signals.has_cpu = true;
+  signals.cpu_usage_percent = cpu;
+  signals.has_net = true;
+  signals.net_bytes_per_sec = net_bytes_per_sec;
+  return signals;
+}
+
+}  // namespace
+
+TEST(AdaptiveIntervalTest, BacksOffWhenIdleAndTightensOnChange) {
+  AdaptiveIntervalOptions options;
+  options.min_interval = milliseconds(1000);
+  options.max_interval = milliseconds(8000);
+  AdaptiveInterval interval(options, milliseconds(4000));
+
+  // 首个周期没有参考值，保持初值
+  EXPECT_EQ(interval.Update(Signals(2.0, 1000.0)), milliseconds(4000));
+  EXPECT_EQ(interval.Update(Signals(3.0, 2000.0)), milliseconds(5000));
+  for (int i = 0; i < 10; ++i) {
+    interval.Update(Signals(3.0, 2000.0));
+  }
+  EXPECT_EQ(interval.current(), milliseconds(8000));
+
+  // CPU 突变：每个活跃周期减半，直到下限
+  EXPECT_EQ(interval.Update(Signals(60.0, 2000.0)), milliseconds(4000));
+  EXPECT_EQ(interval.Update(Signals(10.0, 2000.0)), milliseconds(2000));
+  EXPECT_EQ(interval.Update(Signals(90.0, 2000.0)), milliseconds(1000));
+  EXPECT_EQ(interval.Update(Signals(20.0, 2000.0)), milliseconds(1000));
+}
+
+TEST(AdaptiveIntervalTest, RateChangesUseRelativeThresholdAboveFloor) {
+  AdaptiveIntervalOptions options;
+  options.min_interval = milliseconds(1000);
+  options.max_interval = milliseconds(30000);
+  AdaptiveInterval interval(options, milliseconds(8000));
+  interval.Update(Signals(5.0, 10.0 * 1024 * 1024));
+
+  // 低于下限的小流量抖动不算活跃
+  EXPECT_EQ(interval.Update(Signals(5.0, 1024.0)), milliseconds(4000));
+  EXPECT_EQ(interval.Update(Signals(5.0, 20.0 * 1024)), milliseconds(5000));
+  // 网络速率翻倍以上
+  EXPECT_EQ(interval.Update(Signals(5.0, 1024.0 * 1024)), milliseconds(2500));
+
+  // 缺少某个信号时不参与判断
+  ActivitySignals no_net;
+  no_net.has_cpu = true;
+  no_net.cpu_usage_percent = 5.0;
+  EXPECT_EQ(interval.Update(no_net), milliseconds(3125));
+}
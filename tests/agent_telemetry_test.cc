@@ -0,0 +1,73 @@
+#include "../src/client/agent_telemetry.h"
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using system_insight::client::AgentTelemetry;
+using system_insight::client::ScopedCollectorTimer;
+using systeminsight::proto::MetricsReport;
+
+TEST(AgentTelemetryTest, ExportsCumulativeBucketsFromLogLinearHistogram) {
+  AgentTelemetry telemetry;
+  // 300 落在 [288, 320) 桶；1000 落在 [960, 1024) 桶，整体不超过 1024；
+  // 1030 所在的 [1024, 1152) 跨越 1024，计入下一个上界
+  for (size_t bytes : {300, 1000, 1030, 5000000}) {
+    telemetry.RecordPayloadBytes(bytes);
+  }
+  MetricsReport report;
+  telemetry.AppendSamples(1, &report);
+
+  std::vector<std::pair<std::string, double>> buckets;
+  for (const auto& sample : report.samples()) {
+    if (sample.name() != "system_insight.agent.report_bytes_bucket") continue;
+    ASSERT_EQ(sample.labels_size(), 1);
+    buckets.emplace_back(sample.labels(0).value(), sample.value());
+  }
+  const std::vector<std::pair<std::string, double>> expected = {
+      {"256", 0},    {"1024", 2},    {"4096", 3},    {"16384", 3},
+      {"65536", 3},  {"262144", 3},  {"1048576", 3}, {"+Inf", 4}};
+  EXPECT_EQ(buckets, expected);
+}
+
+TEST(AgentTelemetryTest, AppendsAgentSamples) {
+  AgentTelemetry telemetry;
+  MetricsReport collected;
+  {
+    ScopedCollectorTimer timer(&telemetry, AgentTelemetry::kCollectorMem, &collected);
+    collected.add_samples()->set_name("system.mem.usage_percent");
+    collected.add_samples()->set_name("system.mem.available_bytes");
+  }
+  telemetry.RecordPayloadBytes(300);
+  telemetry.RecordSend(true, std::chrono::milliseconds(3));
+  telemetry.RecordSend(false, std::chrono::milliseconds(0));
+
+  MetricsReport report;
+  telemetry.AppendSamples(1234, &report);
+
+  std::map<std::string, double> values;
+  for (const auto& sample : report.samples()) {
+    EXPECT_EQ(sample.timestamp_ms(), 1234);
+    std::string key = sample.name();
+    for (const auto& label : sample.labels()) {
+      key += "{" + label.value() + "}";
+    }
+    values[key] = sample.value();
+  }
+  EXPECT_EQ(values["system_insight.agent.collector_samples_total{mem}"], 2.0);
+  EXPECT_EQ(values["system_insight.agent.collector_samples_total{cpu}"], 0.0);
+  EXPECT_GE(values["system_insight.agent.collector_wall_us_total{mem}"], 0.0);
+  EXPECT_EQ(values["system_insight.agent.report_bytes_bucket{256}"], 0.0);
+  EXPECT_EQ(values["system_insight.agent.report_bytes_bucket{1024}"], 1.0);
+  EXPECT_EQ(values["system_insight.agent.report_bytes_sum"], 300.0);
+  EXPECT_EQ(values["system_insight.agent.send_latency_us_bucket{2500}"], 0.0);
+  EXPECT_EQ(values["system_insight.agent.send_latency_us_bucket{5000}"], 1.0);
+  EXPECT_EQ(values["system_insight.agent.send_latency_us_bucket{+Inf}"], 1.0);
+  EXPECT_EQ(values["system_insight.agent.send_latency_us_count"], 1.0);
+  EXPECT_EQ(values["system_insight.agent.send_failures_total"], 1.0);
+  EXPECT_GT(values["system_insight.agent.rss_bytes"], 0.0);
+}
@@ -0,0 +1,215 @@
+#include "../src/server/async_metrics_server.h"
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "grpcpp/grpcpp.h"
+
+using system_insight::server::AsyncMetricsServer;
+using system_insight::server::AsyncServerOptions;
+using system_insight::server::IngestOptions;
+using system_insight::server::MetricsRepository;
+using system_insight::server::MetricsServiceImpl;
+using systeminsight::proto::MetricsReport;
+using systeminsight::proto::ReportAck;
+using systeminsight::proto::SystemInsightService;
+
+namespace {
+
+MetricsReport MakeReport(const std::string& host_id, int64_t timestamp_ms, uint64_t sequence) {
+  MetricsReport report;
+  report.set_host_id(host_id);
+  report.set_sequence(sequence);
+  auto* sample = report.add_samples();
+  sample->set_name("cpu_usage");
+  sample->set_value(0.5);
+  sample->set_timestamp_ms(timestamp_ms);
+  return report;
+}
+
+class AsyncMetricsServerTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    repository_ = std::make_shared<MetricsRepository>();
+    service_ = std::make_unique<MetricsServiceImpl>(repository_, 4, nullptr, nullptr, ingest_);
+    async_server_ = std::make_unique<AsyncMetricsServer>(
+        service_.get(), AsyncServerOptions{2, false, 2});
+
+    grpc::ServerBuilder builder;
+    int port = 0;
+    builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+    async_server_->Register(&builder);
+    server_ = builder.BuildAndStart();
+    ASSERT_NE(server_, nullptr);
+    async_server_->Start();
+
+    stub_ = SystemInsightService::NewStub(grpc::CreateChannel(
+        "127.0.0.1:" + std::to_string(port), grpc::InsecureChannelCredentials()));
+  }
+
+  void TearDown() override {
+    if (server_) {
+      server_->Shutdown();
+    }
+    service_->StopIngest();
+    async_server_->Stop();
+  }
+
+  IngestOptions ingest_;
+  std::shared_ptr<MetricsRepository> repository_;
+  std::unique_ptr<MetricsServiceImpl> service_;
+  std::unique_ptr<AsyncMetricsServer> async_server_;
+  std::unique_ptr<grpc::Server> server_;
+  std::unique_ptr<SystemInsightService::Stub> stub_;
+};
+
+TEST_F(AsyncMetricsServerTest, AppliesUnaryReports) {
+  EXPECT_EQ(async_server_->queue_count(), 2u);
+  // 超过每个队列预挂的请求数，验证调用到达后会重新挂起
+  for (int i = 0; i < 10; ++i) {
+    grpc::ClientContext context;
+    ReportAck ack;
+    const auto status = stub_->SendMetrics(
+        &context, MakeReport("host-" + std::to_string(i), 1000, 0), &ack);
+    ASSERT_TRUE(status.ok()) << status.error_message();
+    EXPECT_TRUE(ack.ok());
+    EXPECT_GT(ack.supported_encodings_size(), 0);
+  }
+  EXPECT_EQ(repository_->Snapshot().size(), 10u);
+}
+
+TEST_F(AsyncMetricsServerTest, StreamsReportsWithCredits) {
+  grpc::ClientContext context;
+  auto stream = stub_->StreamMetrics(&context);
+  ReportAck handshake;
+  ASSERT_TRUE(stream->Read(&handshake));
+  EXPECT_TRUE(handshake.ok());
+  EXPECT_EQ(handshake.credits(), 4u);
+
+  for (uint64_t sequence = 1; sequence <= 3; ++sequence) {
+    ASSERT_TRUE(stream->Write(MakeReport("streamer", 1000 * sequence, sequence)));
+    ReportAck ack;
+    ASSERT_TRUE(stream->Read(&ack));
+    EXPECT_TRUE(ack.ok());
+    EXPECT_EQ(ack.acked_sequence(), sequence);
+    EXPECT_EQ(ack.credits(), 1u);
+  }
+  stream->WritesDone();
+  EXPECT_TRUE(stream->Finish().ok());
+
+  const auto hosts = repository_->Snapshot();
+  ASSERT_EQ(hosts.size(), 1u);
+  EXPECT_EQ(hosts[0]->timestamps_ms[0], 3000);
+}
+
+TEST_F(AsyncMetricsServerTest, ServesConcurrentStreams) {
+  std::vector<std::thread> agents;
+  for (int a = 0; a < 8; ++a) {
+    agents.emplace_back([this, a] {
+      grpc::ClientContext context;
+      auto stream = stub_->StreamMetrics(&context);
+      ReportAck ack;
+      if (!stream->Read(&ack)) return;
+      for (uint64_t sequence = 1; sequence <= 20; ++sequence) {
+        if (!stream->Write(MakeReport("agent-" + std::to_string(a), 1000 * sequence, sequence)) ||
+            !stream->Read(&ack)) {
+          return;
+        }
+      }
+      stream->WritesDone();
+      stream->Finish();
+    });
+  }
+  for (auto& agent : agents) agent.join();
+  EXPECT_EQ(repository_->Snapshot().size(), 8u);
+}
+
+TEST_F(AsyncMetricsServerTest, RejectsDeltaReportsUntilFullReport) {
+  auto send = [&](bool delta, int64_t timestamp_ms) {
+    grpc::ClientContext context;
+    auto report = MakeReport("restarted", timestamp_ms, 0);
+    report.set_delta(delta);
+    ReportAck ack;
+    EXPECT_TRUE(stub_->SendMetrics(&context, report, &ack).ok());
+    return ack;
+  };
+
+  // 服务端没有该主机的完整状态，delta 报告不入库并要求完整报告
+  const auto rejected = send(true, 1000);
+  EXPECT_FALSE(rejected.ok());
+  EXPECT_TRUE(rejected.need_full_report());
+  EXPECT_TRUE(repository_->Snapshot().empty());
+
+  EXPECT_TRUE(send(false, 2000).ok());
+  const auto accepted = send(true, 3000);
+  EXPECT_TRUE(accepted.ok());
+  EXPECT_FALSE(accepted.need_full_report());
+}
+
+TEST_F(AsyncMetricsServerTest, QueryRangeWithoutStorageIsUnavailable) {
+  grpc::ClientContext context;
+  systeminsight::proto::QueryRangeRequest request;
+  request.set_metric_name("cpu_usage");
+  systeminsight::proto::QueryRangeResponse response;
+  const auto status = stub_->QueryRange(&context, request, &response);
+  EXPECT_EQ(status.error_code(), grpc::StatusCode::UNAVAILABLE);
+}
+
+// 报告由应用线程成批写入，写入后才确认
+class DurableIngestTest : public AsyncMetricsServerTest {
+ protected:
+  DurableIngestTest() {
+    ingest_.applier_threads = 2;
+    ingest_.durable_ack = true;
+  }
+};
+
+TEST_F(DurableIngestTest, AcksUnaryReportsAfterCommit) {
+  for (int i = 0; i < 10; ++i) {
+    grpc::ClientContext context;
+    ReportAck ack;
+    ASSERT_TRUE(stub_->SendMetrics(&context, MakeReport("host-" + std::to_string(i), 1000, 0),
+                                   &ack)
+                    .ok());
+    EXPECT_TRUE(ack.ok());
+    EXPECT_EQ(repository_->Snapshot().size(), static_cast<size_t>(i + 1));
+  }
+}
+
+TEST_F(DurableIngestTest, AcksStreamReportsAfterCommit) {
+  grpc::ClientContext context;
+  auto stream = stub_->StreamMetrics(&context);
+  ReportAck handshake;
+  ASSERT_TRUE(stream->Read(&handshake));
+  for (uint64_t sequence = 1; sequence <= 5; ++sequence) {
+    ASSERT_TRUE(stream->Write(MakeReport("streamer", 1000 * sequence, sequence)));
+    ReportAck ack;
+    ASSERT_TRUE(stream->Read(&ack));
+    EXPECT_TRUE(ack.ok());
+    EXPECT_EQ(ack.acked_sequence(), sequence);
+    const auto hosts = repository_->Snapshot();
+    ASSERT_EQ(hosts.size(), 1u);
+    EXPECT_EQ(hosts[0]->timestamps_ms[0], static_cast<int64_t>(1000 * sequence));
+  }
+  stream->WritesDone();
+  EXPECT_TRUE(stream->Finish().ok());
+}
+
+TEST_F(AsyncMetricsServerTest, StopsWithOpenStream) {
+  grpc::ClientContext context;
+  auto stream = stub_->StreamMetrics(&context);
+  ReportAck handshake;
+  ASSERT_TRUE(stream->Read(&handshake));
+  // 服务端关闭时取消仍在进行的流，轮询线程随后退出
+  server_->Shutdown(std::chrono::system_clock::now());
+  async_server_->Stop();
+  server_.reset();
+  ReportAck ack;
+  EXPECT_FALSE(stream->Read(&ack));
+}
+
+}  // namespace
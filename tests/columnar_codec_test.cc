@@ -0,0 +1,94 @@
+#include "../src/common/codec/columnar_codec.h"
+
+#include <gtest/gtest.h>
+
+using system_insight::common::codec::ColumnarDecoder;
+using system_insight::common::codec::ColumnarEncoder;
+using systeminsight::proto::MetricSample;
+using systeminsight::proto::MetricsReport;
+
+namespace {
+
+MetricsReport MakeReport(double base_value, int64_t timestamp_ms, int cores) {
+  MetricsReport report;
+  report.set_host_id("unit-test");
+  auto* total = report.add_samples();
+  total->set_name("system.cpu.usage_percent");
+  total->set_value(base_value);
+  total->set_timestamp_ms(timestamp_ms);
+  for (int i = 0; i < cores; ++i) {
+    auto* sample = report.add_samples();
+    sample->set_name("system.cpu.core.usage_percent");
+    sample->set_value(base_value + i * 0.25);
+    sample->set_timestamp_ms(timestamp_ms + (i % 2));
+    auto* label = sample->add_labels();
+    label->set_key("core");
+    label->set_value("cpu" + std::to_string(i));
+  }
+  return report;
+}
+
+void ExpectSameSamples(const MetricsReport& expected, const MetricsReport& actual) {
+  ASSERT_EQ(expected.samples_size(), actual.samples_size());
+  for (int i = 0; i < expected.samples_size(); ++i) {
+    const MetricSample& lhs = expected.samples(i);
+    const MetricSample& rhs = actual.samples(i);
+    EXPECT_EQ(lhs.name(), rhs.name());
+    EXPECT_EQ(lhs.value(), rhs.value());
+    EXPECT_EQ(lhs.timestamp_ms(), rhs.timestamp_ms());
+    ASSERT_EQ(lhs.labels_size(), rhs.labels_size());
+    for (int j = 0; j < lhs.labels_size(); ++j) {
+      EXPECT_EQ(lhs.labels(j).key(), rhs.labels(j).key());
+      EXPECT_EQ(lhs.labels(j).value(), rhs.labels(j).value());
+    }
+  }
+}
+
+}  // namespace
+
+TEST(ColumnarCodecTest, RoundTripsAcrossReportsAndLayoutChanges) {
+  for (auto encoding : {systeminsight::proto::REPORT_ENCODING_COLUMNAR,
+                        systeminsight::proto::REPORT_ENCODING_COLUMNAR_XOR}) {
+    ColumnarEncoder encoder(encoding);
+    ColumnarDecoder decoder;
+    // 第三份报告的布局发生变化（核数减少）
+    const int cores[] = {8, 8, 4, 4};
+    for (int round = 0; round < 4; ++round) {
+      MetricsReport original = MakeReport(10.0 + round * 0.5, 1000 + round * 5000, cores[round]);
+      MetricsReport wire = original;
+      encoder.Encode(&wire);
+      EXPECT_EQ(wire.samples_size(), 0);
+      EXPECT_EQ(wire.columnar().reuse_layout(), round == 1 || round == 3);
+
+      MetricsReport decoded;
+      ASSERT_TRUE(decoded.ParseFromString(wire.SerializeAsString()));
+      ASSERT_EQ(decoder.Decode(&decoded), ColumnarDecoder::Status::kOk);
+      ExpectSameSamples(original, decoded);
+    }
+  }
+}
+
+TEST(ColumnarCodecTest, RequestsKeyframeWhenBaseIsMissing) {
+  ColumnarEncoder encoder(systeminsight::proto::REPORT_ENCODING_COLUMNAR_XOR);
+  ColumnarDecoder decoder;
+
+  MetricsReport first = MakeReport(1.0, 1000, 2);
+  encoder.Encode(&first);
+  ASSERT_EQ(decoder.Decode(&first), ColumnarDecoder::Status::kOk);
+
+  // 第二份报告在传输中丢失
+  MetricsReport lost = MakeReport(2.0, 2000, 2);
+  encoder.Encode(&lost);
+
+  MetricsReport third = MakeReport(3.0, 3000, 2);
+  encoder.Encode(&third);
+  EXPECT_EQ(decoder.Decode(&third), ColumnarDecoder::Status::kMissingBase);
+
+  encoder.Reset();
+  MetricsReport original = MakeReport(3.0, 3000, 2);
+  MetricsReport keyframe = original;
+  encoder.Encode(&keyframe);
+  EXPECT_EQ(keyframe.columnar().base_sequence(), 0u);
+  ASSERT_EQ(decoder.Decode(&keyframe), ColumnarDecoder::Status::kOk);
+  ExpectSameSamples(original, keyframe);
+}
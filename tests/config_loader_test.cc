@@ -1,7 +1,10 @@
 #include "../src/common/config/config_loader.h"
 
+#include <unistd.h>
+
 #include <filesystem>
 #include <fstream>
+#include <string>
 
 #include <gtest/gtest.h>
 
@@ -13,8 +16,12 @@ using system_insight::common::config::ServerConfig;
 
 class TempFile {
  public:
+  // 每个用例在独立进程中运行，文件名带上进程号与用例名，避免并行运行时互相覆盖
   TempFile() {
-    path_ = fs::temp_directory_path() / fs::path("system_insight_test.json");
+    const auto* test = ::testing::UnitTest::GetInstance()->current_test_info();
+    path_ = fs::temp_directory_path() /
+            fs::path("system_insight_test_" + std::to_string(::getpid()) + "_" + test->name() +
+                     ".json");
   }
   ~TempFile() { std::error_code ec; fs::remove(path_, ec); }
 
@@ -64,3 +71,304 @@ TEST(ConfigLoaderTest, ParsesServerExporterConfig) {
   EXPECT_EQ(config.prometheus_http_port, 9200);
 }
 
+TEST(ConfigLoaderTest, ParsesReportEncoding) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"client\": {\n"
+         "    \"report_encoding\": \"columnar\"\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ClientConfig config = LoadClientConfig(temp.path());
+  EXPECT_EQ(config.report_encoding, "columnar");
+}
+
+TEST(ConfigLoaderTest, ParsesClientStreamingConfig) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"client\": {\n"
+         "    \"use_streaming\": false,\n"
+         "    \"stream_reconnect_backoff_min_ms\": 100,\n"
+         "    \"stream_reconnect_backoff_max_ms\": 2000\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ClientConfig config = LoadClientConfig(temp.path());
+  EXPECT_FALSE(config.use_streaming);
+  EXPECT_EQ(config.stream_reconnect_backoff_min_ms, 100);
+  EXPECT_EQ(config.stream_reconnect_backoff_max_ms, 2000);
+  EXPECT_EQ(config.stream_credit_wait_ms, 5000);
+}
+
+TEST(ConfigLoaderTest, ParsesServerStreamCredits) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"server\": {\n"
+         "    \"stream_initial_credits\": 16\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ServerConfig config = LoadServerConfig(temp.path());
+  EXPECT_EQ(config.stream_initial_credits, 16);
+}
+
+TEST(ConfigLoaderTest, ParsesSendQueueConfig) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"client\": {\n"
+         "    \"send_queue_capacity\": 16,\n"
+         "    \"send_queue_overflow_policy\": \"coalesce\",\n"
+         "    \"max_in_flight\": 2\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ClientConfig config = LoadClientConfig(temp.path());
+  EXPECT_EQ(config.send_queue_capacity, 16);
+  EXPECT_EQ(config.send_queue_overflow_policy, "coalesce");
+  EXPECT_EQ(config.max_in_flight, 2);
+  EXPECT_EQ(config.send_timeout_ms, 5000);
+}
+
+TEST(ConfigLoaderTest, ParsesSpoolConfig) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"client\": {\n"
+         "    \"spool_directory\": \"/data/spool\",\n"
+         "    \"spool_max_mb\": 8,\n"
+         "    \"replay_max_reports_per_second\": 50\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ClientConfig config = LoadClientConfig(temp.path());
+  EXPECT_EQ(config.spool_directory, "/data/spool");
+  EXPECT_EQ(config.spool_max_mb, 8);
+  EXPECT_EQ(config.replay_max_reports_per_second, 50);
+}
+
+TEST(ConfigLoaderTest, ParsesSampleInterval) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"client\": {\n"
+         "    \"sample_interval_ms\": 100\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ClientConfig config = LoadClientConfig(temp.path());
+  EXPECT_EQ(config.sample_interval_ms, 100);
+}
+
+TEST(ConfigLoaderTest, ParsesDeadbandConfig) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"client\": {\n"
+         "    \"deadband_enabled\": true,\n"
+         "    \"deadband_relative\": 0.05\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ClientConfig config = LoadClientConfig(temp.path());
+  EXPECT_TRUE(config.deadband_enabled);
+  EXPECT_DOUBLE_EQ(config.deadband_relative, 0.05);
+  EXPECT_DOUBLE_EQ(config.deadband_absolute, 0.0);
+  EXPECT_EQ(config.deadband_max_silence_ms, 60000);
+}
+
+TEST(ConfigLoaderTest, ParsesAdaptiveIntervalConfig) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"client\": {\n"
+         "    \"adaptive_interval_enabled\": true,\n"
+         "    \"max_collection_interval_ms\": 60000\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ClientConfig config = LoadClientConfig(temp.path());
+  EXPECT_TRUE(config.adaptive_interval_enabled);
+  EXPECT_EQ(config.min_collection_interval_ms, 1000);
+  EXPECT_EQ(config.max_collection_interval_ms, 60000);
+}
+
+TEST(ConfigLoaderTest, ParsesShmIngestionConfig) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"client\": {\n"
+         "    \"shm_ingestion_enabled\": true\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ClientConfig config = LoadClientConfig(temp.path());
+  EXPECT_TRUE(config.shm_ingestion_enabled);
+  EXPECT_EQ(config.shm_directory, "/dev/shm");
+}
+
+TEST(ConfigLoaderTest, ParsesTextfileDirectory) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"client\": {\n"
+         "    \"textfile_directory\": \"/var/lib/node_exporter\"\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ClientConfig config = LoadClientConfig(temp.path());
+  EXPECT_EQ(config.textfile_directory, "/var/lib/node_exporter");
+}
+
+TEST(ConfigLoaderTest, ParsesFilesystemCollectorConfig) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"client\": {\n"
+         "    \"filesystem_include_fstypes\": [\"ext4\", \"xfs\"]\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ClientConfig config = LoadClientConfig(temp.path());
+  EXPECT_FALSE(config.filesystem_enabled);
+  EXPECT_EQ(config.filesystem_include_fstypes, std::vector<std::string>({"ext4", "xfs"}));
+  EXPECT_TRUE(config.filesystem_exclude_fstypes.empty());
+  EXPECT_EQ(config.filesystem_network_spread_cycles, 4);
+}
+
+TEST(ConfigLoaderTest, ParsesCpufreqConfig) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"client\": {\n"
+         "    \"cpufreq_enabled\": true\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ClientConfig config = LoadClientConfig(temp.path());
+  EXPECT_TRUE(config.cpufreq_enabled);
+}
+
+TEST(ConfigLoaderTest, ParsesExtendedMemoryConfig) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"client\": {\n"
+         "    \"extended_memory_enabled\": true,\n"
+         "    \"memory_vmstat_keys\": [\"pgfault\"]\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ClientConfig config = LoadClientConfig(temp.path());
+  EXPECT_TRUE(config.extended_memory_enabled);
+  EXPECT_TRUE(config.memory_meminfo_keys.empty());
+  EXPECT_EQ(config.memory_vmstat_keys, std::vector<std::string>({"pgfault"}));
+}
+
+TEST(ConfigLoaderTest, ParsesTsdbConfig) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"server\": {\n"
+         "    \"tsdb_retention_seconds\": 600\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ServerConfig config = LoadServerConfig(temp.path());
+  EXPECT_TRUE(config.tsdb_enabled);
+  EXPECT_EQ(config.tsdb_retention_seconds, 600);
+  EXPECT_EQ(config.tsdb_memory_budget_mb, 256);
+}
+
+TEST(ConfigLoaderTest, ParsesQueryThreads) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"server\": {\n"
+         "    \"query_threads\": 4\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ServerConfig config = LoadServerConfig(temp.path());
+  EXPECT_EQ(config.query_threads, 4);
+}
+
+TEST(ConfigLoaderTest, ParsesTsdbPersistenceConfig) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"server\": {\n"
+         "    \"tsdb_data_directory\": \"/data/tsdb\"\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ServerConfig config = LoadServerConfig(temp.path());
+  EXPECT_EQ(config.tsdb_data_directory, "/data/tsdb");
+  EXPECT_EQ(config.tsdb_compaction_interval_seconds, 300);
+}
+
+TEST(ConfigLoaderTest, ParsesTsdbRollupConfig) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"server\": {\n"
+         "    \"tsdb_rollup_1h_retention_days\": 0\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ServerConfig config = LoadServerConfig(temp.path());
+  EXPECT_EQ(config.tsdb_rollup_1m_retention_hours, 168);
+  EXPECT_EQ(config.tsdb_rollup_1h_retention_days, 0);
+}
+
+TEST(ConfigLoaderTest, ParsesGrpcServingConfig) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"server\": {\n"
+         "    \"grpc_completion_queues\": 4,\n"
+         "    \"grpc_pin_pollers\": false\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ServerConfig config = LoadServerConfig(temp.path());
+  EXPECT_EQ(config.grpc_completion_queues, 4);
+  EXPECT_FALSE(config.grpc_pin_pollers);
+}
+
+TEST(ConfigLoaderTest, ParsesIngestPipelineConfig) {
+  TempFile temp;
+  std::ofstream out(temp.path());
+  out << "{\n"
+         "  \"server\": {\n"
+         "    \"ingest_durable_ack\": true\n"
+         "  }\n"
+         "}\n";
+  out.close();
+
+  ServerConfig config = LoadServerConfig(temp.path());
+  EXPECT_EQ(config.ingest_applier_threads, 2);
+  EXPECT_EQ(config.ingest_queue_capacity, 4096);
+  EXPECT_TRUE(config.ingest_durable_ack);
+}
@@ -0,0 +1,96 @@
+#include "../src/client/metrics/cpufreq_collector.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace fs = std::filesystem;
+using system_insight::client::CpuFreqCollector;
+using system_insight::client::CpuFreqCollectorOptions;
+using systeminsight::proto::MetricsReport;
+
+namespace {
+
+class CpuFreqCollectorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    root_ = fs::temp_directory_path() / ("system_insight_sysfs_" + std::to_string(::getpid()));
+    fs::remove_all(root_);
+  }
+  void TearDown() override { fs::remove_all(root_); }
+
+  void Write(const std::string& relative, const std::string& content) {
+    fs::path path = root_ / relative;
+    fs::create_directories(path.parent_path());
+    std::ofstream(path) << content;
+  }
+
+  // 以 name{label,...} 为键
+  static std::map<std::string, double> Values(const MetricsReport& report) {
+    std::map<std::string, double> values;
+    for (const auto& sample : report.samples()) {
+      std::string key = sample.name();
+      for (const auto& label : sample.labels()) {
+        key += "{" + label.value() + "}";
+      }
+      values[key] = sample.value();
+    }
+    return values;
+  }
+
+  fs::path root_;
+};
+
+}  // namespace
+
+TEST_F(CpuFreqCollectorTest, ReadsFrequencyThrottleAndThermalZones) {
+  for (int cpu : {0, 1, 10}) {
+    const std::string dir = "devices/system/cpu/cpu" + std::to_string(cpu) + "/";
+    Write(dir + "cpufreq/scaling_cur_freq", std::to_string(2000000 + cpu * 1000) + "\n");
+    Write(dir + "thermal_throttle/core_throttle_count", std::to_string(cpu) + "\n");
+    Write(dir + "thermal_throttle/package_throttle_count", "7\n");
+    Write(dir + "topology/physical_package_id", "0\n");
+  }
+  Write("devices/system/cpu/cpufreq/policy0/scaling_cur_freq", "1\n");  // 不是 cpuN 目录
+  Write("class/thermal/thermal_zone0/type", "x86_pkg_temp\n");
+  Write("class/thermal/thermal_zone0/temp", "45000\n");
+  Write("class/thermal/thermal_zone1/type", "acpitz\n");
+  Write("class/thermal/thermal_zone1/temp", "-5000\n");
+
+  CpuFreqCollectorOptions options;
+  options.sysfs_root = root_.string();
+  CpuFreqCollector collector(options);
+  EXPECT_EQ(collector.attribute_count(), 3u * 2u + 1u + 2u);
+
+  MetricsReport report;
+  collector.Collect(&report);
+  auto values = Values(report);
+  EXPECT_EQ(values.size(), 9u);
+  EXPECT_DOUBLE_EQ(values["system.cpu.core.frequency_hz{cpu0}"], 2.0e9);
+  EXPECT_DOUBLE_EQ(values["system.cpu.core.frequency_hz{cpu10}"], 2.01e9);
+  EXPECT_DOUBLE_EQ(values["system.cpu.core.throttle_total{cpu1}"], 1.0);
+  EXPECT_DOUBLE_EQ(values["system.cpu.package.throttle_total{0}"], 7.0);
+  EXPECT_DOUBLE_EQ(values["system.thermal.zone.temperature_celsius{0}{x86_pkg_temp}"], 45.0);
+  EXPECT_DOUBLE_EQ(values["system.thermal.zone.temperature_celsius{1}{acpitz}"], -5.0);
+
+  // 常驻的 fd 每个周期从头重读，能看到新值
+  Write("devices/system/cpu/cpu0/cpufreq/scaling_cur_freq", "800000\n");
+  report.Clear();
+  collector.Collect(&report);
+  EXPECT_DOUBLE_EQ(Values(report)["system.cpu.core.frequency_hz{cpu0}"], 8.0e8);
+}
+
+TEST_F(CpuFreqCollectorTest, MissingSysfsYieldsNoSamples) {
+  CpuFreqCollectorOptions options;
+  options.sysfs_root = root_.string();
+  CpuFreqCollector collector(options);
+  MetricsReport report;
+  collector.Collect(&report);
+  EXPECT_EQ(collector.attribute_count(), 0u);
+  EXPECT_EQ(report.samples_size(), 0);
+}
@@ -0,0 +1,106 @@
+#include "../src/client/deadband_filter.h"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using system_insight::client::DeadbandFilter;
+using system_insight::client::DeadbandOptions;
+using systeminsight::proto::MetricsReport;
+
+namespace {
+
+MetricsReport MakeReport(const std::vector<double>& values) {
+  MetricsReport report;
+  for (size_t i = 0; i < values.size(); ++i) {
+    auto* sample = report.add_samples();
+    sample->set_name("series" + std::to_string(i));
+    sample->set_value(values[i]);
+  }
+  return report;
+}
+
+std::vector<std::string> Names(const MetricsReport& report) {
+  std::vector<std::string> names;
+  for (const auto& sample : report.samples()) {
+    names.push_back(sample.name());
+  }
+  return names;
+}
+
+}  // namespace
+
+TEST(DeadbandFilterTest, SuppressesSamplesWithinThreshold) {
+  DeadbandOptions options;
+  options.absolute = 1.0;
+  options.relative = 0.1;
+  options.max_silence = std::chrono::milliseconds(60000);
+  DeadbandFilter filter(options);
+  auto now = std::chrono::steady_clock::now();
+
+  auto first = MakeReport({10.0, 100.0, 0.0});
+  filter.Filter(&first, now);
+  EXPECT_FALSE(first.delta());
+  EXPECT_EQ(first.samples_size(), 3);
+
+  // series0: |0.5| <= 1.0；series1: |9| <= 10% * 100；series2: |2| > 1.0
+  auto second = MakeReport({10.5, 109.0, 2.0});
+  filter.Filter(&second, now + std::chrono::seconds(1));
+  EXPECT_TRUE(second.delta());
+  EXPECT_EQ(Names(second), std::vector<std::string>({"series2"}));
+
+  // 与上次“发送”的值比较，缓慢漂移累计超过阈值后才发送
+  auto third = MakeReport({11.5, 111.0, 2.0});
+  filter.Filter(&third, now + std::chrono::seconds(2));
+  EXPECT_EQ(Names(third), std::vector<std::string>({"series0", "series1"}));
+  EXPECT_DOUBLE_EQ(third.samples(1).value(), 111.0);
+  EXPECT_EQ(filter.suppressed_total(), 3u);
+}
+
+TEST(DeadbandFilterTest, SendsNewSeriesAndPeriodicFullReports) {
+  DeadbandOptions options;
+  options.max_silence = std::chrono::milliseconds(5000);
+  DeadbandFilter filter(options);
+  auto now = std::chrono::steady_clock::now();
+
+  auto first = MakeReport({1.0});
+  filter.Filter(&first, now);
+
+  auto second = MakeReport({1.0, 2.0});
+  filter.Filter(&second, now + std::chrono::seconds(1));
+  EXPECT_TRUE(second.delta());
+  EXPECT_EQ(Names(second), std::vector<std::string>({"series1"}));
+
+  auto unchanged = MakeReport({1.0, 2.0});
+  filter.Filter(&unchanged, now + std::chrono::seconds(2));
+  EXPECT_EQ(unchanged.samples_size(), 0);
+
+  auto heartbeat = MakeReport({1.0, 2.0});
+  filter.Filter(&heartbeat, now + std::chrono::seconds(5));
+  EXPECT_FALSE(heartbeat.delta());
+  EXPECT_EQ(heartbeat.samples_size(), 2);
+}
+
+TEST(DeadbandFilterTest, RequestFullSendsAllSeriesOnNextReport) {
+  DeadbandOptions options;
+  options.absolute = 1.0;
+  DeadbandFilter filter(options);
+  auto now = std::chrono::steady_clock::now();
+
+  auto first = MakeReport({1.0, 2.0});
+  filter.Filter(&first, now);
+
+  // 上一份报告丢失后，未变化的序列也要随完整报告重新发送
+  filter.RequestFull();
+  auto resync = MakeReport({1.0, 2.0});
+  filter.Filter(&resync, now + std::chrono::seconds(1));
+  EXPECT_FALSE(resync.delta());
+  EXPECT_EQ(resync.samples_size(), 2);
+
+  auto next = MakeReport({1.0, 2.0});
+  filter.Filter(&next, now + std::chrono::seconds(2));
+  EXPECT_TRUE(next.delta());
+  EXPECT_EQ(next.samples_size(), 0);
+}
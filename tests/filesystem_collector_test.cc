@@ -0,0 +1,91 @@
+#include "../src/client/metrics/filesystem_collector.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace fs = std::filesystem;
+using system_insight::client::FilesystemCollector;
+using system_insight::client::FilesystemCollectorOptions;
+using systeminsight::proto::MetricsReport;
+
+namespace {
+
+// 报告中出现的挂载点（只看 size_bytes）
+std::set<std::string> MountPoints(const MetricsReport& report) {
+  std::set<std::string> mount_points;
+  for (const auto& sample : report.samples()) {
+    if (sample.name() != "system.fs.size_bytes") continue;
+    for (const auto& label : sample.labels()) {
+      if (label.key() == "mountpoint") mount_points.insert(label.value());
+    }
+  }
+  return mount_points;
+}
+
+}  // namespace
+
+TEST(FilesystemCollectorTest, UnescapesOctalSequences) {
+  EXPECT_EQ(FilesystemCollector::Unescape("/mnt/with\\040space\\011tab"), "/mnt/with space\ttab");
+  EXPECT_EQ(FilesystemCollector::Unescape("/plain\\"), "/plain\\");
+}
+
+TEST(FilesystemCollectorTest, FiltersMountsAndSpreadsNetworkFilesystems) {
+  fs::path directory =
+      fs::temp_directory_path() / ("system_insight_fs_test_" + std::to_string(::getpid()));
+  fs::remove_all(directory);
+  fs::create_directories(directory / "with space");
+  fs::create_directories(directory / "nfs_a");
+  fs::create_directories(directory / "nfs_b");
+  const std::string base = directory.string();
+
+  fs::path mountinfo = directory / "mountinfo";
+  std::ofstream(mountinfo)
+      << "22 1 8:1 / / rw,relatime shared:1 - ext4 /dev/sda1 rw\n"
+      << "23 22 0:5 / /proc rw,nosuid - proc proc rw\n"
+      << "24 22 0:30 / /var/lib/docker/overlay2/abc/merged rw - overlay overlay rw\n"
+      << "25 22 0:31 / /var/lib/docker/volumes rw - ext4 /dev/sdb1 rw\n"
+      << "26 22 0:40 / " << base << "/with\\040space rw - tmpfs tmpfs rw\n"
+      << "27 22 0:41 / " << base << "/nfs_a rw shared:7 master:2 - nfs4 srv:/a rw\n"
+      << "28 22 0:42 / " << base << "/nfs_b rw - nfs srv:/b rw\n"
+      << "29 22 0:43 / " << base << "/missing rw - ext4 /dev/sdc1 rw\n";
+
+  FilesystemCollectorOptions options;
+  options.mountinfo_path = mountinfo.string();
+  options.network_spread_cycles = 2;
+  FilesystemCollector collector(options);
+
+  MetricsReport report;
+  collector.Collect(&report);
+  EXPECT_EQ(collector.mount_count(), 5u);
+  // 第一个周期只轮到一个网络文件系统；statvfs 失败的挂载点不上报
+  EXPECT_EQ(MountPoints(report),
+            (std::set<std::string>{"/", base + "/with space", base + "/nfs_a"}));
+  ASSERT_EQ(report.samples_size(), 15);
+  EXPECT_EQ(report.samples(0).labels(0).value(), "/dev/sda1");
+  EXPECT_EQ(report.samples(0).labels(1).value(), "ext4");
+
+  // 第二个周期轮到另一个，已采集过的沿用上次的值
+  report.Clear();
+  collector.Collect(&report);
+  EXPECT_EQ(MountPoints(report), (std::set<std::string>{"/", base + "/with space",
+                                                        base + "/nfs_a", base + "/nfs_b"}));
+
+  // 普通文件不会产生 POLLPRI，挂载表只在首次解析
+  EXPECT_EQ(collector.mountinfo_parses(), 1u);
+  fs::remove_all(directory);
+}
+
+TEST(FilesystemCollectorTest, ParsesMountinfoOnlyWhenMountTableChanges) {
+  FilesystemCollector collector{FilesystemCollectorOptions()};
+  MetricsReport report;
+  collector.Collect(&report);
+  collector.Collect(&report);
+  collector.Collect(&report);
+  EXPECT_EQ(collector.mountinfo_parses(), 1u);
+}
@@ -0,0 +1,209 @@
+#include "../src/server/ingest_pipeline.h"
+
+#include <unistd.h>
+
+#include <atomic>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using system_insight::common::codec::PooledReport;
+using system_insight::common::codec::ReportPool;
+using system_insight::server::IngestOptions;
+using system_insight::server::IngestPipeline;
+using system_insight::server::MetricsRepository;
+using system_insight::server::PointBlock;
+using system_insight::server::TimeSeriesDb;
+using system_insight::server::TsdbOptions;
+using systeminsight::proto::MetricsReport;
+
+namespace {
+
+constexpr int64_t kStartMs = 1'700'000'000'000;
+
+MetricsReport MakeReport(const std::string& host_id, int64_t timestamp_ms, double value) {
+  MetricsReport report;
+  report.set_host_id(host_id);
+  auto* sample = report.add_samples();
+  sample->set_name("cpu_usage");
+  sample->set_value(value);
+  sample->set_timestamp_ms(timestamp_ms);
+  return report;
+}
+
+class IngestPipelineTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    repository_ = std::make_shared<MetricsRepository>();
+    TsdbOptions options;
+    options.retention_ms = 24 * 3600 * 1000LL;
+    tsdb_ = std::make_shared<TimeSeriesDb>(options, repository_->shared_series_store());
+  }
+
+  size_t PointsFor(const std::string& host_id) const {
+    const uint32_t id = repository_->series_store().Find(MakeReport(host_id, 0, 0).samples(0));
+    PointBlock points;
+    tsdb_->Query(host_id, id, 0, INT64_MAX, &points);
+    return points.size();
+  }
+
+  PooledReport Pooled(const std::string& host_id, int64_t timestamp_ms, double value) {
+    auto report = pool_.Acquire();
+    report->report()->CopyFrom(MakeReport(host_id, timestamp_ms, value));
+    return report;
+  }
+
+  // 须比各用例中的流水线活得久
+  ReportPool pool_{4};
+  std::shared_ptr<MetricsRepository> repository_;
+  std::shared_ptr<TimeSeriesDb> tsdb_;
+};
+
+TEST_F(IngestPipelineTest, CommitsEveryReportInPerHostOrder) {
+  IngestOptions options;
+  options.applier_threads = 2;
+  options.max_batch = 3;
+  IngestPipeline pipeline(options, repository_, tsdb_);
+  for (int i = 0; i < 20; ++i) {
+    for (int h = 0; h < 5; ++h) {
+      EXPECT_EQ(pipeline.Submit(Pooled("host-" + std::to_string(h), kStartMs + i * 1000, i)),
+                IngestPipeline::SubmitResult::kQueued);
+    }
+  }
+  pipeline.Stop();
+  EXPECT_EQ(pipeline.committed_total(), 100u);
+
+  const auto hosts = repository_->Snapshot();
+  ASSERT_EQ(hosts.size(), 5u);
+  for (const auto& host : hosts) {
+    EXPECT_EQ(host->values[0], 19.0);
+    // 乱序应用会让时序库丢弃样本
+    EXPECT_EQ(PointsFor(host->host_id), 20u);
+  }
+  EXPECT_EQ(tsdb_->out_of_order_total(), 0u);
+}
+
+TEST_F(IngestPipelineTest, DurableCallbackRunsAfterCommit) {
+  IngestOptions options;
+  options.applier_threads = 1;
+  options.durable_ack = true;
+  IngestPipeline pipeline(options, repository_, tsdb_);
+  std::promise<size_t> committed;
+  auto future = committed.get_future();
+  EXPECT_EQ(pipeline.Submit(Pooled("durable", kStartMs, 1.0),
+                            [&] { committed.set_value(repository_->Snapshot().size()); }),
+            IngestPipeline::SubmitResult::kQueued);
+  EXPECT_EQ(future.get(), 1u);
+  EXPECT_EQ(PointsFor("durable"), 1u);
+}
+
+TEST_F(IngestPipelineTest, SyncsWalOncePerDurableBatch) {
+  const auto* test = ::testing::UnitTest::GetInstance()->current_test_info();
+  const auto directory =
+      std::filesystem::temp_directory_path() /
+      ("system_insight_ingest_" + std::to_string(::getpid()) + "_" + test->name());
+  std::filesystem::remove_all(directory);
+  TsdbOptions tsdb_options;
+  tsdb_options.retention_ms = 24 * 3600 * 1000LL;
+  tsdb_options.data_directory = directory.string();
+  tsdb_options.wal_sync = true;
+  tsdb_ = std::make_shared<TimeSeriesDb>(tsdb_options, repository_->shared_series_store());
+  ASSERT_TRUE(tsdb_->Open(nullptr));
+
+  IngestOptions options;
+  options.applier_threads = 1;
+  options.max_batch = 4;
+  options.durable_ack = true;
+  IngestPipeline pipeline(options, repository_, tsdb_);
+
+  // 第一份报告单独成批；应用线程停在它的回调里时，后续 8 份在队列中积累成两批
+  std::promise<void> entered;
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  ASSERT_EQ(pipeline.Submit(Pooled("host", kStartMs, 0.0),
+                            [&entered, released] {
+                              entered.set_value();
+                              released.wait();
+                            }),
+            IngestPipeline::SubmitResult::kQueued);
+  entered.get_future().wait();
+  // 确认回调只在日志落盘之后运行
+  EXPECT_EQ(tsdb_->wal_sync_count(), 1u);
+  for (int i = 1; i <= 8; ++i) {
+    ASSERT_EQ(pipeline.Submit(Pooled("host", kStartMs + i * 1000, i)),
+              IngestPipeline::SubmitResult::kQueued);
+  }
+  release.set_value();
+  pipeline.Stop();
+  EXPECT_EQ(pipeline.committed_total(), 9u);
+  EXPECT_EQ(tsdb_->wal_sync_count(), 3u);
+  tsdb_.reset();
+  std::filesystem::remove_all(directory);
+}
+
+TEST_F(IngestPipelineTest, RejectsWhenQueueIsFull) {
+  IngestOptions options;
+  options.applier_threads = 1;
+  options.queue_capacity = 1;
+  IngestPipeline pipeline(options, repository_, tsdb_);
+
+  // 让应用线程停在第一份报告的回调里，后续报告只能留在队列中
+  std::promise<void> entered;
+  std::promise<void> release;
+  auto released = release.get_future().share();
+  ASSERT_EQ(pipeline.Submit(Pooled("host", kStartMs, 1.0),
+                            [&entered, released] {
+                              entered.set_value();
+                              released.wait();
+                            }),
+            IngestPipeline::SubmitResult::kQueued);
+  entered.get_future().wait();
+
+  EXPECT_EQ(pipeline.Submit(Pooled("host", kStartMs + 1000, 2.0)),
+            IngestPipeline::SubmitResult::kQueued);
+  EXPECT_EQ(pipeline.Submit(Pooled("host", kStartMs + 2000, 3.0)),
+            IngestPipeline::SubmitResult::kRejected);
+  EXPECT_EQ(pipeline.rejected_total(), 1u);
+
+  release.set_value();
+  pipeline.Stop();
+  EXPECT_EQ(pipeline.committed_total(), 2u);
+  EXPECT_EQ(PointsFor("host"), 2u);
+}
+
+TEST_F(IngestPipelineTest, AppliesInlineWithoutAppliersOrAfterStop) {
+  IngestPipeline inline_pipeline(IngestOptions{}, repository_, tsdb_);
+  EXPECT_EQ(inline_pipeline.Submit(Pooled("inline", kStartMs, 1.0)),
+            IngestPipeline::SubmitResult::kApplied);
+  EXPECT_EQ(PointsFor("inline"), 1u);
+
+  IngestOptions options;
+  options.applier_threads = 1;
+  IngestPipeline pipeline(options, repository_, tsdb_);
+  pipeline.Stop();
+  EXPECT_EQ(pipeline.Submit(Pooled("stopped", kStartMs, 1.0)),
+            IngestPipeline::SubmitResult::kApplied);
+  EXPECT_EQ(PointsFor("stopped"), 1u);
+}
+
+TEST_F(IngestPipelineTest, ReturnsReportsToPoolAfterCommit) {
+  IngestOptions options;
+  options.applier_threads = 1;
+  options.durable_ack = true;
+  IngestPipeline pipeline(options, repository_, tsdb_);
+  std::promise<size_t> committed;
+  auto future = committed.get_future();
+  ASSERT_EQ(pool_.free_slots(), 0u);
+  ASSERT_EQ(pipeline.Submit(Pooled("pooled", kStartMs, 1.0),
+                            [&] { committed.set_value(pool_.free_slots()); }),
+            IngestPipeline::SubmitResult::kQueued);
+  // 回调运行前报告已归还，同一调用可以立即取到它
+  EXPECT_EQ(future.get(), 1u);
+  auto reused = pool_.Acquire();
+  EXPECT_EQ(reused->report()->samples_size(), 0);
+}
+
+}  // namespace
@@ -0,0 +1,180 @@
+#include "../src/server/label_index.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../src/server/series_store.h"
+
+using system_insight::server::GallopGe;
+using system_insight::server::IndexMatcher;
+using system_insight::server::LabelIndex;
+using system_insight::server::PostingList;
+using system_insight::server::SeriesStore;
+using systeminsight::proto::MetricSample;
+
+namespace {
+
+IndexMatcher MakeMatcher(const std::string& key, const std::string& value,
+                         IndexMatcher::Type type = IndexMatcher::Type::kEqual) {
+  IndexMatcher matcher;
+  matcher.key = key;
+  matcher.value = value;
+  matcher.type = type;
+  if (type == IndexMatcher::Type::kRegex || type == IndexMatcher::Type::kNotRegex) {
+    matcher.regex = std::regex(value);
+  }
+  return matcher;
+}
+
+MetricSample MakeSample(const std::string& name,
+                        const std::vector<std::pair<std::string, std::string>>& labels) {
+  MetricSample sample;
+  sample.set_name(name);
+  for (const auto& [key, value] : labels) {
+    auto* label = sample.add_labels();
+    label->set_key(key);
+    label->set_value(value);
+  }
+  return sample;
+}
+
+// 直接扫描全部序列定义，作为索引结果的对照
+std::vector<uint32_t> BruteForce(const SeriesStore& store,
+                                 const std::vector<IndexMatcher>& matchers) {
+  static const std::string kEmpty;
+  std::vector<uint32_t> ids;
+  for (uint32_t id = 0; id < store.series_count(); ++id) {
+    const auto& series = store.series(id);
+    bool matched = true;
+    for (const auto& matcher : matchers) {
+      const std::string* value = &kEmpty;
+      if (matcher.key == LabelIndex::kNameKey) {
+        value = series.name;
+      } else {
+        for (const auto& label : series.labels) {
+          if (*label.key == matcher.key) value = label.value;
+        }
+      }
+      matched = matched && matcher.Matches(*value);
+    }
+    if (matched) ids.push_back(id);
+  }
+  return ids;
+}
+
+}  // namespace
+
+TEST(PostingListTest, RoundTripsAcrossBlocksWithLargeGaps) {
+  PostingList list;
+  std::vector<uint32_t> expected;
+  uint32_t id = 3;
+  for (int i = 0; i < 1000; ++i) {
+    expected.push_back(id);
+    list.Append(id);
+    id += (i % 97 == 0) ? 1000000 : (i % 5) + 1;
+  }
+  list.Append(expected.back());  // 重复追加被忽略
+
+  std::vector<uint32_t> decoded;
+  list.AppendTo(&decoded);
+  EXPECT_EQ(decoded, expected);
+  EXPECT_EQ(list.size(), expected.size());
+}
+
+TEST(PostingListTest, SeekGeSkipsForwardAndNeverMovesBack) {
+  PostingList list;
+  for (uint32_t id = 0; id < 10000; id += 3) list.Append(id);
+
+  auto it = list.begin();
+  it.SeekGe(1000);
+  ASSERT_TRUE(it.Valid());
+  EXPECT_EQ(it.Value(), 1002u);
+  it.SeekGe(5);
+  EXPECT_EQ(it.Value(), 1002u);
+  it.SeekGe(9000);
+  EXPECT_EQ(it.Value(), 9000u);
+  it.Next();
+  EXPECT_EQ(it.Value(), 9003u);
+  it.SeekGe(20000);
+  EXPECT_FALSE(it.Valid());
+}
+
+TEST(PostingListTest, DenseIdsTakeAboutOneBytePerId) {
+  PostingList list;
+  constexpr uint32_t kCount = 100000;
+  for (uint32_t id = 0; id < kCount; ++id) list.Append(id * 2);
+  EXPECT_LT(list.MemoryBytes(), kCount * 2);
+}
+
+TEST(GallopGeTest, FindsFirstNotLess) {
+  std::vector<uint32_t> values;
+  for (uint32_t v = 0; v < 1000; v += 2) values.push_back(v);
+  const uint32_t* begin = values.data();
+  const uint32_t* end = begin + values.size();
+  EXPECT_EQ(GallopGe(begin, end, 0), begin);
+  EXPECT_EQ(*GallopGe(begin, end, 301), 302u);
+  EXPECT_EQ(*GallopGe(begin + 10, end, 998), 998u);
+  EXPECT_EQ(GallopGe(begin, end, 999), end);
+}
+
+TEST(LabelIndexTest, SelectsByEqualityRegexAndAbsentLabels) {
+  SeriesStore store;
+  const uint32_t read_sda = store.Intern(MakeSample("disk_read", {{"device", "sda"}}));
+  const uint32_t read_sdb = store.Intern(MakeSample("disk_read", {{"device", "sdb"}}));
+  const uint32_t read_nvme = store.Intern(MakeSample("disk_read", {{"device", "nvme0n1"}}));
+  const uint32_t read_total = store.Intern(MakeSample("disk_read", {}));
+  store.Intern(MakeSample("disk_write", {{"device", "sda"}}));
+  const LabelIndex& index = store.label_index();
+
+  using Type = IndexMatcher::Type;
+  auto select = [&index](std::vector<IndexMatcher> matchers) { return index.Select(matchers); };
+  EXPECT_EQ(select({MakeMatcher("__name__", "disk_read")}),
+            (std::vector<uint32_t>{read_sda, read_sdb, read_nvme, read_total}));
+  EXPECT_EQ(select({MakeMatcher("__name__", "disk_read"), MakeMatcher("device", "sdb")}),
+            (std::vector<uint32_t>{read_sdb}));
+  EXPECT_EQ(select({MakeMatcher("__name__", "disk_read"),
+                    MakeMatcher("device", "sd.*", Type::kRegex)}),
+            (std::vector<uint32_t>{read_sda, read_sdb}));
+  EXPECT_EQ(select({MakeMatcher("__name__", "disk_read"), MakeMatcher("device", "")}),
+            (std::vector<uint32_t>{read_total}));
+  EXPECT_EQ(select({MakeMatcher("__name__", "disk_read"),
+                    MakeMatcher("device", "sda", Type::kNotEqual)}),
+            (std::vector<uint32_t>{read_sdb, read_nvme, read_total}));
+  EXPECT_EQ(select({MakeMatcher("__name__", "disk_read"),
+                    MakeMatcher("device", "sd.*", Type::kNotRegex)}),
+            (std::vector<uint32_t>{read_nvme, read_total}));
+  EXPECT_TRUE(select({MakeMatcher("__name__", "missing")}).empty());
+  EXPECT_TRUE(select({MakeMatcher("device", "sda", Type::kNotEqual)}).empty());
+  EXPECT_GT(index.MemoryBytes(), 0u);
+}
+
+TEST(LabelIndexTest, MatchesBruteForceOnRandomSeries) {
+  SeriesStore store;
+  std::mt19937 rng(42);
+  const std::vector<std::string> names = {"cpu", "disk_read", "net_rx"};
+  for (int i = 0; i < 5000; ++i) {
+    std::vector<std::pair<std::string, std::string>> labels;
+    if (rng() % 4 != 0) labels.emplace_back("core", std::to_string(rng() % 64));
+    if (rng() % 2 != 0) labels.emplace_back("device", "dev" + std::to_string(rng() % 20));
+    labels.emplace_back("zone", std::to_string(i));
+    store.Intern(MakeSample(names[rng() % names.size()], labels));
+  }
+
+  using Type = IndexMatcher::Type;
+  const std::vector<std::vector<IndexMatcher>> cases = {
+      {MakeMatcher("__name__", "cpu"), MakeMatcher("core", "7")},
+      {MakeMatcher("__name__", "disk_read"), MakeMatcher("device", "dev1.*", Type::kRegex)},
+      {MakeMatcher("__name__", "net_rx"), MakeMatcher("core", "")},
+      {MakeMatcher("__name__", "cpu|net_rx", Type::kRegex),
+       MakeMatcher("device", "dev3", Type::kNotEqual), MakeMatcher("core", "1.*", Type::kRegex)},
+      {MakeMatcher("core", "2"), MakeMatcher("device", ".*", Type::kRegex),
+       MakeMatcher("__name__", "disk.*", Type::kNotRegex)},
+      {MakeMatcher("zone", "17"), MakeMatcher("core", ".+", Type::kRegex)},
+  };
+  for (const auto& matchers : cases) {
+    EXPECT_EQ(store.label_index().Select(matchers), BruteForce(store, matchers));
+  }
+}
@@ -0,0 +1,151 @@
+#include "../src/client/metrics/memory_collector.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#include "../src/client/metrics/key_table.h"
+
+namespace fs = std::filesystem;
+using system_insight::client::KeyTable;
+using system_insight::client::MemoryCollector;
+using system_insight::client::MemoryCollectorOptions;
+using systeminsight::proto::MetricsReport;
+
+TEST(KeyTableTest, FindsEveryKeyAndRejectsOthers) {
+  std::vector<std::string> keys;
+  for (int i = 0; i < 200; ++i) {
+    keys.push_back("key_" + std::to_string(i));
+  }
+  keys.push_back("key_7");  // 重复键去重
+  KeyTable table(keys);
+  ASSERT_EQ(table.size(), 200u);
+  for (int i = 0; i < 200; ++i) {
+    EXPECT_EQ(table.Find("key_" + std::to_string(i)), i);
+  }
+  EXPECT_EQ(table.Find("key_200"), -1);
+  EXPECT_EQ(table.Find(""), -1);
+  EXPECT_EQ(table.Find("key_"), -1);
+}
+
+TEST(KeyTableTest, ScansKeyValueLines) {
+  KeyTable table({"MemTotal", "HugePages_Free", "pgfault"});
+  uint64_t values[3] = {};
+  uint8_t seen[3] = {};
+  system_insight::client::ScanKeyValues(
+      "MemTotal:       16318412 kB\nMemTotalX: 1 kB\nHugePages_Free:  4\npgfault 99\n", table, 0,
+      values, seen);
+  EXPECT_EQ(values[0], 16318412u);
+  EXPECT_EQ(values[1], 4u);
+  EXPECT_EQ(values[2], 99u);
+  EXPECT_TRUE(seen[0] && seen[1] && seen[2]);
+}
+
+TEST(MemoryCollectorTest, SnakeCasesMeminfoKeys) {
+  EXPECT_EQ(MemoryCollector::SnakeCase("AnonHugePages"), "anon_huge_pages");
+  EXPECT_EQ(MemoryCollector::SnakeCase("HugePages_Total"), "huge_pages_total");
+  EXPECT_EQ(MemoryCollector::SnakeCase("SReclaimable"), "s_reclaimable");
+  EXPECT_EQ(MemoryCollector::SnakeCase("Active(anon)"), "active_anon");
+  EXPECT_EQ(MemoryCollector::SnakeCase("Hugepagesize"), "hugepagesize");
+}
+
+TEST(MemoryCollectorTest, EmitsGaugesRatesAndNodeMemory) {
+  fs::path root = fs::temp_directory_path() / ("system_insight_mem_" + std::to_string(::getpid()));
+  fs::remove_all(root);
+  fs::create_directories(root / "proc");
+  fs::create_directories(root / "sys/devices/system/node/node0");
+  fs::create_directories(root / "sys/devices/system/node/node1");
+  fs::create_directories(root / "sys/devices/system/node/possible_not_a_node");
+
+  auto write = [&](const fs::path& path, const std::string& content) {
+    std::ofstream(path) << content;
+  };
+  write(root / "proc/meminfo",
+        "MemTotal:       1000 kB\nSwapFree:        200 kB\nHugePages_Total:       8\n");
+  write(root / "proc/vmstat", "nr_free_pages 5\npgfault 1000\npgmajfault 10\n");
+  write(root / "sys/devices/system/node/node0/meminfo",
+        "Node 0 MemTotal:        600 kB\nNode 0 MemFree:         100 kB\n");
+  write(root / "sys/devices/system/node/node1/meminfo", "Node 1 MemTotal:        400 kB\n");
+
+  MemoryCollectorOptions options;
+  options.proc_root = (root / "proc").string();
+  options.sysfs_root = (root / "sys").string();
+  MemoryCollector collector(options);
+  EXPECT_EQ(collector.node_count(), 2u);
+
+  auto values = [](const MetricsReport& report) {
+    std::map<std::string, double> result;
+    for (const auto& sample : report.samples()) {
+      std::string key = sample.name();
+      for (const auto& label : sample.labels()) {
+        key += "{" + label.value() + "}";
+      }
+      result[key] = sample.value();
+    }
+    return result;
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  MetricsReport report;
+  collector.Collect(&report, start);
+  auto first = values(report);
+  EXPECT_DOUBLE_EQ(first["system.mem.swap_free_bytes"], 200.0 * 1024);
+  EXPECT_DOUBLE_EQ(first["system.mem.huge_pages_total"], 8.0);
+  EXPECT_DOUBLE_EQ(first["system.mem.node.mem_total_bytes{0}"], 600.0 * 1024);
+  EXPECT_DOUBLE_EQ(first["system.mem.node.mem_free_bytes{0}"], 100.0 * 1024);
+  EXPECT_DOUBLE_EQ(first["system.mem.node.mem_total_bytes{1}"], 400.0 * 1024);
+  // 首次采集只建立基线；默认键里没有 MemTotal
+  EXPECT_EQ(first.count("system.vmstat.pgfault_per_sec"), 0u);
+  EXPECT_EQ(first.count("system.mem.mem_total_bytes"), 0u);
+
+  write(root / "proc/vmstat", "nr_free_pages 5\npgfault 1500\npgmajfault 4\n");
+  report.Clear();
+  collector.Collect(&report, start + std::chrono::seconds(2));
+  auto second = values(report);
+  EXPECT_DOUBLE_EQ(second["system.vmstat.pgfault_per_sec"], 250.0);
+  // 计数器变小（回绕或重置）时不上报
+  EXPECT_EQ(second.count("system.vmstat.pgmajfault_per_sec"), 0u);
+
+  fs::remove_all(root);
+}
+
+TEST(MemoryCollectorTest, DerivesUsageFromTheSameMeminfoRead) {
+  const auto* test = ::testing::UnitTest::GetInstance()->current_test_info();
+  fs::path root = fs::temp_directory_path() /
+                  ("system_insight_mem_" + std::to_string(::getpid()) + "_" + test->name());
+  fs::remove_all(root);
+  fs::create_directories(root / "proc");
+  std::ofstream(root / "proc/meminfo")
+      << "MemTotal:       1000 kB\nMemFree:         100 kB\nMemAvailable:    250 kB\n"
+         "Cached:          300 kB\n";
+
+  MemoryCollectorOptions options;
+  options.proc_root = (root / "proc").string();
+  options.sysfs_root = (root / "sys").string();
+  // 列出 MemAvailable 也不会再以 mem_available_bytes 重复上报
+  options.meminfo_keys = {"MemTotal", "MemAvailable", "Cached"};
+  MemoryCollector collector(options);
+
+  MetricsReport report;
+  collector.Collect(&report, std::chrono::steady_clock::now());
+  std::map<std::string, int> counts;
+  std::map<std::string, double> values;
+  for (const auto& sample : report.samples()) {
+    ++counts[sample.name()];
+    values[sample.name()] = sample.value();
+  }
+  EXPECT_EQ(counts["system.mem.usage_percent"], 1);
+  EXPECT_EQ(counts["system.mem.available_bytes"], 1);
+  EXPECT_EQ(counts.count("system.mem.mem_available_bytes"), 0u);
+  EXPECT_DOUBLE_EQ(values["system.mem.usage_percent"], 75.0);
+  EXPECT_DOUBLE_EQ(values["system.mem.available_bytes"], 250.0 * 1024);
+  EXPECT_DOUBLE_EQ(values["system.mem.mem_total_bytes"], 1000.0 * 1024);
+  EXPECT_DOUBLE_EQ(values["system.mem.cached_bytes"], 300.0 * 1024);
+
+  fs::remove_all(root);
+}
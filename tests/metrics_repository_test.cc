@@ -0,0 +1,212 @@
+#include "../src/server/metrics_repository.h"
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using system_insight::server::MetricsRepository;
+using systeminsight::proto::MetricsReport;
+
+namespace {
+
+void AddSample(const std::string& name, double value, int64_t timestamp_ms,
+               MetricsReport* report) {
+  auto* sample = report->add_samples();
+  sample->set_name(name);
+  sample->set_value(value);
+  sample->set_timestamp_ms(timestamp_ms);
+}
+
+std::map<std::string, std::pair<double, int64_t>> HostSamples(const MetricsRepository& repository) {
+  std::map<std::string, std::pair<double, int64_t>> samples;
+  for (const auto& host : repository.Snapshot()) {
+    for (size_t i = 0; i < host->series_ids.size(); ++i) {
+      const auto& series = repository.series_store().series(host->series_ids[i]);
+      samples[*series.name] = {host->values[i], host->timestamps_ms[i]};
+    }
+  }
+  return samples;
+}
+
+}  // namespace
+
+TEST(MetricsRepositoryTest, DeltaReportsMergeIntoStoredState) {
+  MetricsRepository repository;
+  MetricsReport full;
+  full.set_host_id("host");
+  AddSample("cpu", 10.0, 1000, &full);
+  AddSample("mem", 50.0, 1000, &full);
+  ASSERT_TRUE(repository.UpdateReport(full));
+
+  MetricsReport delta;
+  delta.set_host_id("host");
+  delta.set_delta(true);
+  AddSample("cpu", 20.0, 2000, &delta);
+  AddSample("disk", 1.0, 2000, &delta);
+  ASSERT_TRUE(repository.UpdateReport(delta));
+
+  auto samples = HostSamples(repository);
+  ASSERT_EQ(samples.size(), 3u);
+  EXPECT_EQ(samples["cpu"], std::make_pair(20.0, int64_t{2000}));
+  // 未变化的序列沿用旧值，时间戳推进到最新报告
+  EXPECT_EQ(samples["mem"], std::make_pair(50.0, int64_t{2000}));
+  EXPECT_EQ(samples["disk"], std::make_pair(1.0, int64_t{2000}));
+
+  // 完整报告替换全部状态，消失的序列被清理
+  MetricsReport next_full;
+  next_full.set_host_id("host");
+  AddSample("cpu", 30.0, 3000, &next_full);
+  ASSERT_TRUE(repository.UpdateReport(next_full));
+  samples = HostSamples(repository);
+  ASSERT_EQ(samples.size(), 1u);
+  EXPECT_EQ(samples["cpu"], std::make_pair(30.0, int64_t{3000}));
+
+  // 过期的 delta 报告不会回退数据
+  MetricsReport stale;
+  stale.set_host_id("host");
+  stale.set_delta(true);
+  AddSample("cpu", 5.0, 2500, &stale);
+  EXPECT_FALSE(repository.UpdateReport(stale));
+  EXPECT_DOUBLE_EQ(HostSamples(repository)["cpu"].first, 30.0);
+}
+
+TEST(MetricsRepositoryTest, SnapshotIsImmutableAndCoversAllShards) {
+  MetricsRepository repository(4);
+  for (int i = 0; i < 100; ++i) {
+    MetricsReport report;
+    report.set_host_id("host-" + std::to_string(i));
+    AddSample("cpu", i, 1000, &report);
+    ASSERT_TRUE(repository.UpdateReport(report));
+  }
+  auto before = repository.Snapshot();
+  ASSERT_EQ(before.size(), 100u);
+
+  MetricsReport delta;
+  delta.set_host_id("host-0");
+  delta.set_delta(true);
+  AddSample("cpu", 42.0, 2000, &delta);
+  ASSERT_TRUE(repository.UpdateReport(delta));
+
+  // 已取得的快照不受后续写入影响
+  for (const auto& host : before) {
+    if (host->host_id == "host-0") {
+      EXPECT_DOUBLE_EQ(host->values[0], 0.0);
+    }
+  }
+  for (const auto& host : repository.Snapshot()) {
+    if (host->host_id == "host-0") {
+      EXPECT_DOUBLE_EQ(host->values[0], 42.0);
+    }
+  }
+}
+
+TEST(MetricsRepositoryTest, ConcurrentWritersAndScraper) {
+  MetricsRepository repository;
+  constexpr int kWriters = 4;
+  constexpr int kHostsPerWriter = 50;
+  constexpr int kRounds = 20;
+  std::atomic<bool> done{false};
+
+  std::thread scraper([&] {
+    while (!done.load()) {
+      for (const auto& host : repository.Snapshot()) {
+        // 每份快照都是某个时刻的完整状态
+        ASSERT_EQ(host->series_ids.size(), 2u);
+        ASSERT_EQ(host->values.size(), 2u);
+      }
+    }
+  });
+  std::vector<std::thread> writers;
+  for (int w = 0; w < kWriters; ++w) {
+    writers.emplace_back([&, w] {
+      for (int round = 1; round <= kRounds; ++round) {
+        for (int h = 0; h < kHostsPerWriter; ++h) {
+          MetricsReport report;
+          report.set_host_id("host-" + std::to_string(w) + "-" + std::to_string(h));
+          report.set_delta(round > 1);
+          AddSample("cpu", round, round * 1000, &report);
+          if (round == 1) AddSample("mem", 1.0, 1000, &report);
+          repository.UpdateReport(report);
+        }
+      }
+    });
+  }
+  for (auto& writer : writers) writer.join();
+  done.store(true);
+  scraper.join();
+
+  auto snapshot = repository.Snapshot();
+  ASSERT_EQ(snapshot.size(), static_cast<size_t>(kWriters * kHostsPerWriter));
+  for (const auto& host : snapshot) {
+    EXPECT_DOUBLE_EQ(host->values[0], kRounds);
+  }
+}
+
+TEST(MetricsRepositoryTest, HostsShareInternedSeries) {
+  MetricsRepository repository;
+  for (const char* host : {"a", "b"}) {
+    MetricsReport report;
+    report.set_host_id(host);
+    AddSample("cpu", 1.0, 1000, &report);
+    auto* sample = report.add_samples();
+    sample->set_name("disk");
+    sample->set_value(2.0);
+    sample->set_timestamp_ms(1000);
+    auto* label = sample->add_labels();
+    label->set_key("device");
+    label->set_value("sda");
+    ASSERT_TRUE(repository.UpdateReport(report));
+  }
+
+  const auto& store = repository.series_store();
+  EXPECT_EQ(store.series_count(), 2u);
+  auto snapshot = repository.Snapshot();
+  ASSERT_EQ(snapshot.size(), 2u);
+  EXPECT_EQ(snapshot[0]->series_ids, snapshot[1]->series_ids);
+  const auto& disk = store.series(snapshot[0]->series_ids[1]);
+  EXPECT_EQ(*disk.name, "disk");
+  ASSERT_EQ(disk.labels.size(), 1u);
+  EXPECT_EQ(*disk.labels[0].key, "device");
+  EXPECT_EQ(*disk.labels[0].value, "sda");
+}
+
+TEST(MetricsRepositoryTest, BatchedUpdatesKeepPerHostOrder) {
+  MetricsRepository repository(4);
+  std::vector<MetricsReport> reports;
+  for (int round = 1; round <= 3; ++round) {
+    for (int h = 0; h < 10; ++h) {
+      MetricsReport report;
+      report.set_host_id("host-" + std::to_string(h));
+      // 第三轮是 delta 报告，只更新 cpu
+      report.set_delta(round == 3);
+      AddSample("cpu", round * 10.0 + h, round * 1000, &report);
+      if (round < 3) AddSample("mem", round * 100.0 + h, round * 1000, &report);
+      reports.push_back(report);
+    }
+  }
+  // 一份过期报告不覆盖已有数据
+  MetricsReport stale;
+  stale.set_host_id("host-0");
+  AddSample("cpu", -1.0, 500, &stale);
+  reports.push_back(stale);
+
+  std::vector<const MetricsReport*> batch;
+  for (const auto& report : reports) batch.push_back(&report);
+  EXPECT_EQ(repository.UpdateReports(batch), 30u);
+
+  const auto hosts = repository.Snapshot();
+  ASSERT_EQ(hosts.size(), 10u);
+  for (const auto& host : hosts) {
+    const int h = std::stoi(host->host_id.substr(5));
+    ASSERT_EQ(host->series_ids.size(), 2u);
+    for (size_t i = 0; i < host->series_ids.size(); ++i) {
+      const auto& name = *repository.series_store().series(host->series_ids[i]).name;
+      EXPECT_EQ(host->values[i], name == "cpu" ? 30.0 + h : 200.0 + h) << name;
+      EXPECT_EQ(host->timestamps_ms[i], 3000);
+    }
+  }
+}
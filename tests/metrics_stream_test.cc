@@ -0,0 +1,296 @@
+#include "../src/client/metrics_stream.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../src/client/metrics_client.h"
+#include "../src/server/async_metrics_server.h"
+#include "grpcpp/grpcpp.h"
+
+using system_insight::client::MetricsClient;
+using system_insight::client::MetricsClientOptions;
+using system_insight::client::MetricsStream;
+using system_insight::client::MetricsStreamOptions;
+using system_insight::client::SendCompletion;
+using system_insight::common::codec::ReportPool;
+using system_insight::server::AsyncMetricsServer;
+using system_insight::server::AsyncServerOptions;
+using system_insight::server::MetricsRepository;
+using system_insight::server::MetricsServiceImpl;
+using systeminsight::proto::MetricsReport;
+using systeminsight::proto::ReportAck;
+using systeminsight::proto::SystemInsightService;
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using WriteResult = MetricsStream::WriteResult;
+
+MetricsReport MakeReport(uint64_t sequence) {
+  MetricsReport report;
+  report.set_host_id("streamer");
+  report.set_sequence(sequence);
+  auto* sample = report.add_samples();
+  sample->set_name("cpu_usage");
+  sample->set_value(0.5);
+  sample->set_timestamp_ms(1000 * static_cast<int64_t>(sequence));
+  return report;
+}
+
+// 测试用通道：gRPC 自身的重连退避调小，服务端重启后尽快可用
+std::shared_ptr<grpc::Channel> MakeChannel(int port) {
+  grpc::ChannelArguments args;
+  args.SetInt(GRPC_ARG_INITIAL_RECONNECT_BACKOFF_MS, 50);
+  args.SetInt(GRPC_ARG_MIN_RECONNECT_BACKOFF_MS, 50);
+  args.SetInt(GRPC_ARG_MAX_RECONNECT_BACKOFF_MS, 100);
+  return grpc::CreateCustomChannel("127.0.0.1:" + std::to_string(port),
+                                   grpc::InsecureChannelCredentials(), args);
+}
+
+// 等到收到 sequence 的确认
+bool WaitForAck(MetricsStream* stream, uint64_t sequence, bool* ok) {
+  const auto deadline = Clock::now() + std::chrono::seconds(5);
+  std::vector<MetricsStream::AckEvent> acks;
+  while (Clock::now() < deadline) {
+    if (!stream->WaitForAcks(std::chrono::milliseconds(100), &acks)) return false;
+    for (const auto& ack : acks) {
+      if (ack.sequence == sequence) {
+        *ok = ack.ok;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief 在本进程内运行异步服务端，可停止后在同一端口重启
+ */
+class MetricsStreamTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    StartServer(0);
+    ASSERT_NE(server_, nullptr);
+    stub_ = SystemInsightService::NewStub(MakeChannel(port_));
+  }
+
+  void TearDown() override { StopServer(); }
+
+  void StartServer(int port) {
+    repository_ = std::make_shared<MetricsRepository>();
+    service_ = std::make_unique<MetricsServiceImpl>(repository_, 2);
+    async_server_ = std::make_unique<AsyncMetricsServer>(service_.get(),
+                                                         AsyncServerOptions{1, false, 2});
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("127.0.0.1:" + std::to_string(port),
+                             grpc::InsecureServerCredentials(), &port_);
+    async_server_->Register(&builder);
+    server_ = builder.BuildAndStart();
+    if (server_) async_server_->Start();
+  }
+
+  void StopServer() {
+    if (!server_) return;
+    server_->Shutdown(std::chrono::system_clock::now());
+    async_server_->Stop();
+    server_.reset();
+    service_->StopIngest();
+    async_server_.reset();
+    service_.reset();
+  }
+
+  MetricsStreamOptions StreamOptions() const {
+    MetricsStreamOptions options;
+    options.reconnect_backoff_min_ms = 200;
+    options.reconnect_backoff_max_ms = 1000;
+    options.credit_wait_ms = 1000;
+    return options;
+  }
+
+  int port_ = 0;
+  std::shared_ptr<MetricsRepository> repository_;
+  std::unique_ptr<MetricsServiceImpl> service_;
+  std::unique_ptr<AsyncMetricsServer> async_server_;
+  std::unique_ptr<grpc::Server> server_;
+  std::unique_ptr<SystemInsightService::Stub> stub_;
+};
+
+TEST_F(MetricsStreamTest, HandshakesAndReturnsCreditsPerReport) {
+  MetricsStream stream(stub_.get(), StreamOptions());
+  ASSERT_EQ(stream.EnsureConnected(), WriteResult::kOk);
+  EXPECT_EQ(stream.generation(), 1u);
+  EXPECT_TRUE(stream.handshake().ok());
+  EXPECT_EQ(stream.handshake().credits(), 2u);
+  EXPECT_GT(stream.handshake().supported_encodings_size(), 0);
+
+  // 初始额度只有 2，每份报告的确认归还一个额度，后续写入才不会耗尽
+  for (uint64_t sequence = 1; sequence <= 5; ++sequence) {
+    ASSERT_EQ(stream.Write(MakeReport(sequence)), WriteResult::kOk);
+    bool ok = false;
+    ASSERT_TRUE(WaitForAck(&stream, sequence, &ok));
+    EXPECT_TRUE(ok);
+  }
+  const auto hosts = repository_->Snapshot();
+  ASSERT_EQ(hosts.size(), 1u);
+  EXPECT_EQ(hosts[0]->timestamps_ms[0], 5000);
+}
+
+TEST_F(MetricsStreamTest, ReportsNeedFullReportForDeltaFromUnknownHost) {
+  MetricsStream stream(stub_.get(), StreamOptions());
+  MetricsReport delta = MakeReport(1);
+  delta.set_delta(true);
+  ASSERT_EQ(stream.Write(delta), WriteResult::kOk);
+  // 服务端尚无该主机的完整报告，拒绝 delta 并要求完整报告
+  std::vector<MetricsStream::AckEvent> acks;
+  const auto deadline = Clock::now() + std::chrono::seconds(5);
+  while (acks.empty() && Clock::now() < deadline) {
+    ASSERT_TRUE(stream.WaitForAcks(std::chrono::milliseconds(100), &acks));
+  }
+  ASSERT_EQ(acks.size(), 1u);
+  EXPECT_EQ(acks[0].sequence, 1u);
+  EXPECT_FALSE(acks[0].ok);
+  EXPECT_TRUE(acks[0].need_full_report);
+}
+
+/**
+ * @brief 只授予初始额度、从不确认报告的流服务
+ */
+class SilentStreamService final : public SystemInsightService::Service {
+ public:
+  grpc::Status StreamMetrics(
+      grpc::ServerContext* /*context*/,
+      grpc::ServerReaderWriter<ReportAck, MetricsReport>* stream) override {
+    ReportAck handshake;
+    handshake.set_ok(true);
+    handshake.set_credits(1);
+    stream->Write(handshake);
+    MetricsReport report;
+    while (stream->Read(&report)) {
+    }
+    return grpc::Status::OK;
+  }
+};
+
+TEST(MetricsStreamCreditTest, WaitsForCreditsAndKeepsConnection) {
+  SilentStreamService service;
+  grpc::ServerBuilder builder;
+  int port = 0;
+  builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+  builder.RegisterService(&service);
+  auto server = builder.BuildAndStart();
+  ASSERT_NE(server, nullptr);
+  auto stub = SystemInsightService::NewStub(MakeChannel(port));
+  {
+    MetricsStreamOptions options;
+    options.credit_wait_ms = 200;
+    MetricsStream stream(stub.get(), options);
+    ASSERT_EQ(stream.Write(MakeReport(1)), WriteResult::kOk);
+    // 额度耗尽：等满 credit_wait_ms 后放弃本次写入，但不断开连接
+    const auto start = Clock::now();
+    EXPECT_EQ(stream.Write(MakeReport(2)), WriteResult::kUnavailable);
+    EXPECT_GE(Clock::now() - start, std::chrono::milliseconds(200));
+    EXPECT_TRUE(stream.connected());
+    EXPECT_EQ(stream.generation(), 1u);
+  }
+  server->Shutdown(std::chrono::system_clock::now());
+}
+
+TEST_F(MetricsStreamTest, ReconnectsWithBackoffAfterServerRestart) {
+  MetricsStream stream(stub_.get(), StreamOptions());
+  ASSERT_EQ(stream.Write(MakeReport(1)), WriteResult::kOk);
+  bool ok = false;
+  ASSERT_TRUE(WaitForAck(&stream, 1, &ok));
+
+  StopServer();
+  std::vector<MetricsStream::AckEvent> acks;
+  for (int i = 0; i < 50 && stream.WaitForAcks(std::chrono::milliseconds(100), &acks); ++i) {
+  }
+  // 流已断开：本次写入失败并安排 200 ms 后重连，退避期间不尝试建流
+  EXPECT_EQ(stream.Write(MakeReport(2)), WriteResult::kUnavailable);
+  EXPECT_FALSE(stream.connected());
+  EXPECT_EQ(stream.EnsureConnected(), WriteResult::kUnavailable);
+
+  // 服务端仍未恢复，重连失败后退避翻倍到 400 ms
+  std::this_thread::sleep_for(std::chrono::milliseconds(250));
+  const auto failed_at = Clock::now();
+  EXPECT_EQ(stream.EnsureConnected(), WriteResult::kUnavailable);
+
+  StartServer(port_);
+  ASSERT_NE(server_, nullptr);
+  WriteResult result = WriteResult::kUnavailable;
+  while (result != WriteResult::kOk && Clock::now() - failed_at < std::chrono::seconds(10)) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    result = stream.EnsureConnected();
+  }
+  ASSERT_EQ(result, WriteResult::kOk);
+  EXPECT_GE(Clock::now() - failed_at, std::chrono::milliseconds(400));
+  EXPECT_EQ(stream.generation(), 2u);
+
+  ASSERT_EQ(stream.Write(MakeReport(3)), WriteResult::kOk);
+  ASSERT_TRUE(WaitForAck(&stream, 3, &ok));
+  EXPECT_TRUE(ok);
+}
+
+/**
+ * @brief 只实现 SendMetrics 的旧版服务端，StreamMetrics 返回 UNIMPLEMENTED
+ */
+class UnaryOnlyService final : public SystemInsightService::Service {
+ public:
+  grpc::Status SendMetrics(grpc::ServerContext* /*context*/, const MetricsReport* request,
+                           ReportAck* response) override {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sequences_.push_back(request->sequence());
+    response->set_ok(true);
+    return grpc::Status::OK;
+  }
+
+  std::vector<uint64_t> sequences() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return sequences_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<uint64_t> sequences_;
+};
+
+TEST(MetricsClientFallbackTest, FallsBackToUnaryWhenStreamingIsUnimplemented) {
+  UnaryOnlyService service;
+  grpc::ServerBuilder builder;
+  int port = 0;
+  builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port);
+  builder.RegisterService(&service);
+  auto server = builder.BuildAndStart();
+  ASSERT_NE(server, nullptr);
+  {
+    MetricsClientOptions options;
+    options.use_streaming = true;
+    MetricsClient client(MakeChannel(port), options);
+    ReportPool pool(4);
+    std::vector<SendCompletion> completions;
+    for (int i = 0; i < 3; ++i) {
+      auto report = pool.Acquire();
+      report->report()->set_host_id("legacy");
+      client.StartSend(std::move(report));
+      // 逐份等待完成，确认回退后的每份报告都走 SendMetrics
+      const auto deadline = Clock::now() + std::chrono::seconds(5);
+      while (completions.size() < static_cast<size_t>(i + 1) && Clock::now() < deadline) {
+        client.Poll(std::chrono::milliseconds(100), &completions);
+      }
+    }
+    ASSERT_EQ(completions.size(), 3u);
+    for (const auto& completion : completions) {
+      EXPECT_TRUE(completion.ok);
+    }
+  }
+  EXPECT_EQ(service.sequences(), std::vector<uint64_t>({1, 2, 3}));
+  server->Shutdown(std::chrono::system_clock::now());
+}
+
+}  // namespace
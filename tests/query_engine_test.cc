@@ -0,0 +1,236 @@
+#include "../src/server/query_engine.h"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../src/server/query_kernels.h"
+
+using system_insight::server::QueryEngine;
+using system_insight::server::QueryEngineOptions;
+using system_insight::server::SeriesStore;
+using system_insight::server::TimeSeriesDb;
+using system_insight::server::TsdbOptions;
+using systeminsight::proto::LabelMatcher;
+using systeminsight::proto::MetricsReport;
+using systeminsight::proto::QueryRangeRequest;
+using systeminsight::proto::QueryRangeResponse;
+
+namespace kernels = system_insight::server::kernels;
+
+namespace {
+
+void AddSample(const std::string& name, const std::string& device, double value,
+               int64_t timestamp_ms, MetricsReport* report) {
+  auto* sample = report->add_samples();
+  sample->set_name(name);
+  sample->set_value(value);
+  sample->set_timestamp_ms(timestamp_ms);
+  if (!device.empty()) {
+    auto* label = sample->add_labels();
+    label->set_key("device");
+    label->set_value(device);
+  }
+}
+
+// 两台主机，每台两块磁盘；每 10 s 一个点，共 60 个点
+std::shared_ptr<TimeSeriesDb> MakeDb() {
+  auto db = std::make_shared<TimeSeriesDb>(TsdbOptions{}, std::make_shared<SeriesStore>());
+  for (int i = 0; i < 60; ++i) {
+    for (const std::string host : {"web-1", "db-1"}) {
+      MetricsReport report;
+      report.set_host_id(host);
+      AddSample("disk.reads", "sda", i * 10.0, i * 10000, &report);
+      AddSample("disk.reads", "sdb", i * 20.0, i * 10000, &report);
+      AddSample("cpu", "", i, i * 10000, &report);
+      db->Append(report);
+    }
+  }
+  return db;
+}
+
+QueryRangeRequest MakeRequest(const std::string& name,
+                              systeminsight::proto::QueryAggregation aggregation) {
+  QueryRangeRequest request;
+  request.set_metric_name(name);
+  request.set_start_ms(0);
+  request.set_end_ms(599'999);
+  request.set_step_ms(60'000);
+  request.set_aggregation(aggregation);
+  return request;
+}
+
+}  // namespace
+
+TEST(QueryKernelsTest, ReductionsMatchScalarResults) {
+  std::vector<double> values;
+  for (int i = 0; i < 37; ++i) values.push_back(std::sin(i) * 100);
+  double sum = 0;
+  double min = values[0];
+  double max = values[0];
+  for (double value : values) {
+    sum += value;
+    min = std::min(min, value);
+    max = std::max(max, value);
+  }
+  EXPECT_NEAR(kernels::Sum(values.data(), values.size()), sum, 1e-9);
+  EXPECT_EQ(kernels::Min(values.data(), values.size()), min);
+  EXPECT_EQ(kernels::Max(values.data(), values.size()), max);
+
+  // 计数器重置：10 -> 30 增长 20，重置到 5 计 5，再到 8 计 3
+  const double counter[] = {10, 30, 5, 8};
+  EXPECT_DOUBLE_EQ(kernels::Increase(counter, 4), 28.0);
+
+  double quantile_values[] = {4, 1, 3, 2, 5};
+  EXPECT_DOUBLE_EQ(kernels::Quantile(quantile_values, 5, 0.5), 3.0);
+  double interpolated[] = {10, 20};
+  EXPECT_DOUBLE_EQ(kernels::Quantile(interpolated, 2, 0.25), 12.5);
+}
+
+TEST(QueryEngineTest, DownsamplesWithEachAggregation) {
+  QueryEngine engine(MakeDb(), QueryEngineOptions{1});
+  QueryRangeResponse response;
+  std::string error;
+
+  auto request = MakeRequest("cpu", systeminsight::proto::QUERY_AGGREGATION_AVG);
+  ASSERT_TRUE(engine.QueryRange(request, &response, &error)) << error;
+  ASSERT_EQ(response.series_size(), 2);
+  // 结果按主机排序；第一个 60 s 桶包含 0..5
+  const auto& series = response.series(0);
+  EXPECT_EQ(series.host_id(), "db-1");
+  ASSERT_EQ(series.values_size(), 10);
+  EXPECT_EQ(series.timestamps_ms(1), 60'000);
+  EXPECT_DOUBLE_EQ(series.values(0), 2.5);
+  // 步长按 1 分钟对齐：每个序列读 9 个已结束的汇总桶和最后一分钟的 6 个原始点
+  EXPECT_EQ(response.resolution_ms(), 60'000);
+  EXPECT_EQ(response.points_scanned(), 30u);
+
+  request.set_aggregation(systeminsight::proto::QUERY_AGGREGATION_MAX);
+  response.Clear();
+  ASSERT_TRUE(engine.QueryRange(request, &response, &error));
+  EXPECT_DOUBLE_EQ(response.series(0).values(1), 11.0);
+
+  request.set_aggregation(systeminsight::proto::QUERY_AGGREGATION_QUANTILE);
+  request.set_quantile(0.5);
+  response.Clear();
+  ASSERT_TRUE(engine.QueryRange(request, &response, &error));
+  EXPECT_DOUBLE_EQ(response.series(0).values(0), 2.5);
+
+  // sda 每 10 s 增加 10，速率 1/s；从第二个桶起以前一个桶的最后一个点为基准
+  auto rate = MakeRequest("disk.reads", systeminsight::proto::QUERY_AGGREGATION_RATE);
+  response.Clear();
+  ASSERT_TRUE(engine.QueryRange(rate, &response, &error));
+  ASSERT_EQ(response.series_size(), 4);
+  for (const auto& result : response.series()) {
+    const double expected = result.labels(0).value() == "sda" ? 1.0 : 2.0;
+    for (double value : result.values()) {
+      EXPECT_DOUBLE_EQ(value, expected);
+    }
+  }
+}
+
+TEST(QueryEngineTest, AppliesLabelAndHostMatchers) {
+  QueryEngine engine(MakeDb(), QueryEngineOptions{1});
+  auto request = MakeRequest("disk.reads", systeminsight::proto::QUERY_AGGREGATION_SUM);
+  auto* host = request.add_matchers();
+  host->set_key("host");
+  host->set_value("web-.*");
+  host->set_type(LabelMatcher::REGEX);
+  auto* device = request.add_matchers();
+  device->set_key("device");
+  device->set_value("sda");
+  device->set_type(LabelMatcher::NOT_EQUAL);
+
+  QueryRangeResponse response;
+  std::string error;
+  ASSERT_TRUE(engine.QueryRange(request, &response, &error)) << error;
+  ASSERT_EQ(response.series_size(), 1);
+  EXPECT_EQ(response.series(0).host_id(), "web-1");
+  EXPECT_EQ(response.series(0).labels(0).value(), "sdb");
+
+  device->set_type(LabelMatcher::REGEX);
+  device->set_value("(");
+  EXPECT_FALSE(engine.QueryRange(request, &response, &error));
+  request.clear_matchers();
+  request.set_step_ms(0);
+  EXPECT_FALSE(engine.QueryRange(request, &response, &error));
+}
+
+TEST(QueryEngineTest, ParallelEvaluationMatchesSerial) {
+  auto db = MakeDb();
+  QueryEngineOptions serial_options{1};
+  QueryEngineOptions parallel_options{4};
+  parallel_options.series_per_task = 1;
+  QueryEngine serial(db, serial_options);
+  QueryEngine parallel(db, parallel_options);
+
+  auto request = MakeRequest("disk.reads", systeminsight::proto::QUERY_AGGREGATION_AVG);
+  QueryRangeResponse expected;
+  QueryRangeResponse actual;
+  std::string error;
+  ASSERT_TRUE(serial.QueryRange(request, &expected, &error));
+  ASSERT_TRUE(parallel.QueryRange(request, &actual, &error));
+  EXPECT_EQ(expected.SerializeAsString(), actual.SerializeAsString());
+}
+
+TEST(QueryEngineTest, UsesCoarsestAlignedRollupTier) {
+  TsdbOptions raw_options;
+  raw_options.rollups.clear();
+  auto raw_db = std::make_shared<TimeSeriesDb>(raw_options, std::make_shared<SeriesStore>());
+  TsdbOptions options;
+  options.rollups = {{10'000, 3'600'000}, {60'000, 3'600'000}};
+  auto db = std::make_shared<TimeSeriesDb>(options, std::make_shared<SeriesStore>());
+  for (int i = 0; i < 1800; ++i) {
+    MetricsReport report;
+    report.set_host_id("web-1");
+    AddSample("cpu", "", std::fmod(i * 7.3, 50.0), i * 1000, &report);
+    db->Append(report);
+    raw_db->Append(report);
+  }
+  QueryEngine engine(db, QueryEngineOptions{1});
+  QueryEngine raw_engine(raw_db, QueryEngineOptions{1});
+
+  struct Case {
+    int64_t start_ms;
+    int64_t step_ms;
+    systeminsight::proto::QueryAggregation aggregation;
+    int64_t resolution_ms;
+  };
+  const std::vector<Case> cases = {
+      {0, 120'000, systeminsight::proto::QUERY_AGGREGATION_AVG, 60'000},
+      {0, 30'000, systeminsight::proto::QUERY_AGGREGATION_MIN, 10'000},
+      {10'000, 60'000, systeminsight::proto::QUERY_AGGREGATION_MAX, 10'000},
+      {0, 60'000, systeminsight::proto::QUERY_AGGREGATION_SUM, 60'000},
+      {0, 15'000, systeminsight::proto::QUERY_AGGREGATION_AVG, 0},
+      {0, 60'000, systeminsight::proto::QUERY_AGGREGATION_RATE, 0},
+  };
+  for (const auto& c : cases) {
+    QueryRangeRequest request;
+    request.set_metric_name("cpu");
+    request.set_start_ms(c.start_ms);
+    request.set_end_ms(1'799'999);
+    request.set_step_ms(c.step_ms);
+    request.set_aggregation(c.aggregation);
+    QueryRangeResponse response;
+    QueryRangeResponse raw_response;
+    std::string error;
+    ASSERT_TRUE(engine.QueryRange(request, &response, &error)) << error;
+    ASSERT_TRUE(raw_engine.QueryRange(request, &raw_response, &error)) << error;
+    EXPECT_EQ(response.resolution_ms(), c.resolution_ms) << c.step_ms;
+    EXPECT_EQ(raw_response.resolution_ms(), 0);
+    ASSERT_EQ(response.series_size(), 1);
+    const auto& series = response.series(0);
+    const auto& raw_series = raw_response.series(0);
+    ASSERT_EQ(series.values_size(), raw_series.values_size());
+    for (int i = 0; i < series.values_size(); ++i) {
+      EXPECT_EQ(series.timestamps_ms(i), raw_series.timestamps_ms(i));
+      EXPECT_NEAR(series.values(i), raw_series.values(i), 1e-9);
+    }
+    if (c.resolution_ms != 0) {
+      EXPECT_LT(response.points_scanned() * 5, raw_response.points_scanned());
+    }
+  }
+}
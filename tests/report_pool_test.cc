@@ -0,0 +1,87 @@
+#include "../src/common/codec/report_pool.h"
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using system_insight::common::codec::PooledReport;
+using system_insight::common::codec::ReportPool;
+using system_insight::common::codec::ReportSlot;
+
+namespace {
+
+void FillReport(ReportSlot* slot, int samples, size_t name_bytes) {
+  auto* report = slot->report();
+  report->set_host_id("unit-test");
+  for (int i = 0; i < samples; ++i) {
+    auto* sample = report->add_samples();
+    sample->set_name(std::string(name_bytes, static_cast<char>('a' + i % 26)));
+    sample->set_value(i);
+  }
+}
+
+TEST(ReportPoolTest, ReusesReleasedSlotWithClearedReport) {
+  ReportPool pool(4);
+  auto report = pool.Acquire();
+  const ReportSlot* slot = report.get();
+  FillReport(report.get(), 8, 16);
+  const auto arena_bytes = report->arena_bytes();
+  report.reset();
+  EXPECT_EQ(pool.free_slots(), 1u);
+
+  auto reused = pool.Acquire();
+  EXPECT_EQ(reused.get(), slot);
+  EXPECT_EQ(pool.free_slots(), 0u);
+  EXPECT_EQ(reused->report()->samples_size(), 0);
+  EXPECT_TRUE(reused->report()->host_id().empty());
+  // 未超出上限时保留 Arena，再次填充不再申请内存
+  FillReport(reused.get(), 8, 16);
+  EXPECT_EQ(reused->arena_bytes(), arena_bytes);
+}
+
+TEST(ReportPoolTest, DestroyedPooledReportReturnsItsSlot) {
+  ReportPool pool(4);
+  {
+    std::vector<PooledReport> reports;
+    reports.push_back(pool.Acquire());
+    reports.push_back(pool.Acquire());
+    EXPECT_EQ(pool.free_slots(), 0u);
+  }
+  EXPECT_EQ(pool.free_slots(), 2u);
+}
+
+TEST(ReportPoolTest, GrowsWhenEmptyAndKeepsAtMostMaxFreeSlots) {
+  ReportPool pool(2);
+  std::vector<PooledReport> reports;
+  for (int i = 0; i < 5; ++i) {
+    reports.push_back(pool.Acquire());
+    ASSERT_NE(reports.back(), nullptr);
+  }
+  for (int i = 0; i < 5; ++i) {
+    for (int j = i + 1; j < 5; ++j) {
+      EXPECT_NE(reports[i].get(), reports[j].get());
+    }
+  }
+  reports.clear();
+  EXPECT_EQ(pool.free_slots(), 2u);
+}
+
+TEST(ReportPoolTest, ResetsArenaAboveMaxRetainedBytes) {
+  constexpr size_t kMaxRetained = 32 * 1024;
+  ReportPool pool(4, kMaxRetained);
+  auto report = pool.Acquire();
+  const ReportSlot* slot = report.get();
+  // 合并过的大报告把 Arena 撑到上限以上
+  FillReport(report.get(), 256, 512);
+  const auto grown_bytes = report->arena_bytes();
+  ASSERT_GT(grown_bytes, kMaxRetained);
+  report.reset();
+
+  auto reused = pool.Acquire();
+  EXPECT_EQ(reused.get(), slot);
+  EXPECT_EQ(reused->report()->samples_size(), 0);
+  EXPECT_LE(reused->arena_bytes(), kMaxRetained);
+}
+
+}  // namespace
@@ -0,0 +1,425 @@
+#include "../src/client/report_sender.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "grpcpp/grpcpp.h"
+
+using system_insight::client::MetricsClient;
+using system_insight::client::MetricsClientOptions;
+using system_insight::client::OverflowPolicy;
+using system_insight::client::ReportSender;
+using system_insight::client::ReportSenderOptions;
+using system_insight::client::ReportSenderStats;
+using system_insight::common::codec::PooledReport;
+using system_insight::common::codec::ReportPool;
+using systeminsight::proto::MetricsReport;
+using systeminsight::proto::ReportAck;
+using systeminsight::proto::SystemInsightService;
+
+namespace {
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+/**
+ * @brief 记录收到的报告；可让 SendMetrics 失败、要求完整报告，或挂起到 Release()
+ */
+class FakeMetricsService final : public SystemInsightService::Service {
+ public:
+  grpc::Status SendMetrics(grpc::ServerContext* /*context*/, const MetricsReport* request,
+                           ReportAck* response) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    ++active_;
+    max_active_ = std::max(max_active_, active_);
+    cv_.notify_all();
+    cv_.wait(lock, [this] { return !hold_; });
+    --active_;
+    if (failing_ || fail_once_.erase(request->host_id()) > 0) {
+      return grpc::Status(grpc::StatusCode::UNAVAILABLE, "server down");
+    }
+    if (reject_delta_ && request->delta()) {
+      response->set_ok(false);
+      response->set_need_full_report(true);
+      return grpc::Status::OK;
+    }
+    received_.push_back(*request);
+    arrivals_.push_back(Clock::now());
+    response->set_ok(true);
+    return grpc::Status::OK;
+  }
+
+  void SetFailing(bool failing) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    failing_ = failing;
+  }
+
+  // 该主机的下一份报告失败一次
+  void FailOnce(const std::string& host_id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    fail_once_.insert(host_id);
+  }
+
+  void SetRejectDelta(bool reject) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    reject_delta_ = reject;
+  }
+
+  void Hold() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    hold_ = true;
+  }
+
+  void Release() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      hold_ = false;
+    }
+    cv_.notify_all();
+  }
+
+  bool WaitForActive(int count) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return cv_.wait_for(lock, std::chrono::seconds(5), [&] { return active_ >= count; });
+  }
+
+  int active() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return active_;
+  }
+
+  int max_active() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return max_active_;
+  }
+
+  std::vector<MetricsReport> received() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return received_;
+  }
+
+  std::vector<Clock::time_point> arrivals() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return arrivals_;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  bool failing_ = false;
+  bool reject_delta_ = false;
+  std::set<std::string> fail_once_;
+  bool hold_ = false;
+  int active_ = 0;
+  int max_active_ = 0;
+  std::vector<MetricsReport> received_;
+  std::vector<Clock::time_point> arrivals_;
+};
+
+class ReportSenderTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    grpc::ServerBuilder builder;
+    builder.AddListeningPort("127.0.0.1:0", grpc::InsecureServerCredentials(), &port_);
+    builder.RegisterService(&service_);
+    server_ = builder.BuildAndStart();
+    ASSERT_NE(server_, nullptr);
+
+    // 每个用例在独立进程中运行，目录名带上进程号与用例名
+    const auto* test = ::testing::UnitTest::GetInstance()->current_test_info();
+    spool_directory_ = fs::temp_directory_path() /
+                       ("system_insight_sender_spool_" + std::to_string(::getpid()) + "_" +
+                        test->name());
+    std::error_code ec;
+    fs::remove_all(spool_directory_, ec);
+  }
+
+  void TearDown() override {
+    service_.Release();
+    sender_.reset();
+    server_->Shutdown();
+    std::error_code ec;
+    fs::remove_all(spool_directory_, ec);
+  }
+
+  void StartSender(const ReportSenderOptions& options, bool start = true) {
+    MetricsClientOptions client_options;
+    client_options.max_in_flight = options.max_in_flight;
+    client_options.send_timeout_ms = 2000;
+    auto channel = grpc::CreateChannel("127.0.0.1:" + std::to_string(port_),
+                                       grpc::InsecureChannelCredentials());
+    sender_ = std::make_unique<ReportSender>(
+        std::make_unique<MetricsClient>(channel, client_options), &pool_, options);
+    if (start) sender_->Start();
+  }
+
+  PooledReport MakeReport(const std::string& host_id,
+                          const std::vector<std::pair<std::string, double>>& samples = {}) {
+    auto report = pool_.Acquire();
+    report->report()->set_host_id(host_id);
+    for (const auto& [name, value] : samples) {
+      auto* sample = report->report()->add_samples();
+      sample->set_name(name);
+      sample->set_value(value);
+      sample->set_timestamp_ms(1000);
+    }
+    return report;
+  }
+
+  // 等到发送线程的统计满足条件
+  bool WaitForStats(const std::function<bool(const ReportSenderStats&)>& done) {
+    const auto deadline = Clock::now() + std::chrono::seconds(5);
+    while (Clock::now() < deadline) {
+      if (done(sender_->GetStats())) return true;
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+  }
+
+  FakeMetricsService service_;
+  int port_ = 0;
+  fs::path spool_directory_;
+  std::unique_ptr<grpc::Server> server_;
+  // 须比 sender_ 活得久
+  ReportPool pool_;
+  std::unique_ptr<ReportSender> sender_;
+};
+
+TEST_F(ReportSenderTest, DropsOldestReportWhenQueueIsFull) {
+  ReportSenderOptions options;
+  options.queue_capacity = 2;
+  // 逐份发送，服务端按入队顺序收到
+  options.max_in_flight = 1;
+  // 先不启动发送线程，入队的报告全部留在队列中
+  StartSender(options, false);
+  sender_->Enqueue(MakeReport("report-1"));
+  sender_->Enqueue(MakeReport("report-2"));
+  sender_->Enqueue(MakeReport("report-3"));
+  auto stats = sender_->GetStats();
+  EXPECT_EQ(stats.queue_depth, 2u);
+  EXPECT_EQ(stats.dropped_total, 1u);
+  EXPECT_EQ(stats.coalesced_total, 0u);
+
+  sender_->Start();
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.sent_total == 2; }));
+  const auto received = service_.received();
+  ASSERT_EQ(received.size(), 2u);
+  EXPECT_EQ(received[0].host_id(), "report-2");
+  EXPECT_EQ(received[1].host_id(), "report-3");
+}
+
+TEST_F(ReportSenderTest, CoalescesOldestReportIntoNext) {
+  ReportSenderOptions options;
+  options.queue_capacity = 1;
+  options.overflow_policy = OverflowPolicy::kCoalesce;
+  StartSender(options, false);
+  sender_->Enqueue(MakeReport("host", {{"cpu", 1.0}, {"mem", 1.0}}));
+  sender_->Enqueue(MakeReport("host", {{"mem", 2.0}, {"disk", 2.0}}));
+  auto stats = sender_->GetStats();
+  EXPECT_EQ(stats.queue_depth, 1u);
+  EXPECT_EQ(stats.coalesced_total, 1u);
+  EXPECT_EQ(stats.dropped_total, 0u);
+
+  sender_->Start();
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.sent_total == 1; }));
+  const auto received = service_.received();
+  ASSERT_EQ(received.size(), 1u);
+  // 同一序列保留新报告的值，旧报告独有的序列补进来
+  ASSERT_EQ(received[0].samples_size(), 3);
+  EXPECT_EQ(received[0].samples(0).name(), "mem");
+  EXPECT_EQ(received[0].samples(0).value(), 2.0);
+  EXPECT_EQ(received[0].samples(1).name(), "disk");
+  EXPECT_EQ(received[0].samples(2).name(), "cpu");
+  EXPECT_EQ(received[0].samples(2).value(), 1.0);
+}
+
+TEST_F(ReportSenderTest, CoalescesFullReportIntoDeltaAsFull) {
+  ReportSenderOptions options;
+  options.queue_capacity = 1;
+  options.overflow_policy = OverflowPolicy::kCoalesce;
+  StartSender(options, false);
+  sender_->Enqueue(MakeReport("host", {{"cpu", 1.0}, {"mem", 1.0}}));
+  auto delta = MakeReport("host", {{"mem", 2.0}});
+  delta->report()->set_delta(true);
+  sender_->Enqueue(std::move(delta));
+
+  sender_->Start();
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.sent_total == 1; }));
+  const auto received = service_.received();
+  ASSERT_EQ(received.size(), 1u);
+  // 合并结果包含完整报告的全部序列，按完整报告发送
+  EXPECT_FALSE(received[0].delta());
+  EXPECT_EQ(received[0].samples_size(), 2);
+}
+
+TEST_F(ReportSenderTest, LimitsReportsInFlight) {
+  ReportSenderOptions options;
+  options.max_in_flight = 2;
+  service_.Hold();
+  StartSender(options);
+  for (int i = 0; i < 5; ++i) {
+    sender_->Enqueue(MakeReport("report-" + std::to_string(i)));
+  }
+  ASSERT_TRUE(service_.WaitForActive(2));
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.queue_depth == 3; }));
+  // 给发送线程机会越过上限
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  EXPECT_EQ(service_.active(), 2);
+  EXPECT_EQ(sender_->GetStats().queue_depth, 3u);
+
+  service_.Release();
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.sent_total == 5; }));
+  EXPECT_EQ(service_.max_active(), 2);
+  EXPECT_EQ(sender_->GetStats().in_flight, 0u);
+}
+
+TEST_F(ReportSenderTest, CountsFailedSendsWithoutSpool) {
+  service_.SetFailing(true);
+  StartSender(ReportSenderOptions{});
+  sender_->Enqueue(MakeReport("lost"));
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.failed_total == 1; }));
+  const auto stats = sender_->GetStats();
+  EXPECT_EQ(stats.sent_total, 0u);
+  EXPECT_EQ(stats.spooled_total, 0u);
+  EXPECT_EQ(stats.in_flight, 0u);
+
+  // 失败的发送不影响后续报告
+  service_.SetFailing(false);
+  sender_->Enqueue(MakeReport("delivered"));
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.sent_total == 1; }));
+  const auto received = service_.received();
+  ASSERT_EQ(received.size(), 1u);
+  EXPECT_EQ(received[0].host_id(), "delivered");
+}
+
+TEST_F(ReportSenderTest, CountsFullReportRequestsWithoutSpooling) {
+  ReportSenderOptions options;
+  options.spool_directory = spool_directory_.string();
+  service_.SetRejectDelta(true);
+  StartSender(options);
+  auto delta = MakeReport("restarted-server", {{"cpu", 1.0}});
+  delta->report()->set_delta(true);
+  sender_->Enqueue(std::move(delta));
+  ASSERT_TRUE(
+      WaitForStats([](const ReportSenderStats& s) { return s.full_report_requests_total == 1; }));
+  // 被拒的 delta 报告既不算发送失败，也不落盘补发
+  auto stats = sender_->GetStats();
+  EXPECT_EQ(stats.failed_total, 0u);
+  EXPECT_EQ(stats.spooled_total, 0u);
+  EXPECT_EQ(stats.spool_reports, 0u);
+
+  sender_->Enqueue(MakeReport("restarted-server", {{"cpu", 1.0}, {"mem", 2.0}}));
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.sent_total == 1; }));
+  stats = sender_->GetStats();
+  EXPECT_EQ(stats.spool_reports, 0u);
+  EXPECT_EQ(stats.replayed_total, 0u);
+  const auto received = service_.received();
+  ASSERT_EQ(received.size(), 1u);
+  EXPECT_FALSE(received[0].delta());
+}
+
+TEST_F(ReportSenderTest, SpoolsFailedReportsAndReplaysOldestFirst) {
+  ReportSenderOptions options;
+  options.max_in_flight = 1;
+  options.spool_directory = spool_directory_.string();
+  options.replay_max_per_second = 10;
+  service_.SetFailing(true);
+  StartSender(options);
+  for (int i = 1; i <= 3; ++i) {
+    sender_->Enqueue(MakeReport("spooled-" + std::to_string(i)));
+  }
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.spooled_total == 3; }));
+  EXPECT_EQ(sender_->GetStats().spool_reports, 3u);
+  EXPECT_TRUE(service_.received().empty());
+
+  // 服务端恢复：实时报告发送成功后才开始补发
+  service_.SetFailing(false);
+  sender_->Enqueue(MakeReport("live"));
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.replayed_total == 3; }));
+  EXPECT_EQ(sender_->GetStats().spool_reports, 0u);
+
+  const auto received = service_.received();
+  ASSERT_EQ(received.size(), 4u);
+  EXPECT_EQ(received[0].host_id(), "live");
+  EXPECT_FALSE(received[0].backfill());
+  for (int i = 1; i <= 3; ++i) {
+    EXPECT_EQ(received[i].host_id(), "spooled-" + std::to_string(i));
+    EXPECT_TRUE(received[i].backfill());
+  }
+  // 每秒最多补发 10 份
+  const auto arrivals = service_.arrivals();
+  for (size_t i = 2; i < arrivals.size(); ++i) {
+    EXPECT_GE(arrivals[i] - arrivals[i - 1], std::chrono::milliseconds(80));
+  }
+}
+
+TEST_F(ReportSenderTest, KeepsReplayOrderWhenReplayFails) {
+  ReportSenderOptions options;
+  options.max_in_flight = 1;
+  options.spool_directory = spool_directory_.string();
+  options.replay_max_per_second = 100;
+  service_.SetFailing(true);
+  StartSender(options);
+  for (int i = 1; i <= 3; ++i) {
+    sender_->Enqueue(MakeReport("spooled-" + std::to_string(i)));
+  }
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.spooled_total == 3; }));
+
+  // 补发第二份时失败：它留在队首，补发暂停到下一份实时报告发送成功
+  service_.FailOnce("spooled-2");
+  service_.SetFailing(false);
+  sender_->Enqueue(MakeReport("live-1"));
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.failed_total == 4; }));
+  EXPECT_EQ(sender_->GetStats().spool_reports, 2u);
+  sender_->Enqueue(MakeReport("live-2"));
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.replayed_total == 3; }));
+
+  const auto stats = sender_->GetStats();
+  EXPECT_EQ(stats.spooled_total, 3u);
+  EXPECT_EQ(stats.spool_reports, 0u);
+  std::vector<std::string> hosts;
+  for (const auto& report : service_.received()) {
+    hosts.push_back(report.host_id());
+  }
+  EXPECT_EQ(hosts, std::vector<std::string>(
+                       {"live-1", "spooled-1", "live-2", "spooled-2", "spooled-3"}));
+}
+
+TEST_F(ReportSenderTest, ReplaysSpoolAfterRestart) {
+  ReportSenderOptions options;
+  options.max_in_flight = 1;
+  options.spool_directory = spool_directory_.string();
+  options.replay_max_per_second = 100;
+  service_.SetFailing(true);
+  StartSender(options);
+  sender_->Enqueue(MakeReport("spooled-1"));
+  sender_->Enqueue(MakeReport("spooled-2"));
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.spooled_total == 2; }));
+  sender_.reset();
+
+  service_.SetFailing(false);
+  StartSender(options);
+  sender_->Enqueue(MakeReport("live"));
+  ASSERT_TRUE(WaitForStats([](const ReportSenderStats& s) { return s.replayed_total == 2; }));
+  const auto received = service_.received();
+  ASSERT_EQ(received.size(), 3u);
+  EXPECT_EQ(received[1].host_id(), "spooled-1");
+  EXPECT_EQ(received[2].host_id(), "spooled-2");
+  EXPECT_TRUE(received[2].backfill());
+}
+
+}  // namespace
@@ -0,0 +1,137 @@
+#include "../src/sdk/metrics.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../src/client/shm_ingestor.h"
+
+namespace fs = std::filesystem;
+using system_insight::client::ShmIngestor;
+using system_insight::client::ShmIngestorOptions;
+using system_insight::sdk::Counter;
+using system_insight::sdk::Histogram;
+using system_insight::sdk::MetricsFlusher;
+using system_insight::sdk::MetricsRegistry;
+using systeminsight::proto::MetricsReport;
+
+TEST(SdkMetricsTest, CounterSumsShardsAcrossThreads) {
+  Counter counter;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 40; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 1000; ++i) {
+        counter.Add();
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(counter.Value(), 40000u);
+}
+
+TEST(SdkMetricsTest, HistogramBucketsAreLogLinear) {
+  // 小值精确，之后每个 2 的幂区间 8 个桶，下标连续且单调
+  for (uint64_t v = 0; v < 8; ++v) {
+    EXPECT_EQ(Histogram::BucketIndex(v), v);
+  }
+  EXPECT_EQ(Histogram::BucketIndex(8), 8u);
+  EXPECT_EQ(Histogram::BucketIndex(16), 16u);
+  EXPECT_EQ(Histogram::BucketIndex(17), 16u);
+  EXPECT_EQ(Histogram::BucketIndex(UINT64_MAX), Histogram::kBucketCount - 1);
+
+  size_t previous = 0;
+  for (uint64_t v = 1; v < (uint64_t{1} << 40); v = v * 3 / 2 + 1) {
+    const size_t index = Histogram::BucketIndex(v);
+    EXPECT_GE(index, previous);
+    const double lower = static_cast<double>(Histogram::BucketLowerBound(index));
+    EXPECT_LE(lower, static_cast<double>(v));
+    EXPECT_GT(lower + Histogram::BucketWidth(index), static_cast<double>(v));
+    EXPECT_LE(Histogram::BucketWidth(index), std::max(1.0, static_cast<double>(v) / 8.0));
+    previous = index;
+  }
+}
+
+TEST(SdkMetricsTest, HistogramQuantilesWithinBucketError) {
+  Histogram histogram;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      for (uint64_t v = 1; v <= 1000; ++v) {
+        histogram.Observe(v);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  Histogram::Snapshot snapshot;
+  histogram.Read(&snapshot);
+  EXPECT_EQ(snapshot.count, 4000u);
+  EXPECT_EQ(snapshot.sum, 4u * 500500u);
+  EXPECT_NEAR(snapshot.Quantile(0.5), 500.0, 500.0 / 8.0);
+  EXPECT_NEAR(snapshot.Quantile(0.99), 990.0, 990.0 / 8.0);
+}
+
+TEST(SdkMetricsTest, RegistryRejectsTypeConflicts) {
+  MetricsRegistry registry;
+  Counter* counter = registry.GetCounter("svc.requests_total");
+  ASSERT_NE(counter, nullptr);
+  EXPECT_EQ(registry.GetCounter("svc.requests_total"), counter);
+  EXPECT_EQ(registry.GetGauge("svc.requests_total"), nullptr);
+  EXPECT_NE(registry.GetHistogram("svc.latency_us"), nullptr);
+}
+
+TEST(SdkMetricsTest, FlusherPublishesAggregatesToAgent) {
+  fs::path directory =
+      fs::temp_directory_path() / ("system_insight_sdk_test_" + std::to_string(::getpid()));
+  fs::remove_all(directory);
+  fs::create_directories(directory);
+
+  MetricsRegistry registry;
+  Counter* requests = registry.GetCounter("svc.requests_total");
+  registry.GetGauge("svc.queue_depth")->Set(12);
+  Histogram* latency = registry.GetHistogram("svc.latency_us");
+
+  MetricsFlusher::Options options;
+  options.app = "svc";
+  options.interval = std::chrono::hours(1);  // 只测显式刷新
+  options.shm.directory = directory.string();
+  MetricsFlusher flusher(&registry, options);
+  ASSERT_TRUE(flusher.Start());
+
+  requests->Add(5);
+  for (uint64_t v = 1; v <= 100; ++v) {
+    latency->Observe(v);
+  }
+  flusher.Flush();
+  requests->Add(3);
+  latency->Observe(5000);
+  flusher.Flush();
+
+  ShmIngestorOptions ingestor_options;
+  ingestor_options.directory = directory.string();
+  ShmIngestor ingestor(ingestor_options);
+  MetricsReport report;
+  ingestor.Drain(1000, &report);
+  std::map<std::string, double> values;
+  for (const auto& sample : report.samples()) {
+    values[sample.name()] = sample.value();
+  }
+  EXPECT_DOUBLE_EQ(values["svc.requests_total"], 8.0);
+  EXPECT_DOUBLE_EQ(values["svc.queue_depth"], 12.0);
+  EXPECT_DOUBLE_EQ(values["svc.latency_us_count"], 101.0);
+  EXPECT_DOUBLE_EQ(values["svc.latency_us_sum"], 5050.0 + 5000.0);
+  // 分位数只覆盖最近一次刷新以来的样本
+  EXPECT_NEAR(values["svc.latency_us_p50"], 5000.0, 5000.0 / 8.0);
+
+  flusher.Stop();
+  fs::remove_all(directory);
+}
@@ -0,0 +1,171 @@
+#include "../src/common/storage/segment_log.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+namespace fs = std::filesystem;
+using system_insight::common::storage::SegmentLog;
+using system_insight::common::storage::SegmentLogOptions;
+
+class TempDir {
+ public:
+  // 每个用例在独立进程中运行，目录名带上进程号与用例名，避免并行运行时互相删除
+  TempDir() {
+    const auto* test = ::testing::UnitTest::GetInstance()->current_test_info();
+    path_ = fs::temp_directory_path() /
+            fs::path("system_insight_segment_log_test_" + std::to_string(::getpid()) + "_" +
+                     test->name());
+    std::error_code ec;
+    fs::remove_all(path_, ec);
+  }
+  ~TempDir() { std::error_code ec; fs::remove_all(path_, ec); }
+
+  const fs::path& path() const { return path_; }
+
+ private:
+  fs::path path_;
+};
+
+namespace {
+
+SegmentLogOptions MakeOptions(const TempDir& dir) {
+  SegmentLogOptions options;
+  options.directory = dir.path().string();
+  options.segment_bytes = 64;
+  options.max_total_bytes = 1024;
+  return options;
+}
+
+std::string Record(int i) {
+  return "report-" + std::to_string(i);
+}
+
+}  // namespace
+
+TEST(SegmentLogTest, ConsumesOldestFirstAcrossSegmentsAndRestarts) {
+  TempDir dir;
+  {
+    SegmentLog log(MakeOptions(dir));
+    ASSERT_TRUE(log.Open());
+    for (int i = 0; i < 10; ++i) {
+      ASSERT_TRUE(log.Append(Record(i)));
+    }
+    std::string payload;
+    for (int i = 0; i < 3; ++i) {
+      ASSERT_TRUE(log.ReadFront(&payload));
+      EXPECT_EQ(payload, Record(i));
+      log.PopFront();
+    }
+    EXPECT_EQ(log.pending_records(), 7u);
+  }
+
+  // 消费位置不落盘，重启后从最旧的未删除段重新开始
+  SegmentLog log(MakeOptions(dir));
+  ASSERT_TRUE(log.Open());
+  ASSERT_TRUE(log.Append(Record(10)));
+  std::string payload;
+  int expected = -1;
+  int count = 0;
+  while (log.ReadFront(&payload)) {
+    int value = std::stoi(payload.substr(payload.find('-') + 1));
+    EXPECT_GT(value, expected);
+    expected = value;
+    log.PopFront();
+    ++count;
+  }
+  EXPECT_EQ(expected, 10);
+  EXPECT_GE(count, 8);
+  EXPECT_TRUE(log.empty());
+  EXPECT_EQ(log.total_bytes(), 0u);
+  EXPECT_TRUE(fs::is_empty(dir.path()));
+}
+
+TEST(SegmentLogTest, TruncatesTornTailOnOpen) {
+  TempDir dir;
+  fs::path last_segment;
+  {
+    SegmentLog log(MakeOptions(dir));
+    ASSERT_TRUE(log.Open());
+    ASSERT_TRUE(log.Append(Record(0)));
+    ASSERT_TRUE(log.Append(Record(1)));
+  }
+  for (const auto& entry : fs::directory_iterator(dir.path())) {
+    last_segment = std::max(last_segment, entry.path());
+  }
+  auto intact_size = fs::file_size(last_segment);
+  {
+    // 模拟写了一半的记录
+    std::ofstream out(last_segment, std::ios::binary | std::ios::app);
+    out.write("\x20\x00\x00\x00\x01\x02", 6);
+  }
+
+  SegmentLog log(MakeOptions(dir));
+  ASSERT_TRUE(log.Open());
+  EXPECT_EQ(fs::file_size(last_segment), intact_size);
+  EXPECT_EQ(log.pending_records(), 2u);
+  std::string payload;
+  ASSERT_TRUE(log.ReadFront(&payload));
+  EXPECT_EQ(payload, Record(0));
+}
+
+TEST(SegmentLogTest, DropsOldestSegmentsWhenOverLimit) {
+  TempDir dir;
+  SegmentLogOptions options = MakeOptions(dir);
+  options.max_total_bytes = 256;
+  SegmentLog log(options);
+  ASSERT_TRUE(log.Open());
+  for (int i = 0; i < 100; ++i) {
+    ASSERT_TRUE(log.Append(Record(i)));
+  }
+  EXPECT_LE(log.total_bytes(), options.max_total_bytes);
+  EXPECT_GT(log.dropped_records(), 0u);
+  EXPECT_EQ(log.pending_records() + log.dropped_records(), 100u);
+
+  std::string payload;
+  std::string last;
+  while (log.ReadFront(&payload)) {
+    last = payload;
+    log.PopFront();
+  }
+  EXPECT_EQ(last, Record(99));
+}
+
+TEST(SegmentLogTest, ScansWithoutConsumingAndDropsWholeSegments) {
+  TempDir dir;
+  SegmentLog log(MakeOptions(dir));
+  ASSERT_TRUE(log.Open());
+  // 每条记录 16 字节，每段 4 条
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_TRUE(log.Append(Record(i)));
+  }
+  std::string payload;
+  ASSERT_TRUE(log.ReadFront(&payload));
+  log.PopFront();
+
+  std::vector<std::string> scanned;
+  ASSERT_TRUE(log.Scan([&scanned](const std::string& record) {
+    scanned.push_back(record);
+    return true;
+  }));
+  ASSERT_EQ(scanned.size(), 9u);
+  EXPECT_EQ(scanned.front(), Record(1));
+  EXPECT_EQ(scanned.back(), Record(9));
+  EXPECT_EQ(log.pending_records(), 9u);
+
+  // 第一段剩余 3 条被整段丢弃，第二段只被部分覆盖而保留
+  EXPECT_EQ(log.DropFront(5), 3u);
+  EXPECT_EQ(log.pending_records(), 6u);
+  EXPECT_EQ(log.dropped_records(), 0u);
+  ASSERT_TRUE(log.ReadFront(&payload));
+  EXPECT_EQ(payload, Record(4));
+
+  int visited = 0;
+  ASSERT_TRUE(log.Scan([&visited](const std::string&) { return ++visited < 2; }));
+  EXPECT_EQ(visited, 2);
+}
@@ -0,0 +1,122 @@
+#include "../src/client/shm_ingestor.h"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../src/sdk/shm_metrics.h"
+
+namespace fs = std::filesystem;
+using system_insight::client::ShmIngestor;
+using system_insight::client::ShmIngestorOptions;
+using system_insight::sdk::ShmMetricsProducer;
+using systeminsight::proto::MetricsReport;
+namespace shm = system_insight::sdk::shm;
+
+namespace {
+
+class ShmIngestorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    directory_ = fs::temp_directory_path() /
+                 ("system_insight_shm_test_" + std::to_string(::getpid()));
+    fs::remove_all(directory_);
+    fs::create_directories(directory_);
+    options_.directory = directory_.string();
+  }
+  void TearDown() override { fs::remove_all(directory_); }
+
+  ShmMetricsProducer::Options ProducerOptions(uint32_t capacity) const {
+    ShmMetricsProducer::Options options;
+    options.directory = directory_.string();
+    options.capacity = capacity;
+    options.max_metrics = 8;
+    return options;
+  }
+
+  static std::map<std::string, double> Values(const MetricsReport& report) {
+    std::map<std::string, double> values;
+    for (const auto& sample : report.samples()) {
+      EXPECT_EQ(sample.labels_size(), 1);
+      EXPECT_EQ(sample.labels(0).key(), "app");
+      values[sample.labels(0).value() + "/" + sample.name()] = sample.value();
+    }
+    return values;
+  }
+
+  fs::path directory_;
+  ShmIngestorOptions options_;
+};
+
+}  // namespace
+
+TEST_F(ShmIngestorTest, DrainsCountersAndGaugesFromMultipleThreads) {
+  auto producer = ShmMetricsProducer::Create("orders", ProducerOptions(1 << 16));
+  ASSERT_NE(producer, nullptr);
+  int32_t requests = producer->Register("orders.requests_total", shm::kCounter);
+  int32_t queue = producer->Register("orders.queue_depth", shm::kGauge);
+  EXPECT_EQ(producer->Register("orders.requests_total", shm::kCounter), requests);
+
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([&] {
+      for (int i = 0; i < 1000; ++i) {
+        producer->Add(requests, 1);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  producer->Set(queue, 7);
+  producer->Set(queue, 3);
+
+  ShmIngestor ingestor(options_);
+  MetricsReport report;
+  ingestor.Drain(1000, &report);
+  auto values = Values(report);
+  EXPECT_EQ(ingestor.producer_count(), 1u);
+  EXPECT_DOUBLE_EQ(values["orders/orders.requests_total"], 4000.0);
+  EXPECT_DOUBLE_EQ(values["orders/orders.queue_depth"], 3.0);
+  EXPECT_DOUBLE_EQ(values["orders/system_insight.agent.shm_dropped_total"], 0.0);
+
+  // 计数器跨周期累加，gauge 沿用最后一次的值
+  producer->Add(requests, 5);
+  report.Clear();
+  ingestor.Drain(2000, &report);
+  values = Values(report);
+  EXPECT_DOUBLE_EQ(values["orders/orders.requests_total"], 4005.0);
+  EXPECT_DOUBLE_EQ(values["orders/orders.queue_depth"], 3.0);
+}
+
+TEST_F(ShmIngestorTest, CountsDropsAndRemovesClosedProducers) {
+  auto producer = ShmMetricsProducer::Create("batch", ProducerOptions(4));
+  ASSERT_NE(producer, nullptr);
+  int32_t jobs = producer->Register("batch.jobs_total", shm::kCounter);
+  for (int i = 0; i < 6; ++i) {
+    producer->Add(jobs, 1);
+  }
+  EXPECT_EQ(producer->dropped(), 2u);
+
+  ShmIngestor ingestor(options_);
+  MetricsReport report;
+  ingestor.Drain(1000, &report);
+  auto values = Values(report);
+  EXPECT_DOUBLE_EQ(values["batch/batch.jobs_total"], 4.0);
+  EXPECT_DOUBLE_EQ(values["batch/system_insight.agent.shm_dropped_total"], 2.0);
+
+  // 环被读空后又可以写入；生产者退出后读完剩余记录并删除段文件
+  producer->Add(jobs, 10);
+  producer.reset();
+  report.Clear();
+  ingestor.Drain(2000, &report);
+  EXPECT_DOUBLE_EQ(Values(report)["batch/batch.jobs_total"], 14.0);
+  EXPECT_EQ(ingestor.producer_count(), 0u);
+  EXPECT_TRUE(fs::is_empty(directory_));
+}
@@ -0,0 +1,139 @@
+#include "../src/client/textfile_collector.h"
+
+#include <unistd.h>
+
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+namespace fs = std::filesystem;
+using system_insight::client::TextfileCollector;
+using system_insight::client::TextfileCollectorOptions;
+using systeminsight::proto::MetricSample;
+using systeminsight::proto::MetricsReport;
+
+namespace {
+
+class TextfileCollectorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    directory_ = fs::temp_directory_path() /
+                 ("system_insight_textfile_test_" + std::to_string(::getpid()));
+    fs::remove_all(directory_);
+    fs::create_directories(directory_);
+    options_.directory = directory_.string();
+  }
+  void TearDown() override { fs::remove_all(directory_); }
+
+  // 与批处理任务的推荐做法一致：先写临时文件再 rename
+  void WriteFile(const std::string& name, const std::string& content) {
+    fs::path temp = directory_ / ("." + name + ".tmp");
+    std::ofstream(temp) << content;
+    fs::rename(temp, directory_ / name);
+  }
+
+  // 以 name{k=v,...} 为键，不含 agent 自身的样本
+  static std::map<std::string, double> Values(const MetricsReport& report) {
+    std::map<std::string, double> values;
+    for (const auto& sample : report.samples()) {
+      if (sample.name().rfind("system_insight.agent.", 0) == 0) continue;
+      std::string key = sample.name();
+      for (const auto& label : sample.labels()) {
+        key += "," + label.key() + "=" + label.value();
+      }
+      values[key] = sample.value();
+    }
+    return values;
+  }
+
+  fs::path directory_;
+  TextfileCollectorOptions options_;
+};
+
+}  // namespace
+
+TEST(TextfileParseLineTest, ParsesExpositionFormat) {
+  MetricSample sample;
+  bool error = false;
+  ASSERT_TRUE(TextfileCollector::ParseLine(
+      "backup_last_success{job=\"db\", path=\"C:\\\\data \\\"x\\\"\\n\"} 1.5e9 1700000000000",
+      &sample, &error));
+  EXPECT_EQ(sample.name(), "backup_last_success");
+  ASSERT_EQ(sample.labels_size(), 2);
+  EXPECT_EQ(sample.labels(1).key(), "path");
+  EXPECT_EQ(sample.labels(1).value(), "C:\\data \"x\"\n");
+  EXPECT_DOUBLE_EQ(sample.value(), 1.5e9);
+
+  ASSERT_TRUE(TextfileCollector::ParseLine("queue_depth +Inf", &sample, &error));
+  EXPECT_TRUE(std::isinf(sample.value()));
+  ASSERT_TRUE(TextfileCollector::ParseLine("ratio{} NaN", &sample, &error));
+  EXPECT_TRUE(std::isnan(sample.value()));
+
+  EXPECT_FALSE(TextfileCollector::ParseLine("# TYPE backup_last_success gauge", &sample, &error));
+  EXPECT_FALSE(error);
+  EXPECT_FALSE(TextfileCollector::ParseLine("   ", &sample, &error));
+  EXPECT_FALSE(error);
+  for (const char* bad : {"1metric 1", "m{job=db} 1", "m{job=\"db\" 1", "m abc", "m 1 2 3",
+                          "m{1x=\"a\"} 1"}) {
+    EXPECT_FALSE(TextfileCollector::ParseLine(bad, &sample, &error)) << bad;
+    EXPECT_TRUE(error) << bad;
+  }
+}
+
+TEST_F(TextfileCollectorTest, ReparsesOnlyChangedFiles) {
+  WriteFile("backup.prom", "# HELP backup_ok ok\nbackup_ok{job=\"db\"} 1\nbackup_bytes 42\n");
+  WriteFile("cleanup.prom", "cleanup_removed 7");  // 没有结尾换行
+  std::ofstream(directory_ / "ignored.txt") << "not_a_metric 1\n";
+
+  TextfileCollector collector(options_);
+  MetricsReport report;
+  collector.Append(1000, &report);
+  auto values = Values(report);
+  EXPECT_EQ(values.size(), 3u);
+  EXPECT_DOUBLE_EQ(values["backup_ok,job=db"], 1.0);
+  EXPECT_DOUBLE_EQ(values["backup_bytes"], 42.0);
+  EXPECT_DOUBLE_EQ(values["cleanup_removed"], 7.0);
+  EXPECT_EQ(report.samples(0).timestamp_ms(), 1000);
+  EXPECT_EQ(collector.files_parsed_total(), 2u);
+
+  // 没有变化的周期不重新解析
+  report.Clear();
+  collector.Append(2000, &report);
+  EXPECT_EQ(collector.files_parsed_total(), 2u);
+  EXPECT_EQ(Values(report).size(), 3u);
+  EXPECT_EQ(report.samples(0).timestamp_ms(), 2000);
+
+  WriteFile("cleanup.prom", "cleanup_removed 9\n");
+  report.Clear();
+  collector.Append(3000, &report);
+  EXPECT_EQ(collector.files_parsed_total(), 3u);
+  EXPECT_DOUBLE_EQ(Values(report)["cleanup_removed"], 9.0);
+
+  fs::remove(directory_ / "backup.prom");
+  report.Clear();
+  collector.Append(4000, &report);
+  values = Values(report);
+  EXPECT_EQ(values.size(), 1u);
+  EXPECT_EQ(collector.file_count(), 1u);
+  EXPECT_EQ(collector.files_parsed_total(), 3u);
+}
+
+TEST_F(TextfileCollectorTest, BoundsLinesAndSamples) {
+  options_.max_line_bytes = 64;
+  options_.max_samples_per_file = 2;
+  WriteFile("job.prom", "a 1\n" + std::string(200, 'x') + " 1\nbroken{\nb 2\nc 3\n");
+
+  TextfileCollector collector(options_);
+  MetricsReport report;
+  collector.Append(1000, &report);
+  auto values = Values(report);
+  EXPECT_EQ(values.size(), 2u);
+  EXPECT_DOUBLE_EQ(values["a"], 1.0);
+  EXPECT_DOUBLE_EQ(values["b"], 2.0);
+  // 超长行、格式错误的行与超出样本上限的行
+  EXPECT_EQ(collector.parse_errors_total(), 3u);
+}
@@ -0,0 +1,525 @@
+#include "../src/server/time_series_db.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "../src/server/gorilla_chunk.h"
+
+using system_insight::server::AggregateBlock;
+using system_insight::server::HeadChunk;
+using system_insight::server::PointBlock;
+using system_insight::server::SeriesStore;
+using system_insight::server::TimeSeriesDb;
+using system_insight::server::TsdbOptions;
+using systeminsight::proto::MetricSample;
+using systeminsight::proto::MetricsReport;
+
+namespace {
+
+MetricsReport MakeReport(const std::string& host, int64_t timestamp_ms, double value) {
+  MetricsReport report;
+  report.set_host_id(host);
+  auto* sample = report.add_samples();
+  sample->set_name("cpu");
+  sample->set_value(value);
+  sample->set_timestamp_ms(timestamp_ms);
+  return report;
+}
+
+// 目录名带上进程号与用例名，并行运行时互不干扰
+std::filesystem::path TestDirectory() {
+  const auto* test = ::testing::UnitTest::GetInstance()->current_test_info();
+  return std::filesystem::temp_directory_path() /
+         ("system_insight_tsdb_" + std::to_string(::getpid()) + "_" + test->name());
+}
+
+TsdbOptions PersistentOptions(const std::filesystem::path& directory) {
+  TsdbOptions options;
+  options.data_directory = directory.string();
+  // 测试用的时间戳远早于当前时间，保留期放宽到不会过期
+  options.retention_ms = INT64_MAX / 4;
+  options.wal_segment_bytes = 4096;
+  return options;
+}
+
+uint32_t CpuSeries(const SeriesStore& store) {
+  MetricSample sample;
+  sample.set_name("cpu");
+  return store.Find(sample);
+}
+
+TimeSeriesDb::SeriesRef CpuRef(const TimeSeriesDb& db) {
+  std::vector<TimeSeriesDb::SeriesRef> refs;
+  db.Select([](const std::string&) { return true; }, {CpuSeries(db.series_store())}, &refs);
+  return refs.empty() ? TimeSeriesDb::SeriesRef{} : refs.front();
+}
+
+struct Bucket {
+  double min = std::numeric_limits<double>::infinity();
+  double max = -std::numeric_limits<double>::infinity();
+  double sum = 0;
+  double count = 0;
+
+  void Merge(double min_value, double max_value, double sum_value, double count_value) {
+    min = std::min(min, min_value);
+    max = std::max(max, max_value);
+    sum += sum_value;
+    count += count_value;
+  }
+};
+
+// 把汇总行按 step_ms 合并成桶
+std::vector<Bucket> MergeBuckets(const AggregateBlock& block, int64_t step_ms, size_t buckets) {
+  std::vector<Bucket> merged(buckets);
+  for (size_t i = 0; i < block.size(); ++i) {
+    merged[static_cast<size_t>(block.timestamps_ms[i] / step_ms)].Merge(
+        block.min[i], block.max[i], block.sum[i], block.count[i]);
+  }
+  return merged;
+}
+
+// 直接由原始样本计算的桶，作为汇总结果的对照
+std::vector<Bucket> RawBuckets(const TimeSeriesDb::SeriesRef& ref, int64_t step_ms,
+                               size_t buckets) {
+  PointBlock points;
+  TimeSeriesDb::Read(ref, 0, INT64_MAX, &points);
+  std::vector<Bucket> merged(buckets);
+  for (size_t i = 0; i < points.size(); ++i) {
+    const double value = points.values[i];
+    merged[static_cast<size_t>(points.timestamps_ms[i] / step_ms)].Merge(value, value, value, 1);
+  }
+  return merged;
+}
+
+void ExpectSameBuckets(const std::vector<Bucket>& actual, const std::vector<Bucket>& expected) {
+  ASSERT_EQ(actual.size(), expected.size());
+  for (size_t i = 0; i < actual.size(); ++i) {
+    EXPECT_EQ(actual[i].count, expected[i].count) << "bucket " << i;
+    if (expected[i].count == 0) continue;
+    EXPECT_EQ(actual[i].min, expected[i].min) << "bucket " << i;
+    EXPECT_EQ(actual[i].max, expected[i].max) << "bucket " << i;
+    EXPECT_NEAR(actual[i].sum, expected[i].sum, 1e-9 * std::abs(expected[i].sum)) << "bucket " << i;
+  }
+}
+
+}  // namespace
+
+TEST(GorillaChunkTest, RoundTripsIrregularTimestampsAndValues) {
+  HeadChunk chunk;
+  PointBlock written;
+  int64_t timestamp_ms = 1'700'000'000'000;
+  const double values[] = {0.0, 1.5, 1.5, -3.25, 1e300, std::numeric_limits<double>::infinity(),
+                           42.0, 42.000001, 7.0};
+  const int64_t steps[] = {15000, 15000, 15001, 14000, 90000000, 1, 15000, 15000, 15000};
+  for (size_t i = 0; i < std::size(values); ++i) {
+    timestamp_ms += steps[i];
+    ASSERT_TRUE(chunk.Append(timestamp_ms, values[i]));
+    written.timestamps_ms.push_back(timestamp_ms);
+    written.values.push_back(values[i]);
+  }
+
+  PointBlock read;
+  chunk.Read(std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max(), &read);
+  ASSERT_EQ(read.size(), written.size());
+  for (size_t i = 0; i < read.size(); ++i) {
+    EXPECT_EQ(read.timestamps_ms[i], written.timestamps_ms[i]);
+    EXPECT_EQ(read.values[i], written.values[i]);
+  }
+
+  // 封存块解码出同样的点
+  auto sealed = chunk.Seal();
+  PointBlock decoded;
+  system_insight::server::DecodeChunk(sealed->words(), sealed->word_count(), sealed->count,
+                                      written.timestamps_ms[2], written.timestamps_ms[4], &decoded);
+  ASSERT_EQ(decoded.size(), 3u);
+  EXPECT_EQ(decoded.values[0], 1.5);
+  EXPECT_EQ(decoded.values[2], 1e300);
+}
+
+TEST(GorillaChunkTest, RegularSeriesCompressesWell) {
+  HeadChunk chunk;
+  uint32_t appended = 0;
+  while (chunk.Append(1000 + appended * 15000, 100.0 + (appended % 3))) {
+    ++appended;
+  }
+  // 固定间隔时间戳每个只占 1 位，取值在少数几个数之间变化
+  EXPECT_GE(appended, 40u);
+  EXPECT_LT(chunk.Seal()->word_count() * 8.0 / appended, 4.0);
+}
+
+TEST(TimeSeriesDbTest, AppendsAcrossChunksAndQueriesRange) {
+  auto store = std::make_shared<SeriesStore>();
+  TimeSeriesDb db(TsdbOptions{}, store);
+  for (int i = 0; i < 500; ++i) {
+    ASSERT_EQ(db.Append(MakeReport("host", 1000 + i * 1000, i * 0.5)), 1u);
+  }
+  // 乱序与重复的时间戳被丢弃
+  EXPECT_EQ(db.Append(MakeReport("host", 1000, 9.0)), 0u);
+  EXPECT_EQ(db.out_of_order_total(), 1u);
+  EXPECT_EQ(db.series_count(), 1u);
+
+  PointBlock points;
+  ASSERT_TRUE(db.Query("host", CpuSeries(*store), 0, 1'000'000, &points));
+  ASSERT_EQ(points.size(), 500u);
+  for (int i = 0; i < 500; ++i) {
+    EXPECT_EQ(points.timestamps_ms[i], 1000 + i * 1000);
+    EXPECT_DOUBLE_EQ(points.values[i], i * 0.5);
+  }
+
+  points.clear();
+  ASSERT_TRUE(db.Query("host", CpuSeries(*store), 100'500, 110'000, &points));
+  ASSERT_EQ(points.size(), 10u);
+  EXPECT_EQ(points.timestamps_ms.front(), 101'000);
+  EXPECT_FALSE(db.Query("other", CpuSeries(*store), 0, 1'000'000, &points));
+}
+
+TEST(TimeSeriesDbTest, PurgeEnforcesRetentionAndMemoryBudget) {
+  auto store = std::make_shared<SeriesStore>();
+  TsdbOptions options;
+  options.retention_ms = 60'000;
+  options.rollups.clear();  // 汇总的保留见 RollupsFollowTierRetention
+  TimeSeriesDb db(options, store);
+  for (int i = 0; i < 120; ++i) {
+    db.Append(MakeReport("host", i * 1000, i));
+  }
+  db.Purge(120'000);
+  PointBlock points;
+  ASSERT_TRUE(db.Query("host", CpuSeries(*store), 0, 200'000, &points));
+  ASSERT_GT(points.size(), 0u);
+  // 整块丢弃：块内最新的点都在保留期内
+  EXPECT_GT(points.timestamps_ms.front(), 45'000);
+  EXPECT_EQ(points.timestamps_ms.back(), 119'000);
+
+  // 保留期内没有新样本的序列被移除
+  db.Purge(500'000);
+  EXPECT_EQ(db.series_count(), 0u);
+  EXPECT_EQ(db.memory_bytes(), 0u);
+
+  TsdbOptions small;
+  small.memory_budget_bytes = 4096;
+  TimeSeriesDb budgeted(small, store);
+  for (int i = 0; i < 2000; ++i) {
+    budgeted.Append(MakeReport("host", i * 1000, i * 1.1));
+  }
+  budgeted.Purge(2'000'000);
+  EXPECT_LE(budgeted.memory_bytes(), 4096u);
+  points.clear();
+  ASSERT_TRUE(budgeted.Query("host", CpuSeries(*store), 0, 3'000'000, &points));
+  EXPECT_EQ(points.timestamps_ms.back(), 1'999'000);
+}
+
+TEST(TimeSeriesDbTest, QueriesRunConcurrentlyWithAppends) {
+  auto store = std::make_shared<SeriesStore>();
+  TimeSeriesDb db(TsdbOptions{}, store);
+  db.Append(MakeReport("host", 0, 0));
+  const uint32_t series = CpuSeries(*store);
+  std::atomic<bool> done{false};
+
+  std::thread reader([&] {
+    PointBlock points;
+    while (!done.load()) {
+      points.clear();
+      db.Query("host", series, 0, INT64_MAX, &points);
+      for (size_t i = 0; i < points.size(); ++i) {
+        // 读到的始终是从头开始、连续无缺口的前缀
+        ASSERT_EQ(points.timestamps_ms[i], static_cast<int64_t>(i) * 1000);
+        ASSERT_EQ(points.values[i], static_cast<double>(i));
+      }
+    }
+  });
+  for (int i = 1; i < 5000; ++i) {
+    db.Append(MakeReport("host", i * 1000, i));
+  }
+  done.store(true);
+  reader.join();
+}
+
+TEST(TimeSeriesDbTest, AppendsSeriesOfOneHostConcurrentlyWithCompaction) {
+  const auto directory = TestDirectory();
+  std::filesystem::remove_all(directory);
+  constexpr int kWriters = 4;
+  constexpr int kPoints = 2000;
+  auto metric = [](int writer) {
+    MetricSample sample;
+    sample.set_name("metric_" + std::to_string(writer));
+    return sample;
+  };
+  {
+    TimeSeriesDb db(PersistentOptions(directory), std::make_shared<SeriesStore>());
+    ASSERT_TRUE(db.Open(nullptr));
+    // 同一主机的不同序列落在同一分片，追加只持各自的序列锁，压缩在分片锁内逐个取序列锁
+    std::atomic<bool> done{false};
+    std::thread compactor([&] {
+      while (!done.load()) {
+        EXPECT_TRUE(db.Compact());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    });
+    std::vector<std::thread> writers;
+    for (int w = 0; w < kWriters; ++w) {
+      writers.emplace_back([&db, &metric, w] {
+        for (int i = 0; i < kPoints; ++i) {
+          MetricsReport report;
+          report.set_host_id("host");
+          auto* sample = report.add_samples();
+          *sample = metric(w);
+          sample->set_value(i);
+          sample->set_timestamp_ms(1000 + i * 1000);
+          db.Append(report);
+        }
+      });
+    }
+    for (auto& writer : writers) writer.join();
+    done.store(true);
+    compactor.join();
+    EXPECT_EQ(db.out_of_order_total(), 0u);
+  }
+
+  auto store = std::make_shared<SeriesStore>();
+  TimeSeriesDb db(PersistentOptions(directory), store);
+  ASSERT_TRUE(db.Open(nullptr));
+  for (int w = 0; w < kWriters; ++w) {
+    PointBlock points;
+    ASSERT_TRUE(db.Query("host", store->Find(metric(w)), 0, INT64_MAX, &points));
+    ASSERT_EQ(points.size(), static_cast<size_t>(kPoints)) << "writer " << w;
+    for (size_t i = 0; i < points.size(); ++i) {
+      ASSERT_EQ(points.values[i], static_cast<double>(i));
+    }
+  }
+  std::filesystem::remove_all(directory);
+}
+
+TEST(TimeSeriesDbTest, RestartsFromBlocksAndWalTail) {
+  const auto directory = TestDirectory();
+  std::filesystem::remove_all(directory);
+  constexpr int kCompacted = 1000;
+  constexpr int kTail = 50;
+  {
+    TimeSeriesDb db(PersistentOptions(directory), std::make_shared<SeriesStore>());
+    ASSERT_TRUE(db.Open(nullptr));
+    for (int i = 0; i < kCompacted; ++i) {
+      db.Append(MakeReport("host", 1000 + i * 1000, i * 0.5));
+    }
+    const uint64_t wal_before = db.wal_bytes();
+    ASSERT_TRUE(db.Compact());
+    EXPECT_EQ(db.block_count(), 1u);
+    // 已落盘封存块对应的日志段被删除，只保留头块之后的部分
+    EXPECT_LT(db.wal_bytes(), wal_before / 4);
+    for (int i = kCompacted; i < kCompacted + kTail; ++i) {
+      db.Append(MakeReport("host", 1000 + i * 1000, i * 0.5));
+    }
+  }
+
+  auto store = std::make_shared<SeriesStore>();
+  TimeSeriesDb db(PersistentOptions(directory), store);
+  int replayed = 0;
+  ASSERT_TRUE(db.Open([&replayed](const MetricsReport&) { ++replayed; }));
+  EXPECT_EQ(db.block_count(), 1u);
+  EXPECT_LT(replayed, kCompacted / 2);
+  EXPECT_EQ(db.out_of_order_total(), 0u);
+
+  PointBlock points;
+  ASSERT_TRUE(db.Query("host", CpuSeries(*store), 0, INT64_MAX, &points));
+  ASSERT_EQ(points.size(), static_cast<size_t>(kCompacted + kTail));
+  for (size_t i = 0; i < points.size(); ++i) {
+    ASSERT_EQ(points.timestamps_ms[i], 1000 + static_cast<int64_t>(i) * 1000);
+    ASSERT_EQ(points.values[i], i * 0.5);
+  }
+
+  // 重启后的写入与再次压缩接着已有的块继续
+  db.Append(MakeReport("host", 1000 + (kCompacted + kTail) * 1000, 1.0));
+  ASSERT_TRUE(db.Compact());
+  db.Purge(INT64_MAX / 4 + 1000 + 2000 * 1000);
+  EXPECT_EQ(db.block_count(), 0u);
+  std::filesystem::remove_all(directory);
+}
+
+TEST(TimeSeriesDbTest, KeepsBackfillReplayedAfterLiveData) {
+  const auto directory = TestDirectory();
+  std::filesystem::remove_all(directory);
+  constexpr int kLive = 300;
+  constexpr int kBackfill = 300;
+  // 客户端断线期间的报告在恢复后补发，此时序列已有更晚的实时样本
+  const auto backfill = [](int64_t timestamp_ms, double value) {
+    MetricsReport report = MakeReport("host", timestamp_ms, value);
+    report.set_backfill(true);
+    return report;
+  };
+  std::vector<int64_t> expected;
+  {
+    TimeSeriesDb db(PersistentOptions(directory), std::make_shared<SeriesStore>());
+    ASSERT_TRUE(db.Open(nullptr));
+    for (int i = 0; i < kLive; ++i) {
+      ASSERT_EQ(db.Append(MakeReport("host", 1'000'000 + i * 1000, i)), 1u);
+      expected.push_back(1'000'000 + i * 1000);
+    }
+    for (int i = 0; i < kBackfill; ++i) {
+      ASSERT_EQ(db.Append(backfill(1000 + i * 1000, -i)), 1u);
+      expected.push_back(1000 + i * 1000);
+    }
+    // 落在实时样本之间的补发点
+    ASSERT_EQ(db.Append(backfill(1'000'500, 0.5)), 1u);
+    expected.push_back(1'000'500);
+    // 已有的时间戳与不带补发标记的乱序样本仍被丢弃
+    EXPECT_EQ(db.Append(backfill(1000, 9.0)), 0u);
+    EXPECT_EQ(db.Append(backfill(1'000'000, 9.0)), 0u);
+    EXPECT_EQ(db.Append(MakeReport("host", 500, 9.0)), 0u);
+    EXPECT_EQ(db.out_of_order_total(), 3u);
+    ASSERT_TRUE(db.Compact());
+    ASSERT_EQ(db.Append(MakeReport("host", 1'000'000 + kLive * 1000, 1.0)), 1u);
+    expected.push_back(1'000'000 + kLive * 1000);
+    ASSERT_EQ(db.Append(backfill(kBackfill * 1000 + 1000, 1.0)), 1u);
+    expected.push_back(kBackfill * 1000 + 1000);
+  }
+  std::sort(expected.begin(), expected.end());
+
+  // 块文件中的补发块与日志尾部的补发点都恢复，重放不会重复写入
+  auto store = std::make_shared<SeriesStore>();
+  TimeSeriesDb db(PersistentOptions(directory), store);
+  ASSERT_TRUE(db.Open(nullptr));
+  PointBlock points;
+  ASSERT_TRUE(db.Query("host", CpuSeries(*store), 0, INT64_MAX, &points));
+  EXPECT_EQ(points.timestamps_ms, expected);
+  for (size_t i = 0; i < points.size(); ++i) {
+    const int64_t timestamp_ms = points.timestamps_ms[i];
+    if (timestamp_ms == 1'000'500) {
+      EXPECT_EQ(points.values[i], 0.5);
+    } else if (timestamp_ms < 1000 + kBackfill * 1000) {
+      EXPECT_EQ(points.values[i], -(timestamp_ms - 1000) / 1000);
+    }
+  }
+  points.clear();
+  ASSERT_TRUE(db.Query("host", CpuSeries(*store), 100'000, 1'001'000, &points));
+  ASSERT_EQ(points.size(), 205u);
+  EXPECT_EQ(points.timestamps_ms.front(), 100'000);
+  EXPECT_EQ(points.timestamps_ms.back(), 1'001'000);
+  std::filesystem::remove_all(directory);
+}
+
+TEST(TimeSeriesDbTest, CompactsAfterWalSizeCapDroppedSegments) {
+  const auto directory = TestDirectory();
+  std::filesystem::remove_all(directory);
+  TsdbOptions options = PersistentOptions(directory);
+  // 上限远小于全部写入：最旧的段在压缩前就被删除，头块的记录仍在日志中
+  options.wal_max_bytes = 16 * 1024;
+  constexpr int kReports = 2000;
+  {
+    TimeSeriesDb db(options, std::make_shared<SeriesStore>());
+    ASSERT_TRUE(db.Open(nullptr));
+    for (int i = 0; i < kReports; ++i) {
+      db.Append(MakeReport("host", 1000 + i * 1000, i * 0.5));
+    }
+    ASSERT_LE(db.wal_bytes(), options.wal_max_bytes + options.wal_segment_bytes);
+    ASSERT_TRUE(db.Compact());
+  }
+
+  // 封存块已落盘，头块由日志尾部重放；压缩不能删掉头块仍需要的记录
+  auto store = std::make_shared<SeriesStore>();
+  TimeSeriesDb db(options, store);
+  ASSERT_TRUE(db.Open(nullptr));
+  PointBlock points;
+  ASSERT_TRUE(db.Query("host", CpuSeries(*store), 0, INT64_MAX, &points));
+  ASSERT_EQ(points.size(), static_cast<size_t>(kReports));
+  for (size_t i = 0; i < points.size(); ++i) {
+    ASSERT_EQ(points.timestamps_ms[i], 1000 + static_cast<int64_t>(i) * 1000);
+  }
+  std::filesystem::remove_all(directory);
+}
+
+TEST(TimeSeriesDbTest, RollupsMatchRawAggregatesAcrossTiers) {
+  TsdbOptions options;
+  options.retention_ms = INT64_MAX / 4;
+  options.rollups = {{60'000, INT64_MAX / 4}, {10'000, INT64_MAX / 4}};  // 构造时按分辨率排序
+  TimeSeriesDb db(options, std::make_shared<SeriesStore>());
+  ASSERT_EQ(db.rollup_tiers().size(), 2u);
+  EXPECT_EQ(db.rollup_tiers()[0].resolution_ms, 10'000);
+
+  // 每秒一个点，中间空出一段，取值不规则
+  constexpr int kSeconds = 3000;
+  for (int i = 0; i < kSeconds; ++i) {
+    if (i >= 1200 && i < 1500) continue;
+    db.Append(MakeReport("host", i * 1000, std::sin(i * 0.1) * 100 + (i % 7)));
+  }
+  const auto ref = CpuRef(db);
+  ASSERT_TRUE(ref.series);
+  constexpr size_t kBuckets = kSeconds / 60;
+  const auto expected = RawBuckets(ref, 60'000, kBuckets);
+
+  for (size_t tier = 0; tier < 2; ++tier) {
+    AggregateBlock block;
+    const size_t rows = TimeSeriesDb::ReadAggregates(ref, tier, 0, INT64_MAX, &block);
+    EXPECT_EQ(rows, block.size());
+    ExpectSameBuckets(MergeBuckets(block, 60'000, kBuckets), expected);
+    // 只有最后一个未结束的桶读原始样本
+    EXPECT_LT(block.size(), tier == 0 ? 300u : 70u);
+  }
+}
+
+TEST(TimeSeriesDbTest, RollupsFollowTierRetention) {
+  auto store = std::make_shared<SeriesStore>();
+  TsdbOptions options;
+  options.retention_ms = 60'000;
+  options.rollups = {{10'000, 600'000}, {60'000, 3'600'000}};
+  TimeSeriesDb db(options, store);
+  for (int i = 0; i < 1200; ++i) {
+    db.Append(MakeReport("host", i * 1000, i));
+  }
+
+  // 原始样本过期后序列仍由汇总保留；停止上报后未结束的桶被关闭
+  db.Purge(2'000'000);
+  ASSERT_EQ(db.series_count(), 1u);
+  const auto ref = CpuRef(db);
+  AggregateBlock block;
+  TimeSeriesDb::ReadAggregates(ref, 0, 0, INT64_MAX, &block);
+  EXPECT_TRUE(block.timestamps_ms.empty());
+  TimeSeriesDb::ReadAggregates(ref, 1, 0, INT64_MAX, &block);
+  ASSERT_EQ(block.size(), 20u);
+  EXPECT_EQ(block.timestamps_ms.back(), 1'140'000);
+  EXPECT_EQ(block.count.back(), 60);
+  EXPECT_EQ(block.sum.back(), (1140 + 1199) * 60 / 2.0);
+
+  db.Purge(5'000'000);
+  EXPECT_EQ(db.series_count(), 0u);
+  EXPECT_EQ(db.memory_bytes(), 0u);
+}
+
+TEST(TimeSeriesDbTest, RollupsSurviveRestart) {
+  const auto directory = TestDirectory();
+  std::filesystem::remove_all(directory);
+  TsdbOptions options = PersistentOptions(directory);
+  options.rollups = {{10'000, INT64_MAX / 4}, {60'000, INT64_MAX / 4}};
+  // 汇总块满 120 个桶封存：压缩时第一层已有封存块落盘，其余部分重启时由原始样本和更细一层重建
+  constexpr int kSeconds = 4000;
+  std::vector<Bucket> expected;
+  {
+    TimeSeriesDb db(options, std::make_shared<SeriesStore>());
+    ASSERT_TRUE(db.Open(nullptr));
+    for (int i = 0; i < kSeconds; ++i) {
+      db.Append(MakeReport("host", i * 1000, (i * 37) % 101));
+      if (i == 2500) ASSERT_TRUE(db.Compact());
+    }
+    expected = RawBuckets(CpuRef(db), 60'000, kSeconds / 60 + 1);
+  }
+
+  auto store = std::make_shared<SeriesStore>();
+  TimeSeriesDb db(options, store);
+  ASSERT_TRUE(db.Open(nullptr));
+  EXPECT_EQ(db.block_count(), 2u);  // 原始块与汇总块各一个
+  for (size_t tier = 0; tier < 2; ++tier) {
+    AggregateBlock block;
+    TimeSeriesDb::ReadAggregates(CpuRef(db), tier, 0, INT64_MAX, &block);
+    ExpectSameBuckets(MergeBuckets(block, 60'000, kSeconds / 60 + 1), expected);
+  }
+  std::filesystem::remove_all(directory);
+}
@@ -0,0 +1,135 @@
+#include "../src/client/window_aggregator.h"
+
+#include <map>
+#include <string>
+
+#include <gtest/gtest.h>
+
+using system_insight::client::QuantileSketch;
+using system_insight::client::WindowAggregator;
+using systeminsight::proto::MetricsReport;
+
+namespace {
+
+MetricsReport MakeTick(double cpu, double core_value, int64_t timestamp_ms) {
+  MetricsReport report;
+  auto* total = report.add_samples();
+  total->set_name("system.cpu.usage_percent");
+  total->set_value(cpu);
+  total->set_timestamp_ms(timestamp_ms);
+  auto* core = report.add_samples();
+  core->set_name("system.cpu.core.usage_percent");
+  core->set_value(core_value);
+  core->set_timestamp_ms(timestamp_ms);
+  auto* label = core->add_labels();
+  label->set_key("core");
+  label->set_value("cpu0");
+  return report;
+}
+
+std::map<std::string, double> ByName(const MetricsReport& report, bool labeled) {
+  std::map<std::string, double> values;
+  for (const auto& sample : report.samples()) {
+    if ((sample.labels_size() > 0) == labeled) {
+      values[sample.name()] = sample.value();
+    }
+  }
+  return values;
+}
+
+}  // namespace
+
+TEST(QuantileSketchTest, EstimatesQuantilesWithinRelativeError) {
+  QuantileSketch sketch;
+  for (int i = 1; i <= 1000; ++i) {
+    sketch.Add(static_cast<double>(i));
+  }
+  EXPECT_NEAR(sketch.Quantile(0.5), 500.0, 500.0 * 0.03);
+  EXPECT_NEAR(sketch.Quantile(0.9), 900.0, 900.0 * 0.03);
+  EXPECT_NEAR(sketch.Quantile(0.99), 990.0, 990.0 * 0.03);
+
+  sketch.Reset();
+  sketch.Add(0.0);
+  sketch.Add(0.0);
+  sketch.Add(42.0);
+  EXPECT_EQ(sketch.Quantile(0.5), 0.0);
+  EXPECT_NEAR(sketch.Quantile(1.0), 42.0, 42.0 * 0.03);
+}
+
+TEST(QuantileSketchTest, EstimatesQuantilesOfNegativeValues) {
+  QuantileSketch sketch;
+  for (int i = 1; i <= 1000; ++i) {
+    sketch.Add(-static_cast<double>(i));
+  }
+  EXPECT_NEAR(sketch.Quantile(0.0), -1000.0, 1000.0 * 0.03);
+  EXPECT_NEAR(sketch.Quantile(0.5), -501.0, 501.0 * 0.03);
+  EXPECT_NEAR(sketch.Quantile(0.9), -101.0, 101.0 * 0.03);
+  EXPECT_NEAR(sketch.Quantile(0.99), -11.0, 11.0 * 0.03);
+
+  // 负值、零与正值混合时按数值顺序排列
+  sketch.Reset();
+  for (double value : {-20.0, -10.0, 0.0, 10.0, 20.0}) {
+    sketch.Add(value);
+  }
+  EXPECT_NEAR(sketch.Quantile(0.0), -20.0, 20.0 * 0.03);
+  EXPECT_NEAR(sketch.Quantile(0.25), -10.0, 10.0 * 0.03);
+  EXPECT_EQ(sketch.Quantile(0.5), 0.0);
+  EXPECT_NEAR(sketch.Quantile(0.75), 10.0, 10.0 * 0.03);
+  EXPECT_NEAR(sketch.Quantile(1.0), 20.0, 20.0 * 0.03);
+}
+
+TEST(WindowAggregatorTest, EmitsQuantilesForNegativeSeries) {
+  WindowAggregator aggregator;
+  for (int i = 0; i < 50; ++i) {
+    aggregator.Add(MakeTick(-10.0 - i, -1.0, 1000 + i * 100));
+  }
+  MetricsReport report;
+  aggregator.Flush(&report);
+  auto total = ByName(report, false);
+  EXPECT_DOUBLE_EQ(total["system.cpu.usage_percent.min"], -59.0);
+  EXPECT_DOUBLE_EQ(total["system.cpu.usage_percent.max"], -10.0);
+  EXPECT_NEAR(total["system.cpu.usage_percent.p50"], -34.5, 34.5 * 0.05);
+  EXPECT_NEAR(total["system.cpu.usage_percent.p90"], -14.9, 14.9 * 0.05);
+}
+
+TEST(WindowAggregatorTest, EmitsSummariesPerSeriesAndResetsWindow) {
+  WindowAggregator aggregator;
+  for (int i = 0; i < 50; ++i) {
+    aggregator.Add(MakeTick(10.0 + i, 100.0 - i, 1000 + i * 100));
+  }
+
+  MetricsReport report;
+  aggregator.Flush(&report);
+  EXPECT_EQ(report.samples_size(), 14);
+
+  auto total = ByName(report, false);
+  EXPECT_DOUBLE_EQ(total["system.cpu.usage_percent"], 59.0);
+  EXPECT_DOUBLE_EQ(total["system.cpu.usage_percent.min"], 10.0);
+  EXPECT_DOUBLE_EQ(total["system.cpu.usage_percent.max"], 59.0);
+  EXPECT_DOUBLE_EQ(total["system.cpu.usage_percent.mean"], 34.5);
+  EXPECT_NEAR(total["system.cpu.usage_percent.p50"], 34.5, 34.5 * 0.05);
+  EXPECT_NEAR(total["system.cpu.usage_percent.p99"], 59.0, 59.0 * 0.05);
+
+  auto core = ByName(report, true);
+  EXPECT_DOUBLE_EQ(core["system.cpu.core.usage_percent"], 51.0);
+  EXPECT_DOUBLE_EQ(core["system.cpu.core.usage_percent.min"], 51.0);
+  EXPECT_DOUBLE_EQ(core["system.cpu.core.usage_percent.max"], 100.0);
+  for (const auto& sample : report.samples()) {
+    EXPECT_EQ(sample.timestamp_ms(), 1000 + 49 * 100);
+  }
+
+  // 新窗口只包含之后的采样；没有采样的序列不输出
+  MetricsReport only_total;
+  auto* sample = only_total.add_samples();
+  sample->set_name("system.cpu.usage_percent");
+  sample->set_value(5.0);
+  sample->set_timestamp_ms(9000);
+  aggregator.Add(only_total);
+  report.Clear();
+  aggregator.Flush(&report);
+  EXPECT_EQ(report.samples_size(), 7);
+  total = ByName(report, false);
+  EXPECT_DOUBLE_EQ(total["system.cpu.usage_percent.min"], 5.0);
+  EXPECT_DOUBLE_EQ(total["system.cpu.usage_percent.p90"], 5.0);
+  EXPECT_EQ(aggregator.series_count(), 2u);
+}